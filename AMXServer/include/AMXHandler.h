@@ -7,6 +7,11 @@
 #include "CRC.h"
 #include "CMutex.h"
 
+#define AMX_FRAME_START			0xa5
+#define AMX_RECV_BUFFER_SIZE	512
+#define AMX_EVENT_TIMEOUT		500		//ms. only bounds how long Close() and a lost EIB connection go unnoticed
+#define AMX_MAX_EIB_BATCH		32		//datagrams read from the EIB socket per wakeup
+
 typedef struct ParseResult
 {
 	bool is_valid;
@@ -15,6 +20,13 @@ typedef struct ParseResult
 	bool on;
 }ParseResult;
 
+/*! \class CAMXListener
+	\brief Event loop of the AMX bridge
+
+	A single thread waits (epoll, select on Windows) on both the AMX TCP socket and the EIB data
+	socket and translates press/release frames and EIB telegrams as soon as they arrive.
+	AMX frames are reassembled from the TCP stream, so frames split between reads are not lost.
+*/
 class CAMXListener : public JTCThread, JTCMonitor
 {
 public:
@@ -27,14 +39,29 @@ public:
 	void SendAMXMessage(unsigned char device_id, bool press);
 
 private:
+	/*!
+	\brief Length of the AMX frame at the start of buf
+	\fn static int GetAMXFrameLength(const unsigned char* buf, int length)
+	\return 0 if more bytes are needed, -1 if buf does not start with a known frame
+	*/
+	static int GetAMXFrameLength(const unsigned char* buf, int length);
 	bool ParseSingleAMXFrame(unsigned char* buf, int length, ParseResult& res);
-	void MaintainAMXConnection(unsigned char* buffer, int& len);
+	void MaintainAMXConnection(const unsigned char* frame);
 	void HandleParsedFrame(const ParseResult& result);
 
+	bool OnAMXReadable();
+	void OnEIBReadable();
+	int WaitForEvents(int amx_fd, int eib_fd, bool& amx_ready, bool& eib_ready);
+
 private:
 	TCPSocket _sock;
 	bool _stop;
 	JTCMonitor _mon;
+	unsigned char _buffer[AMX_RECV_BUFFER_SIZE];
+	int _buffered;
+#ifndef WIN32
+	int _epoll_fd;
+#endif
 };
 
 #endif
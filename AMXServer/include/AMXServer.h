@@ -9,7 +9,6 @@
 #include "LogFile.h"
 #include "MsgTable.h"
 #include "AMXHandler.h"
-#include "EIBListener.h"
 #include "SingletonValidation.h"
 
 using namespace std;
@@ -61,19 +60,16 @@ public:
 	inline CAMXServerConfig& GetConfig() { return _conf;}
 	inline CMsgTable& GetMsgsTable() { return _msgs_table;}
 	inline CAMXListener& GetAMXListenr() { return *_amx_handler; }
-	inline CEIBListener& GetEIBListenr() { return *_eib_listener; }
+	inline int GetDataDescriptor() const { return _data_sock.GetDescriptor(); }
 	
 	static void Create();
 	static void Destroy();
 
-	friend class CEIBListener;
-
 private:
 	static CAMXServer _instance;
 	CAMXServerConfig _conf;
 	CLogFile _log;
 	CAMXListener* _amx_handler;
-	CEIBListener* _eib_listener;
 	CMsgTable _msgs_table;
 	bool _stop;
 };
@@ -4,8 +4,11 @@
 #include "CString.h"
 #include "TranslationTable.h"
 #include "GenericDB.h"
+#include <vector>
 
 #define AMX_MSG_TABLE_GENERAL_BLOCK "MESSAGES"
+#define AMX_MAX_DEVICES 256
+#define EIB_MAX_FUNCTIONS 0x10000
 
 class AMXENTRY
 {
@@ -31,11 +34,50 @@ public:
 };
 
 
+/*! \class CMsgTable
+	\brief AMX <-> EIB translation table
+
+	Besides the ordered maps of CTanslationTable (used to reject duplicates while loading), every
+	entry is kept in arrays indexed by the AMX device id and by the EIB function address, so the
+	bridge translates a message with a direct array access.
+*/
 class CMsgTable : public CTanslationTable<AMXENTRY,EIBENTRY>
 {
 public:
 	CMsgTable();
 	virtual ~CMsgTable();
+
+	//returns false if either side is already mapped
+	bool AddEntry(const AMXENTRY& amx, const EIBENTRY& eib);
+
+	const EIBENTRY* FindByAMX(unsigned char device_id, bool press) const
+	{
+		int i = device_id * 2 + (press ? 1 : 0);
+		return _amx_valid[i] ? &_by_amx[i] : NULL;
+	}
+
+	const AMXENTRY* FindByEIB(unsigned short function, unsigned char value) const
+	{
+		for(int i = _eib_first[function]; i != -1; i = _eib_bindings[i]._next){
+			if(_eib_bindings[i]._value == value){
+				return &_eib_bindings[i]._amx;
+			}
+		}
+		return NULL;
+	}
+
+private:
+	typedef struct
+	{
+		unsigned char _value;
+		AMXENTRY _amx;
+		int _next; //next binding of the same function, -1 at the end
+	}EIBBinding;
+
+	EIBENTRY _by_amx[AMX_MAX_DEVICES * 2];
+	bool _amx_valid[AMX_MAX_DEVICES * 2];
+	std::vector<int> _eib_first; //first binding of each function, -1 if none
+	std::vector<EIBBinding> _eib_bindings;
 };
 
 class CMsgsDB : public CGenericDB<CString,CString>
@@ -1,13 +1,27 @@
 #include "AMXHandler.h"
 #include "AMXServer.h"
 
+#ifndef WIN32
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
 CAMXListener::CAMXListener() : 
-_stop(false)
+_stop(false),
+_buffered(0)
+#ifndef WIN32
+,_epoll_fd(-1)
+#endif
 {
 }
 
 CAMXListener::~CAMXListener()
 {
+#ifndef WIN32
+	if(_epoll_fd != -1){
+		close(_epoll_fd);
+	}
+#endif
 }
 
 void CAMXListener::Close()
@@ -19,39 +33,154 @@ void CAMXListener::Close()
 
 void CAMXListener::run()
 {
-	JTCSynchronized sync(*this);
+	int amx_fd = _sock.GetDescriptor();
+	int eib_fd = CAMXServer::GetInstance().GetDataDescriptor();
+
+#ifndef WIN32
+	_epoll_fd = epoll_create(2);
+	if(_epoll_fd == -1){
+		LOG_ERROR("AMX Handler cannot create the event loop: %s", strerror(errno));
+		return;
+	}
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = amx_fd;
+	epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, amx_fd, &ev);
+	ev.data.fd = eib_fd;
+	epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, eib_fd, &ev);
+#endif
 
-	int len = 0;
-	unsigned char buffer[100];
-	
 	cout << endl;
-	ParseResult res;
 	while (!_stop)
 	{
-		//get massage from device
-		START_TRY
-			len = _sock.Recv(buffer,sizeof(buffer),2000);
-			res.length = 0;
-			unsigned char* tmp_ptr = buffer;
-			int tmp_len = len;
-			while(ParseSingleAMXFrame(tmp_ptr,tmp_len,res)){
-				HandleParsedFrame(res);
-				tmp_ptr += res.length;
-				tmp_len -= res.length;
-			}
-			//last frame in packet
+		bool amx_ready = false, eib_ready = false;
+		if(WaitForEvents(amx_fd, eib_fd, amx_ready, eib_ready) < 0){
+			break;
+		}
+
+		if(amx_ready && !OnAMXReadable()){
+			LOG_ERROR("AMX Interface closed the connection. Stopping AMX Handler...");
+			break;
+		}
+		if(eib_ready){
+			OnEIBReadable();
+		}
+
+		if(eib_fd != -1 && !CAMXServer::GetInstance().IsConnected()){
+			LOG_ERROR("EIB Server is disconnected. EIB telegrams are no longer forwarded to AMX.");
+#ifndef WIN32
+			epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, eib_fd, &ev);
+#endif
+			eib_fd = -1;
+		}
+	}
+}
+
+int CAMXListener::WaitForEvents(int amx_fd, int eib_fd, bool& amx_ready, bool& eib_ready)
+{
+#ifdef WIN32
+	fd_set rfds;
+	FD_ZERO(&rfds);
+	FD_SET(amx_fd, &rfds);
+	if(eib_fd != -1){
+		FD_SET(eib_fd, &rfds);
+	}
+	struct timeval tv;
+	tv.tv_sec = AMX_EVENT_TIMEOUT / 1000;
+	tv.tv_usec = (AMX_EVENT_TIMEOUT % 1000) * 1000;
+	int n = select(0, &rfds, NULL, NULL, &tv);
+	if(n < 0){
+		LOG_ERROR("AMX Handler event loop failed.");
+		return -1;
+	}
+	amx_ready = FD_ISSET(amx_fd, &rfds) != 0;
+	eib_ready = eib_fd != -1 && FD_ISSET(eib_fd, &rfds) != 0;
+	return n;
+#else
+	struct epoll_event events[2];
+	int n = epoll_wait(_epoll_fd, events, 2, AMX_EVENT_TIMEOUT);
+	if(n < 0){
+		if(errno == EINTR){
+			return 0;
+		}
+		LOG_ERROR("AMX Handler event loop failed: %s", strerror(errno));
+		return -1;
+	}
+	for(int i = 0; i < n; i++)
+	{
+		if(events[i].data.fd == amx_fd){
+			amx_ready = true;
+		}else if(events[i].data.fd == eib_fd){
+			eib_ready = true;
+		}
+	}
+	return n;
+#endif
+}
+
+bool CAMXListener::OnAMXReadable()
+{
+	int len = 0;
+	START_TRY
+		len = _sock.CommunicatingSocket::Recv(_buffer + _buffered, sizeof(_buffer) - _buffered);
+	END_TRY_START_CATCH_SOCKET(e)
+		LOG_ERROR("AMX Handler Socket Exception: %s", e.what());
+		return false;
+	END_CATCH
+
+	if(len <= 0){
+		return false;
+	}
+	_buffered += len;
+
+	int pos = 0;
+	while(pos < _buffered)
+	{
+		int frame_len = GetAMXFrameLength(_buffer + pos, _buffered - pos);
+		if(frame_len == 0){
+			//incomplete frame, wait for the rest
+			break;
+		}
+		if(frame_len < 0){
+			//resynchronize on the next frame start
+			pos++;
+			continue;
+		}
+
+		ParseResult res;
+		if(ParseSingleAMXFrame(_buffer + pos, frame_len, res)){
 			HandleParsedFrame(res);
-		END_TRY_START_CATCH_SOCKET(e)
-			CAMXServer::GetInstance().GetLog().Log(LOG_LEVEL_ERROR,"AMX Handler Socket Exception: ",e.what());
-		END_CATCH
-		
-		//packet inspection
-		while (len > 0)
-		{
-			MaintainAMXConnection(buffer,len);		
 		}
+		MaintainAMXConnection(_buffer + pos);
+		pos += frame_len;
+	}
 
-		this->wait(10);
+	//only the start of an incomplete frame (less than 16 bytes) stays in the buffer
+	_buffered -= pos;
+	if(pos > 0 && _buffered > 0){
+		memmove(_buffer, _buffer + pos, _buffered);
+	}
+	return true;
+}
+
+void CAMXListener::OnEIBReadable()
+{
+	CAMXServer& server = CAMXServer::GetInstance();
+	CEibAddress func;
+	unsigned char val[MAX_EIB_VALUE_LEN];
+	unsigned char val_len = 0;
+
+	//drain what is already queued, the socket stays readable for the rest
+	for(int i = 0; i < AMX_MAX_EIB_BATCH; i++)
+	{
+		if(server.ReceiveEIBNetwork(func,val,val_len,0) <= 0){
+			break;
+		}
+		const AMXENTRY* result = server.GetMsgsTable().FindByEIB(func.ToByteArray(), val[0]);
+		if(result != NULL){
+			SendAMXMessage(result->_device_id,result->_press);
+		}
 	}
 }
 
@@ -95,45 +224,58 @@ void CAMXListener::Init()
 	END_CATCH
 }
 
+int CAMXListener::GetAMXFrameLength(const unsigned char* buf, int length)
+{
+	if(length < 2){
+		return 0;
+	}
+	if(buf[0] != AMX_FRAME_START){
+		return -1;
+	}
+
+	int frame_len;
+	switch (buf[1])
+	{
+	case 0x05: frame_len = 12; break;
+	case 0x06: frame_len = 16; break;
+	case 0x13:
+	case 0x14:
+	case 0x15:
+	case 0x16: frame_len = 9; break;
+	case 0x23:
+	case 0x24: frame_len = 10; break;
+	case 0x52: frame_len = 13; break;
+	default:
+		return -1;
+	}
+	return length < frame_len ? 0 : frame_len;
+}
+
 bool CAMXListener::ParseSingleAMXFrame(unsigned char* buf, int length, ParseResult& res)
 {
-	if(length < 2 || buf[0] != 0xa5){
-		res.is_valid = false;
+	res.is_valid = false;
+	res.length = length;
+	if(length < 10){
 		return false;
 	}
-	
+
 	switch (buf[1])
 	{
-	case 0x6:
-		res.is_valid = false;
-		res.length = 16;
-		break;
-	case 0x5:
-		res.is_valid = false;
-		res.length = 12;
-		break;
-	case 0x15:
-		res.is_valid = false;
-		res.length = 9;
-		break;
 	case 0x23:
 		res.is_valid = true;
-		res.length = 10;
 		res.channel_id = buf[7];
 		res.on = true;
 		break;
 	case 0x24:
 		res.is_valid = true;
-		res.length = 10;
 		res.channel_id = buf[7];
 		res.on = false;
 		break;
 	default:
-		res.is_valid = false;
-		return false;
+		break;
 	}
 
-	return (length - res.length) > 0;
+	return res.is_valid;
 }
 
 void CAMXListener::HandleParsedFrame(const ParseResult& result)
@@ -143,86 +285,45 @@ void CAMXListener::HandleParsedFrame(const ParseResult& result)
 		return;
 	}
 	
-	AMXENTRY amx_entry;
-	amx_entry._device_id = result.channel_id;
-	amx_entry._press = result.on;
-	amx_entry._release = !result.on;
-
-	EIBENTRY eib_entry;
-	if(CAMXServer::GetInstance().GetMsgsTable().FindByLeft(amx_entry,eib_entry))
+	const EIBENTRY* eib_entry = CAMXServer::GetInstance().GetMsgsTable().FindByAMX((unsigned char)result.channel_id, result.on);
+	if(eib_entry != NULL)
 	{
-		CEibAddress addr(eib_entry._function, true);
+		CEibAddress addr(eib_entry->_function, true);
 		unsigned char val[1];
-		val[0] = eib_entry._value;
+		val[0] = eib_entry->_value;
 		CAMXServer::GetInstance().SendEIBNetwork(addr, val, 1, NON_BLOCKING);
 	}
 }
 
-void CAMXListener::MaintainAMXConnection(unsigned char* buffer, int& len)
+void CAMXListener::MaintainAMXConnection(const unsigned char* frame)
 {
-	int i;
-	if (buffer[1] == 0x05){
-	if (len > 12){
-			for (i=12; i<len; i++) buffer[i-12]=buffer[i];
-		}
-		len-=12;
-	}
-	if (buffer[1] == 0x06){
-		JTCSynchronized sync(_mon);
-		_sock.Send(macack, sizeof(macack));
-		_sock.Send(ver2, sizeof(ver2));
-		if (len > 16){
-			for (i=16; i<len; i++) buffer[i-16]=buffer[i];
-		}
-		len-=16;
-	}
-	if (buffer[1] == 0x13){
-		if (len > 9){
-			for (i=9; i<len; i++) buffer[i-9]=buffer[i];
-		}
-		len-=9;
-	}
-	if (buffer[1] == 0x14)
-	{
-		if (len > 9){
-			for (i=9; i<len; i++) buffer[i-9]=buffer[i];
-		}
-		len-=9;
-	}
-	if (buffer[1] == 0x15){
-		if (len > 9){
-			for (i=9; i<len; i++) buffer[i-9]=buffer[i];
-		}
-		len-=9;
-	}
-	if (buffer[1] == 0x16){
-		JTCSynchronized sync(_mon);
-		_sock.Send(ver1, sizeof(ver1));
-		if (len > 9)
+	//answers the controller expects to keep the session alive
+	START_TRY
+		switch (frame[1])
 		{
-			for (i=9; i<len; i++) buffer[i-9]=buffer[i];
-		}
-		len-=9;
-	}
-	if (buffer[1] == 0x23){
-		if (len > 10){
-			for (i=10; i<len; i++) buffer[i-10]=buffer[i];
-		}
-		len-=10;
-	}
-	if (buffer[1] == 0x24){
-		if (len > 10){
-			for (i=10; i<len; i++) buffer[i-10]=buffer[i];
-		}
-		len-=10;
-	}
-	if (buffer[1] == 0x52){
-		JTCSynchronized sync(_mon);
-		_sock.Send(ver1s, sizeof(ver1s));
-		if (len > 13){
-			for (i=13; i<len; i++) buffer[i-13]=buffer[i];
+		case 0x06:
+			{
+				JTCSynchronized sync(_mon);
+				_sock.Send(macack, sizeof(macack));
+				_sock.Send(ver2, sizeof(ver2));
+			}
+			break;
+		case 0x16:
+			{
+				JTCSynchronized sync(_mon);
+				_sock.Send(ver1, sizeof(ver1));
+			}
+			break;
+		case 0x52:
+			{
+				JTCSynchronized sync(_mon);
+				_sock.Send(ver1s, sizeof(ver1s));
+			}
+			break;
+		default:
+			break;
 		}
-		len-=13;
-   }
+	END_TRY_START_CATCH_SOCKET(e)
+		LOG_ERROR("AMX Handler Socket Exception: %s", e.what());
+	END_CATCH
 }
-
@@ -10,7 +10,6 @@ _amx_handler(NULL),
 _stop(false)
 {
 	_amx_handler = new CAMXListener();
-	_eib_listener = new CEIBListener();
 }
 
 CAMXServer::~CAMXServer()
@@ -38,10 +37,8 @@ void CAMXServer::Start()
 		LOG_INFO("\nEIB Server Connection established.\n");
 	}
 
-	LOG_INFO("Starting AMX/NET Listener...");
+	LOG_INFO("Starting AMX/NET <-> EIB/NET bridge...");
 	_amx_handler->start();
-	LOG_INFO("Starting EIB/NET Listener...");
-	_eib_listener->start();
 }
 
 void CAMXServer::Close()
@@ -49,11 +46,11 @@ void CAMXServer::Close()
 	LOG_INFO("Saving Configuration file...");
 	_conf.Save(CURRENT_CONF_FOLDER + AMX_CONF_FILE_NAME);
 	
-	LOG_INFO("Closing EIB Listener...");
-	_eib_listener->Close();
-
 	LOG_INFO("Closing AMX Interface...");
 	_amx_handler->Close();
+	if(_amx_handler->isAlive()){
+		_amx_handler->join();
+	}
 
 	LOG_INFO("Closing Generic Server module...");
 	CGenericServer::Close();
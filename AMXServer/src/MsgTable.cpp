@@ -1,14 +1,36 @@
 #include "MsgTable.h"
 #include "AMXServer.h"
 
-CMsgTable::CMsgTable()
+CMsgTable::CMsgTable() :
+_eib_first(EIB_MAX_FUNCTIONS, -1)
 {
+	memset(_by_amx, 0, sizeof(_by_amx));
+	memset(_amx_valid, 0, sizeof(_amx_valid));
 }
 
 CMsgTable::~CMsgTable()
 {
 }
 
+bool CMsgTable::AddEntry(const AMXENTRY& amx, const EIBENTRY& eib)
+{
+	if(!InsertEntry(amx, eib)){
+		return false;
+	}
+
+	int i = amx._device_id * 2 + (amx._press ? 1 : 0);
+	_by_amx[i] = eib;
+	_amx_valid[i] = true;
+
+	EIBBinding binding;
+	binding._value = eib._value;
+	binding._amx = amx;
+	binding._next = _eib_first[eib._function];
+	_eib_first[eib._function] = (int)_eib_bindings.size();
+	_eib_bindings.push_back(binding);
+	return true;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 CMsgsDB::CMsgsDB()
 {
@@ -67,7 +89,7 @@ void CMsgsDB::OnReadParamComplete(CString& current_record, const CString& param,
 	right._function = eib_function;
 	right._value = eib_val;
 
-	if(!CAMXServer::GetInstance().GetMsgsTable().InsertEntry(left,right))
+	if(!CAMXServer::GetInstance().GetMsgsTable().AddEntry(left,right))
 	{
 		throw CEIBException(ConfigFileError,"Error in Configuration file: %s. File contains duplicate entries",_file_name.GetBuffer());
 	}
@@ -3,6 +3,9 @@ CONF_ENTRY(bool, AutoDiscoverEibServer,"AUTO_DISCOVER_EIB_SERVER", true)
 CONF_ENTRY(CString,EibIPAddress,"EIB_SERVER_IP_ADDRESS","127.0.0.1")
 CONF_ENTRY(int,EibPort,"EIB_SERVER_PORT",5000)
 CONF_ENTRY(int,KnxIpPort,"KNXIP_LISTEN_PORT",3671)
+CONF_ENTRY(int,MaxConnections,"MAX_CONNECTIONS",255)
+CONF_ENTRY(bool,RoutingMode,"ROUTING_MODE",false)
+CONF_ENTRY(CString,RoutingMulticastAddress,"ROUTING_MULTICAST_ADDRESS","224.0.23.12")
 CONF_ENTRY(CString,Name,"RELAY_SERVER_NAME","RELAY")
 CONF_ENTRY(CString,NetworkName,"RELAY_NETWORK_NAME","RELAY")
 CONF_ENTRY(CString,Password,"RELAY_SERVER_PASSWORD","RELAY")
@@ -5,12 +5,26 @@
 #include "JTC.h"
 #include "GenericServer.h"
 #include "Socket.h"
-
-#define MAX_CONNS 10
+#include "ConnectionTable.h"
+#include <deque>
+#include <chrono>
+
+#define RELAY_FORWARD_QUEUE_SIZE 256	//frames waiting to be forwarded to the EIBServer
+#define RELAY_MAX_OUTSTANDING	 32		//forwarded frames per channel waiting for L_DATA_CON
+#define RELAY_CONFIRM_TIMEOUT	 3		//seconds to wait for the L_DATA_CON of a forwarded frame
+#define RELAY_SEND_QUEUE_SIZE	 64		//frames per client waiting to be tunnelled (the oldest is dropped when full)
+#define RELAY_ACK_TIMEOUT		 1000	//milliseconds to wait for the tunnelling ack of a frame sent to a client
+#define RELAY_MAX_SEND_TIMEOUTS	 2		//frames in a row a client did not ack (after the retry) before it is disconnected
+#define RELAY_SEND_POLL_INTERVAL 200	//milliseconds between checks of the clients ack timeouts
+#define RELAY_ROUTING_CHANNEL	 0		//channel of frames received as routing indications (never assigned to a client)
+#define RELAY_ROUTING_BUSY_LEVEL 192	//forwarding queue level at which routing peers are asked to pause
+#define RELAY_ROUTING_BUSY_WAIT	 100	//milliseconds the routing peers are asked to pause
+#define RELAY_ROUTING_HOLD_SIZE	 64		//routing indications held while a peer is busy (the oldest is dropped when full)
 
 class CRelayInputHandler;
 class CRelayDataInputHandler;
 class CRelayOutputHandler;
+class CRelayForwardHandler;
 
 // This class is responsible to maintain a single KNX/IP connection with remote client
 class CRelayHandler : public CGenericServer, public JTCMonitor
@@ -27,10 +41,17 @@ public:
 	int GetLocalCtrlPort() const { return _input_handler->GetLocalCtrlPort(); }
 	
 private:
+	//a frame that was forwarded to the bus and waits for its confirmation
+	typedef struct
+	{
+		unsigned int seq;
+		CEibAddress dst;
+		CTime expires;
+	}OutstandingRequest;
+
 	typedef struct
 	{
 		bool		  is_connected;
-		unsigned char id;
 		unsigned char channelid;
 		unsigned char recv_sequence;
 		unsigned char send_sequence;
@@ -39,7 +60,14 @@ private:
 		CString _remote_data_addr;
 		int 	_remote_data_port;
 		JTCMonitor state_monitor;
-		CTime 	   _timeout;
+		time_t	   _timeout; //renewed by heartbeats. the connection table re-arms lazily
+		std::deque<OutstandingRequest> outstanding; //guarded by the CRelayHandler monitor
+		//frames to tunnel to the client. the front frame is in flight while waiting_ack is set. guarded by state_monitor
+		std::deque<CCemi_L_Data_Frame> send_queue;
+		bool waiting_ack;
+		int	 send_retries;	//repeats of the frame in flight
+		int	 send_timeouts;	//frames in a row that were never acked
+		std::chrono::steady_clock::time_point ack_deadline;
 	}ConnectionState;
 
 private:
@@ -61,6 +89,8 @@ public:
 		void SetParent(CRelayHandler* relay) { _relay = relay; }
 
 		void SendTunnelToClient(const CCemi_L_Data_Frame& frame, ConnectionState* s);
+		void DisconnectClient(ConnectionState* s);
+		void SendRoutingIndication(const CCemi_L_Data_Frame& frame);
 
 	private:
 		void HandleDisconnectRequest(unsigned char* buffer, int max_len);
@@ -71,6 +101,12 @@ public:
 		void HandleDisconnectResponse(unsigned char* buffer, int max_len);
 		void HandleTunnelAck(unsigned char* buffer, int max_len);
 		void HandleDescriptionRequest(unsigned char* buffer, int max_len);
+		void HandleRoutingIndication(unsigned char* buffer, int max_len);
+		void HandleRoutingBusy(unsigned char* buffer, int max_len);
+		void HandleRoutingLostMessage(unsigned char* buffer, int max_len);
+		void SendRoutingBusy();
+		void SendRoutingLostMessage();
+		bool IsRoutingPeer(const CString& src_ip, int src_port) const;
 
 	private:
 		CRelayHandler* _relay;
@@ -78,6 +114,11 @@ public:
 		UDPSocket _sock;
 		CString _local_addr; //used for Control + Data channels
 		int _local_port; //used for Control + Data channels
+		bool _routing;
+		CString _mcast_addr;
+		unsigned short _routing_lost; //routing indications dropped since the last lost message
+		time_t _last_lost_report;
+		time_t _last_busy;
 	};
 
 	//This handler will be response of receiving data from the EIBServer and writing 
@@ -97,25 +138,75 @@ public:
 		bool _stop;
 	};
 
+	//Forwards tunnel requests of all clients to the EIBServer, so the input handler
+	//can ack a request as soon as it is queued instead of waiting for the bus
+	class CRelayForwardHandler : public JTCThread, public JTCMonitor
+	{
+	public:
+		CRelayForwardHandler();
+		virtual ~CRelayForwardHandler();
+
+		virtual void run();
+		void Close();
+		void SetParent(CRelayHandler* relay) { _relay = relay; }
+		//returns false if the queue is full (the request is not acked and the client will repeat it)
+		bool Enqueue(unsigned char channelid, const CCemi_L_Data_Frame& frame);
+		int GetQueueSize();
+
+	private:
+		typedef struct
+		{
+			unsigned char channelid;
+			CCemi_L_Data_Frame frame;
+		}ForwardRequest;
+
+		CRelayHandler* _relay;
+		bool _stop;
+		std::deque<ForwardRequest> _queue;
+	};
+
 	typedef JTCHandleT<CRelayHandler::CRelayInputHandler> CRelayInputHandlerHandle;
 	typedef JTCHandleT<CRelayHandler::CRelayOutputHandler> CRelayOutputHandlerHandle;
+	typedef JTCHandleT<CRelayHandler::CRelayForwardHandler> CRelayForwardHandlerHandle;
 
 private:
 	void SendTunnelToClient(const CCemi_L_Data_Frame& frame, ConnectionState* s) { _input_handler->SendTunnelToClient(frame, s); }
+	//queues a frame for a client and sends it if the client is not waiting for an ack
+	void QueueToClient(const CCemi_L_Data_Frame& frame, ConnectionState* s);
+	//sends the next queued frame of a client. the caller holds the client state_monitor
+	void SendNextToClient(ConnectionState* s);
 
 public:
 	void Broadcast(const CCemi_L_Data_Frame& frame);
+	//sends a bus frame once to the routing multicast group (held back while a routing peer is busy)
+	void Publish(const CCemi_L_Data_Frame& frame);
+	//sends the held routing indications once the busy pause is over.
+	//returns the milliseconds left until they can be sent (0 if none are held)
+	int SendHeldRouting();
+	void SetRoutingBusy(int wait_time);
+	bool IsRoutingMode() const { return _server_conf->GetRoutingMode(); }
+	int GetForwardQueueSize() { return _forward_handler->GetQueueSize(); }
+	bool Forward(unsigned char channelid, const CCemi_L_Data_Frame& frame) { return _forward_handler->Enqueue(channelid, frame); }
+	bool AddOutstanding(unsigned char channelid, const CCemi_L_Data_Frame& frame);
+	void RouteConfirmation(const CCemi_L_Data_Frame& frame);
 	ConnectionState* GetState(int channel);
 	ConnectionState* AllocateNewState(const CString& source_ip, int sourc_port);
 	void FreeConnection(ConnectionState* s);
 	void CheckConnectionsCleanup();
+	void CheckSendTimeouts();
 
 private:
 	CRelayServerConfig* _server_conf;
 	CLogFile* _log_file;
 	CRelayInputHandlerHandle _input_handler;
 	CRelayOutputHandlerHandle _data_output_handler;
-	ConnectionState* _states[MAX_CONNS];
+	CRelayForwardHandlerHandle _forward_handler;
+	CConnectionTable<ConnectionState> _states; //guarded by this monitor
+	unsigned int _forward_seq;
+	time_t _last_cleanup;
+	//routing indications are held until this deadline after a ROUTING_BUSY. guarded by this monitor
+	std::chrono::steady_clock::time_point _routing_resume;
+	std::deque<CCemi_L_Data_Frame> _routing_held; //guarded by this monitor
 };
 
 #endif
@@ -125,6 +125,17 @@ void CEIBRelayServer::InteractiveConf()
 	if(ConsoleCLI::Getint("KNXNet/IP Listening port?",ival, _conf.GetKnxIpPort())){
 		_conf.SetKnxIpPort(ival);
 	}
+	if(ConsoleCLI::Getint("Maximum number of KNXNet/IP clients (1-255)?",ival, _conf.GetMaxConnections())){
+		_conf.SetMaxConnections(ival);
+	}
+	if(ConsoleCLI::Getbool("Publish bus traffic as KNXNet/IP routing (multicast)?",bval,_conf.GetRoutingMode())){
+		_conf.SetRoutingMode(bval);
+		if(bval){
+			if(ConsoleCLI::GetCString("Routing multicast address?",sval,_conf.GetRoutingMulticastAddress())){
+				_conf.SetRoutingMulticastAddress(sval);
+			}
+		}
+	}
 
 	if(ConsoleCLI::GetCString("RELAY Server user name (used to connect to EIB Server)?",sval, _conf.GetName())){
 		_conf.SetName(sval);
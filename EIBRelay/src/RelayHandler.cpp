@@ -10,29 +10,30 @@
 #include "TunnelRequest.h"
 #include "TunnelAck.h"
 #include "DescriptionRequest.h"
+#include "RoutingIndication.h"
+#include "RoutingBusy.h"
+#include "RoutingLostMessage.h"
 
 using namespace EibStack;
 
 CRelayHandler::CRelayHandler() :
 CGenericServer(EIB_TYPE_RELAY_SERVER),
 _server_conf(NULL),
-_log_file(NULL)
+_log_file(NULL),
+_forward_seq(0),
+_last_cleanup(0)
 {
 	_input_handler = new CRelayInputHandler();
 	_data_output_handler = new CRelayOutputHandler();
+	_forward_handler = new CRelayForwardHandler();
 
 	_input_handler->SetParent(this);
 	_data_output_handler->SetParent(this);
-	memset(_states, 0, sizeof(_states));
+	_forward_handler->SetParent(this);
 }
 
 CRelayHandler::~CRelayHandler()
 {
-	for(int i = 0; i < MAX_CONNS; i++){
-		if(_states[i] != NULL){
-			delete _states[i];
-		}
-	}
 }
 
 void CRelayHandler::InitState(CRelayHandler::ConnectionState* s)
@@ -40,13 +41,15 @@ void CRelayHandler::InitState(CRelayHandler::ConnectionState* s)
 	if(s == NULL)
 		return;
 
-	s->id = 0;
 	s->is_connected = false;
 	s->channelid = 0;
 	s->recv_sequence = 0;
 	s->send_sequence = 0;
-	s->_timeout.SetNow();
-	s->_timeout += HEARTBEAT_REQUEST_TIME_OUT;
+	s->_timeout = time(NULL) + HEARTBEAT_REQUEST_TIME_OUT;
+	s->send_queue.clear();
+	s->waiting_ack = false;
+	s->send_retries = 0;
+	s->send_timeouts = 0;
 }
 
 void CRelayHandler::Init(CRelayServerConfig* server_conf, CLogFile* log_file)
@@ -55,6 +58,7 @@ void CRelayHandler::Init(CRelayServerConfig* server_conf, CLogFile* log_file)
 	_server_conf = server_conf;
 
 	CGenericServer::Init(log_file);
+	_states.SetMaxConnections(_server_conf->GetMaxConnections());
 	_input_handler->Init();
 }
 
@@ -65,6 +69,9 @@ void CRelayHandler::Close()
 	_input_handler->Close();
 	_input_handler->join();
 
+	_forward_handler->Close();
+	_forward_handler->join();
+
 	_data_output_handler->Close();
 	_data_output_handler->join();
 }
@@ -100,6 +107,7 @@ void CRelayHandler::Start()
 {
 	_input_handler->start();
 	_data_output_handler->start();
+	_forward_handler->start();
 }
 
 void CRelayHandler::Broadcast(const CCemi_L_Data_Frame& frame)
@@ -107,67 +115,258 @@ void CRelayHandler::Broadcast(const CCemi_L_Data_Frame& frame)
 	//lock this object so if cleanup occured it will wait
 	JTCSynchronized s(*this);
 
-	for(int i = 0; i < MAX_CONNS; i++)
+	//each client gets the frame in its own queue, so a slow client only delays itself
+	const vector<unsigned char>& channels = _states.GetChannels();
+	for(unsigned int i = 0; i < channels.size(); i++)
+	{
+		QueueToClient(frame, _states.Get(channels[i]));
+	}
+}
+
+void CRelayHandler::QueueToClient(const CCemi_L_Data_Frame& frame, ConnectionState* s)
+{
+	JTCSynchronized sync(s->state_monitor);
+	if(!s->is_connected){
+		return;
+	}
+	if(s->send_queue.size() >= RELAY_SEND_QUEUE_SIZE){
+		//drop the oldest frame that is not in flight
+		LOG_ERROR("[Client %d] Send queue is full. dropping the oldest frame.", s->channelid);
+		s->send_queue.erase(s->send_queue.begin() + (s->waiting_ack ? 1 : 0));
+	}
+	s->send_queue.push_back(frame);
+	SendNextToClient(s);
+}
+
+void CRelayHandler::SendNextToClient(ConnectionState* s)
+{
+	//one frame in flight per client: the next frame uses the next sequence number and
+	//is sent only after the previous one was acked (or given up)
+	if(s->waiting_ack || s->send_queue.empty() || !s->is_connected){
+		return;
+	}
+	SendTunnelToClient(s->send_queue.front(), s);
+	s->waiting_ack = true;
+	s->send_retries = 0;
+	s->ack_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(RELAY_ACK_TIMEOUT);
+}
+
+void CRelayHandler::CheckSendTimeouts()
+{
+	JTCSynchronized sync(*this);
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	vector<ConnectionState*> dead;
+	const vector<unsigned char>& channels = _states.GetChannels();
+	for(unsigned int i = 0; i < channels.size(); i++)
 	{
-		if(_states[i] != NULL){
-			SendTunnelToClient(frame, _states[i]);
+		ConnectionState* s = _states.Get(channels[i]);
+		JTCSynchronized state_sync(s->state_monitor);
+		if(!s->waiting_ack || now < s->ack_deadline){
+			continue;
 		}
+		if(s->send_retries == 0){
+			//repeat once with the same sequence number
+			LOG_DEBUG("[Client %d] No tunnel ack for sequence %d (repeating)", s->channelid, s->send_sequence);
+			SendTunnelToClient(s->send_queue.front(), s);
+			s->send_retries++;
+			s->ack_deadline = now + std::chrono::milliseconds(RELAY_ACK_TIMEOUT);
+			continue;
+		}
+		//give up on this frame
+		LOG_ERROR("[Client %d] No tunnel ack for sequence %d (dropping frame)", s->channelid, s->send_sequence);
+		s->send_queue.pop_front();
+		s->waiting_ack = false;
+		s->send_sequence++;
+		if(++s->send_timeouts >= RELAY_MAX_SEND_TIMEOUTS){
+			dead.push_back(s);
+			continue;
+		}
+		SendNextToClient(s);
+	}
+
+	for(unsigned int i = 0; i < dead.size(); i++)
+	{
+		LOG_ERROR("[Client %d] Client does not ack tunnel requests. Closing connection.", dead[i]->channelid);
+		_input_handler->DisconnectClient(dead[i]);
+		//the state is used by the input handler, so it is freed there on its next cleanup
+		dead[i]->_timeout = 0;
+		_states.SetTimeout(dead[i]->channelid, time(NULL));
 	}
 }
 
-void CRelayHandler::CheckConnectionsCleanup()
+void CRelayHandler::Publish(const CCemi_L_Data_Frame& frame)
 {
-	//lock this object so if broadcast occured it will wait
-	JTCSynchronized s(*this);
-	
-	//check if any connection has expired
-	for(int i = 0; i < MAX_CONNS; i++)
 	{
-		if(_states[i] != NULL && _states[i]->_timeout.SecondsTo() == 0){
-			// Connection timeout. force close connection
-			LOG_ERROR("[Connection timeout] Closing connection with client %d.", _states[i]->channelid);
-			FreeConnection(_states[i]);
+		JTCSynchronized s(*this);
+		if(!_routing_held.empty() || std::chrono::steady_clock::now() < _routing_resume){
+			//a routing peer asked us to pause. the tunnelling clients are not held back
+			if(_routing_held.size() >= RELAY_ROUTING_HOLD_SIZE){
+				LOG_ERROR("[Routing] Routing peers busy. dropping the oldest held indication.");
+				_routing_held.pop_front();
+			}
+			_routing_held.push_back(frame);
+			LOG_DEBUG("[Routing] Holding indication (routing busy)");
+			return;
 		}
 	}
+	_input_handler->SendRoutingIndication(frame);
 }
 
-CRelayHandler::ConnectionState* CRelayHandler::GetState(int channel)
+int CRelayHandler::SendHeldRouting()
 {
-	for(int i = 0; i < MAX_CONNS; i++)
+	std::deque<CCemi_L_Data_Frame> ready;
 	{
-		if(_states[i] != NULL && channel == _states[i]->channelid){
-			return _states[i];
+		JTCSynchronized s(*this);
+		if(_routing_held.empty()){
+			return 0;
 		}
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if(now < _routing_resume){
+			int left = (int)std::chrono::duration_cast<std::chrono::milliseconds>(_routing_resume - now).count();
+			return left > 0 ? left : 1;
+		}
+		ready.swap(_routing_held);
+	}
+	for(std::deque<CCemi_L_Data_Frame>::iterator it = ready.begin(); it != ready.end(); ++it){
+		_input_handler->SendRoutingIndication(*it);
 	}
-	return NULL;	
+	return 0;
 }
 
-CRelayHandler::ConnectionState* CRelayHandler::AllocateNewState(const CString& source_ip, int sourc_port)
+void CRelayHandler::SetRoutingBusy(int wait_time)
+{
+	JTCSynchronized s(*this);
+	std::chrono::steady_clock::time_point resume = std::chrono::steady_clock::now() + std::chrono::milliseconds(wait_time);
+	if(resume > _routing_resume){
+		_routing_resume = resume;
+	}
+}
+
+bool CRelayHandler::AddOutstanding(unsigned char channelid, const CCemi_L_Data_Frame& frame)
+{
+	JTCSynchronized s(*this);
+
+	if(channelid == RELAY_ROUTING_CHANNEL){
+		//routing indications are not confirmed to anyone
+		return true;
+	}
+	ConnectionState* state = GetState(channelid);
+	if(state == NULL){
+		//client disconnected while its request was queued
+		return false;
+	}
+	if(frame.GetMessageCode() != L_DATA_REQ){
+		return true;
+	}
+
+	OutstandingRequest req;
+	req.seq = ++_forward_seq;
+	req.dst = frame.GetDestAddress();
+	req.expires.SetNow();
+	req.expires += RELAY_CONFIRM_TIMEOUT;
+	if(state->outstanding.size() >= RELAY_MAX_OUTSTANDING){
+		state->outstanding.pop_front();
+	}
+	state->outstanding.push_back(req);
+	return true;
+}
+
+void CRelayHandler::RouteConfirmation(const CCemi_L_Data_Frame& frame)
+{
+	JTCSynchronized s(*this);
+
+	//the bus confirms frames in the order they were sent, so the confirmation belongs
+	//to the oldest outstanding request (of any channel) with the same destination
+	CEibAddress dst = frame.GetDestAddress();
+	ConnectionState* owner = NULL;
+	std::deque<OutstandingRequest>::iterator match;
+	const vector<unsigned char>& channels = _states.GetChannels();
+	for(unsigned int i = 0; i < channels.size(); i++)
+	{
+		ConnectionState* state = _states.Get(channels[i]);
+		std::deque<OutstandingRequest>::iterator it;
+		for(it = state->outstanding.begin(); it != state->outstanding.end(); ++it)
+		{
+			if(it->dst == dst){
+				if(owner == NULL || it->seq < match->seq){
+					owner = state;
+					match = it;
+				}
+				break;
+			}
+		}
+	}
+
+	if(owner == NULL){
+		LOG_DEBUG("[Received] [EIB] [Confirmation] %s: not requested by a relay client (ignoring)", dst.ToString().GetBuffer());
+		return;
+	}
+	owner->outstanding.erase(match);
+	LOG_DEBUG("[Received] [EIB] [Confirmation] %s -> Client %d", dst.ToString().GetBuffer(), owner->channelid);
+	QueueToClient(frame, owner);
+}
+
+void CRelayHandler::CheckConnectionsCleanup()
 {
-	CRelayHandler::ConnectionState* s = NULL;
-	for(int i = 0; i < MAX_CONNS; i++)
+	//lock this object so if broadcast occured it will wait
+	JTCSynchronized s(*this);
+
+	//timeouts have a one second resolution
+	time_t now = time(NULL);
+	if(now == _last_cleanup){
+		return;
+	}
+	_last_cleanup = now;
+
+	//connections that missed their heartbeat
+	vector<unsigned char> expired;
+	_states.Expire(now, expired);
+	for(unsigned int i = 0; i < expired.size(); i++)
 	{
-		if(_states[i] == NULL){
-			//allocate memory
-			s = new CRelayHandler::ConnectionState();
-			InitState(s);
-			_states[i] = s;
-			//set the connection id
-			s->id = i;
-			srand((unsigned)time(0));
-			unsigned char channelid = 0;
-			do
-			{
-				//assign new channel id (make sure its unique)
-				channelid = rand() % 0xFF;
-			}while(GetState(channelid) != NULL);
-			s->channelid = channelid;
-			break;
+		ConnectionState* state = _states.Get(expired[i]);
+		if(state->_timeout > now){
+			//a heartbeat arrived since the timeout was armed
+			_states.SetTimeout(expired[i], state->_timeout);
+			continue;
+		}
+		// Connection timeout. force close connection
+		LOG_ERROR("[Connection timeout] Closing connection with client %d.", expired[i]);
+		FreeConnection(state);
+	}
+
+	//drop requests whose confirmation never arrived
+	const vector<unsigned char>& channels = _states.GetChannels();
+	for(unsigned int i = 0; i < channels.size(); i++)
+	{
+		ConnectionState* state = _states.Get(channels[i]);
+		while(!state->outstanding.empty() && state->outstanding.front().expires.SecondsTo() == 0)
+		{
+			LOG_DEBUG("[Client %d] No confirmation for frame to %s", state->channelid,
+					  state->outstanding.front().dst.ToString().GetBuffer());
+			state->outstanding.pop_front();
 		}
 	}
+}
+
+CRelayHandler::ConnectionState* CRelayHandler::GetState(int channel)
+{
+	return _states.Get(channel);
+}
+
+CRelayHandler::ConnectionState* CRelayHandler::AllocateNewState(const CString& source_ip, int sourc_port)
+{
+	JTCSynchronized sync(*this);
+
+	unsigned char channelid = 0;
+	CRelayHandler::ConnectionState* s = _states.Allocate(channelid);
 	if(s == NULL){
-		LOG_ERROR("Error: EIB Relay is already connected to max number of clients.");
+		LOG_ERROR("Error: EIB Relay is already connected to max number of clients (%d).", _states.GetMaxConnections());
+		return NULL;
 	}
+	InitState(s);
+	s->channelid = channelid;
+	_states.SetTimeout(channelid, s->_timeout);
 	return s;
 }
 
@@ -176,11 +375,10 @@ void CRelayHandler::FreeConnection(CRelayHandler::ConnectionState* s)
 	if(s == NULL){
 		return;
 	}
-	CRelayHandler::ConnectionState* ptr = GetState(s->channelid);
-	if(ptr != NULL){
-		int id = ptr->id;
-		_states[id] = NULL;
-		free(ptr);
+	JTCSynchronized sync(*this);
+	int id = s->channelid;
+	if(_states.Get(id) == s){
+		_states.Free(id);
 		LOG_DEBUG("Resources for Connection %d Cleaned successfuly.",id);
 	}
 }
@@ -192,7 +390,12 @@ JTCThread("CRelayControlHandler"),
 _relay(NULL),
 _stop(false),
 _local_addr(EMPTY_STRING),
-_local_port(0)
+_local_port(0),
+_routing(false),
+_mcast_addr(EIB_MULTICAST_ADDRESS),
+_routing_lost(0),
+_last_lost_report(0),
+_last_busy(0)
 {
 
 }
@@ -208,6 +411,18 @@ void CRelayHandler::CRelayInputHandler::Init()
 		_sock.SetLocalAddressAndPort(_local_addr, _relay->_server_conf->GetKnxIpPort());
 		_local_port = _sock.GetLocalPort();
 		_sock.JoinGroup(_local_addr,EIB_MULTICAST_ADDRESS);
+
+		_routing = _relay->_server_conf->GetRoutingMode();
+		if(_routing){
+			_mcast_addr = _relay->_server_conf->GetRoutingMulticastAddress();
+			if(_mcast_addr != EIB_MULTICAST_ADDRESS){
+				_sock.JoinGroup(_local_addr,_mcast_addr);
+			}
+			_sock.SetMulticastInterface(_local_addr);
+			//routing multicast default TTL
+			_sock.SetMulticastTTL(16);
+			LOG_INFO("KNXNet/IP routing enabled on %s:%d", _mcast_addr.GetBuffer(), _local_port);
+		}
 	END_TRY_START_CATCH_SOCKET(e)
 		throw CEIBException(GeneralError, e.what());
 	END_CATCH
@@ -222,7 +437,8 @@ void CRelayHandler::CRelayInputHandler::run()
 	while (!_stop)
 	{
 		_relay->CheckConnectionsCleanup();
-		
+		SendRoutingLostMessage();
+
 		len = _sock.RecvFrom(buffer, sizeof(buffer), src_ip, src_port, timeout_interval);
 
 		if(len == 0){
@@ -261,7 +477,19 @@ void CRelayHandler::CRelayInputHandler::run()
 			HandleTunnelAck(buffer, sizeof(buffer));
 			break;
 		case ROUTING_INDICATION:
+			if(IsRoutingPeer(src_ip, src_port)){
+				HandleRoutingIndication(buffer, sizeof(buffer));
+			}
+			break;
+		case ROUTING_BUSY:
+			if(IsRoutingPeer(src_ip, src_port)){
+				HandleRoutingBusy(buffer, sizeof(buffer));
+			}
+			break;
 		case ROUTING_LOST_MESSAGE:
+			if(IsRoutingPeer(src_ip, src_port)){
+				HandleRoutingLostMessage(buffer, sizeof(buffer));
+			}
 			break;
 		default:
 			LOG_ERROR("[Received] [Unknown service message code] Source: %s:%d", src_ip.GetBuffer(), src_port);
@@ -270,6 +498,127 @@ void CRelayHandler::CRelayInputHandler::run()
 	}
 }
 
+bool CRelayHandler::CRelayInputHandler::IsRoutingPeer(const CString& src_ip, int src_port) const
+{
+	//routing messages are ignored unless routing is enabled. our own multicast is looped back to us
+	return _routing && !(src_port == _local_port && src_ip == _local_addr);
+}
+
+void CRelayHandler::CRelayInputHandler::HandleRoutingIndication(unsigned char* buffer, int /*max_len*/)
+{
+	START_TRY
+		CRoutingIndication ind(buffer);
+		CCemi_L_Data_Frame frame = ind.GetCemiFrame();
+		LOG_DEBUG("[Received] [Routing Indication] %s", frame.GetDestAddress().ToString().GetBuffer());
+
+		//routing indications are writes to the bus
+		frame.SetMessageControl(L_DATA_REQ);
+		if(!_relay->Forward(RELAY_ROUTING_CHANNEL, frame)){
+			//reported in the next routing lost message
+			if(_routing_lost < 0xFFFF){
+				_routing_lost++;
+			}
+			return;
+		}
+		if(_relay->GetForwardQueueSize() >= RELAY_ROUTING_BUSY_LEVEL){
+			SendRoutingBusy();
+		}
+	END_TRY_START_CATCH(e)
+		LOG_ERROR("Error in routing indication parsing: %s",e.what());
+	END_TRY_START_CATCH_SOCKET(ex)
+		LOG_ERROR("Socket Error in routing indication parsing: %s",ex.what());
+	END_TRY_START_CATCH_ANY
+		LOG_ERROR("Unknown Error in routing indication parsing");
+	END_CATCH
+}
+
+void CRelayHandler::CRelayInputHandler::HandleRoutingBusy(unsigned char* buffer, int /*max_len*/)
+{
+	START_TRY
+		CRoutingBusy busy(buffer);
+		LOG_DEBUG("[Received] [Routing Busy] Wait time: %d ms", busy.GetWaitTime());
+		_relay->SetRoutingBusy(busy.GetWaitTime());
+	END_TRY_START_CATCH(e)
+		LOG_ERROR("Error in routing busy parsing: %s",e.what());
+	END_TRY_START_CATCH_SOCKET(ex)
+		LOG_ERROR("Socket Error in routing busy parsing: %s",ex.what());
+	END_TRY_START_CATCH_ANY
+		LOG_ERROR("Unknown Error in routing busy parsing");
+	END_CATCH
+}
+
+void CRelayHandler::CRelayInputHandler::HandleRoutingLostMessage(unsigned char* buffer, int /*max_len*/)
+{
+	START_TRY
+		CRoutingLostMessage lost(buffer);
+		LOG_ERROR("[Received] [Routing Lost Message] A routing device lost %d messages", lost.GetLostMessages());
+	END_TRY_START_CATCH(e)
+		LOG_ERROR("Error in routing lost message parsing: %s",e.what());
+	END_TRY_START_CATCH_SOCKET(ex)
+		LOG_ERROR("Socket Error in routing lost message parsing: %s",ex.what());
+	END_TRY_START_CATCH_ANY
+		LOG_ERROR("Unknown Error in routing lost message parsing");
+	END_CATCH
+}
+
+void CRelayHandler::CRelayInputHandler::SendRoutingBusy()
+{
+	//at most one busy message per second
+	time_t now = time(NULL);
+	if(now == _last_busy){
+		return;
+	}
+	_last_busy = now;
+
+	START_TRY
+		unsigned char buffer[64];
+		CRoutingBusy busy(0, RELAY_ROUTING_BUSY_WAIT);
+		busy.FillBuffer(buffer, sizeof(buffer));
+		_sock.SendTo(buffer, busy.GetTotalSize(), _mcast_addr, _local_port);
+		LOG_DEBUG("[Send] [Routing Busy] Wait time: %d ms", RELAY_ROUTING_BUSY_WAIT);
+	END_TRY_START_CATCH_SOCKET(ex)
+		LOG_ERROR("Socket Error in SendRoutingBusy: %s",ex.what());
+	END_CATCH
+}
+
+void CRelayHandler::CRelayInputHandler::SendRoutingLostMessage()
+{
+	//at most one lost message per second
+	time_t now = time(NULL);
+	if(_routing_lost == 0 || now == _last_lost_report){
+		return;
+	}
+	_last_lost_report = now;
+
+	START_TRY
+		unsigned char buffer[64];
+		CRoutingLostMessage lost(0, _routing_lost);
+		lost.FillBuffer(buffer, sizeof(buffer));
+		_sock.SendTo(buffer, lost.GetTotalSize(), _mcast_addr, _local_port);
+		LOG_ERROR("[Send] [Routing Lost Message] %d routing indications were dropped", _routing_lost);
+	END_TRY_START_CATCH_SOCKET(ex)
+		LOG_ERROR("Socket Error in SendRoutingLostMessage: %s",ex.what());
+	END_CATCH
+	_routing_lost = 0;
+}
+
+void CRelayHandler::CRelayInputHandler::SendRoutingIndication(const CCemi_L_Data_Frame& frame)
+{
+	START_TRY
+		unsigned char buffer[256];
+		CRoutingIndication ind(frame);
+		ind.FillBuffer(buffer, sizeof(buffer));
+		_sock.SendTo(buffer, ind.GetTotalSize(), _mcast_addr, _local_port);
+		LOG_DEBUG("[Send] [Routing Indication] %s", frame.GetDestAddress().ToString().GetBuffer());
+	END_TRY_START_CATCH(e)
+		LOG_ERROR("Error in SendRoutingIndication: %s",e.what());
+	END_TRY_START_CATCH_SOCKET(ex)
+		LOG_ERROR("Socket Error in SendRoutingIndication: %s",ex.what());
+	END_TRY_START_CATCH_ANY
+		LOG_ERROR("Unknown Error in SendRoutingIndication");
+	END_CATCH
+}
+
 void CRelayHandler::CRelayInputHandler::HandleTunnelAck(unsigned char* buffer, int max_len)
 {
 	START_TRY
@@ -284,12 +633,21 @@ void CRelayHandler::CRelayInputHandler::HandleTunnelAck(unsigned char* buffer, i
 		}
 
 		JTCSynchronized sync(s->state_monitor);
-		if(s->send_sequence == ack.GetSequenceNumber()){
-			//increment the send sequence
-			s->send_sequence++;
-		}else{
+		if(!s->waiting_ack || s->send_sequence != ack.GetSequenceNumber()){
 			LOG_ERROR("Error: Incorrect Sequnece number in Tunnel Ack. Ignore Ack.");
+			return;
 		}
+		if(ack.GetStatus() != E_NO_ERROR){
+			//the request is repeated when the ack timeout expires
+			LOG_ERROR("[Received] [Client %d] [Tunnel Ack] Error: %s", s->channelid, ack.GetStatusString().GetBuffer());
+			return;
+		}
+		//the frame was delivered: increment the send sequence and send the next one
+		s->send_queue.pop_front();
+		s->waiting_ack = false;
+		s->send_timeouts = 0;
+		s->send_sequence++;
+		_relay->SendNextToClient(s);
 
 	END_TRY_START_CATCH(e)
 		LOG_ERROR("Error in tunnel ack parsing: %s",e.what());
@@ -370,16 +728,18 @@ void CRelayHandler::CRelayInputHandler::HandleTunnelRequest(unsigned char* buffe
 			break;
 		}
 
-		//sending an ack back
+		//queue the frame for the EIB Server. the L_DATA_CON is routed back to this channel when it arrives
+		if(!_relay->Forward(s->channelid, req.GetcEMI())){
+			//no ack: the client repeats the request with the same sequence number
+			LOG_ERROR("[Received] [Client %d] [Tunnel Request] Forwarding queue is full (request not acked)", s->channelid);
+			return;
+		}
+
+		//ack right away
 		CTunnelingAck ack(s->channelid, s->recv_sequence , E_NO_ERROR);
 		//increment the recv sequence
 		s->recv_sequence++;
 		ack.FillBuffer(buffer, max_len);
-		
-		//everything is ok. we send forward the request to EIB Sever and waiting for confirmation
-		if(_relay->SendEIBNetwork(req.GetcEMI(), WAIT_FOR_CONFRM)){
-			LOG_DEBUG("[Send] [EIB] [Raw frame from client]");
-		}
 		//We send the ACK back over the Data channel (the channel that the request was received from)
 		_sock.SendTo(buffer, ack.GetTotalSize(), s->_remote_data_addr,s->_remote_data_port);
 
@@ -463,8 +823,7 @@ void CRelayHandler::CRelayInputHandler::HandleConnectionStateRequest(unsigned ch
 		}
 
 		//reset the timeout
-		s->_timeout.SetNow();
-		s->_timeout += HEARTBEAT_REQUEST_TIME_OUT;
+		s->_timeout = time(NULL) + HEARTBEAT_REQUEST_TIME_OUT;
 
 		CConnectionStateResponse resp(s->channelid, E_NO_ERROR);
 		resp.FillBuffer(buffer, max_len);
@@ -569,10 +928,14 @@ void CRelayHandler::CRelayInputHandler::HandleSearchRequest(unsigned char* buffe
 		LOG_DEBUG("[Received] [Search Request]");	
 		//send search response back to the sender
 		char serial[6] = { 0 };
-		unsigned long mcast = inet_addr(EIB_MULTICAST_ADDRESS);
+		unsigned long mcast = inet_addr(_mcast_addr.GetBuffer());
 		const char* name = "EIB Relay Device";
+		int services = SERVICE_CORE | SERVICE_DEV_MNGMT | SERVICE_TUNNELING;
+		if(_routing){
+			services |= SERVICE_ROUTING;
+		}
 		CSearchResponse resp(_local_addr,_local_port, MEDIUM_TP1, CEibAddress((unsigned int)0, false),
-				0, serial, mcast, serial, name, (SERVICE_CORE | SERVICE_DEV_MNGMT | SERVICE_TUNNELING));
+				0, serial, mcast, serial, name, services);
 		resp.FillBuffer(buffer, max_len);
 		_sock.SendTo(buffer,resp.GetTotalSize(),req.GetRemoteIPAddress(),req.GetRemotePort());
 		LOG_DEBUG("[Send] [Search Response]");
@@ -607,6 +970,27 @@ void CRelayHandler::CRelayInputHandler::SendTunnelToClient(const CCemi_L_Data_Fr
 	END_CATCH
 }
 
+void CRelayHandler::CRelayInputHandler::DisconnectClient(ConnectionState* s)
+{
+	START_TRY
+		JTCSynchronized sync(s->state_monitor);
+		if(s->is_connected){
+			unsigned char buffer[256];
+			CDisconnectRequest req(s->channelid, _local_port, _local_addr);
+			req.FillBuffer(buffer, sizeof(buffer));
+			_sock.SendTo(buffer, req.GetTotalSize(), s->_remote_ctrl_addr, s->_remote_ctrl_port);
+			LOG_DEBUG("[Send] [Client %d] [Disconnect Request]", s->channelid);
+			s->is_connected = false;
+		}
+	END_TRY_START_CATCH(e)
+		LOG_ERROR("Error in DisconnectClient: %s",e.what());
+	END_TRY_START_CATCH_SOCKET(ex)
+		LOG_ERROR("Socket Error in DisconnectClient: %s",ex.what());
+	END_TRY_START_CATCH_ANY
+		LOG_ERROR("Unknown Error in DisconnectClient");
+	END_CATCH
+}
+
 void CRelayHandler::CRelayInputHandler::Close()
 {
 	_stop = true;
@@ -636,11 +1020,102 @@ void CRelayHandler::CRelayOutputHandler::run()
 	
 	while(!_stop)
 	{
-		int len = _relay->ReceiveEIBNetwork(frame,2000);
+		//repeat or give up frames the clients did not ack
+		_relay->CheckSendTimeouts();
+
+		//wake up in time to release the routing indications held by a ROUTING_BUSY
+		int poll = RELAY_SEND_POLL_INTERVAL;
+		int held = _relay->SendHeldRouting();
+		if(held > 0 && held < poll){
+			poll = held;
+		}
+
+		int len = _relay->ReceiveEIBNetwork(frame,poll);
 		if(len == 0){
 			continue;
 		}
+		if(frame.GetMessageCode() == L_DATA_CON){
+			//confirmations go only to the client whose request was confirmed
+			_relay->RouteConfirmation(frame);
+			continue;
+		}
 		LOG_DEBUG("[Received] [EIB] [Raw frame]");
 		_relay->Broadcast(frame);
+		if(frame.GetMessageCode() == L_DATA_IND && _relay->IsRoutingMode()){
+			_relay->Publish(frame);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CRelayHandler::CRelayForwardHandler::CRelayForwardHandler() :
+JTCThread("CRelayForwardHandler"),
+_relay(NULL),
+_stop(false)
+{
+}
+
+CRelayHandler::CRelayForwardHandler::~CRelayForwardHandler()
+{
+}
+
+void CRelayHandler::CRelayForwardHandler::Close()
+{
+	JTCSynchronized sync(*this);
+	_stop = true;
+	this->notify();
+}
+
+bool CRelayHandler::CRelayForwardHandler::Enqueue(unsigned char channelid, const CCemi_L_Data_Frame& frame)
+{
+	JTCSynchronized sync(*this);
+	if(_queue.size() >= RELAY_FORWARD_QUEUE_SIZE){
+		return false;
+	}
+	ForwardRequest req;
+	req.channelid = channelid;
+	req.frame = frame;
+	_queue.push_back(req);
+	this->notify();
+	return true;
+}
+
+int CRelayHandler::CRelayForwardHandler::GetQueueSize()
+{
+	JTCSynchronized sync(*this);
+	return (int)_queue.size();
+}
+
+void CRelayHandler::CRelayForwardHandler::run()
+{
+	std::deque<ForwardRequest> batch;
+
+	while(!_stop)
+	{
+		{
+			JTCSynchronized sync(*this);
+			while(!_stop && _queue.empty()){
+				this->wait();
+			}
+			batch.swap(_queue);
+		}
+
+		while(!batch.empty())
+		{
+			ForwardRequest& req = batch.front();
+			//register before sending so a fast confirmation cannot overtake it
+			if(_relay->AddOutstanding(req.channelid, req.frame)){
+				//the EIB Server must not block on the bus: the relay tracks the confirmation itself
+				if(_relay->SendEIBNetwork(req.frame, NON_BLOCKING)){
+					if(req.channelid == RELAY_ROUTING_CHANNEL){
+						LOG_DEBUG("[Send] [EIB] [Raw frame from routing]");
+					}else{
+						LOG_DEBUG("[Send] [EIB] [Raw frame from client %d]", req.channelid);
+					}
+				}
+			}
+			batch.pop_front();
+		}
 	}
 }
@@ -143,6 +143,14 @@ public:
 		\param source_ip The Client's IP address
 	*/	
 	void Init(int source_port,int keep_alive_port,CString& source_ip);
+	/*!
+		\fn bool Handshake()
+		\brief Performs the key exchange and authentication with the client
+		\return true if the client is logged in and the thread may be started
+
+		Called by a CHandshakeWorker of the clients manager before the client thread is started.
+	*/
+	bool Handshake();
 	/*!
 		\fn int GetSessionID() { return _session_id;} const
 		\brief Gets _session_id
@@ -256,10 +264,23 @@ public:
 
 	const CString& GetName() const {return _client_name;}
 	void Close();
+	/*!
+		\fn int GetForwardedFrames() const
+		\brief Number of bus frames forwarded to the client
+	*/
+	int GetForwardedFrames() const { return _forwarded_frames;}
+	/*!
+		\fn int64 GetForwardLatencyNs(bool max) const
+		\brief Time from receiving a bus frame till it was sent to the client
+		\param max return the maximum latency if true, the average otherwise
+		\return latency in nanoseconds
+	*/
+	int64 GetForwardLatencyNs(bool max) const;
 
 private:
 	bool ExchangeKeys();
-	bool Authenticate(CUser& user);
+	bool Authenticate();
+	bool RefreshUser();
 	void CreatePublicData(CHttpReply& reply);
 	void HandleIncomingPktsFromBus(const CUser& user, const CString* key, CCemi_L_Data_Frame& msg);
 	void HandleIncomingPktsFromClient(char* buffer, int max_len, const CUser& user, const CString* key, CString& s_address, CCemi_L_Data_Frame& msg);
@@ -277,6 +298,11 @@ private:
 	int _client_ka_port;
 	CDiffieHellman _encryptor;
 	ClientPolicy _policy;
+	CUserSnapshot _user;
+	unsigned int _user_generation; //users table generation _user was taken from
+	int _forwarded_frames;
+	int64 _forward_latency_total_ns;
+	int64 _forward_latency_max_ns;
 	JTCMonitor _pkt_mon;
 };
 
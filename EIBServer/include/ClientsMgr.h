@@ -9,8 +9,12 @@
 
 #include <iostream>
 #include <map>
+#include <unordered_map>
 #include <stack>
 #include <list>
+#include <deque>
+#include <vector>
+#include <chrono>
 #include "CString.h"
 #include "Client.h"
 #include "Socket.h"
@@ -25,11 +29,77 @@ typedef JTCHandleT<CClient> CClientHandle;
 
 using namespace std;
 
+#define HANDSHAKE_MAX_DATAGRAM_LEN 1024
+#define HANDSHAKE_RATE_WINDOW_MS 1000
+#define HANDSHAKE_RATE_TABLE_MAX 256
+
+class CClientsMgr;
+
+/*! \enum HandshakeJobType
+	\brief Type of datagram waiting in the pending-handshake table
+*/
+typedef enum HandshakeJobType
+{
+	HANDSHAKE_CLIENT_HELLO,	//!< Datagram received on the clients listening socket
+	HANDSHAKE_DISCOVERY		//!< Datagram received on the auto-discovery multicast socket
+}HandshakeJobType;
+
+/*! \struct HandshakeJob
+	\brief A raw datagram handed from the acceptor thread to the handshake workers
+*/
+typedef struct HandshakeJob
+{
+	HandshakeJobType _type;
+	CString _source_address;
+	int _source_port;
+	int _length;
+	char _data[HANDSHAKE_MAX_DATAGRAM_LEN];
+	std::chrono::steady_clock::time_point _received;
+}HandshakeJob;
+
+/*! \struct HandshakeStats
+	\brief Counters and latency figures of the connection acceptance pipeline
+*/
+typedef struct HandshakeStats
+{
+	unsigned int _accepted;		//!< Handshakes that completed key exchange and authentication
+	unsigned int _failed;		//!< Handshakes that were rejected or failed half way
+	unsigned int _rate_limited;	//!< Datagrams refused by the per-source rate limit
+	unsigned int _dropped;		//!< Datagrams refused because the pending table was full
+	unsigned int _pending;		//!< Handshakes currently queued or in progress
+	double _last_latency_ms;	//!< Receive-to-authenticated latency of the last handshake
+	double _min_latency_ms;
+	double _max_latency_ms;
+	double _total_latency_ms;	//!< Sum over all accepted handshakes (average = total / accepted)
+}HandshakeStats;
+
+/*! \class CHandshakeWorker
+	\brief Worker thread of the connection acceptance pipeline
+
+	A fixed number of workers is started by CClientsMgr. Each worker pops datagrams from the
+	pending-handshake table and performs the complete key exchange and authentication with the
+	new client, so the acceptor thread itself never blocks on a slow client.
+*/
+class CHandshakeWorker : public JTCThread
+{
+public:
+	CHandshakeWorker(CClientsMgr* mgr);
+	virtual ~CHandshakeWorker();
+
+	virtual void run();
+
+private:
+	CClientsMgr* _mgr;
+};
+
+typedef JTCHandleT<CHandshakeWorker> CHandshakeWorkerHandle;
+
 /*! \class CClientsMgr
 	\brief Handles new connections and disconnections of clients
 
 	CClientsMgr is a thread that manages the list of connected clients.
-	The thread accepts new connections and handles disconnection of connected clients.
+	The thread only receives datagrams and dispatches them to a pool of CHandshakeWorker threads,
+	which perform the key exchange and authentication of new clients.
 */
 class CClientsMgr : public JTCThread, public JTCMonitor
 {
@@ -71,21 +141,57 @@ public:
 
 	const CString GetListeningAddress() const { return _local_address; }
 
+	/*!
+		\fn bool IsClientConnected(const CString& client_name,CString& client_ip,int& session_id)
+		\brief Looks up a logged in client by its user name (hashed index, O(1))
+	*/
 	bool IsClientConnected(const CString& client_name,CString& client_ip,int& session_id);
+	/*!
+		\fn void GetHandshakeStats(HandshakeStats& stats)
+		\brief Returns a snapshot of the connection acceptance metrics
+	*/
+	void GetHandshakeStats(HandshakeStats& stats);
+
+	friend class CHandshakeWorker;
 
 private:
-	void InitClient(CString& source_address,int source_port,int keep_alive_port);
+	bool PopHandshakeJob(HandshakeJob& job);
+	void DispatchHandshakeJob(HandshakeJobType type, char* data, int length, const CString& source_address, int source_port);
+	bool IsRateLimited(const CString& source_address, const std::chrono::steady_clock::time_point& now);
+	bool ProcessHandshakeJob(HandshakeJob& job);
+	void HandshakeDone(const HandshakeJob& job, bool success);
+	void StartHandshakeWorkers();
+	void StopHandshakeWorkers();
+	CClientHandle InitClient(CString& source_address,int source_port,int keep_alive_port);
+	void RegisterClientName(const CClientHandle& client);
 	bool IsOpenConnectionMessage(char* data, int length,CString& source_address,int& source_port,int& keep_alive_port);
 	int GetSessionID();
-	void HandleServiceDiscovery(char* buffer, int maxlen);
+	void HandleServiceDiscovery(char* buffer, int len);
 
 private:
 	UDPSocket _server_sock; //!socket to listen for new clients
 	UDPSocket _broadcast_sock; //! socket to serve "Auto discovery" service requests
-	map<int,CClientHandle> _clients; //! hash table of connected clients
+	typedef unordered_map<int,CClientHandle> ClientsTable;
+	typedef unordered_multimap<CString,int,CStringHash> ClientsNameIndex;
+	ClientsTable _clients; //! hash table of connected clients, keyed by session id
+	ClientsNameIndex _clients_by_name; //! user name -> session id of logged in clients
 	bool _stop;
 	CString _local_address;
 	bool _auto_discovery_enabled;
+
+	//connection acceptance pipeline
+	typedef struct SourceRate
+	{
+		std::chrono::steady_clock::time_point _window_start;
+		int _count;
+	}SourceRate;
+
+	JTCMonitor _handshake_mon; //! guards the pending-handshake table, rate table and stats
+	deque<HandshakeJob> _pending_jobs;
+	map<CString,SourceRate> _source_rates;
+	vector<CHandshakeWorkerHandle> _workers;
+	HandshakeStats _handshake_stats;
+	bool _workers_stop;
 };
 
 #endif
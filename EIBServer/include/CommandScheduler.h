@@ -8,21 +8,101 @@
 #include "CemiFrame.h"
 #include <queue>
 #include <vector>
+#include <map>
+#include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 
 using namespace std;
 
+#define SCHEDULER_JOURNAL_FILE	"Scheduler.journal"
+#define SCHEDULER_MAX_WAIT_MS	60000	// longest sleep when nothing is due (new commands wake the thread)
+#define SCHEDULER_RETRY_MS		1000	// retry interval for commands that did not fit in the output queue
+
+/*!
+	\enum ScheduleType
+	Defines when a scheduled command fires
+*/
+enum ScheduleType
+{
+	SCHEDULE_ONCE,		//!< fires once at _time
+	SCHEDULE_CRON,		//!< fires on every match of a cron expression (local time)
+	SCHEDULE_SUNRISE,	//!< fires every day at sunrise + _offset minutes
+	SCHEDULE_SUNSET		//!< fires every day at sunset + _offset minutes
+};
+
+/*! \class CCronExpression
+	\brief Five field cron expression: "minute hour day-of-month month day-of-week"
+
+	Each field accepts *, numbers, lists (1,15), ranges (1-5) and steps (*\/10, 8-18/2).
+	Day of week is 0-6 (Sunday = 0, 7 is accepted as Sunday). When both day fields
+	are restricted a day matching either one matches, as in cron.
+*/
+class CCronExpression
+{
+public:
+	CCronExpression();
+
+	bool Parse(const CString& expr);
+	/*!
+		\fn time_t Next(time_t after) const
+		\brief Returns the first matching minute after 'after', or 0 if there is none within 5 years
+	*/
+	time_t Next(time_t after) const;
+	const CString& ToString() const { return _expr; }
+
+private:
+	static bool ParseField(const CString& field, int min_val, int max_val, uint64_t& mask);
+	bool IsDayMatch(const struct tm& tm) const;
+
+	CString _expr;
+	uint64_t _minutes;
+	uint64_t _hours;
+	uint64_t _days;
+	uint64_t _months;
+	uint64_t _weekdays;
+	bool _any_day;
+	bool _any_weekday;
+};
+
+/*! \class CSunCalculator
+	\brief Computes sunrise and sunset times (NOAA sunrise equation, about one minute accuracy)
+*/
+class CSunCalculator
+{
+public:
+	/*!
+		\fn static bool GetSunTimes(time_t day, double latitude, double longitude, time_t& sunrise, time_t& sunset)
+		\brief Sunrise and sunset of the local day containing 'day'
+		\param latitude degrees, north positive
+		\param longitude degrees, east positive
+		\return false if the sun does not rise or set on that day (polar day / night)
+	*/
+	static bool GetSunTimes(time_t day, double latitude, double longitude, time_t& sunrise, time_t& sunset);
+};
+
 typedef struct ScheduledCommand
 {
+	ScheduledCommand() : _id(0), _type(SCHEDULE_ONCE), _offset(0), _value_len(0)
+	{
+	};
+
 	ScheduledCommand(const CTime& time, const CEibAddress& dst, unsigned char* value, unsigned char val_len)
 	{
+		_id = 0;
+		_type = SCHEDULE_ONCE;
+		_offset = 0;
 		_time = time;
 		_dst = dst;
 		_value_len = val_len;
 		memcpy(_value,value,val_len);
 	};
 
-	CTime _time;
+	unsigned int _id;
+	ScheduleType _type;
+	CString _cron;	//SCHEDULE_CRON only
+	int _offset;	//SCHEDULE_SUNRISE / SCHEDULE_SUNSET only, in minutes
+	CTime _time;	//next time the command is due
 	CEibAddress _dst;
 	unsigned char _value_len;
 	unsigned char _value[MAX_EIB_VALUE_LEN];
@@ -42,6 +122,14 @@ public:
 
 typedef priority_queue<ScheduledCommand,vector<ScheduledCommand>,ScheduledCommandComparison > SchedQueue;
 
+/*! \class CCommandScheduler
+	\brief Sends commands to the EIB bus at a given time
+
+	Pending commands are kept in a min-heap ordered by due time and the thread sleeps
+	exactly until the earliest one is due. Cancelled commands are dropped lazily when
+	they reach the top of the heap. Every change is appended to a journal file which is
+	replayed (and compacted) by Init(), so scheduled commands survive a restart.
+*/
 class CCommandScheduler : public JTCThread, public JTCMonitor
 {
 public:
@@ -51,18 +139,57 @@ public:
 	virtual void run();
 	void Close();
 
-	void CheckForScheduledCommand();
+	/*!
+		\fn bool Init(const CString& journal_file)
+		\brief Replays the journal and opens it for appending. Without Init() commands are not persisted
+	*/
+	bool Init(const CString& journal_file);
+	void SetLocation(double latitude, double longitude);
+
 	bool AddScheduledCommand(const CTime& time,
 							 const CEibAddress& dst,
 							 unsigned char* value,
 							 unsigned char val_len,
 							 CString& err_str);
+	/*!
+		\fn unsigned int ScheduleCommand(const ScheduledCommand& cmd, CString& err_str)
+		\brief Schedules a one shot or recurring command
+		\return the id of the command (used for cancellation) or 0 on error
+	*/
+	unsigned int ScheduleCommand(const ScheduledCommand& cmd, CString& err_str);
+	bool CancelScheduledCommand(unsigned int id);
+	bool GetScheduledCommand(unsigned int id, ScheduledCommand& cmd);
+	int GetNumScheduledCommands();
+
+	/*!
+		\fn int CollectDueCommands(time_t now, vector<ScheduledCommand>& due)
+		\brief Moves all commands due at 'now' to 'due'. Recurring commands are rescheduled
+		\return number of commands collected
+	*/
+	int CollectDueCommands(time_t now, vector<ScheduledCommand>& due);
+	//the due time of the earliest pending command, 0 if there is none
+	time_t GetNextDueTime();
 
 private:
-	void SendToEIB(const CEibAddress& dst, unsigned char* value, unsigned char value_len);
+	bool ComputeNextTime(ScheduledCommand& cmd, time_t after, CString& err_str);
+	void SendToEIB(vector<ScheduledCommand>& cmds);
+
+	void Replay();
+	void CompactJournal();
+	void JournalAdd(const ScheduledCommand& cmd);
+	void JournalRemove(unsigned int id);
 
 	bool _stop;
 	SchedQueue _schedule;
+	map<unsigned int, ScheduledCommand> _jobs; //live commands by id
+	vector<ScheduledCommand> _unsent; //due commands that did not fit in the output queue
+	unsigned int _next_id;
+	bool _has_location;
+	double _latitude;
+	double _longitude;
+	CString _journal_file;
+	FILE* _journal;
+	int _journal_dead; //records in the journal that no longer describe a live command
 };
 
 #endif
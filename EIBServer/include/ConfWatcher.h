@@ -0,0 +1,49 @@
+#ifndef __CONF_WATCHER_HEADER__
+#define __CONF_WATCHER_HEADER__
+
+#include "JTC.h"
+#include "CString.h"
+#include <time.h>
+
+#define CONF_WATCHER_POLL_MS	500	// how often the watcher checks its stop flag
+#define CONF_WATCHER_SETTLE_MS	200	// quiet time after the last change before a file is reloaded
+
+/*! \class CConfWatcher
+	\brief Reloads EIB.conf and Users.db when they change on disk
+
+	The conf folder is watched with inotify (modification times are polled where inotify
+	is not available). The changed file is parsed on this thread and then published by
+	CEIBServer in one step, so connected clients and web requests keep running on the
+	previous configuration until the new one is complete.
+*/
+class CConfWatcher : public JTCThread
+{
+public:
+	CConfWatcher();
+	virtual ~CConfWatcher();
+
+	virtual void run();
+	void Close();
+
+private:
+	bool Open();
+	void Release();
+	/*!
+		\fn bool WaitForChanges(int timeout, bool& conf_changed, bool& users_changed)
+		\brief Waits up to timeout milliseconds for a change in one of the watched files
+		\return true if a watched file changed
+	*/
+	bool WaitForChanges(int timeout, bool& conf_changed, bool& users_changed);
+	bool PollModificationTimes(int timeout, bool& conf_changed, bool& users_changed);
+
+private:
+	volatile bool _stop;
+	int _fd;
+	int _wd;
+	time_t _conf_mtime;
+	time_t _users_mtime;
+};
+
+typedef JTCHandleT<CConfWatcher> CConfWatcherHandle;
+
+#endif
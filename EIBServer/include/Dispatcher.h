@@ -4,6 +4,8 @@
 #include <httplib.h>
 #include <thread>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
 #include "CString.h"
 
 class CDispatcher {
@@ -12,16 +14,21 @@ public:
 	~CDispatcher();
 
 	void Init();   // creates SSLServer, registers all routes & mount points
-	void Start();  // launches listen() in background thread
-	void Close();  // calls server->stop(), joins thread
+	void Start();  // launches listen() and session housekeeping in background threads
+	void Close();  // calls server->stop(), joins threads
 
 	int GetServerPort() const { return _port; }
 
 private:
 	void RegisterRoutes();
+	void Housekeeping();
 
 	std::unique_ptr<httplib::SSLServer> _server;
 	std::thread _listen_thread;
+	std::thread _housekeeping_thread;
+	std::mutex _housekeeping_mutex;
+	std::condition_variable _housekeeping_cv;
+	bool _stop;
 	int _port;
 };
 
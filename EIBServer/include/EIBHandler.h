@@ -13,6 +13,7 @@
 #include "EIBNetIP.h"
 #include "CemiFrame.h"
 #include "IConnection.h"
+#include <vector>
 
 using namespace std;
 using namespace EibStack;
@@ -64,6 +65,14 @@ public:
 			   this monitor will be first aquired and released when ack/confirmation is received.
 	*/
 	void Write(const CCemi_L_Data_Frame& data, BlockingMode mode, JTCMonitor* optional_mon);
+	/*!
+		\fn int Write(const vector<CCemi_L_Data_Frame>& frames, BlockingMode mode)
+		\brief Queues several messages at once (one lock, one wake up of the writer thread)
+		\param frames the messages to send, in order
+		\param mode The sending mode. Blocking modes are not supported for batches
+		\return the number of messages queued. the rest did not fit in the queue
+	*/
+	int Write(const vector<CCemi_L_Data_Frame>& frames, BlockingMode mode);
 	/*!
 		\fn virtual void Run(void* arg) 
 		\brief Starting point for thread, calls either RunEIBReader or RunEIBWriter
@@ -128,6 +128,14 @@ public:
 
 
 private:
+	/*!
+		\fn void StartHandler(CEIBHandler* handler, const CString& cpu_list)
+		\brief Starts a handler thread with the stack size, cpu affinity & scheduling policy from EIB.conf
+		\param handler The handler to start
+		\param cpu_list Comma separated list of cpus the handler may run on, or "none"
+	*/
+	void StartHandler(CEIBHandler* handler, const CString& cpu_list);
+
 	//device mode
 	EIB_DEVICE_MODE _mode;
 	//the connection
@@ -22,6 +22,11 @@
 #include "DummyThread.h"
 #include "Dispatcher.h"
 #include "CommandScheduler.h"
+#include "ConfWatcher.h"
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
 
 #ifdef WIN32
 #include "XGetopt.h"
@@ -91,10 +96,13 @@ public:
 	static void Create();
 	
 	/*!
-		\fn inline CServerConfig& GetConfig()
-		Returns reference to the server's configuration file
+		\fn inline CServerConfigPtr GetConfig()
+		Returns the server's configuration file
+
+		After EIB.conf was reloaded this is the newly published configuration. A previous
+		version is freed when the last reader holding it lets go.
 	*/
-	inline CServerConfig& GetConfig() { return _conf;}
+	inline CServerConfigPtr GetConfig() { return std::atomic_load(&_current_conf);}
 	/*!
 		\fn inline CUsersDB& GetUsersDB()
 		Returns reference to the server's user database
@@ -138,6 +146,17 @@ public:
 	inline CCommandScheduler& GetScheduler() { return *_scheduler;}
 
 	void ReloadConfiguration();
+	/*!
+		\fn void ReloadServerConfig()
+		\brief Parses EIB.conf into a new configuration and publishes it
+	*/
+	void ReloadServerConfig();
+	/*!
+		\fn void ReloadUsersDB()
+		\brief Parses Users.db into a new database and publishes it. Connected clients pick up the
+		new policies and filters with their next packet
+	*/
+	void ReloadUsersDB();
 	void InteractiveConf();
 
 private:
@@ -146,8 +165,11 @@ private:
 	CDispatcher* _dispatcher;
 	CCommandSchedulerHandle _scheduler;
 	CEIBInterface* _interface;
+	CConfWatcherHandle _conf_watcher;
 	CUsersDB _users_db;
 	CServerConfig _conf;
+	CServerConfigPtr _current_conf; //accessed through std::atomic_load/atomic_store only
+	std::mutex _reload_lock;
 	CLogFile _log;
 	CStatsDB _stats;
 };
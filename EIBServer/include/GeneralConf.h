@@ -1,12 +1,23 @@
 CONF_ENTRY(CString,InitialKey,"EIB_INITIAL_KEY","EIBKEY")
 CONF_ENTRY(int,ListeningPort,"LISTENING_PORT",5000)
 CONF_ENTRY(int,MaxConcurrentClients,"MAX_CONCURRENT_CLIENTS",10)
+CONF_ENTRY(int,HandshakeWorkers,"HANDSHAKE_WORKERS",4)
+CONF_ENTRY(int,MaxPendingHandshakes,"MAX_PENDING_HANDSHAKES",64)
+CONF_ENTRY(int,HandshakeRateLimit,"HANDSHAKE_RATE_LIMIT",5)
 CONF_ENTRY(int,LogLevel,"LOG_LEVEL",3)
 CONF_ENTRY(int,LogFileMaxSize,"LOG_FILE_MAX_SIZE",512)
 CONF_ENTRY(int,MaxNumObjectsHistory,"MAX_NUM_OBJECTS_HISTORY",100)
+CONF_ENTRY(bool,AutoReloadConf,"AUTO_RELOAD_CONF",true)
+CONF_ENTRY(CString,Location,"LOCATION","none")
 CONF_ENTRY(CString,EibDeviceMode,"EIB_DEVICE_MODE","MODE_TUNNELING")
 CONF_ENTRY(CString,EibDeviceAddress,"EIB_IP_ADDRESS","224.0.23.12")
 CONF_ENTRY(bool,AutoDetectEibDeviceAddress,"AUTO_DETECT_EIB_DEVICE_ADDRESS",false)
+CONF_ENTRY(int,ThreadStackSize,"THREAD_STACK_SIZE",0)
+CONF_ENTRY(int,EibHandlerStackSize,"EIB_HANDLER_STACK_SIZE",0)
+CONF_ENTRY(CString,EibInputCpuAffinity,"EIB_INPUT_CPU_AFFINITY","none")
+CONF_ENTRY(CString,EibOutputCpuAffinity,"EIB_OUTPUT_CPU_AFFINITY","none")
+CONF_ENTRY(CString,EibHandlerSchedPolicy,"EIB_HANDLER_SCHED_POLICY","OTHER")
+CONF_ENTRY(int,EibHandlerSchedPriority,"EIB_HANDLER_SCHED_PRIORITY",0)
 #ifdef WIN32
 CONF_ENTRY(int,EibLocalInterface,"EIB_LOCAL_INTERFACE",1)
 CONF_ENTRY(int,ClientsListenInterface,"CLIENTS_LISTEN_INTERFACE",1)
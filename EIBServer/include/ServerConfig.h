@@ -9,6 +9,7 @@
 
 #include "ConfigFile.h"
 #include "IConfBase.h"
+#include <memory>
 
 using namespace std;
 
@@ -76,4 +77,7 @@ private:
 	bool _load_ok;
 };
 
+//published configuration. replaced as a unit when EIB.conf is reloaded
+typedef std::shared_ptr<CServerConfig> CServerConfigPtr;
+
 #endif
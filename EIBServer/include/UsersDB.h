@@ -3,6 +3,9 @@
 
 #include "CString.h"
 #include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
 #include <fstream>
 #include "GenericDB.h"
 #include "EibNetwork.h"
@@ -23,6 +26,12 @@
 #define USER_ALLOWED_DEST_ADDRESS "ALLOWED_DEST_ADDRESS"
 #define USER_ALLOWED_DEST_MASK "ALLOWED_DEST_MASK"
 
+//Stored passwords: $pbkdf2-sha256$<iterations>$<salt hex>$<key hex>
+#define USER_PASSWORD_HASH_PREFIX "$pbkdf2-sha256$"
+#define USER_PASSWORD_KDF_ITERATIONS 10000
+#define USER_PASSWORD_SALT_LEN 16
+#define USER_PASSWORD_KEY_LEN 32
+
 class CEIBServer;
 class CUsersDB;
 
@@ -31,6 +40,7 @@ class CUser
 public:
 	CUser();
 	CUser(const CUser& user);
+	CUser& operator=(const CUser& user);
 	virtual ~CUser();
 
 	bool IsReadPolicyAllowed() const;
@@ -39,7 +49,12 @@ public:
 	bool IsAdminAccessAllowed() const { return (_priviliges & USER_POLICY_ADMIN_ACCESS) != 0; }
 
 	const CString& GetName() const;
+	//the stored credential: a salted hash, or plain text for records not yet migrated
 	const CString& GetPassword() const;
+	bool VerifyPassword(const CString& password) const;
+
+	static CString HashPassword(const CString& password, int iterations = USER_PASSWORD_KDF_ITERATIONS);
+	static bool IsPasswordHash(const CString& password);
 	unsigned int GetPriviliges() const { return _priviliges; }
 	unsigned short GetSrcMask() const { return _filter.GetSrcMask(); }
 	unsigned short GetDstMask() const { return _filter.GetDstMask(); }
@@ -67,6 +82,12 @@ private:
 	CPacketFilter _filter;
 };
 
+//shared, read only copy of a user record. handed out per request instead of copying CUser
+typedef std::shared_ptr<const CUser> CUserSnapshot;
+//immutable view of the whole database. replaced as a unit when Users.db is reloaded
+typedef map<CString,CUserSnapshot> CUsersTable;
+typedef std::shared_ptr<const CUsersTable> CUsersTableSnapshot;
+
 class CUsersDB : public CGenericDB<CString,CUser>
 {
 public:
@@ -76,9 +97,23 @@ public:
 
 	virtual void Init(const CString& file_name);
 	virtual void Print() const;
-	const map<CString,CUser>& GetUsersList() const { return _data;}
 	bool AuthenticateUser(const CString& user_name, const CString& password, CUser& user);
-	int GetNumOfUsers() const { return _data.size(); }
+	CUserSnapshot AuthenticateUser(const CString& user_name, const CString& password);
+	CUserSnapshot GetUserSnapshot(const CString& user_name);
+	//the currently published users. readers never block the reloading thread
+	CUsersTableSnapshot GetUsersTable();
+	int GetNumOfUsers() { return (int)GetUsersTable()->size(); }
+	//incremented whenever a new users table is published. used to detect changed policies
+	unsigned int GetGeneration() const { return _generation; }
+
+	/*!
+		\fn void Replace(CUsersDB& other)
+		\brief Takes over the records of a database loaded off line and publishes them
+	*/
+	void Replace(CUsersDB& other);
+
+	//writes Users.db. excludes Replace() so the records are not swapped while being written
+	bool Save();
 
 	bool Validate();
 
@@ -88,11 +123,20 @@ public:
 	virtual void OnReadRecordComplete(CUser& current_record);
 	virtual void OnReadRecordNameComplete(CUser& current_record, const CString& record_name);
 	virtual void OnSaveRecordStarted(const CUser& record,CString& record_name, list<pair<CString,CString> >& param_values);
+	virtual void OnRecordsChanged();
 
 private:
+	void Publish();
 	bool AddOrUpdateUser(CUser& user);
 	bool DeleteUser(const CString& file_name);
 	bool UpdateUser(const CString& file_name);
+	bool EditInteractive(const CString& file_name);
+
+private:
+	std::mutex _publish_lock;
+	CUsersTableSnapshot _table; //accessed through std::atomic_load/atomic_store only
+	std::atomic<bool> _dirty;
+	std::atomic<unsigned int> _generation;
 };
 
 #endif
@@ -1,29 +1,28 @@
 #ifndef __WEB_HANDLER_HEADER__
 #define __WEB_HANDLER_HEADER__
 
-#include <map>
-#include <mutex>
 #include <httplib.h>
 #include "CString.h"
 #include "UsersDB.h"
+#include "StatsDB.h"
 #include "XmlJsonUtil.h"
+#include "WebSessionTable.h"
+#include <mutex>
+#include <unordered_map>
+
+#define WEB_AUTH_CACHE_TTL			60		// seconds a verified Authorization header is trusted without re-running the KDF
+#define WEB_AUTH_CACHE_MAX			256		// cached headers before the cache is flushed
 
 #ifndef MAX_EIB_VALUE_LEN
 #define MAX_EIB_VALUE_LEN 16
 #endif
 
-// Session entry for cookie-based auth
-struct WebSession {
-	CString user_name;
-	CString session_id;
-	time_t created;
-	time_t last_access;
-};
-
 class CWebHandler {
 public:
 	// Route registration (called from CDispatcher::RegisterRoutes)
 	static void RegisterRoutes(httplib::SSLServer& server);
+	// Removes idle sessions (called periodically by CDispatcher)
+	static int ExpireSessions();
 
 private:
 	// Session endpoints
@@ -36,6 +35,7 @@ private:
 	static void ApiGetAddressHistory(const httplib::Request& req, httplib::Response& res);
 	static void ApiSendEibCommand(const httplib::Request& req, httplib::Response& res);
 	static void ApiScheduleCommand(const httplib::Request& req, httplib::Response& res);
+	static void ApiCancelScheduledCommand(const httplib::Request& req, httplib::Response& res);
 
 	// Admin endpoints
 	static void ApiGetUsers(const httplib::Request& req, httplib::Response& res);
@@ -47,11 +47,17 @@ private:
 	static void ApiBusMonSendCmd(const httplib::Request& req, httplib::Response& res);
 
 	// Helpers
-	static bool Authenticate(const httplib::Request& req, CUser& user);
+	static CUserSnapshot Authenticate(const httplib::Request& req);
+	static CUserSnapshot AuthenticateBasic(const std::string& auth_hdr);
 	static CString GetSessionCookie(const httplib::Request& req);
 	static CString GenerateSessionId();
 	static CString GetJsonField(const CString& json, const CString& field);
 
+	// Time format of the history APIs, selected with ?time_format=ctime|iso8601|epoch_ms
+	enum JsonTimeFormat { JSON_TIME_CTIME, JSON_TIME_ISO8601, JSON_TIME_EPOCH_MS };
+	static JsonTimeFormat GetJsonTimeFormat(const httplib::Request& req);
+	static void AppendJsonRecord(CString& json, const CEIBRecord& rec, JsonTimeFormat format);
+
 	static void SetJsonResponse(httplib::Response& res, const CString& json, int status = 200);
 	static void SetJsonError(httplib::Response& res, const CString& message, int status = 500);
 
@@ -66,8 +72,16 @@ private:
 
 	friend class WebHandlerUtilTest;
 
-	static std::map<CString, WebSession> _sessions;
-	static std::mutex _session_mutex;
+	static CWebSessionTable _sessions;
+
+	// Verified Basic credentials, keyed by the SHA-256 of the Authorization header
+	struct CachedCredential {
+		CUserSnapshot user;
+		unsigned int generation;
+		time_t expires;
+	};
+	static std::mutex _auth_cache_lock;
+	static std::unordered_map<CString, CachedCredential, CStringHash> _auth_cache;
 };
 
 #endif
@@ -0,0 +1,66 @@
+#ifndef __WEB_SESSION_TABLE_HEADER__
+#define __WEB_SESSION_TABLE_HEADER__
+
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <time.h>
+#include "CString.h"
+
+#define WEB_SESSION_TIMEOUT			3600	// idle seconds before a session expires
+#define WEB_SESSION_SHARDS			16		// lock stripes of the session table
+#define WEB_SESSION_WHEEL_TICK		60		// seconds covered by one timer wheel slot
+#define WEB_SESSION_WHEEL_SLOTS		64		// must cover WEB_SESSION_TIMEOUT / WEB_SESSION_WHEEL_TICK + 1
+// longest timeout the wheel holds without a deadline wrapping onto a slot that comes up earlier
+#define WEB_SESSION_MAX_TIMEOUT		((WEB_SESSION_WHEEL_SLOTS - 2) * WEB_SESSION_WHEEL_TICK)
+
+// Session entry for cookie-based auth
+struct WebSession {
+	CString user_name;
+	CString session_id;
+	time_t created;
+	time_t last_access;
+};
+
+// Lock-striped table of web sessions.
+//
+// Lookups only take the mutex of the shard the session id hashes to, so
+// concurrent API calls on different sessions never contend. Idle sessions
+// are removed by a coarse timer wheel advanced from Expire(); an access
+// only refreshes last_access and the wheel re-files the session when its
+// slot comes up instead of rescheduling on every request.
+class CWebSessionTable {
+public:
+	// timeout is clamped to [1, WEB_SESSION_MAX_TIMEOUT]
+	CWebSessionTable(int timeout = WEB_SESSION_TIMEOUT);
+
+	void Insert(const CString& sid, const CString& user_name, time_t now);
+	// Looks up a live session and refreshes its idle timer
+	bool Touch(const CString& sid, time_t now, CString& user_name);
+	bool Lookup(const CString& sid, WebSession& session);
+	void Remove(const CString& sid);
+	void Clear();
+
+	// Advances the timer wheel up to 'now'. Returns the number of expired sessions.
+	int Expire(time_t now);
+	int GetNumSessions();
+	int GetTimeout() const { return _timeout; }
+
+private:
+	struct Shard {
+		std::mutex mutex;
+		std::unordered_map<CString, WebSession, CStringHash> sessions;
+	};
+
+	Shard& GetShard(const CString& sid) { return _shards[CStringHash()(sid) % WEB_SESSION_SHARDS]; }
+	void Schedule(const CString& sid, time_t expires);
+	void ProcessSlot(int slot, time_t now, int& expired);
+
+	Shard _shards[WEB_SESSION_SHARDS];
+	std::mutex _wheel_mutex;
+	std::vector<CString> _wheel[WEB_SESSION_WHEEL_SLOTS];
+	time_t _wheel_tick; // last tick processed by Expire(), -1 before the first session
+	int _timeout;
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define __CONNECTED_CLIENTS_CONF_HEADER__
 
 #include "IConfBase.h"
+#include "UsersDB.h"
 #include <list>
 
 //defs
@@ -26,12 +27,18 @@ public:
 
 	virtual void ToXml(CDataBuffer& xml_str);
 	virtual void FromXml(const CDataBuffer& xml_str);
+	//reads the users list straight from the text. each user goes into the users db as soon as it is read
+	void FromXml(const char* xml, int length);
 
 	void GetConnectedClients();
 	void SetConnectedClients();
 
 private:
-	list<CClientConf> _clients;
+	static void SetField(CClientConf& client, const CString& field, const CString& value);
+	void AddUser(const CClientConf& client);
+
+	list<CClientConf> _clients; //written by ToXml
+	CUsersDB _users; //read by FromXml
 };
 
 class CClientConf
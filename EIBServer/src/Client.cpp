@@ -7,11 +7,16 @@ _client_type(0),
 _session_id(session_id),
 _keep_alive_thread(NULL),
 _client_port(UNDEFINED_PORT),
-_client_ka_port(UNDEFINED_PORT)
+_client_ka_port(UNDEFINED_PORT),
+_user_generation(0),
+_forwarded_frames(0),
+_forward_latency_total_ns(0),
+_forward_latency_max_ns(0)
 
 {
 	this->setName("Client Thread");
 	_keep_alive_thread = new CListenerThread();
+	_keep_alive_thread->SetParent(this);
 }
 
 CClient::~CClient()
@@ -72,6 +77,24 @@ void CClient::HandleIncomingPktsFromBus(const CUser& user, const CString* key, C
 		
 	CDataBuffer::Encrypt(buffer,len,key);
 	_sock.SendTo(buffer,len,GetClientIP(),GetClientPort());
+
+	//bus receive to client send latency
+	if(!msg.GetTimeStamp().IsZero()){
+		int64 latency = msg.GetTimeStamp().ElapsedNs();
+		_forward_latency_total_ns += latency;
+		if(latency > _forward_latency_max_ns){
+			_forward_latency_max_ns = latency;
+		}
+		++_forwarded_frames;
+	}
+}
+
+int64 CClient::GetForwardLatencyNs(bool max) const
+{
+	if(max){
+		return _forward_latency_max_ns;
+	}
+	return _forwarded_frames == 0 ? 0 : _forward_latency_total_ns / _forwarded_frames;
 }
 
 void CClient::HandleIncomingPktsFromClient(char* buffer, int max_len, const CUser& user, const CString* key, CString& s_address, CCemi_L_Data_Frame& msg)
@@ -146,16 +169,32 @@ void CClient::HandleIncomingPktsFromClient(char* buffer, int max_len, const CUse
 	}
 }
 
-void CClient::run()
+bool CClient::Handshake()
 {
-	CUser user;
-	if(!ExchangeKeys() || !Authenticate(user)){
-		//connection initialization failed. terminate connection & client
-		UnregisterClient();
-		return;
+	return ExchangeKeys() && Authenticate();
+}
+
+bool CClient::RefreshUser()
+{
+	CUsersDB& users = CEIBServer::GetInstance().GetUsersDB();
+	unsigned int generation = users.GetGeneration();
+	if(generation == _user_generation){
+		return true;
 	}
+	//Users.db was reloaded. pick up the new policy and filter without reconnecting
+	_user_generation = generation;
+	CUserSnapshot user = users.GetUserSnapshot(_client_name);
+	if(!user){
+		return false;
+	}
+	_user = user;
+	_policy._read = _user->IsReadPolicyAllowed();
+	_policy._write = _user->IsWritePolicyAllowed();
+	return true;
+}
 
-	_keep_alive_thread->SetParent(this);
+void CClient::run()
+{
 	_keep_alive_thread->start();
 
 	CString s_address;
@@ -164,18 +203,30 @@ void CClient::run()
 	CCemi_L_Data_Frame msg;
 	while (_logged_in)
 	{
+		if(!RefreshUser()){
+			LOG_INFO("User \"%s\" was removed. Disconnecting client.",_client_name.GetBuffer());
+			this->Close();
+			_logged_in = false;
+			break;
+		}
+		const CUser& user = *_user;
 		START_TRY
 			//handle incoming packets from EIB Bus
 			HandleIncomingPktsFromBus(user, key, msg);
 			//handle incoming packets from client
 			HandleIncomingPktsFromClient(buffer, 256, user, key, s_address, msg);
 		END_TRY_START_CATCH_ANY
-			LOG_ERROR("Unknown execption in client \"%s\"",user.GetName().GetBuffer());
+			LOG_ERROR("Unknown execption in client \"%s\"",_client_name.GetBuffer());
 		END_CATCH
 	}
 
 	_sock.Close();
 	UnregisterClient();
+
+	if(_forwarded_frames > 0){
+		LOG_INFO("Client [%s] forwarded %d frames. Latency avg %lld us, max %lld us.",_client_name.GetBuffer(),_forwarded_frames,
+				 (long long)(GetForwardLatencyNs(false) / 1000),(long long)(GetForwardLatencyNs(true) / 1000));
+	}
 	
 	LOG_DEBUG("Client Thread [%s] Exit.",GetName().GetBuffer());
 }
@@ -232,7 +283,7 @@ bool CClient::ExchangeKeys()
 	
 	//send public keys to client
 	START_TRY
-		raw_data.Encrypt(&CEIBServer::GetInstance().GetConfig().GetInitialKey());
+		raw_data.Encrypt(&CEIBServer::GetInstance().GetConfig()->GetInitialKey());
 		
 		//send server public key
 		_sock.SendTo(raw_data.GetBuffer(),raw_data.GetLength(),GetClientIP(),GetClientPort());
@@ -259,7 +310,7 @@ bool CClient::ExchangeKeys()
 			return false;
 		}
 
-		CDataBuffer::Decrypt(buffer,len,&CEIBServer::GetInstance().GetConfig().GetInitialKey());
+		CDataBuffer::Decrypt(buffer,len,&CEIBServer::GetInstance().GetConfig()->GetInitialKey());
 		CHttpParser parser(request,buffer,len);
 		if(!parser.IsLegalRequest() || request.GetRequestURI() != DIFFIE_HELLMAN_CLIENT_PUBLIC_DATA){
 			LOG_ERROR("[Clients Manager] Illegal http reply from client. Terminating connection");
@@ -307,7 +358,7 @@ bool CClient::ExchangeKeys()
 	END_CATCH
 }
 
-bool CClient::Authenticate(CUser& user)
+bool CClient::Authenticate()
 {
 	int len,s_port;
 	CHttpReply reply;
@@ -321,7 +372,7 @@ bool CClient::Authenticate(CUser& user)
 	LOG_INFO("[Clients Manager] Authenticating...");
 	log.SetConsoleColor(WHITE);
 
-	len = _sock.RecvFrom(buf,sizeof(buf),s_address,s_port);
+	len = _sock.RecvFrom(buf,sizeof(buf),s_address,s_port,5000);
 
 	if(len == 0 || s_address != GetClientIP() || s_port != GetClientPort()){
 		//client not responding OR faked client - terminate session
@@ -341,20 +392,23 @@ bool CClient::Authenticate(CUser& user)
 	if(!request.GetHeader(PASSWORD_HEADER,pass_header)){
 		return false;
 	}
-	if(!CEIBServer::GetInstance().GetUsersDB().AuthenticateUser(user_header.GetValue(), pass_header.GetValue(), user)){
+	CUsersDB& users = CEIBServer::GetInstance().GetUsersDB();
+	_user_generation = users.GetGeneration();
+	_user = users.AuthenticateUser(user_header.GetValue(), pass_header.GetValue());
+	if(!_user){
 		LOG_ERROR("[Clients Manager] Authentication failed for user \"%s\".", user_header.GetValue().GetBuffer());
 		return false;
 	}
-	_client_name = user.GetName();
+	_client_name = _user->GetName();
 	
 
 	log.SetConsoleColor(YELLOW);
-	LOG_INFO("[Clients Manager] User \"%s\" Logged in successfully.",user.GetName().GetBuffer());
+	LOG_INFO("[Clients Manager] User \"%s\" Logged in successfully.",_client_name.GetBuffer());
 	log.SetConsoleColor(WHITE);
 	_logged_in = true;
 
-	_policy._read = user.IsReadPolicyAllowed();
-	_policy._write = user.IsWritePolicyAllowed();
+	_policy._read = _user->IsReadPolicyAllowed();
+	_policy._write = _user->IsWritePolicyAllowed();
 		
 	CDataBuffer raw_data;
 	reply.SetStatusCode(STATUS_OK);
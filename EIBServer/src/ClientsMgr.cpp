@@ -1,10 +1,12 @@
 #include "ClientsMgr.h"
 #include "ConfigFile.h"
 #include "EIBServer.h"
+#include <openssl/rand.h>
 
 CClientsMgr::CClientsMgr():
-_stop(false),_auto_discovery_enabled(false)
+_stop(false),_auto_discovery_enabled(false),_workers_stop(false)
 {
+	memset(&_handshake_stats,0,sizeof(_handshake_stats));
 }
 
 CClientsMgr::~CClientsMgr()
@@ -22,10 +24,10 @@ int CClientsMgr::GetNumConnectedClients()
 void CClientsMgr::Init()
 {
 	this->setName("Clients Manager Thread");
-	CServerConfig& conf = CEIBServer::GetInstance().GetConfig();
+	CServerConfigPtr conf = CEIBServer::GetInstance().GetConfig();
 	//Initialize the socket
-	_local_address = Socket::LocalAddress(conf.GetClientsListenInterface());
-	_server_sock.SetLocalAddressAndPort(_local_address,conf.GetListeningPort());
+	_local_address = Socket::LocalAddress(conf->GetClientsListenInterface());
+	_server_sock.SetLocalAddressAndPort(_local_address,conf->GetListeningPort());
 	START_TRY
 		//register to multicast address for auto discovery service
 		_broadcast_sock.JoinGroup(_local_address, AUTO_DISCOVERY_SERVICE_ADDRESS);
@@ -44,73 +46,267 @@ bool CClientsMgr::IsClientConnected(const CString& client_name, CString& client_
 {
 	JTCSynchronized sync(*this);
 
-	map<int,CClientHandle>::iterator it;
-	for(it = _clients.begin(); it != _clients.end(); ++it)
-	{
-		if(it->second->GetName() == client_name){
-			client_ip = it->second->GetClientIP();
-			session_id = it->first;
-			return true;
-		}
+	ClientsNameIndex::iterator it = _clients_by_name.find(client_name);
+	if(it == _clients_by_name.end()){
+		return false;
 	}
-	
-	return false;
+
+	ClientsTable::iterator client = _clients.find(it->second);
+	if(client == _clients.end()){
+		return false;
+	}
+	client_ip = client->second->GetClientIP();
+	session_id = it->second;
+	return true;
+}
+
+void CClientsMgr::RegisterClientName(const CClientHandle& client)
+{
+	JTCSynchronized sync(*this);
+	_clients_by_name.insert(pair<CString,int>(client->GetName(),client->GetSessionID()));
 }
 
 void CClientsMgr::run()
 {
-	CServerConfig& conf = CEIBServer::GetInstance().GetConfig();
-	char buffer[1024];
+	char buffer[HANDSHAKE_MAX_DATAGRAM_LEN];
 	CString source_address;
-	int source_port,keep_alive_port;
-	
+	int source_port;
+
+	StartHandshakeWorkers();
+
 	START_TRY
 
 		while(!_stop)
 		{
-			
+			//the acceptor only receives and dispatches. decryption, parsing, key exchange
+			//and authentication are all done by the handshake workers.
 			int len = _server_sock.RecvFrom(buffer,sizeof(buffer),source_address,source_port,100);
-			
-			if (len == 0 && _auto_discovery_enabled) {
-				HandleServiceDiscovery(buffer,1024);				
+			if(len > 0){
+				DispatchHandshakeJob(HANDSHAKE_CLIENT_HELLO,buffer,len,source_address,source_port);
 				continue;
 			}
 
-			if(conf.GetMaxConcurrentClients() == GetNumConnectedClients()){
-				//write error to client
-				//write to log file
-				LOG_ERROR("[Clients Manager] Max clients exceeded. Refusing new client.");
-				//keep listening
-				continue;
-			}
-
-			if(IsOpenConnectionMessage(buffer,len,source_address,source_port,keep_alive_port)){
-				//initialize client with session id
-				InitClient(source_address,source_port,keep_alive_port);
-				//write here to log file
-			}
-			else{
-				LOG_ERROR("[Clients Manager] Unknown request");
+			if (_auto_discovery_enabled) {
+				len = _broadcast_sock.RecvFrom(buffer,sizeof(buffer),source_address,source_port,0);
+				if(len > 0){
+					DispatchHandshakeJob(HANDSHAKE_DISCOVERY,buffer,len,source_address,source_port);
+				}
 			}
 		}
 
 	END_TRY_START_CATCH_SOCKET(e)
 		LOG_ERROR("[Clients manager] disptacher unknown exception: %s",e.what());
 	END_CATCH
+
+	StopHandshakeWorkers();
 }
 
-void CClientsMgr::HandleServiceDiscovery(char* buffer, int maxlen)
+void CClientsMgr::StartHandshakeWorkers()
 {
-	CString saddr;
-	int sport = 0;
-	int len = _broadcast_sock.RecvFrom(buffer,maxlen,saddr,sport,0);
+	CServerConfigPtr conf = CEIBServer::GetInstance().GetConfig();
+	int num_workers = conf->GetHandshakeWorkers();
+	if(num_workers < 1){
+		num_workers = 1;
+	}
+
+	JTCSynchronized sync(_handshake_mon);
+	_workers_stop = false;
+	for(int i = 0; i < num_workers; ++i)
+	{
+		CHandshakeWorkerHandle worker = new CHandshakeWorker(this);
+		_workers.push_back(worker);
+		worker->start();
+	}
+	LOG_DEBUG("[Clients Manager] Started %d handshake workers.",num_workers);
+}
+
+void CClientsMgr::StopHandshakeWorkers()
+{
+	{
+		JTCSynchronized sync(_handshake_mon);
+		_workers_stop = true;
+		_handshake_mon.notifyAll();
+	}
 
-	if(len == 0){
+	//workers in the middle of a handshake finish it (bounded by the socket timeouts)
+	vector<CHandshakeWorkerHandle>::iterator it;
+	for(it = _workers.begin(); it != _workers.end(); ++it)
+	{
+		(*it)->join();
+	}
+	_workers.clear();
+}
+
+bool CClientsMgr::IsRateLimited(const CString& source_address, const std::chrono::steady_clock::time_point& now)
+{
+	int limit = CEIBServer::GetInstance().GetConfig()->GetHandshakeRateLimit();
+	if(limit <= 0){
+		return false;
+	}
+
+	const std::chrono::milliseconds window(HANDSHAKE_RATE_WINDOW_MS);
+
+	//keep the rate table bounded: forget sources whose window already expired
+	if(_source_rates.size() >= HANDSHAKE_RATE_TABLE_MAX){
+		map<CString,SourceRate>::iterator it = _source_rates.begin();
+		while(it != _source_rates.end()){
+			if(now - it->second._window_start >= window){
+				_source_rates.erase(it++);
+			}else{
+				++it;
+			}
+		}
+	}
+
+	map<CString,SourceRate>::iterator it = _source_rates.find(source_address);
+	if(it == _source_rates.end()){
+		if(_source_rates.size() >= HANDSHAKE_RATE_TABLE_MAX){
+			//too many distinct sources inside one window
+			return true;
+		}
+		SourceRate rate;
+		rate._window_start = now;
+		rate._count = 1;
+		_source_rates.insert(pair<CString,SourceRate>(source_address,rate));
+		return false;
+	}
+
+	SourceRate& rate = it->second;
+	if(now - rate._window_start >= window){
+		rate._window_start = now;
+		rate._count = 0;
+	}
+	return ++rate._count > limit;
+}
+
+void CClientsMgr::DispatchHandshakeJob(HandshakeJobType type, char* data, int length, const CString& source_address, int source_port)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	CServerConfigPtr conf = CEIBServer::GetInstance().GetConfig();
+
+	JTCSynchronized sync(_handshake_mon);
+
+	if(IsRateLimited(source_address,now)){
+		++_handshake_stats._rate_limited;
+		LOG_ERROR("[Clients Manager] Too many connection requests from [%s]. Ignoring.",source_address.GetBuffer());
+		return;
+	}
+
+	if((int)_handshake_stats._pending >= conf->GetMaxPendingHandshakes()){
+		++_handshake_stats._dropped;
+		LOG_ERROR("[Clients Manager] Pending handshakes table is full. Dropping request from [%s].",source_address.GetBuffer());
 		return;
 	}
 
+	_pending_jobs.push_back(HandshakeJob());
+	HandshakeJob& job = _pending_jobs.back();
+	job._type = type;
+	job._source_address = source_address;
+	job._source_port = source_port;
+	job._length = length;
+	memcpy(job._data,data,length);
+	job._received = now;
+
+	++_handshake_stats._pending;
+	_handshake_mon.notify();
+}
+
+bool CClientsMgr::PopHandshakeJob(HandshakeJob& job)
+{
+	JTCSynchronized sync(_handshake_mon);
+
+	while(_pending_jobs.empty() && !_workers_stop){
+		_handshake_mon.wait();
+	}
+	if(_workers_stop){
+		return false;
+	}
+
+	job = _pending_jobs.front();
+	_pending_jobs.pop_front();
+	return true;
+}
+
+void CClientsMgr::HandshakeDone(const HandshakeJob& job, bool success)
+{
+	double latency = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now() - job._received).count();
+
+	JTCSynchronized sync(_handshake_mon);
+	--_handshake_stats._pending;
+	if(job._type == HANDSHAKE_DISCOVERY){
+		return;
+	}
+	if(!success){
+		++_handshake_stats._failed;
+		return;
+	}
+
+	++_handshake_stats._accepted;
+	_handshake_stats._last_latency_ms = latency;
+	_handshake_stats._total_latency_ms += latency;
+	if(_handshake_stats._accepted == 1 || latency < _handshake_stats._min_latency_ms){
+		_handshake_stats._min_latency_ms = latency;
+	}
+	if(latency > _handshake_stats._max_latency_ms){
+		_handshake_stats._max_latency_ms = latency;
+	}
+	LOG_DEBUG("[Clients Manager] Handshake with [%s] completed in %.1f ms.",job._source_address.GetBuffer(),latency);
+}
+
+void CClientsMgr::GetHandshakeStats(HandshakeStats& stats)
+{
+	JTCSynchronized sync(_handshake_mon);
+	stats = _handshake_stats;
+}
+
+bool CClientsMgr::ProcessHandshakeJob(HandshakeJob& job)
+{
+	if(job._type == HANDSHAKE_DISCOVERY){
+		HandleServiceDiscovery(job._data,job._length);
+		return true;
+	}
+
+	CString client_address;
+	int client_port,keep_alive_port;
+	if(!IsOpenConnectionMessage(job._data,job._length,client_address,client_port,keep_alive_port)){
+		LOG_ERROR("[Clients Manager] Unknown request");
+		return false;
+	}
+
+	CClientHandle client = InitClient(client_address,client_port,keep_alive_port);
+	if(!client){
+		return false;
+	}
+
+	bool ok = false;
+	START_TRY
+		ok = client->Handshake();
+	END_TRY_START_CATCH_SOCKET(e)
+		LOG_ERROR("[Clients Manager] Handshake error : %s",e.what());
+	END_CATCH
+
+	if(ok && _stop){
+		//server is shutting down. don't start a client nobody will close
+		ok = false;
+	}
+	if(!ok){
+		//connection initialization failed. terminate connection & client
+		client->UnregisterClient();
+		return false;
+	}
+
+	RegisterClientName(client);
+	client->start();
+	return true;
+}
+
+void CClientsMgr::HandleServiceDiscovery(char* buffer, int len)
+{
+	CString saddr;
+	int sport = 0;
+
 	CDataBuffer raw_request(buffer,len);
-	raw_request.Decrypt(&CEIBServer::GetInstance().GetConfig().GetInitialKey());
+	raw_request.Decrypt(&CEIBServer::GetInstance().GetConfig()->GetInitialKey());
 	CHttpRequest request;
 
 	CHttpParser parser(request,raw_request);
@@ -140,12 +336,12 @@ void CClientsMgr::HandleServiceDiscovery(char* buffer, int maxlen)
 	reply.SetVersion(HTTP_1_0);
 	//add the data
 	reply.AddHeader(ADDRESS_HEADER,_local_address);
-	CServerConfig& conf = CEIBServer::GetInstance().GetConfig();
-	reply.AddHeader(DATA_PORT_HEADER,conf.GetListeningPort());
+	CServerConfigPtr conf = CEIBServer::GetInstance().GetConfig();
+	reply.AddHeader(DATA_PORT_HEADER,conf->GetListeningPort());
 
 	CDataBuffer raw_reply;
 	reply.Finalize(raw_reply);
-	raw_reply.Encrypt(&CEIBServer::GetInstance().GetConfig().GetInitialKey());
+	raw_reply.Encrypt(&CEIBServer::GetInstance().GetConfig()->GetInitialKey());
 	//send to reply over the network
 	LOG_DEBUG("[Send] Auto-Discovery search response to [%s:%d]", saddr.GetBuffer(), sport);
 	_broadcast_sock.SendTo(raw_reply.GetBuffer(), raw_reply.GetLength(), saddr, sport);
@@ -156,26 +352,33 @@ void CClientsMgr::Close()
 	//aquire lock
 	JTCSynchronized sync(*this);
 	
-	//close any active clients
-	map<int,CClientHandle>::iterator it;
+	//close any active clients (clients still in handshake are dropped by their worker)
+	ClientsTable::iterator it;
 	for(it = _clients.begin(); it != _clients.end(); ++it)
 	{
-		it->second->Close();
+		if(it->second->IsLoggedIn()){
+			it->second->Close();
+		}
 	}
 
 	_stop = true;
 }
 
-void CClientsMgr::InitClient(CString& source_address,int source_port,int keep_alive_port)
+CClientHandle CClientsMgr::InitClient(CString& source_address,int source_port,int keep_alive_port)
 {
 	JTCSynchronized sync(*this);
 
+	if(CEIBServer::GetInstance().GetConfig()->GetMaxConcurrentClients() <= (int)_clients.size()){
+		LOG_ERROR("[Clients Manager] Max clients exceeded. Refusing new client.");
+		return NULL;
+	}
+
 	CClientHandle Client = NULL;
 	START_TRY
 		Client = new CClient(GetSessionID());
 	END_TRY_START_CATCH_ANY
 		LOG_ERROR("Error during client init. insufficient memory");
-		return;
+		return NULL;
 	END_CATCH
 	
 	_clients.insert(pair<int,CClientHandle>(Client->GetSessionID(),Client));
@@ -184,13 +387,13 @@ void CClientsMgr::InitClient(CString& source_address,int source_port,int keep_al
 	CEIBServer::GetInstance().GetLog().SetConsoleColor(YELLOW);
 	LOG_INFO("[Clients Manager] New Client Initialized.");
 	CEIBServer::GetInstance().GetLog().SetConsoleColor(WHITE);
-	Client->start();
+	return Client;
 }
 
 bool CClientsMgr::IsOpenConnectionMessage(char* data, int length,CString& source_address,int& source_port,int& keep_alive_port)
 {
 	CDataBuffer raw_request(data,length);
-	raw_request.Decrypt(&CEIBServer::GetInstance().GetConfig().GetInitialKey());
+	raw_request.Decrypt(&CEIBServer::GetInstance().GetConfig()->GetInitialKey());
 	CHttpRequest request;
 
 	CHttpParser parser(request,raw_request);
@@ -219,11 +422,20 @@ void CClientsMgr::Disconnect(int session_id)
 {
 	JTCSynchronized sync(*this);
 	
-	map<int,CClientHandle>::iterator it = _clients.find(session_id);
+	ClientsTable::iterator it = _clients.find(session_id);
 	if(it == _clients.end()){
 		//log error
 		throw CEIBException(GeneralError,"Client not found");
 	}
+
+	pair<ClientsNameIndex::iterator,ClientsNameIndex::iterator> range = _clients_by_name.equal_range(it->second->GetName());
+	for(ClientsNameIndex::iterator name_it = range.first; name_it != range.second; ++name_it)
+	{
+		if(name_it->second == session_id){
+			_clients_by_name.erase(name_it);
+			break;
+		}
+	}
 	_clients.erase(it);
 }
 
@@ -235,7 +447,7 @@ void CClientsMgr::Brodcast(CCemi_L_Data_Frame& msg)
 		return;
 	}
 
-	map<int,CClientHandle>::iterator it;
+	ClientsTable::iterator it;
 	
 	for(it = _clients.begin(); it != _clients.end(); ++it)
 	{
@@ -262,14 +474,42 @@ int CClientsMgr::GetSessionID()
 {
 	while(true)
 	{
-		int session_id = rand();
-		
-		map<int,CClientHandle>::iterator it = _clients.find(session_id);
-				
-		if(it == _clients.end()){
+		//session ids are sent to the client and used to authenticate heartbeats - must not be predictable
+		unsigned int rnd = 0;
+		if(RAND_bytes((unsigned char*)&rnd,sizeof(rnd)) != 1){
+			throw CEIBException(GeneralError,"Cannot generate random session id");
+		}
+		int session_id = (int)(rnd & 0x7FFFFFFF);
+		if(session_id != 0 && _clients.find(session_id) == _clients.end()){
 			return session_id;
 		}
 	}
 	return -1;
 }
 
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CHandshakeWorker::CHandshakeWorker(CClientsMgr* mgr) : _mgr(mgr)
+{
+	this->setName("Client Handshake Thread");
+}
+
+CHandshakeWorker::~CHandshakeWorker()
+{
+}
+
+void CHandshakeWorker::run()
+{
+	HandshakeJob job;
+	while(_mgr->PopHandshakeJob(job))
+	{
+		bool ok = false;
+		START_TRY
+			ok = _mgr->ProcessHandshakeJob(job);
+		END_TRY_START_CATCH_ANY
+			LOG_ERROR("[Clients Manager] Unknown exception during handshake with [%s]",job._source_address.GetBuffer());
+		END_CATCH
+		_mgr->HandshakeDone(job,ok);
+	}
+}
@@ -1,35 +1,282 @@
 #include "CommandScheduler.h"
 #include "EIBServer.h"
+#include <math.h>
+#include <chrono>
+
+#define CRON_MAX_STEPS 100000
+
+static void LocalTime(time_t t, struct tm& res)
+{
+#ifdef WIN32
+	localtime_s(&res, &t);
+#else
+	localtime_r(&t, &res);
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// CCronExpression
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+CCronExpression::CCronExpression() :
+_minutes(0),
+_hours(0),
+_days(0),
+_months(0),
+_weekdays(0),
+_any_day(true),
+_any_weekday(true)
+{
+}
+
+bool CCronExpression::ParseField(const CString& field, int min_val, int max_val, uint64_t& mask)
+{
+	mask = 0;
+	CString rest(field);
+	while(rest.GetLength() > 0)
+	{
+		//take the next element of the comma separated list
+		CString item;
+		int comma = rest.FindFirstOf(',');
+		if(comma < 0){
+			item = rest;
+			rest.Clear();
+		}else{
+			item = rest.SubString(0, comma);
+			rest = rest.SubString(comma + 1, rest.GetLength() - comma - 1);
+		}
+
+		int step = 1;
+		int slash = item.FindFirstOf('/');
+		if(slash >= 0){
+			step = item.SubString(slash + 1, item.GetLength() - slash - 1).ToInt();
+			item = item.SubString(0, slash);
+			if(step <= 0){
+				return false;
+			}
+		}
+
+		int from, to;
+		int dash = item.FindFirstOf('-');
+		if(item == "*"){
+			from = min_val;
+			to = max_val;
+		}else if(dash > 0){
+			from = item.SubString(0, dash).ToInt();
+			to = item.SubString(dash + 1, item.GetLength() - dash - 1).ToInt();
+		}else if(item.GetLength() > 0 && isdigit((unsigned char)item[0])){
+			from = item.ToInt();
+			//"5/15" means from 5 to the end of the range
+			to = (slash >= 0) ? max_val : from;
+		}else{
+			return false;
+		}
+
+		if(from < min_val || to > max_val || from > to){
+			return false;
+		}
+		for(int i = from; i <= to; i += step){
+			mask |= ((uint64_t)1 << i);
+		}
+	}
+	return mask != 0;
+}
+
+bool CCronExpression::Parse(const CString& expr)
+{
+	CString fields[5];
+	int count = 0;
+	const char* p = expr.GetBuffer();
+	while(*p != '\0')
+	{
+		while(*p == ' ' || *p == '\t') ++p;
+		if(*p == '\0') break;
+		const char* start = p;
+		while(*p != '\0' && *p != ' ' && *p != '\t') ++p;
+		if(count == 5){
+			return false;
+		}
+		fields[count++] = CString(start, (int)(p - start));
+	}
+	if(count != 5){
+		return false;
+	}
+
+	if(!ParseField(fields[0], 0, 59, _minutes) ||
+	   !ParseField(fields[1], 0, 23, _hours) ||
+	   !ParseField(fields[2], 1, 31, _days) ||
+	   !ParseField(fields[3], 1, 12, _months) ||
+	   !ParseField(fields[4], 0, 7, _weekdays)){
+		return false;
+	}
+	//7 is sunday as well
+	if(_weekdays & ((uint64_t)1 << 7)){
+		_weekdays |= 1;
+	}
+	_any_day = (fields[2] == "*");
+	_any_weekday = (fields[4] == "*");
+	_expr = expr;
+	return true;
+}
+
+bool CCronExpression::IsDayMatch(const struct tm& tm) const
+{
+	bool day = (_days & ((uint64_t)1 << tm.tm_mday)) != 0;
+	bool weekday = (_weekdays & ((uint64_t)1 << tm.tm_wday)) != 0;
+	if(_any_day || _any_weekday){
+		return day && weekday;
+	}
+	return day || weekday;
+}
+
+time_t CCronExpression::Next(time_t after) const
+{
+	if(_minutes == 0){
+		return 0;
+	}
+
+	struct tm tm;
+	time_t t = after - (after % 60) + 60;
+	time_t limit = after + 5 * 366 * 24 * 3600;
+
+	//skip whole months / days / hours that cannot match
+	for(int i = 0; i < CRON_MAX_STEPS && t <= limit; ++i)
+	{
+		LocalTime(t, tm);
+		if(!(_months & ((uint64_t)1 << (tm.tm_mon + 1)))){
+			tm.tm_mon++;
+			tm.tm_mday = 1;
+			tm.tm_hour = 0;
+			tm.tm_min = 0;
+		}else if(!IsDayMatch(tm)){
+			tm.tm_mday++;
+			tm.tm_hour = 0;
+			tm.tm_min = 0;
+		}else if(!(_hours & ((uint64_t)1 << tm.tm_hour))){
+			tm.tm_hour++;
+			tm.tm_min = 0;
+		}else if(!(_minutes & ((uint64_t)1 << tm.tm_min))){
+			tm.tm_min++;
+		}else{
+			return t;
+		}
+		tm.tm_sec = 0;
+		tm.tm_isdst = -1;
+		time_t next = mktime(&tm);
+		//a skipped DST hour can map back to the same instant
+		t = (next > t) ? next : t + 60;
+	}
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// CSunCalculator
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#define DEG_TO_RAD(x) ((x) * M_PI / 180.0)
+#define RAD_TO_DEG(x) ((x) * 180.0 / M_PI)
+#define JULIAN_UNIX_EPOCH 2440587.5
+#define JULIAN_J2000 2451545.0
+
+bool CSunCalculator::GetSunTimes(time_t day, double latitude, double longitude, time_t& sunrise, time_t& sunset)
+{
+	//local noon of the requested day
+	struct tm tm;
+	LocalTime(day, tm);
+	tm.tm_hour = 12;
+	tm.tm_min = 0;
+	tm.tm_sec = 0;
+	tm.tm_isdst = -1;
+	time_t noon = mktime(&tm);
+
+	double jdate = (double)noon / 86400.0 + JULIAN_UNIX_EPOCH;
+	double n = floor(jdate - JULIAN_J2000 + 0.0008 + 0.5);
+	//mean solar noon
+	double j_star = n - longitude / 360.0;
+	//solar mean anomaly
+	double m = fmod(357.5291 + 0.98560028 * j_star, 360.0);
+	//equation of the center
+	double c = 1.9148 * sin(DEG_TO_RAD(m)) + 0.0200 * sin(DEG_TO_RAD(2 * m)) + 0.0003 * sin(DEG_TO_RAD(3 * m));
+	//ecliptic longitude
+	double lambda = fmod(m + c + 180.0 + 102.9372, 360.0);
+	double j_transit = JULIAN_J2000 + j_star + 0.0053 * sin(DEG_TO_RAD(m)) - 0.0069 * sin(DEG_TO_RAD(2 * lambda));
+	//declination of the sun
+	double sin_d = sin(DEG_TO_RAD(lambda)) * sin(DEG_TO_RAD(23.4397));
+	double cos_d = cos(asin(sin_d));
+	//hour angle (-0.833 degrees accounts for refraction and the solar disc)
+	double cos_w = (sin(DEG_TO_RAD(-0.833)) - sin(DEG_TO_RAD(latitude)) * sin_d) / (cos(DEG_TO_RAD(latitude)) * cos_d);
+	if(cos_w < -1.0 || cos_w > 1.0){
+		return false;
+	}
+	double w = RAD_TO_DEG(acos(cos_w));
+
+	sunrise = (time_t)floor(((j_transit - w / 360.0) - JULIAN_UNIX_EPOCH) * 86400.0 + 0.5);
+	sunset = (time_t)floor(((j_transit + w / 360.0) - JULIAN_UNIX_EPOCH) * 86400.0 + 0.5);
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// CCommandScheduler
+//////////////////////////////////////////////////////////////////////////////////////////////
 
 CCommandScheduler::CCommandScheduler() :
 _stop(false),
-_schedule(ScheduledCommandComparison())
+_schedule(ScheduledCommandComparison()),
+_next_id(1),
+_has_location(false),
+_latitude(0),
+_longitude(0),
+_journal(NULL),
+_journal_dead(0)
 {
 	this->setName("CommandScheduler");
 }
 
 CCommandScheduler::~CCommandScheduler()
 {
+	if(_journal != NULL){
+		fclose(_journal);
+	}
+}
+
+static int64_t NowMillis()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
 }
 
 void CCommandScheduler::run()
 {
-	CTime time_count;
-	time_count.SetNow();
-	time_count += 60;
+	vector<ScheduledCommand> due;
 
 	while(!_stop)
 	{
-		if(time_count.SecondsTo() == 0){
-			CheckForScheduledCommand();
-			time_count.SetNow();
-			time_count += 60;
+		due.clear();
+		CollectDueCommands(time(NULL), due);
+		if(!due.empty()){
+			SendToEIB(due);
 		}
 
-		// Sleep briefly to avoid busy-waiting
 		JTCSynchronized sync(*this);
+		if(_stop){
+			break;
+		}
+		//sleep until the next command is due (to the millisecond) or until a new one is added
+		int64_t wait_ms = SCHEDULER_MAX_WAIT_MS;
+		time_t next = GetNextDueTime();
+		if(!_unsent.empty()){
+			wait_ms = SCHEDULER_RETRY_MS;
+		}else if(next != 0){
+			wait_ms = (int64_t)next * 1000 - NowMillis();
+			if(wait_ms > SCHEDULER_MAX_WAIT_MS){
+				wait_ms = SCHEDULER_MAX_WAIT_MS;
+			}
+		}
+		if(wait_ms <= 0){
+			continue;
+		}
 		try {
-			this->wait(1000);
+			this->wait((long)wait_ms);
 		} catch (...) {
 		}
 	}
@@ -42,68 +289,381 @@ void CCommandScheduler::Close()
 	this->notify();
 }
 
-void CCommandScheduler::CheckForScheduledCommand()
+void CCommandScheduler::SetLocation(double latitude, double longitude)
 {
 	JTCSynchronized sync(*this);
+	_latitude = latitude;
+	_longitude = longitude;
+	_has_location = true;
+}
 
-	if(_schedule.empty()){
-		return;
+bool CCommandScheduler::ComputeNextTime(ScheduledCommand& cmd, time_t after, CString& err_str)
+{
+	switch(cmd._type)
+	{
+	case SCHEDULE_ONCE:
+		if(cmd._time.GetTime() <= after){
+			err_str += "Cannot schedule task in the past. a Time Machine should be used instead.";
+			return false;
+		}
+		return true;
+	case SCHEDULE_CRON:
+		{
+			CCronExpression cron;
+			if(!cron.Parse(cmd._cron)){
+				err_str += "Invalid cron expression";
+				return false;
+			}
+			time_t next = cron.Next(after);
+			if(next == 0){
+				err_str += "Cron expression never matches";
+				return false;
+			}
+			cmd._time.SetTime(next);
+			return true;
+		}
+	case SCHEDULE_SUNRISE:
+	case SCHEDULE_SUNSET:
+		{
+			if(!_has_location){
+				err_str += "Sunrise/sunset commands require LOCATION in the server configuration";
+				return false;
+			}
+			//look at most a year ahead (polar night / day)
+			for(int day = -1; day <= 366; ++day)
+			{
+				time_t sunrise, sunset;
+				if(!CSunCalculator::GetSunTimes(after + day * 86400, _latitude, _longitude, sunrise, sunset)){
+					continue;
+				}
+				time_t t = ((cmd._type == SCHEDULE_SUNRISE) ? sunrise : sunset) + cmd._offset * 60;
+				if(t > after){
+					cmd._time.SetTime(t);
+					return true;
+				}
+			}
+			err_str += "The sun does not rise/set at the configured location";
+			return false;
+		}
+	}
+	err_str += "Unknown schedule type";
+	return false;
+}
+
+bool CCommandScheduler::AddScheduledCommand(const CTime& time,
+										const CEibAddress& dst,
+										unsigned char* value,
+										unsigned char val_len,
+										CString& err_str)
+{
+	return ScheduleCommand(ScheduledCommand(time,dst,value,val_len), err_str) != 0;
+}
+
+unsigned int CCommandScheduler::ScheduleCommand(const ScheduledCommand& cmd, CString& err_str)
+{
+	JTCSynchronized sync(*this);
+
+	ScheduledCommand job(cmd);
+	if(!ComputeNextTime(job, time(NULL), err_str)){
+		return 0;
+	}
+	job._id = _next_id++;
+
+	_jobs.insert(pair<unsigned int, ScheduledCommand>(job._id, job));
+	_schedule.push(job);
+	JournalAdd(job);
+
+	//the new command may be due before the one the thread is waiting for
+	this->notify();
+	return job._id;
+}
+
+bool CCommandScheduler::CancelScheduledCommand(unsigned int id)
+{
+	JTCSynchronized sync(*this);
+
+	//the heap entry is dropped when it reaches the top
+	if(_jobs.erase(id) == 0){
+		return false;
+	}
+	JournalRemove(id);
+	return true;
+}
+
+bool CCommandScheduler::GetScheduledCommand(unsigned int id, ScheduledCommand& cmd)
+{
+	JTCSynchronized sync(*this);
+
+	map<unsigned int, ScheduledCommand>::iterator it = _jobs.find(id);
+	if(it == _jobs.end()){
+		return false;
+	}
+	cmd = it->second;
+	return true;
+}
+
+int CCommandScheduler::GetNumScheduledCommands()
+{
+	JTCSynchronized sync(*this);
+	return (int)_jobs.size();
+}
+
+time_t CCommandScheduler::GetNextDueTime()
+{
+	JTCSynchronized sync(*this);
+
+	while(!_schedule.empty())
+	{
+		const ScheduledCommand& top = _schedule.top();
+		map<unsigned int, ScheduledCommand>::iterator it = _jobs.find(top._id);
+		//skip cancelled commands and stale entries of rescheduled ones
+		if(it == _jobs.end() || it->second._time != top._time){
+			_schedule.pop();
+			continue;
+		}
+		return top._time.GetTime();
 	}
+	return 0;
+}
 
-	ScheduledCommand cmd = _schedule.top();
-	CTime t;
-	t.SetNow();
+int CCommandScheduler::CollectDueCommands(time_t now, vector<ScheduledCommand>& due)
+{
+	JTCSynchronized sync(*this);
 
-	while(cmd._time <= t)
+	int count = 0;
+	time_t next;
+	while((next = GetNextDueTime()) != 0 && next <= now)
 	{
+		ScheduledCommand cmd = _schedule.top();
 		_schedule.pop();
-		SendToEIB(cmd._dst, cmd._value, cmd._value_len);
-		if(_schedule.empty()){
-			return;
+		due.push_back(cmd);
+		++count;
+
+		map<unsigned int, ScheduledCommand>::iterator it = _jobs.find(cmd._id);
+		CString err;
+		if(cmd._type != SCHEDULE_ONCE && ComputeNextTime(it->second, now, err)){
+			_schedule.push(it->second);
+		}else{
+			_jobs.erase(it);
+			JournalRemove(cmd._id);
 		}
-		cmd = _schedule.top();
 	}
+	return count;
 }
 
-void CCommandScheduler::SendToEIB(const CEibAddress& dst, unsigned char* value, unsigned char value_len)
+void CCommandScheduler::SendToEIB(vector<ScheduledCommand>& cmds)
 {
 	START_TRY
 		CEIBInterface& iface = CEIBServer::GetInstance().GetEIBInterface();
 
-		CCemi_L_Data_Frame msg;
-		msg.SetMessageControl(L_DATA_REQ);
-		msg.SetAddilLength(0);
-		msg.SetCtrl1(0);
-		msg.SetCtrl2(6);
-		msg.SetPriority(PRIORITY_NORMAL);
-		msg.SetFrameFormatStandard();
-		msg.SetSrcAddress(CEibAddress());
-		msg.SetDestAddress(dst);
-		msg.SetValue(value, value_len);
-
-		iface.GetOutputHandler()->Write(msg, NON_BLOCKING, NULL);
-		LOG_DEBUG("[Scheduler] Sent scheduled command to %s", dst.ToString().GetBuffer());
+		//commands left over from the previous round go first
+		vector<ScheduledCommand> pending;
+		{
+			JTCSynchronized sync(*this);
+			pending.swap(_unsent);
+		}
+		pending.insert(pending.end(), cmds.begin(), cmds.end());
+
+		vector<CCemi_L_Data_Frame> frames;
+		frames.reserve(pending.size());
+		vector<ScheduledCommand>::iterator it;
+		for(it = pending.begin(); it != pending.end(); ++it)
+		{
+			CCemi_L_Data_Frame msg;
+			msg.SetMessageControl(L_DATA_REQ);
+			msg.SetAddilLength(0);
+			msg.SetCtrl1(0);
+			msg.SetCtrl2(6);
+			msg.SetPriority(PRIORITY_NORMAL);
+			msg.SetFrameFormatStandard();
+			msg.SetSrcAddress(CEibAddress());
+			msg.SetDestAddress(it->_dst);
+			msg.SetValue(it->_value, it->_value_len);
+			frames.push_back(msg);
+		}
+
+		//one enqueue for everything that is due
+		int sent = iface.GetOutputHandler()->Write(frames, NON_BLOCKING);
+		LOG_DEBUG("[Scheduler] Sent %d scheduled commands", sent);
+		if(sent < (int)pending.size()){
+			JTCSynchronized sync(*this);
+			_unsent.assign(pending.begin() + sent, pending.end());
+			LOG_DEBUG("[Scheduler] Output queue full. %d commands deferred", (int)_unsent.size());
+		}
 	END_TRY_START_CATCH(e)
 		LOG_ERROR("[Scheduler] Failed to send scheduled command: %s", e.what());
 	END_CATCH
 }
 
-bool CCommandScheduler::AddScheduledCommand(const CTime& time,
-										const CEibAddress& dst,
-										unsigned char* value,
-										unsigned char val_len,
-										CString& err_str)
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Journal
+//
+// One record per line:
+//   A <id> <type> <time> <address> <is group> <offset> <value hex> [<cron expression>]
+//   R <id>
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+bool CCommandScheduler::Init(const CString& journal_file)
 {
 	JTCSynchronized sync(*this);
 
-	CTime t;
-	t.SetNow();
-	if(time <= t){
-		err_str += "Cannot schedule task in the past. a Time Machine should be used instead.";
-		return false;
+	if(_journal != NULL){
+		fclose(_journal);
+		_journal = NULL;
 	}
+	_journal_file = journal_file;
+	Replay();
+	//rewrite the journal with the live commands only, then keep appending to it
+	CompactJournal();
+	return _journal != NULL;
+}
 
-	_schedule.push(ScheduledCommand(time,dst,value,val_len));
+void CCommandScheduler::Replay()
+{
+	FILE* f = fopen(_journal_file.GetBuffer(), "r");
+	if(f == NULL){
+		return;
+	}
 
-	return true;
+	map<unsigned int, ScheduledCommand> jobs;
+	char line[512];
+	while(fgets(line, sizeof(line), f) != NULL)
+	{
+		line[strcspn(line, "\r\n")] = '\0';
+		unsigned int id = 0;
+		if(line[0] == 'R' && sscanf(line + 1, "%u", &id) == 1){
+			jobs.erase(id);
+			continue;
+		}
+		if(line[0] != 'A'){
+			continue;
+		}
+
+		ScheduledCommand cmd;
+		int type, is_group, offset, consumed = 0;
+		long long t;
+		unsigned int address;
+		//wider than any valid value, so a long token is rejected instead of cut
+		char value_hex[64];
+		if(sscanf(line + 1, "%u %d %lld %u %d %d %63s%n", &id, &type, &t, &address, &is_group, &offset, value_hex, &consumed) < 7){
+			continue;
+		}
+		//"-" stands for an empty value. a damaged value skips the record like any other unreadable line
+		size_t hex_len = strcmp(value_hex, "-") == 0 ? 0 : strlen(value_hex);
+		if(hex_len % 2 != 0 || hex_len > 2 * MAX_EIB_VALUE_LEN){
+			continue;
+		}
+		bool valid = true;
+		for(size_t i = 0; i < hex_len / 2 && valid; ++i){
+			unsigned int byte;
+			valid = sscanf(value_hex + 2 * i, "%2x", &byte) == 1;
+			if(valid){
+				cmd._value[i] = (unsigned char)byte;
+			}
+		}
+		if(!valid){
+			continue;
+		}
+		cmd._id = id;
+		cmd._type = (ScheduleType)type;
+		cmd._time.SetTime((time_t)t);
+		cmd._dst = CEibAddress(address, is_group != 0);
+		cmd._offset = offset;
+		cmd._value_len = (unsigned char)(hex_len / 2);
+		if(cmd._type == SCHEDULE_CRON){
+			CString cron(line + 1 + consumed);
+			cron.Trim();
+			cmd._cron = cron;
+		}
+		jobs[id] = cmd;
+	}
+	fclose(f);
+
+	time_t now = time(NULL);
+	map<unsigned int, ScheduledCommand>::iterator it;
+	for(it = jobs.begin(); it != jobs.end(); ++it)
+	{
+		ScheduledCommand& cmd = it->second;
+		if(cmd._id >= _next_id){
+			_next_id = cmd._id + 1;
+		}
+		CString err;
+		if(cmd._type == SCHEDULE_ONCE && cmd._time.GetTime() <= now){
+			LOG_INFO("[Scheduler] Dropping command %u to %s: it was due while the server was down", cmd._id, cmd._dst.ToString().GetBuffer());
+			continue;
+		}
+		//recurring commands continue from now
+		if(!ComputeNextTime(cmd, now, err)){
+			LOG_ERROR("[Scheduler] Dropping command %u: %s", cmd._id, err.GetBuffer());
+			continue;
+		}
+		_jobs[cmd._id] = cmd;
+		_schedule.push(cmd);
+	}
+}
+
+static void WriteJournalRecord(FILE* f, const ScheduledCommand& cmd)
+{
+	CString value = CString::ToHexFormat((const char*)cmd._value, cmd._value_len, false);
+	fprintf(f, "A %u %d %lld %u %d %d %s", cmd._id, (int)cmd._type, (long long)cmd._time.GetTime(),
+		(unsigned int)cmd._dst.ToByteArray(), cmd._dst.IsGroupAddress() ? 1 : 0, cmd._offset,
+		value.GetLength() > 0 ? value.GetBuffer() : "-");
+	if(cmd._type == SCHEDULE_CRON){
+		fprintf(f, " %s", cmd._cron.GetBuffer());
+	}
+	fprintf(f, "\n");
+}
+
+void CCommandScheduler::CompactJournal()
+{
+	if(_journal_file.GetLength() == 0){
+		return;
+	}
+	if(_journal != NULL){
+		fclose(_journal);
+		_journal = NULL;
+	}
+
+	//write the live commands to a new file and atomically replace the old one
+	CString tmp_file = _journal_file + ".tmp";
+	FILE* f = fopen(tmp_file.GetBuffer(), "w");
+	if(f == NULL){
+		LOG_ERROR("[Scheduler] Cannot write journal file %s", tmp_file.GetBuffer());
+		return;
+	}
+	map<unsigned int, ScheduledCommand>::iterator it;
+	for(it = _jobs.begin(); it != _jobs.end(); ++it){
+		WriteJournalRecord(f, it->second);
+	}
+	fclose(f);
+	if(rename(tmp_file.GetBuffer(), _journal_file.GetBuffer()) != 0){
+		LOG_ERROR("[Scheduler] Cannot replace journal file %s", _journal_file.GetBuffer());
+	}
+
+	_journal_dead = 0;
+	_journal = fopen(_journal_file.GetBuffer(), "a");
+}
+
+void CCommandScheduler::JournalAdd(const ScheduledCommand& cmd)
+{
+	if(_journal == NULL){
+		return;
+	}
+	WriteJournalRecord(_journal, cmd);
+	fflush(_journal);
+}
+
+void CCommandScheduler::JournalRemove(unsigned int id)
+{
+	if(_journal == NULL){
+		return;
+	}
+	fprintf(_journal, "R %u\n", id);
+	fflush(_journal);
+
+	//an add and a remove record per finished command
+	_journal_dead += 2;
+	if(_journal_dead > 1024 && _journal_dead > 2 * (int)_jobs.size()){
+		CompactJournal();
+	}
 }
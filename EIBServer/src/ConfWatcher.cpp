@@ -0,0 +1,159 @@
+#include "ConfWatcher.h"
+#include "EIBServer.h"
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+static time_t GetModificationTime(const CString& file_name)
+{
+	struct stat st;
+	if(stat(file_name.GetBuffer(), &st) != 0){
+		return 0;
+	}
+	return st.st_mtime;
+}
+
+CConfWatcher::CConfWatcher() :
+_stop(false),
+_fd(-1),
+_wd(-1),
+_conf_mtime(0),
+_users_mtime(0)
+{
+	this->setName("Configuration Watcher");
+}
+
+CConfWatcher::~CConfWatcher()
+{
+	Release();
+}
+
+bool CConfWatcher::Open()
+{
+	CString folder(CURRENT_CONF_FOLDER);
+	_conf_mtime = GetModificationTime(folder + DEFAULT_CONF_FILE_NAME);
+	_users_mtime = GetModificationTime(folder + DEFAULT_USERS_DB_FILE);
+
+#ifdef __linux__
+	_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(_fd < 0){
+		return false;
+	}
+	//editors usually write a temporary file and rename it over the original
+	_wd = inotify_add_watch(_fd, folder.GetBuffer(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if(_wd < 0){
+		Release();
+		return false;
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+void CConfWatcher::Release()
+{
+#ifdef __linux__
+	if(_fd >= 0){
+		close(_fd);
+	}
+#endif
+	_fd = -1;
+	_wd = -1;
+}
+
+void CConfWatcher::run()
+{
+	if(!Open()){
+		LOG_INFO("[Conf Watcher] inotify not available. Polling configuration files for changes.");
+	}
+
+	CEIBServer& server = CEIBServer::GetInstance();
+	while(!_stop)
+	{
+		bool conf_changed = false, users_changed = false;
+		if(!WaitForChanges(CONF_WATCHER_POLL_MS, conf_changed, users_changed)){
+			continue;
+		}
+		//a save usually produces several events. reload once the file is quiet
+		while(!_stop && WaitForChanges(CONF_WATCHER_SETTLE_MS, conf_changed, users_changed));
+		if(_stop){
+			break;
+		}
+
+		if(conf_changed){
+			LOG_INFO("[Conf Watcher] %s changed on disk.", DEFAULT_CONF_FILE_NAME);
+			server.ReloadServerConfig();
+		}
+		if(users_changed){
+			LOG_INFO("[Conf Watcher] %s changed on disk.", DEFAULT_USERS_DB_FILE);
+			server.ReloadUsersDB();
+		}
+	}
+
+	Release();
+}
+
+void CConfWatcher::Close()
+{
+	_stop = true;
+}
+
+bool CConfWatcher::WaitForChanges(int timeout, bool& conf_changed, bool& users_changed)
+{
+#ifdef __linux__
+	if(_fd >= 0)
+	{
+		struct pollfd pfd;
+		pfd.fd = _fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if(poll(&pfd, 1, timeout) <= 0){
+			return false;
+		}
+
+		bool changed = false;
+		char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+		int len;
+		while((len = (int)read(_fd, buf, sizeof(buf))) > 0)
+		{
+			for(char* p = buf; p < buf + len; p += sizeof(struct inotify_event) + ((struct inotify_event*)p)->len)
+			{
+				struct inotify_event* ev = (struct inotify_event*)p;
+				if(ev->len == 0){
+					continue;
+				}
+				if(strcmp(ev->name, DEFAULT_CONF_FILE_NAME) == 0){
+					conf_changed = changed = true;
+				}else if(strcmp(ev->name, DEFAULT_USERS_DB_FILE) == 0){
+					users_changed = changed = true;
+				}
+			}
+		}
+		return changed;
+	}
+#endif
+	return PollModificationTimes(timeout, conf_changed, users_changed);
+}
+
+bool CConfWatcher::PollModificationTimes(int timeout, bool& conf_changed, bool& users_changed)
+{
+	JTCThread::sleep(timeout);
+
+	CString folder(CURRENT_CONF_FOLDER);
+	bool changed = false;
+	time_t mtime = GetModificationTime(folder + DEFAULT_CONF_FILE_NAME);
+	if(mtime != _conf_mtime){
+		_conf_mtime = mtime;
+		conf_changed = changed = true;
+	}
+	mtime = GetModificationTime(folder + DEFAULT_USERS_DB_FILE);
+	if(mtime != _users_mtime){
+		_users_mtime = mtime;
+		users_changed = changed = true;
+	}
+	return changed;
+}
@@ -2,7 +2,7 @@
 #include "EIBServer.h"
 #include "WebHandler.h"
 
-CDispatcher::CDispatcher() : _port(0)
+CDispatcher::CDispatcher() : _stop(false), _port(0)
 {
 }
 
@@ -12,11 +12,11 @@ CDispatcher::~CDispatcher()
 
 void CDispatcher::Init()
 {
-	CServerConfig& conf = CEIBServer::GetInstance().GetConfig();
-	_port = conf.GetWEBServerPort();
+	CServerConfigPtr conf = CEIBServer::GetInstance().GetConfig();
+	_port = conf->GetWEBServerPort();
 
-	const CString& cert = conf.GetTLSCertFile();
-	const CString& key  = conf.GetTLSKeyFile();
+	const CString& cert = conf->GetTLSCertFile();
+	const CString& key  = conf->GetTLSKeyFile();
 
 	if (cert.GetLength() == 0 || key.GetLength() == 0) {
 		throw CEIBException(GeneralError,
@@ -39,8 +39,8 @@ void CDispatcher::Init()
 	RegisterRoutes();
 
 	// Static file mount points
-	CString www_root = conf.GetWwwRoot();
-	CString images_folder = conf.GetImagesFolder();
+	CString www_root = conf->GetWwwRoot();
+	CString images_folder = conf->GetImagesFolder();
 
 	if (www_root.GetLength() > 0) {
 		_server->set_mount_point("/", www_root.GetBuffer());
@@ -84,6 +84,25 @@ void CDispatcher::Start()
 	_listen_thread = std::thread([this]() {
 		_server->listen("0.0.0.0", _port);
 	});
+	_housekeeping_thread = std::thread(&CDispatcher::Housekeeping, this);
+}
+
+void CDispatcher::Housekeeping()
+{
+	// Advance the web session timer wheel once a second
+	std::unique_lock<std::mutex> lock(_housekeeping_mutex);
+	while (!_stop) {
+		_housekeeping_cv.wait_for(lock, std::chrono::seconds(1));
+		if (_stop) {
+			break;
+		}
+		lock.unlock();
+		int expired = CWebHandler::ExpireSessions();
+		if (expired > 0) {
+			LOG_DEBUG("[Dispatcher] %d idle web sessions expired.", expired);
+		}
+		lock.lock();
+	}
 }
 
 void CDispatcher::Close()
@@ -94,4 +113,12 @@ void CDispatcher::Close()
 	if (_listen_thread.joinable()) {
 		_listen_thread.join();
 	}
+	{
+		std::lock_guard<std::mutex> lock(_housekeeping_mutex);
+		_stop = true;
+	}
+	_housekeeping_cv.notify_all();
+	if (_housekeeping_thread.joinable()) {
+		_housekeeping_thread.join();
+	}
 }
@@ -2,7 +2,7 @@
 #include "EIBServer.h"
 
 CEIBHandler::CEIBHandler(HANDLER_TYPE type) : 
-JTCThread("EIB Handler"),
+JTCThread(type == INPUT_HANDLER ? "EIB Input Handler" : "EIB Output Handler"),
 _type(type),
 _stop(false),
 _pause(false)
@@ -49,7 +49,10 @@ void CEIBHandler::RunEIBReader()
 				unsigned char value_of_pkt[MAX_EIB_VALUE_LEN];
 				msg.FillBufferWithFrameData(value_of_pkt,MAX_EIB_VALUE_LEN);
 			
-				stats_db.AddRecord(msg.GetDestAddress(),value_of_pkt,msg.GetValueLength());
+				//frames carry their receive time. the fallback uses the same precise clocks so the stats gaps never mix in the coarse one
+				const CTimeStamp& time_stamp = msg.GetTimeStamp();
+				stats_db.AddRecord(msg.GetDestAddress(),value_of_pkt,msg.GetValueLength(),
+								   time_stamp.IsZero() ? CTimeStamp::Now() : time_stamp);
 				//forward packet to all connected clients (i.e. WEBServer, SMSServer etc.)
 				c_mgr->Brodcast(msg);
 			}
@@ -96,6 +99,28 @@ void CEIBHandler::Write(const CCemi_L_Data_Frame& data, BlockingMode mode, JTCMo
 	}
 }
 
+int CEIBHandler::Write(const vector<CCemi_L_Data_Frame>& frames, BlockingMode mode)
+{
+	JTCSynchronized _sync(*this);
+	int count = 0;
+	KnxElementQueue elem;
+	elem._mode = mode;
+	elem._optional_mon = NULL;
+	vector<CCemi_L_Data_Frame>::const_iterator it;
+	for(it = frames.begin(); it != frames.end(); ++it)
+	{
+		elem._frame = *it;
+		if(!_buffer.Write(elem)){
+			break;
+		}
+		++count;
+	}
+	if(count > 0){
+		this->notify();
+	}
+	return count;
+}
+
 void CEIBHandler::RunEIBWriter()
 {
 	KnxElementQueue msg2write;
@@ -1,5 +1,6 @@
 #include "EIBInterface.h"
 #include "EIBServer.h"
+#include "StringTokenizer.h"
 
 CEIBInterface::CEIBInterface() : 
 _mode(UNDEFINED_MODE),
@@ -29,9 +30,58 @@ CEIBInterface::~CEIBInterface()
 
 void CEIBInterface::Start()
 {
+	CServerConfigPtr conf = CEIBServer::GetInstance().GetConfig();
 	//start EIB handlres
-	_input_handler->start();
-	_output_handler->start();
+	StartHandler(_input_handler.get(), conf->GetEibInputCpuAffinity());
+	StartHandler(_output_handler.get(), conf->GetEibOutputCpuAffinity());
+}
+
+void CEIBInterface::StartHandler(CEIBHandler* handler, const CString& cpu_list)
+{
+	CServerConfigPtr conf = CEIBServer::GetInstance().GetConfig();
+	if(conf->GetEibHandlerStackSize() > 0){
+		handler->setStackSize(conf->GetEibHandlerStackSize() * 1024);
+	}
+	handler->start();
+
+	//affinity & policy are applied to the running thread. the handler works without them
+	CString cpus_str(cpu_list);
+	cpus_str.Trim();
+	cpus_str.ToLower();
+	if(!cpus_str.IsEmpty() && cpus_str != "none"){
+		vector<int> cpus;
+		StringTokenizer tok(cpus_str, ",");
+		while(tok.HasMoreTokens()){
+			cpus.push_back(tok.NextIntToken());
+		}
+		START_TRY
+			handler->setAffinity(&cpus[0], (int)cpus.size());
+			LOG_INFO("%s pinned to cpu(s) %s", handler->getName(), cpus_str.GetBuffer());
+		END_TRY_START_CATCH_JTC(e)
+			LOG_ERROR("Cannot set cpu affinity \"%s\" of %s: %s", cpus_str.GetBuffer(), handler->getName(), e.getMessage());
+		END_CATCH
+	}
+
+	CString policy_str = conf->GetEibHandlerSchedPolicy();
+	policy_str.Trim();
+	policy_str.ToUpper();
+	JTCThread::SchedPolicy policy;
+	if(policy_str == "FIFO"){
+		policy = JTCThread::JTC_SCHED_FIFO;
+	}else if(policy_str == "RR"){
+		policy = JTCThread::JTC_SCHED_RR;
+	}else{
+		if(policy_str != "OTHER"){
+			LOG_ERROR("Unknown scheduling policy \"%s\". Using OTHER.", policy_str.GetBuffer());
+		}
+		return;
+	}
+	START_TRY
+		handler->setSchedPolicy(policy, conf->GetEibHandlerSchedPriority());
+		LOG_INFO("%s runs with scheduling policy %s, priority %d", handler->getName(), policy_str.GetBuffer(), conf->GetEibHandlerSchedPriority());
+	END_TRY_START_CATCH_JTC(e)
+		LOG_ERROR("Cannot set scheduling policy %s of %s: %s", policy_str.GetBuffer(), handler->getName(), e.getMessage());
+	END_CATCH
 }
 
 IConnection* CEIBInterface::GetConnection()
@@ -59,9 +109,9 @@ void CEIBInterface::Close()
 
 void CEIBInterface::Init()
 {
-	CServerConfig& conf = CEIBServer::GetInstance().GetConfig();
+	CServerConfigPtr conf = CEIBServer::GetInstance().GetConfig();
 	
-	CString device_mode = conf.GetEibDeviceMode();
+	CString device_mode = conf->GetEibDeviceMode();
 	device_mode.ToUpper();
 	//read device mode from conf file
 	if (device_mode == EIB_DEVICE_MODE_ROUTING_STR){
@@ -74,7 +124,7 @@ void CEIBInterface::Init()
 
 	
 	//read the if name from conf file and get the ip address of the card
-	CString local_address(Socket::LocalAddress(conf.GetEibLocalInterface()));
+	CString local_address(Socket::LocalAddress(conf->GetEibLocalInterface()));
 	bool result = false;
 	//initialize
 	if(_connection != NULL){
@@ -9,12 +9,16 @@ CSingletonProcess(EIB_SERVER_PROCESS_NAME),
 _clients_mgr(NULL),
 _dispatcher(NULL),
 _scheduler(NULL),
-_interface(NULL)
+_interface(NULL),
+_conf_watcher(NULL),
+//the configuration loaded at startup is a member. it is not owned by the pointer
+_current_conf(CServerConfigPtr(), &_conf)
 {
 	_interface = new CEIBInterface();
 	_clients_mgr = new CClientsMgr();
 	_dispatcher = new CDispatcher();
 	_scheduler = new CCommandScheduler();
+	_conf_watcher = new CConfWatcher();
 }
 
 // Note: _dispatcher is now a raw pointer (not JTC handle) since
@@ -28,9 +32,16 @@ CEIBServer::~CEIBServer()
 
 void CEIBServer::Close()
 {
-	if(_conf.GetLoadOK()) {
+	//stop watching before the files below are written
+	if(_conf_watcher->isAlive()){
+		_conf_watcher->Close();
+		_conf_watcher->join();
+	}
+
+	CServerConfigPtr conf = GetConfig();
+	if(conf->GetLoadOK()) {
 		LOG_INFO("Saving Configuration file...");
-		_conf.Save(DEFAULT_CONF_FILE_NAME);
+		conf->Save(DEFAULT_CONF_FILE_NAME);
 	}
 
 	LOG_INFO("Saving Users database...");
@@ -82,6 +93,10 @@ void CEIBServer::Start()
 	_dispatcher->Start();
 	//start command scheduler
 	_scheduler->start();
+	//reload EIB.conf & Users.db when they change
+	if(_conf.GetAutoReloadConf()){
+		_conf_watcher->start();
+	}
 
 	CTime t;
 	CString time_str = t.Format();
@@ -107,6 +122,10 @@ bool CEIBServer::Init()
 		//load configuration from file
 		_conf.Load(DEFAULT_CONF_FILE_NAME);
 		_log.SetLogLevel((LogLevel)_conf.GetLogLevel());
+		//applies to every thread started from now on
+		if(_conf.GetThreadStackSize() > 0){
+			JTCThread::setDefaultStackSize(_conf.GetThreadStackSize() * 1024);
+		}
 		LOG_INFO("Reading Configuration file...Successful.");
 	END_TRY_START_CATCH(e)
 		LOG_ERROR("Reading Configuration file... Failed: %s", e.what());
@@ -145,6 +164,26 @@ bool CEIBServer::Init()
 		_log.SetConsoleColor(WHITE);
 	END_CATCH
 
+	START_TRY
+		//restore scheduled commands
+		CString location(_conf.GetLocation());
+		int comma = location.FindFirstOf(',');
+		if(comma > 0){
+			double latitude = atof(location.SubString(0, comma).GetBuffer());
+			double longitude = atof(location.SubString(comma + 1, location.GetLength() - comma - 1).GetBuffer());
+			_scheduler->SetLocation(latitude, longitude);
+		}else if(location != "none"){
+			LOG_ERROR("Invalid LOCATION \"%s\" (expected \"latitude,longitude\"). Sunrise/sunset commands are disabled.", location.GetBuffer());
+		}
+		if(_scheduler->Init(CURRENT_CONF_FOLDER + CString(SCHEDULER_JOURNAL_FILE))){
+			LOG_INFO("Initializing Command scheduler...Successful. (%d scheduled commands)", _scheduler->GetNumScheduledCommands());
+		}else{
+			LOG_ERROR("Initializing Command scheduler...Failed: cannot open the journal. Scheduled commands will not survive a restart.");
+		}
+	END_TRY_START_CATCH(e)
+		LOG_ERROR("Initializing Command scheduler...Failed: %s", e.what());
+	END_CATCH
+
 	START_TRY
 		//initialize clients manager module
 		_clients_mgr->Init();
@@ -183,23 +222,42 @@ bool CEIBServer::Init()
 
 void CEIBServer::ReloadConfiguration()
 {
+	ReloadServerConfig();
+	ReloadUsersDB();
+}
+
+void CEIBServer::ReloadServerConfig()
+{
+	std::lock_guard<std::mutex> lock(_reload_lock);
+
+	CServerConfigPtr conf = std::make_shared<CServerConfig>();
 	START_TRY
 		//load configuration from file
-		_conf.Load(DEFAULT_CONF_FILE_NAME);
-		_log.SetLogLevel((LogLevel)_conf.GetLogLevel());
-		LOG_INFO("Reloading Configuration file...Successful.");
+		conf->Load(DEFAULT_CONF_FILE_NAME);
 	END_TRY_START_CATCH(e)
 		LOG_ERROR("Reloading Configuration file...Failed: %s",e.what());
+		return;
 	END_CATCH
 
+	//readers still holding the previous version keep it alive until they are done
+	std::atomic_store(&_current_conf, conf);
+	_log.SetLogLevel((LogLevel)conf->GetLogLevel());
+	LOG_INFO("Reloading Configuration file...Successful.");
+}
+
+void CEIBServer::ReloadUsersDB()
+{
+	std::lock_guard<std::mutex> lock(_reload_lock);
+
 	START_TRY
-		//initializing users db
+		//parse into a separate database. the live one is replaced only if the file is valid
 		CString file_name(CURRENT_CONF_FOLDER);
 		file_name += DEFAULT_USERS_DB_FILE;
-		_users_db.Init(file_name);
-		_users_db.Clear();
-		_users_db.Load();
-		_users_db.Validate();
+		CUsersDB users;
+		users.Init(file_name);
+		users.Load();
+		users.Validate();
+		_users_db.Replace(users);
 		LOG_INFO("Reloading Users database...Successful.");
 	END_TRY_START_CATCH(e)
 		LOG_ERROR("Reloading Users database...Failed: %s",e.what());
@@ -23,6 +23,7 @@ bool CRoutingConnection::Connect()
 		//set the source port to default EIB Port (3671)
 		_data_sock.SetLocalAddressAndPort(_ipaddress,EIB_PORT);
 		_data_sock.JoinGroup(_ipaddress,EIB_MULTICAST_ADDRESS);
+		_data_sock.EnableReceiveTimeStamps();
 	END_TRY_START_CATCH_SOCKET(e)
 		throw CEIBException(SocketError,e.what());
 	END_CATCH
@@ -52,7 +53,8 @@ bool CRoutingConnection::ReceiveDataFrame(CCemi_L_Data_Frame& frame)
 	unsigned char buffer[256];
 	CString tmp_ip;
 	int tmp_port;
-	int len = _data_sock.RecvFrom(buffer,256,tmp_ip,tmp_port,2000);
+	CTimeStamp time_stamp;
+	int len = _data_sock.RecvFrom(buffer,256,tmp_ip,tmp_port,2000,time_stamp);
 	if(len == 0){
 		return false;
 	}
@@ -65,6 +67,7 @@ bool CRoutingConnection::ReceiveDataFrame(CCemi_L_Data_Frame& frame)
 
 	CRoutingIndication req(buffer);
 	frame = req.GetCemiFrame();
+	frame.SetTimeStamp(time_stamp);
 	
 	return true;
 }
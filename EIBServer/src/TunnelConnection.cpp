@@ -44,6 +44,9 @@ bool CTunnelingConnection::Connect()
 		return false;
 	}
 
+	//let the kernel time stamp the frames we receive
+	_data_sock.EnableReceiveTimeStamps();
+
 	//send the connect request
 	//(we send both HPAI  identical - means the control channel & data channel will be the same on the EIB Server side
 	CConnectRequest con_req(CConnectRequest::TunnelConnection ,CConnectRequest::TunnelLinkLayer,_data_sock.GetLocalPort(),_ipaddress);
@@ -97,7 +100,7 @@ void CTunnelingConnection::InitConnectionParams()
 		_data_sock.SetNonBlocking();
 	}
 
-	bool auto_discover = CEIBServer::GetInstance().GetConfig().GetAutoDetectEibDeviceAddress();
+	bool auto_discover = CEIBServer::GetInstance().GetConfig()->GetAutoDetectEibDeviceAddress();
 
 	if(auto_discover)
 	{
@@ -111,7 +114,7 @@ void CTunnelingConnection::InitConnectionParams()
 		int len =_data_sock.RecvFrom(buffer,256,tmp_ip,tmp_port,3000);
 		if(len == 0){
 			//if we didn't got the search response in 3 seconds - lets used the configured params (ip address of the device)
-			_device_control_address = CEIBServer::GetInstance().GetConfig().GetEibDeviceAddress();
+			_device_control_address = CEIBServer::GetInstance().GetConfig()->GetEibDeviceAddress();
 			_device_control_port = EIB_PORT;
 		}
 		else{
@@ -134,7 +137,7 @@ void CTunnelingConnection::InitConnectionParams()
 	}
 	else
 	{
-		_device_control_address = CEIBServer::GetInstance().GetConfig().GetEibDeviceAddress();
+		_device_control_address = CEIBServer::GetInstance().GetConfig()->GetEibDeviceAddress();
 		_device_control_port = EIB_PORT;
 	}
 }
@@ -178,8 +181,9 @@ bool CTunnelingConnection::ReceiveDataFrame(CCemi_L_Data_Frame &frame)
 	
 	CString d_add;
 	int d_port;
+	CTimeStamp time_stamp;
 
-	len = _data_sock.RecvFrom(buffer,256,d_add,d_port,100);
+	len = _data_sock.RecvFrom(buffer,256,d_add,d_port,100,time_stamp);
 	
 	if(len == 0){
 		return false;
@@ -199,6 +203,9 @@ bool CTunnelingConnection::ReceiveDataFrame(CCemi_L_Data_Frame &frame)
 		break;
 	case EIBNETIP_TUNNELING:
 		res = HandleTunnelingServices(buffer, len, frame);
+		if(res){
+			frame.SetTimeStamp(time_stamp);
+		}
 		break;
 	case EIBNETIP_ROUTING:
 	case EIBNETIP_REMLOG:
@@ -2,8 +2,11 @@
 #include "Globals.h"
 #include "EIBServer.h"
 #include "cli.h"
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/crypto.h>
 
-CUsersDB::CUsersDB() 
+CUsersDB::CUsersDB() : _dirty(true), _generation(0)
 {
 }
 
@@ -16,6 +19,49 @@ void CUsersDB::Init(const CString& file_name)
 	CGenericDB<CString,CUser>::Init(file_name);
 }
 
+void CUsersDB::OnRecordsChanged()
+{
+	//the table is rebuilt by the next reader. Replace() publishes directly
+	_dirty = true;
+}
+
+void CUsersDB::Publish()
+{
+	std::shared_ptr<CUsersTable> table = std::make_shared<CUsersTable>();
+	map<CString,CUser>::const_iterator it;
+	for (it = _data.begin(); it != _data.end(); ++it){
+		table->insert(table->end(), pair<CString,CUserSnapshot>(it->first, std::make_shared<const CUser>(it->second)));
+	}
+	std::atomic_store(&_table, CUsersTableSnapshot(table));
+	//readers seeing the new generation are guaranteed to load the new table
+	++_generation;
+}
+
+void CUsersDB::Replace(CUsersDB& other)
+{
+	std::lock_guard<std::mutex> lock(_publish_lock);
+	_data.swap(other._data);
+	_dirty = false;
+	Publish();
+}
+
+bool CUsersDB::Save()
+{
+	std::lock_guard<std::mutex> lock(_publish_lock);
+	return CGenericDB<CString,CUser>::Save();
+}
+
+CUsersTableSnapshot CUsersDB::GetUsersTable()
+{
+	if (_dirty.load()){
+		std::lock_guard<std::mutex> lock(_publish_lock);
+		if (_dirty.exchange(false)){
+			Publish();
+		}
+	}
+	return std::atomic_load(&_table);
+}
+
 bool CUsersDB::Validate()
 {
 	if(IsEmpty())
@@ -58,6 +104,10 @@ void CUsersDB::OnReadParamComplete(CUser& current_record, const CString& param,c
 
 void CUsersDB::OnReadRecordComplete(CUser& current_record)
 {
+	//plain text passwords from older files are hashed on load. the file is rewritten on the next Save()
+	if(!CUser::IsPasswordHash(current_record.GetPassword())){
+		current_record.SetPassword(CUser::HashPassword(current_record.GetPassword()));
+	}
 	if(!AddRecord(current_record.GetName(),current_record)){
 		//log error
 		throw CEIBException(ConfigFileError,"Duplicate user name block. please check your .conf file");
@@ -100,7 +150,12 @@ void CUsersDB::OnSaveRecordStarted(const CUser& record,CString& record_name, lis
 		priv |= USER_POLICY_ADMIN_ACCESS;
 	CString temp(priv);
 	param_values.insert(param_values.end(), pair<CString,CString>(USER_PRIVILIGES_PARAM_NAME,temp));
-	param_values.insert(param_values.end(), pair<CString,CString>(USER_PASSWORD_PARAM_NAME,record.GetPassword()));
+	//passwords entered through the console or the admin api are hashed before they reach the disk
+	if(CUser::IsPasswordHash(record.GetPassword())){
+		param_values.insert(param_values.end(), pair<CString,CString>(USER_PASSWORD_PARAM_NAME,record.GetPassword()));
+	}else{
+		param_values.insert(param_values.end(), pair<CString,CString>(USER_PASSWORD_PARAM_NAME,CUser::HashPassword(record.GetPassword())));
+	}
 	param_values.insert(param_values.end(), pair<CString,CString>(USER_ALLOWED_SOURCE_MASK,CString::ToHexFormat(record.GetFilter().GetSrcMask())));
 	param_values.insert(param_values.end(), pair<CString,CString>(USER_ALLOWED_DEST_MASK,CString::ToHexFormat(record.GetFilter().GetDstMask())));
 }
@@ -109,9 +164,19 @@ void CUsersDB::InteractiveConf()
 {
 	CString file_name(CURRENT_CONF_FOLDER);
 	file_name += DEFAULT_USERS_DB_FILE;
-	Init(file_name);
-	Load();
 
+	//edited off line like a reload, so readers of the published table never see a half edited list
+	CUsersDB edit;
+	edit.Init(file_name);
+	edit.Load();
+	if(edit.EditInteractive(file_name)){
+		Init(file_name);
+		Replace(edit);
+	}
+}
+
+bool CUsersDB::EditInteractive(const CString& file_name)
+{
 	CUser user;
 
 start:
@@ -162,13 +227,14 @@ start:
 		LOG_SCREEN("\nUsers file: \"%s\" saved successfully. the new file will be loaded automatically.\n", file_name.GetBuffer());
 		CEIBServer::GetInstance().GetLog().SetConsoleColor(WHITE);
 		LOG_SCREEN("\n\n");
-		break;
-	case 6: return;
+		return true;
+	case 6: return false;
 	case NO_DEFAULT_OPTION: goto start;
 	default:
 		LOG_SCREEN("Unknown Option\n");
 		goto start;
 	}
+	return false;
 }
 bool CUsersDB::UpdateUser(const CString& file_name)
 {
@@ -271,15 +337,33 @@ bool CUsersDB::AddOrUpdateUser(CUser& user)
 
 bool CUsersDB::AuthenticateUser(const CString& user_name, const CString& password, CUser& user)
 {
-	if (!GetRecord(user_name, user)){
-		return false;
-	}
-	if (user.GetPassword() != password){
+	CUserSnapshot snapshot = AuthenticateUser(user_name, password);
+	if (!snapshot){
 		return false;
 	}
+	user = *snapshot;
 	return true;
 }
 
+CUserSnapshot CUsersDB::AuthenticateUser(const CString& user_name, const CString& password)
+{
+	CUserSnapshot user = GetUserSnapshot(user_name);
+	if (!user || !user->VerifyPassword(password)){
+		return CUserSnapshot();
+	}
+	return user;
+}
+
+CUserSnapshot CUsersDB::GetUserSnapshot(const CString& user_name)
+{
+	CUsersTableSnapshot table = GetUsersTable();
+	CUsersTable::const_iterator it = table->find(user_name);
+	if (it == table->end()){
+		return CUserSnapshot();
+	}
+	return it->second;
+}
+
 /////////////////////////////////// CUser Members ///////////////////////////////////////
 
 CUser::CUser(): _name(EMPTY_STRING),_password(EMPTY_STRING),_priviliges(USER_POLICY_NONE)
@@ -295,6 +379,17 @@ CUser::CUser(const CUser& user)
 	_filter = user._filter;
 }
 
+CUser& CUser::operator=(const CUser& user)
+{
+	if (this != &user){
+		_name = user._name;
+		_password = user._password;
+		_priviliges = user._priviliges;
+		_filter = user._filter;
+	}
+	return *this;
+}
+
 CUser::~CUser()
 {
 }
@@ -321,6 +416,88 @@ const CString& CUser::GetPassword() const
 	return _password;
 }
 
+bool CUser::IsPasswordHash(const CString& password)
+{
+	return strncmp(password.GetBuffer(), USER_PASSWORD_HASH_PREFIX, strlen(USER_PASSWORD_HASH_PREFIX)) == 0;
+}
+
+static bool ParseHexBytes(const CString& hex, unsigned char* buf, int len)
+{
+	if (hex.GetLength() != len * 2){
+		return false;
+	}
+	const char* p = hex.GetBuffer();
+	for (int i = 0; i < len * 2; ++i){
+		char c = p[i];
+		int nibble;
+		if (c >= '0' && c <= '9') nibble = c - '0';
+		else if (c >= 'a' && c <= 'f') nibble = c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F') nibble = c - 'A' + 10;
+		else return false;
+		buf[i / 2] = (unsigned char)((i % 2 == 0) ? (nibble << 4) : (buf[i / 2] | nibble));
+	}
+	return true;
+}
+
+static bool DerivePasswordKey(const CString& password, const unsigned char* salt, int salt_len,
+							  int iterations, unsigned char* key, int key_len)
+{
+	return PKCS5_PBKDF2_HMAC(password.GetBuffer(), password.GetLength(), salt, salt_len,
+							 iterations, EVP_sha256(), key_len, key) == 1;
+}
+
+CString CUser::HashPassword(const CString& password, int iterations)
+{
+	unsigned char salt[USER_PASSWORD_SALT_LEN];
+	unsigned char key[USER_PASSWORD_KEY_LEN];
+
+	if (RAND_bytes(salt, sizeof(salt)) != 1 ||
+		!DerivePasswordKey(password, salt, sizeof(salt), iterations, key, sizeof(key))){
+		throw CEIBException(GeneralError,"Cannot hash user password");
+	}
+
+	CString hash(USER_PASSWORD_HASH_PREFIX);
+	hash += iterations;
+	hash += '$';
+	hash += CString::ToHexFormat((const char*)salt, sizeof(salt), false);
+	hash += '$';
+	hash += CString::ToHexFormat((const char*)key, sizeof(key), false);
+	return hash;
+}
+
+bool CUser::VerifyPassword(const CString& password) const
+{
+	if (!IsPasswordHash(_password)){
+		//record added in memory and not saved yet
+		return _password.GetLength() == password.GetLength() &&
+			CRYPTO_memcmp(_password.GetBuffer(), password.GetBuffer(), password.GetLength()) == 0;
+	}
+
+	//$pbkdf2-sha256$<iterations>$<salt>$<key>
+	CString fields(_password.GetBuffer() + strlen(USER_PASSWORD_HASH_PREFIX));
+	size_t sep1 = fields.Find('$');
+	size_t sep2 = (sep1 == string::npos) ? string::npos : fields.Find('$', sep1 + 1);
+	if (sep2 == string::npos){
+		return false;
+	}
+	int iterations = fields.SubString(0, (int)sep1).ToInt();
+	CString salt_hex = fields.SubString((int)sep1 + 1, (int)(sep2 - sep1 - 1));
+	CString key_hex = fields.SubString((int)sep2 + 1, fields.GetLength() - (int)sep2 - 1);
+
+	unsigned char salt[USER_PASSWORD_SALT_LEN * 4];
+	unsigned char stored[USER_PASSWORD_KEY_LEN];
+	unsigned char key[USER_PASSWORD_KEY_LEN];
+	int salt_len = salt_hex.GetLength() / 2;
+	if (iterations <= 0 || salt_len > (int)sizeof(salt) ||
+		!ParseHexBytes(salt_hex, salt, salt_len) || !ParseHexBytes(key_hex, stored, sizeof(stored))){
+		return false;
+	}
+	if (!DerivePasswordKey(password, salt, salt_len, iterations, key, sizeof(key))){
+		return false;
+	}
+	return CRYPTO_memcmp(key, stored, sizeof(key)) == 0;
+}
+
 bool CUser::IsReadPolicyAllowed() const
 {
 	return ((USER_POLICY_READ_ACCESS & _priviliges) != 0);
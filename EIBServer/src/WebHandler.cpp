@@ -11,9 +11,12 @@
 #include "CommandScheduler.h"
 #include <cstdlib>
 #include <ctime>
+#include <openssl/rand.h>
+#include <openssl/evp.h>
 
-std::map<CString, WebSession> CWebHandler::_sessions;
-std::mutex CWebHandler::_session_mutex;
+CWebSessionTable CWebHandler::_sessions;
+std::mutex CWebHandler::_auth_cache_lock;
+std::unordered_map<CString, CWebHandler::CachedCredential, CStringHash> CWebHandler::_auth_cache;
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 // Route Registration
@@ -31,6 +34,7 @@ void CWebHandler::RegisterRoutes(httplib::SSLServer& server)
 	server.Get(R"(/api/history/(.+))",     ApiGetAddressHistory);
 	server.Post("/api/eib/send",           ApiSendEibCommand);
 	server.Post("/api/eib/schedule",       ApiScheduleCommand);
+	server.Post("/api/eib/schedule/cancel", ApiCancelScheduledCommand);
 
 	// Admin (require authentication)
 	server.Get("/api/admin/users",             ApiGetUsers);
@@ -58,23 +62,64 @@ void CWebHandler::SetJsonError(httplib::Response& res, const CString& message, i
 	SetJsonResponse(res, CXmlJsonUtil::JsonError(message), status);
 }
 
+CWebHandler::JsonTimeFormat CWebHandler::GetJsonTimeFormat(const httplib::Request& req)
+{
+	std::string format = req.get_param_value("time_format");
+	if (format == "iso8601") {
+		return JSON_TIME_ISO8601;
+	}
+	if (format == "epoch_ms") {
+		return JSON_TIME_EPOCH_MS;
+	}
+	return JSON_TIME_CTIME;
+}
+
+void CWebHandler::AppendJsonRecord(CString& json, const CEIBRecord& rec, JsonTimeFormat format)
+{
+	const CTimeStamp& ts = rec.GetTimeStamp();
+	json += "{\"time\":";
+	switch (format)
+	{
+	case JSON_TIME_ISO8601:
+		json += '"';
+		json += ts.IsZero() ? rec.GetTime().FormatISO8601() : ts.FormatISO8601();
+		json += '"';
+		break;
+	case JSON_TIME_EPOCH_MS:
+		json.AppendInt(ts.IsZero() ? rec.GetTime().GetEpochMs() : ts.GetEpochMs());
+		break;
+	default:
+		//the ctime format has no characters that need escaping
+		json += '"';
+		rec.GetTime().AddFormatToString(json, CTime::GetDefaultLocalTime());
+		json += '"';
+		break;
+	}
+	json += ",\"time_ns\":";
+	json.AppendInt(ts.GetWallNs());
+	json += ",\"value\":\"0x";
+	for (int i = 0; i < rec.GetValueLength(); ++i) {
+		json.AppendHex(rec.GetValue()[i]);
+	}
+	json += "\"}";
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 // Session Management
 //////////////////////////////////////////////////////////////////////////////////////////////
 
 CString CWebHandler::GenerateSessionId()
 {
-	static bool seeded = false;
-	if (!seeded) {
-		srand((unsigned int)time(NULL));
-		seeded = true;
+	unsigned char rnd[16];
+	if (RAND_bytes(rnd, sizeof(rnd)) != 1) {
+		throw CEIBException(GeneralError, "Cannot generate random session id");
 	}
-	CString sid;
-	const char hex[] = "0123456789abcdef";
-	for (int i = 0; i < 32; i++) {
-		sid += hex[rand() % 16];
-	}
-	return sid;
+	return CString::ToHexFormat((const char*)rnd, sizeof(rnd), false);
+}
+
+int CWebHandler::ExpireSessions()
+{
+	return _sessions.Expire(time(NULL));
 }
 
 CString CWebHandler::GetSessionCookie(const httplib::Request& req)
@@ -106,29 +151,26 @@ void CWebHandler::ApiLogin(const httplib::Request& req, httplib::Response& res)
 		return;
 	}
 
-	CUser user;
-	if (!CEIBServer::GetInstance().GetUsersDB().AuthenticateUser(user_name, password, user)) {
+	CUserSnapshot user = CEIBServer::GetInstance().GetUsersDB().AuthenticateUser(user_name, password);
+	if (!user) {
 		SetJsonError(res, "Invalid credentials", 401);
 		return;
 	}
 
-	if (!user.IsWebAccessAllowed()) {
+	if (!user->IsWebAccessAllowed()) {
 		SetJsonError(res, "Web access not allowed for this user", 403);
 		return;
 	}
 
 	// Create session
-	CString sid = GenerateSessionId();
-	WebSession session;
-	session.user_name = user_name;
-	session.session_id = sid;
-	session.created = time(NULL);
-	session.last_access = session.created;
-
-	{
-		std::lock_guard<std::mutex> lock(_session_mutex);
-		_sessions[sid] = session;
-	}
+	CString sid;
+	START_TRY
+		sid = GenerateSessionId();
+	END_TRY_START_CATCH(e)
+		SetJsonError(res, e.what());
+		return;
+	END_CATCH
+	_sessions.Insert(sid, user_name, time(NULL));
 
 	// Set cookie
 	CString cookie_val = CString("WEBSESSIONID=") + sid + "; Path=/";
@@ -137,11 +179,11 @@ void CWebHandler::ApiLogin(const httplib::Request& req, httplib::Response& res)
 	CString json = "{\"status\":\"ok\",\"user\":\"";
 	json += CXmlJsonUtil::JsonEscape(user_name);
 	json += "\",\"read\":";
-	json += user.IsReadPolicyAllowed() ? "true" : "false";
+	json += user->IsReadPolicyAllowed() ? "true" : "false";
 	json += ",\"write\":";
-	json += user.IsWritePolicyAllowed() ? "true" : "false";
+	json += user->IsWritePolicyAllowed() ? "true" : "false";
 	json += ",\"admin\":";
-	json += user.IsAdminAccessAllowed() ? "true" : "false";
+	json += user->IsAdminAccessAllowed() ? "true" : "false";
 	json += "}";
 
 	SetJsonResponse(res, json);
@@ -151,8 +193,7 @@ void CWebHandler::ApiLogout(const httplib::Request& req, httplib::Response& res)
 {
 	CString sid = GetSessionCookie(req);
 	if (sid.GetLength() > 0) {
-		std::lock_guard<std::mutex> lock(_session_mutex);
-		_sessions.erase(sid);
+		_sessions.Remove(sid);
 	}
 
 	// Clear cookie
@@ -163,25 +204,22 @@ void CWebHandler::ApiLogout(const httplib::Request& req, httplib::Response& res)
 
 void CWebHandler::ApiSessionCheck(const httplib::Request& req, httplib::Response& res)
 {
-	CUser user;
-	if (Authenticate(req, user)) {
+	CUserSnapshot user = Authenticate(req);
+	if (user) {
 		CString sid = GetSessionCookie(req);
 		CString user_name;
-		{
-			std::lock_guard<std::mutex> lock(_session_mutex);
-			std::map<CString, WebSession>::iterator it = _sessions.find(sid);
-			if (it != _sessions.end()) {
-				user_name = it->second.user_name;
-			}
+		WebSession session;
+		if (_sessions.Lookup(sid, session)) {
+			user_name = session.user_name;
 		}
 		CString json = "{\"authenticated\":true,\"user\":\"";
 		json += CXmlJsonUtil::JsonEscape(user_name);
 		json += "\",\"read\":";
-		json += user.IsReadPolicyAllowed() ? "true" : "false";
+		json += user->IsReadPolicyAllowed() ? "true" : "false";
 		json += ",\"write\":";
-		json += user.IsWritePolicyAllowed() ? "true" : "false";
+		json += user->IsWritePolicyAllowed() ? "true" : "false";
 		json += ",\"admin\":";
-		json += user.IsAdminAccessAllowed() ? "true" : "false";
+		json += user->IsAdminAccessAllowed() ? "true" : "false";
 		json += "}";
 		SetJsonResponse(res, json);
 	} else {
@@ -189,51 +227,84 @@ void CWebHandler::ApiSessionCheck(const httplib::Request& req, httplib::Response
 	}
 }
 
-bool CWebHandler::Authenticate(const httplib::Request& req, CUser& user)
+CUserSnapshot CWebHandler::Authenticate(const httplib::Request& req)
 {
 	CString sid = GetSessionCookie(req);
 	if (sid.GetLength() == 0) {
 		// Also try Basic Auth for API backward compat
 		std::string auth_hdr = req.get_header_value("Authorization");
 		if (!auth_hdr.empty()) {
-			CDigest digest(ALGORITHM_BASE64);
-			size_t index = auth_hdr.find("Basic ");
-			if (index != std::string::npos) {
-				CString cipher(auth_hdr.c_str() + index + 6);
-				CString clear;
-				if (digest.Decode(cipher, clear)) {
-					// clear is "user:pass"
-					size_t colon = std::string(clear.GetBuffer()).find(':');
-					if (colon != std::string::npos) {
-						CString uname(clear.GetBuffer(), (int)colon);
-						CString pass(clear.GetBuffer() + colon + 1);
-						if (CEIBServer::GetInstance().GetUsersDB().AuthenticateUser(uname, pass, user)) {
-							return true;
-						}
-					}
-				}
-			}
+			return AuthenticateBasic(auth_hdr);
 		}
-		return false;
+		return CUserSnapshot();
 	}
 
-	std::lock_guard<std::mutex> lock(_session_mutex);
-	std::map<CString, WebSession>::iterator it = _sessions.find(sid);
-	if (it == _sessions.end()) {
-		return false;
+	// Idle sessions are removed by the session table's timer wheel
+	CString user_name;
+	if (!_sessions.Touch(sid, time(NULL), user_name)) {
+		return CUserSnapshot();
 	}
 
-	// Check session age (expire after 1 hour)
+	return CEIBServer::GetInstance().GetUsersDB().GetUserSnapshot(user_name);
+}
+
+CUserSnapshot CWebHandler::AuthenticateBasic(const std::string& auth_hdr)
+{
+	CUsersDB& users = CEIBServer::GetInstance().GetUsersDB();
+	unsigned int generation = users.GetGeneration();
 	time_t now = time(NULL);
-	if (now - it->second.last_access > 3600) {
-		_sessions.erase(it);
-		return false;
+
+	// Scripts polling the API send the same header on every call. Remember headers
+	// that already passed the password KDF. Failures are never cached.
+	unsigned char md[EVP_MAX_MD_SIZE];
+	unsigned int md_len = 0;
+	if (EVP_Digest(auth_hdr.data(), auth_hdr.length(), md, &md_len, EVP_sha256(), NULL) != 1) {
+		return CUserSnapshot();
+	}
+	CString key = CString::ToHexFormat((const char*)md, (int)md_len, false);
+	{
+		std::lock_guard<std::mutex> lock(_auth_cache_lock);
+		std::unordered_map<CString, CachedCredential, CStringHash>::iterator it = _auth_cache.find(key);
+		if (it != _auth_cache.end()) {
+			if (it->second.generation == generation && it->second.expires > now) {
+				return it->second.user;
+			}
+			_auth_cache.erase(it);
+		}
 	}
 
-	it->second.last_access = now;
-	CString user_name = it->second.user_name;
+	CDigest digest(ALGORITHM_BASE64);
+	size_t index = auth_hdr.find("Basic ");
+	if (index == std::string::npos) {
+		return CUserSnapshot();
+	}
+	CString cipher(auth_hdr.c_str() + index + 6);
+	CString clear;
+	if (!digest.Decode(cipher, clear)) {
+		return CUserSnapshot();
+	}
+	// clear is "user:pass"
+	size_t colon = std::string(clear.GetBuffer()).find(':');
+	if (colon == std::string::npos) {
+		return CUserSnapshot();
+	}
+	CString uname(clear.GetBuffer(), (int)colon);
+	CString pass(clear.GetBuffer() + colon + 1);
+	CUserSnapshot user = users.AuthenticateUser(uname, pass);
+	if (!user) {
+		return CUserSnapshot();
+	}
 
-	return CEIBServer::GetInstance().GetUsersDB().GetRecord(user_name, user);
+	CachedCredential cred;
+	cred.user = user;
+	cred.generation = generation;
+	cred.expires = now + WEB_AUTH_CACHE_TTL;
+	std::lock_guard<std::mutex> lock(_auth_cache_lock);
+	if (_auth_cache.size() >= WEB_AUTH_CACHE_MAX) {
+		_auth_cache.clear();
+	}
+	_auth_cache[key] = cred;
+	return user;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -242,8 +313,8 @@ bool CWebHandler::Authenticate(const httplib::Request& req, CUser& user)
 
 void CWebHandler::ApiGetUsers(const httplib::Request& req, httplib::Response& res)
 {
-	CUser user;
-	if (!Authenticate(req, user)) {
+	CUserSnapshot user = Authenticate(req);
+	if (!user) {
 		SetJsonError(res, "Not authenticated", 401);
 		return;
 	}
@@ -263,21 +334,19 @@ void CWebHandler::ApiGetUsers(const httplib::Request& req, httplib::Response& re
 
 void CWebHandler::ApiSetUsers(const httplib::Request& req, httplib::Response& res)
 {
-	CUser user;
-	if (!Authenticate(req, user)) {
+	CUserSnapshot user = Authenticate(req);
+	if (!user) {
 		SetJsonError(res, "Not authenticated", 401);
 		return;
 	}
-	if (!user.IsAdminAccessAllowed()) {
+	if (!user->IsAdminAccessAllowed()) {
 		SetJsonError(res, "Admin privileges required", 403);
 		return;
 	}
 
 	START_TRY
 		CEIBServerUsersConf conf;
-		CDataBuffer body_buf;
-		body_buf.Add(req.body.c_str(), (int)req.body.length());
-		conf.FromXml(body_buf);
+		conf.FromXml(req.body.c_str(), (int)req.body.length());
 		conf.SetConnectedClients();
 		SetJsonResponse(res, CXmlJsonUtil::JsonOk());
 	END_TRY_START_CATCH(e)
@@ -287,8 +356,8 @@ void CWebHandler::ApiSetUsers(const httplib::Request& req, httplib::Response& re
 
 void CWebHandler::ApiGetInterface(const httplib::Request& req, httplib::Response& res)
 {
-	CUser user;
-	if (!Authenticate(req, user)) {
+	CUserSnapshot user = Authenticate(req);
+	if (!user) {
 		SetJsonError(res, "Not authenticated", 401);
 		return;
 	}
@@ -307,12 +376,12 @@ void CWebHandler::ApiGetInterface(const httplib::Request& req, httplib::Response
 
 void CWebHandler::ApiInterfaceStart(const httplib::Request& req, httplib::Response& res)
 {
-	CUser user;
-	if (!Authenticate(req, user)) {
+	CUserSnapshot user = Authenticate(req);
+	if (!user) {
 		SetJsonError(res, "Not authenticated", 401);
 		return;
 	}
-	if (!user.IsAdminAccessAllowed()) {
+	if (!user->IsAdminAccessAllowed()) {
 		SetJsonError(res, "Admin privileges required", 403);
 		return;
 	}
@@ -331,12 +400,12 @@ void CWebHandler::ApiInterfaceStart(const httplib::Request& req, httplib::Respon
 
 void CWebHandler::ApiInterfaceStop(const httplib::Request& req, httplib::Response& res)
 {
-	CUser user;
-	if (!Authenticate(req, user)) {
+	CUserSnapshot user = Authenticate(req);
+	if (!user) {
 		SetJsonError(res, "Not authenticated", 401);
 		return;
 	}
-	if (!user.IsAdminAccessAllowed()) {
+	if (!user->IsAdminAccessAllowed()) {
 		SetJsonError(res, "Admin privileges required", 403);
 		return;
 	}
@@ -355,8 +424,8 @@ void CWebHandler::ApiInterfaceStop(const httplib::Request& req, httplib::Respons
 
 void CWebHandler::ApiGetBusMonAddresses(const httplib::Request& req, httplib::Response& res)
 {
-	CUser user;
-	if (!Authenticate(req, user)) {
+	CUserSnapshot user = Authenticate(req);
+	if (!user) {
 		SetJsonError(res, "Not authenticated", 401);
 		return;
 	}
@@ -375,12 +444,12 @@ void CWebHandler::ApiGetBusMonAddresses(const httplib::Request& req, httplib::Re
 
 void CWebHandler::ApiBusMonSendCmd(const httplib::Request& req, httplib::Response& res)
 {
-	CUser user;
-	if (!Authenticate(req, user)) {
+	CUserSnapshot user = Authenticate(req);
+	if (!user) {
 		SetJsonError(res, "Not authenticated", 401);
 		return;
 	}
-	if (!user.IsAdminAccessAllowed()) {
+	if (!user->IsAdminAccessAllowed()) {
 		SetJsonError(res, "Admin privileges required", 403);
 		return;
 	}
@@ -407,19 +476,22 @@ void CWebHandler::ApiBusMonSendCmd(const httplib::Request& req, httplib::Respons
 
 void CWebHandler::ApiGetGlobalHistory(const httplib::Request& req, httplib::Response& res)
 {
-	CUser user;
-	if (!Authenticate(req, user)) {
+	CUserSnapshot user = Authenticate(req);
+	if (!user) {
 		SetJsonError(res, "Not authenticated", 401);
 		return;
 	}
-	if (!user.IsReadPolicyAllowed()) {
+	if (!user->IsReadPolicyAllowed()) {
 		SetJsonError(res, "Insufficient privileges", 403);
 		return;
 	}
 
 	CStatsDB& db = CEIBServer::GetInstance().GetStatsDB();
 
-	CString json = "{\"records\":[";
+	JsonTimeFormat time_format = GetJsonTimeFormat(req);
+	CString json = "{\"last_gap_ns\":";
+	json += db.GetLastGapNs();
+	json += ",\"records\":[";
 	map<CEibAddress, CEIBObjectRecord>& records = db.GetData();
 	bool first = true;
 	map<CEibAddress, CEIBObjectRecord>::const_iterator it;
@@ -435,13 +507,7 @@ void CWebHandler::ApiGetGlobalHistory(const httplib::Request& req, httplib::Resp
 		for (eit = entries.begin(); eit != entries.end(); ++eit) {
 			if (!first_entry) json += ",";
 			first_entry = false;
-			json += "{\"time\":\"";
-			json += CXmlJsonUtil::JsonEscape(eit->GetTime().Format());
-			json += "\",\"value\":\"0x";
-			for (int i = 0; i < eit->GetValueLength(); ++i) {
-				json += ToHex((int)eit->GetValue()[i]);
-			}
-			json += "\"}";
+			AppendJsonRecord(json, *eit, time_format);
 		}
 		json += "]}";
 	}
@@ -452,12 +518,12 @@ void CWebHandler::ApiGetGlobalHistory(const httplib::Request& req, httplib::Resp
 
 void CWebHandler::ApiGetAddressHistory(const httplib::Request& req, httplib::Response& res)
 {
-	CUser user;
-	if (!Authenticate(req, user)) {
+	CUserSnapshot user = Authenticate(req);
+	if (!user) {
 		SetJsonError(res, "Not authenticated", 401);
 		return;
 	}
-	if (!user.IsReadPolicyAllowed()) {
+	if (!user->IsReadPolicyAllowed()) {
 		SetJsonError(res, "Insufficient privileges", 403);
 		return;
 	}
@@ -473,6 +539,7 @@ void CWebHandler::ApiGetAddressHistory(const httplib::Request& req, httplib::Res
 		return;
 	}
 
+	JsonTimeFormat time_format = GetJsonTimeFormat(req);
 	CString json = "{\"address\":\"";
 	json += CXmlJsonUtil::JsonEscape(address);
 	json += "\",\"entries\":[";
@@ -482,13 +549,7 @@ void CWebHandler::ApiGetAddressHistory(const httplib::Request& req, httplib::Res
 	for (eit = entries.begin(); eit != entries.end(); ++eit) {
 		if (!first) json += ",";
 		first = false;
-		json += "{\"time\":\"";
-		json += CXmlJsonUtil::JsonEscape(eit->GetTime().Format());
-		json += "\",\"value\":\"0x";
-		for (int i = 0; i < eit->GetValueLength(); ++i) {
-			json += ToHex((int)eit->GetValue()[i]);
-		}
-		json += "\"}";
+		AppendJsonRecord(json, *eit, time_format);
 	}
 	json += "]}";
 
@@ -497,12 +558,12 @@ void CWebHandler::ApiGetAddressHistory(const httplib::Request& req, httplib::Res
 
 void CWebHandler::ApiSendEibCommand(const httplib::Request& req, httplib::Response& res)
 {
-	CUser user;
-	if (!Authenticate(req, user)) {
+	CUserSnapshot user = Authenticate(req);
+	if (!user) {
 		SetJsonError(res, "Not authenticated", 401);
 		return;
 	}
-	if (!user.IsWritePolicyAllowed()) {
+	if (!user->IsWritePolicyAllowed()) {
 		SetJsonError(res, "Insufficient privileges", 403);
 		return;
 	}
@@ -534,12 +595,12 @@ void CWebHandler::ApiSendEibCommand(const httplib::Request& req, httplib::Respon
 
 void CWebHandler::ApiScheduleCommand(const httplib::Request& req, httplib::Response& res)
 {
-	CUser user;
-	if (!Authenticate(req, user)) {
+	CUserSnapshot user = Authenticate(req);
+	if (!user) {
 		SetJsonError(res, "Not authenticated", 401);
 		return;
 	}
-	if (!user.IsWritePolicyAllowed()) {
+	if (!user->IsWritePolicyAllowed()) {
 		SetJsonError(res, "Insufficient privileges", 403);
 		return;
 	}
@@ -548,27 +609,88 @@ void CWebHandler::ApiScheduleCommand(const httplib::Request& req, httplib::Respo
 	CString addr = GetJsonField(body_str, "address");
 	CString apci_str = GetJsonField(body_str, "value");
 	CString datetime_str = GetJsonField(body_str, "datetime");
+	CString cron_str = GetJsonField(body_str, "cron");
+	CString sun_str = GetJsonField(body_str, "sun");
+	CString offset_str = GetJsonField(body_str, "offset");
 
-	if (addr.GetLength() == 0 || apci_str.GetLength() == 0 || datetime_str.GetLength() == 0) {
+	//one shot commands need a datetime, recurring ones a cron expression or sunrise/sunset
+	if (addr.GetLength() == 0 || apci_str.GetLength() == 0 ||
+		(datetime_str.GetLength() == 0 && cron_str.GetLength() == 0 && sun_str.GetLength() == 0)) {
 		SetJsonError(res, "Missing address, value, or datetime");
 		return;
 	}
 
-	unsigned char apci[MAX_EIB_VALUE_LEN];
-	unsigned char apci_len;
-	if (!GetByteArrayFromHexString(apci_str, apci, apci_len)) {
+	int offset = 0;
+	if (offset_str.GetLength() > 0) {
+		char* end = NULL;
+		offset = (int)strtol(offset_str.GetBuffer(), &end, 10);
+		if (end == offset_str.GetBuffer() || *end != '\0') {
+			SetJsonError(res, "Invalid offset (expected minutes as an integer)", 400);
+			return;
+		}
+	}
+
+	ScheduledCommand cmd;
+	if (!GetByteArrayFromHexString(apci_str, cmd._value, cmd._value_len)) {
 		SetJsonError(res, "Invalid hex value");
 		return;
 	}
+	cmd._dst = CEibAddress(addr);
+
+	if (cron_str.GetLength() > 0) {
+		cmd._type = SCHEDULE_CRON;
+		cmd._cron = cron_str;
+	} else if (sun_str.GetLength() > 0) {
+		if (sun_str == "sunrise") {
+			cmd._type = SCHEDULE_SUNRISE;
+		} else if (sun_str == "sunset") {
+			cmd._type = SCHEDULE_SUNSET;
+		} else {
+			SetJsonError(res, "Invalid sun value (expected sunrise or sunset)");
+			return;
+		}
+		cmd._offset = offset;
+	} else {
+		cmd._time = CTime(datetime_str.GetBuffer(), true);
+	}
 
-	CTime datetime(datetime_str.GetBuffer(), true);
 	CString err;
-	if (!CEIBServer::GetInstance().GetScheduler().AddScheduledCommand(
-			datetime, CEibAddress(addr), apci, apci_len, err)) {
+	unsigned int id = CEIBServer::GetInstance().GetScheduler().ScheduleCommand(cmd, err);
+	if (id == 0) {
 		SetJsonError(res, err);
 		return;
 	}
 
+	CString json("{\"status\":\"ok\",\"id\":");
+	json += id;
+	json += "}";
+	SetJsonResponse(res, json);
+}
+
+void CWebHandler::ApiCancelScheduledCommand(const httplib::Request& req, httplib::Response& res)
+{
+	CUserSnapshot user = Authenticate(req);
+	if (!user) {
+		SetJsonError(res, "Not authenticated", 401);
+		return;
+	}
+	if (!user->IsWritePolicyAllowed()) {
+		SetJsonError(res, "Insufficient privileges", 403);
+		return;
+	}
+
+	CString body_str(req.body.c_str(), (int)req.body.length());
+	CString id_str = GetJsonField(body_str, "id");
+	if (id_str.GetLength() == 0) {
+		SetJsonError(res, "Missing id");
+		return;
+	}
+
+	if (!CEIBServer::GetInstance().GetScheduler().CancelScheduledCommand((unsigned int)id_str.ToInt())) {
+		SetJsonError(res, "No such scheduled command", 404);
+		return;
+	}
+
 	SetJsonResponse(res, CXmlJsonUtil::JsonOk());
 }
 
@@ -615,16 +737,29 @@ CString CWebHandler::GetJsonField(const CString& json, const CString& field)
 {
 	CString search = "\"";
 	search += field;
-	search += "\":\"";
+	search += "\":";
 
 	size_t pos = json.Find(search);
 	if (pos == string::npos) return EMPTY_STRING;
 
 	pos += search.GetLength();
-	size_t end = json.Find("\"", pos);
-	if (end == string::npos) return EMPTY_STRING;
-
-	return json.SubString(pos, end - pos);
+	const char* p = json.GetBuffer();
+	size_t len = (size_t)json.GetLength();
+	while (pos < len && (p[pos] == ' ' || p[pos] == '\t')) ++pos;
+
+	if (pos < len && p[pos] == '"') {
+		++pos;
+		size_t end = json.Find("\"", pos);
+		if (end == string::npos) return EMPTY_STRING;
+		return json.SubString(pos, end - pos);
+	}
+
+	// Numbers, true and false are returned as written; null is the same as a missing field
+	size_t end = pos;
+	while (end < len && p[end] != ',' && p[end] != '}' && p[end] != ']' && !isspace((unsigned char)p[end])) ++end;
+	CString value = json.SubString(pos, end - pos);
+	if (value == "null") return EMPTY_STRING;
+	return value;
 }
 
 bool CWebHandler::GetByteArrayFromHexString(const CString& str, unsigned char *val, unsigned char &val_len)
@@ -0,0 +1,151 @@
+#include "WebSessionTable.h"
+
+CWebSessionTable::CWebSessionTable(int timeout) :
+_wheel_tick(-1),
+_timeout(timeout)
+{
+	if (_timeout > WEB_SESSION_MAX_TIMEOUT) {
+		_timeout = WEB_SESSION_MAX_TIMEOUT;
+	}
+	else if (_timeout < 1) {
+		_timeout = 1;
+	}
+}
+
+void CWebSessionTable::Insert(const CString& sid, const CString& user_name, time_t now)
+{
+	WebSession session;
+	session.user_name = user_name;
+	session.session_id = sid;
+	session.created = now;
+	session.last_access = now;
+
+	{
+		Shard& shard = GetShard(sid);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		shard.sessions[sid] = session;
+	}
+
+	std::lock_guard<std::mutex> lock(_wheel_mutex);
+	if (_wheel_tick < 0) {
+		_wheel_tick = now / WEB_SESSION_WHEEL_TICK;
+	}
+	Schedule(sid, now + _timeout);
+}
+
+bool CWebSessionTable::Touch(const CString& sid, time_t now, CString& user_name)
+{
+	Shard& shard = GetShard(sid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	std::unordered_map<CString, WebSession, CStringHash>::iterator it = shard.sessions.find(sid);
+	if (it == shard.sessions.end()) {
+		return false;
+	}
+	// The wheel removes the session at the next tick; until then refuse it
+	if (now - it->second.last_access > _timeout) {
+		return false;
+	}
+	it->second.last_access = now;
+	user_name = it->second.user_name;
+	return true;
+}
+
+bool CWebSessionTable::Lookup(const CString& sid, WebSession& session)
+{
+	Shard& shard = GetShard(sid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	std::unordered_map<CString, WebSession, CStringHash>::iterator it = shard.sessions.find(sid);
+	if (it == shard.sessions.end()) {
+		return false;
+	}
+	session = it->second;
+	return true;
+}
+
+void CWebSessionTable::Remove(const CString& sid)
+{
+	// The wheel entry is left behind and skipped when its slot comes up
+	Shard& shard = GetShard(sid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	shard.sessions.erase(sid);
+}
+
+void CWebSessionTable::Clear()
+{
+	std::lock_guard<std::mutex> wheel_lock(_wheel_mutex);
+	for (int i = 0; i < WEB_SESSION_SHARDS; ++i) {
+		std::lock_guard<std::mutex> lock(_shards[i].mutex);
+		_shards[i].sessions.clear();
+	}
+	for (int i = 0; i < WEB_SESSION_WHEEL_SLOTS; ++i) {
+		_wheel[i].clear();
+	}
+	_wheel_tick = -1;
+}
+
+int CWebSessionTable::GetNumSessions()
+{
+	int count = 0;
+	for (int i = 0; i < WEB_SESSION_SHARDS; ++i) {
+		std::lock_guard<std::mutex> lock(_shards[i].mutex);
+		count += (int)_shards[i].sessions.size();
+	}
+	return count;
+}
+
+// Caller holds _wheel_mutex. A session expiring at 'expires' is filed in the
+// slot of the first tick that starts after it, so processing that slot is
+// always late enough to decide.
+void CWebSessionTable::Schedule(const CString& sid, time_t expires)
+{
+	int slot = (int)((expires / WEB_SESSION_WHEEL_TICK + 1) % WEB_SESSION_WHEEL_SLOTS);
+	_wheel[slot].push_back(sid);
+}
+
+// Caller holds _wheel_mutex
+void CWebSessionTable::ProcessSlot(int slot, time_t now, int& expired)
+{
+	std::vector<CString> entries;
+	entries.swap(_wheel[slot]);
+
+	std::vector<CString>::iterator it;
+	for (it = entries.begin(); it != entries.end(); ++it) {
+		time_t expires = 0;
+		{
+			Shard& shard = GetShard(*it);
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			std::unordered_map<CString, WebSession, CStringHash>::iterator sit = shard.sessions.find(*it);
+			if (sit == shard.sessions.end()) {
+				continue; // logged out
+			}
+			expires = sit->second.last_access + _timeout;
+			if (expires <= now) {
+				shard.sessions.erase(sit);
+				++expired;
+				continue;
+			}
+		}
+		// Accessed since it was filed: move it to the slot of its new deadline
+		Schedule(*it, expires);
+	}
+}
+
+int CWebSessionTable::Expire(time_t now)
+{
+	std::lock_guard<std::mutex> lock(_wheel_mutex);
+	if (_wheel_tick < 0) {
+		return 0;
+	}
+
+	int expired = 0;
+	time_t current = now / WEB_SESSION_WHEEL_TICK;
+	if (current - _wheel_tick > WEB_SESSION_WHEEL_SLOTS) {
+		// Clock jumped over a whole revolution: visit every slot once
+		_wheel_tick = current - WEB_SESSION_WHEEL_SLOTS;
+	}
+	while (_wheel_tick < current) {
+		++_wheel_tick;
+		ProcessSlot((int)(_wheel_tick % WEB_SESSION_WHEEL_SLOTS), now, expired);
+	}
+	return expired;
+}
@@ -34,7 +34,7 @@ void CEIBInterfaceConf::ToXml(CDataBuffer& xml_str)
 	}
 	root.InsertChild(EIB_INTERFACE_DEVICE_MODE_XML).SetValue(mode_str);
 	//is autodetect feature is on?
-	root.InsertChild(EIB_INTERFACE_AUTO_DETECT_XML).SetValue(CEIBServer::GetInstance().GetConfig().GetAutoDetectEibDeviceAddress());
+	root.InsertChild(EIB_INTERFACE_AUTO_DETECT_XML).SetValue(CEIBServer::GetInstance().GetConfig()->GetAutoDetectEibDeviceAddress());
 	//interface stats
 	const EIBInterfaceStats& stats = eib_interface.GetInterfaceStats();
 	root.InsertChild(EIB_INTERFACE_LAST_TIME_PACKET_SENT_XML).SetValue(stats._last_time_sent.GetTime() ? stats._last_time_sent.Format() : "Never");
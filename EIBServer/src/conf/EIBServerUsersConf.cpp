@@ -1,5 +1,6 @@
 #include "conf/EIBServerUsersConf.h"
 #include "EIBServer.h"
+#include "xml/XmlReader.h"
 
 CEIBServerUsersConf::CEIBServerUsersConf()
 {
@@ -39,71 +40,111 @@ void CEIBServerUsersConf::ToXml(CDataBuffer& xml_str)
 
 void CEIBServerUsersConf::FromXml(const CDataBuffer& xml_str)
 {
-	_clients.clear();
+	FromXml((const char*)xml_str.GetBuffer(), xml_str.GetLength());
+}
+
+void CEIBServerUsersConf::FromXml(const char* xml, int length)
+{
+	_users.Clear();
 	try
 	{
-		// CDataBuffer is not null-terminated; create a CString to ensure
-		// the XML parser receives a properly terminated C string.
-		CString xml_safe((const char*)xml_str.GetBuffer(), xml_str.GetLength());
-		_doc.Parse(xml_safe);
-		if(!_doc.RootElement().FirstChildElement(EIB_SERVER_USERS_LIST_XML).IsValid()){
-			//send error xml to console
-			return;
-		}
-		CXmlElement users_list_elem = _doc.RootElement().FirstChildElement(EIB_SERVER_USERS_LIST_XML);
-		CXmlElement client_elem = users_list_elem.FirstChildElement(EIB_SERVER_USER_XML);
-		do
+		// <Root><EIB_SERVER_USERS_LIST><EIB_SERVER_USER><EIB_SERVER_USER_NAME>...
+		// every user is added to the users db at its end tag, no intermediate list is built
+		CXmlReader reader(xml, length);
+		CClientConf single_client;
+		CString field;
+		bool in_list = false, in_client = false;
+		XmlReadResult res;
+
+		while((res = reader.Read()) != XML_READ_END)
 		{
-			CString name = client_elem.FirstChildElement(EIB_SERVER_USER_NAME_XML).GetValue();
-			CString password = client_elem.FirstChildElement(EIB_SERVER_USER_PASSWORD_XML).GetValue();
-			CString privliges = client_elem.FirstChildElement(EIB_SERVER_USER_PRIVILIGES_XML).GetValue();
-			CString src_mask = client_elem.FirstChildElement(EIB_SERVER_USER_SOURCE_ADDR_MASK_XML).GetValue();
-			CString dst_mask = client_elem.FirstChildElement(EIB_SERVER_USER_DST_ADDR_MASK_XML).GetValue();
-
-			CClientConf single_client;
-			
-			single_client._name = name;
-			single_client._password = password;
-			single_client._priviliges = privliges.ToInt();
-			single_client._sa_mask = src_mask.ToUShort();
-			single_client._da_mask = dst_mask.ToUShort();
-
-			_clients.insert(_clients.begin(),single_client);
-
-			client_elem = client_elem.NextSibling(EIB_SERVER_USER_XML);
-
-		}while(client_elem.IsValid());
+			switch(res)
+			{
+			case XML_READ_START_ELEMENT:
+				if(reader.GetDepth() == 2){
+					in_list = reader.IsName(EIB_SERVER_USERS_LIST_XML);
+				}
+				else if(reader.GetDepth() == 3 && in_list && reader.IsName(EIB_SERVER_USER_XML)){
+					in_client = true;
+					single_client = CClientConf();
+					single_client._priviliges = 0;
+					single_client._sa_mask = 0;
+					single_client._da_mask = 0;
+				}
+				else if(reader.GetDepth() == 4 && in_client){
+					field = reader.GetName();
+				}
+				break;
+			case XML_READ_TEXT:
+				if(reader.GetDepth() == 4 && in_client){
+					SetField(single_client, field, reader.GetText());
+				}
+				break;
+			case XML_READ_END_ELEMENT:
+				if(reader.GetDepth() == 4){
+					field = EMPTY_STRING;
+				}
+				else if(reader.GetDepth() == 3 && in_client){
+					AddUser(single_client);
+					in_client = false;
+				}
+				else if(reader.GetDepth() == 2){
+					in_list = false;
+				}
+				break;
+			default:
+				//never apply half a list
+				throw CEIBException(XmlError, "%s", reader.GetError().GetBuffer());
+			}
+		}
 	}
 	catch (CEIBException& e)
 	{
+		_users.Clear();
 		CEIBServer::GetInstance().GetLog().Log(LOG_LEVEL_ERROR,"Error parsing in XML file: %s", e.what());
+		throw;
 	}
 }
 
-void CEIBServerUsersConf::SetConnectedClients()
+void CEIBServerUsersConf::SetField(CClientConf& client, const CString& field, const CString& value)
 {
-	CUsersDB users;
-
-	list<CClientConf>::iterator list_it = _clients.begin();
+	if(field == EIB_SERVER_USER_NAME_XML){
+		client._name = value;
+	}
+	else if(field == EIB_SERVER_USER_PASSWORD_XML){
+		client._password = value;
+	}
+	else if(field == EIB_SERVER_USER_PRIVILIGES_XML){
+		client._priviliges = value.ToInt();
+	}
+	else if(field == EIB_SERVER_USER_SOURCE_ADDR_MASK_XML){
+		client._sa_mask = value.ToUShort();
+	}
+	else if(field == EIB_SERVER_USER_DST_ADDR_MASK_XML){
+		client._da_mask = value.ToUShort();
+	}
+}
 
-	for(list_it = _clients.begin();list_it!= _clients.end();++list_it)
-	{
-		CUser current;
+void CEIBServerUsersConf::AddUser(const CClientConf& client)
+{
+	CUser current;
 
-		current.SetName(list_it->_name);
-		current.SetPriviliges(list_it->_priviliges);
-		current.SetPassword(list_it->_password);
-		current.SetAllowedDestAddressMask(list_it->_da_mask);
-		current.SetAllowedSourceAddressMask(list_it->_sa_mask);
+	current.SetName(client._name);
+	current.SetPriviliges(client._priviliges);
+	current.SetPassword(client._password);
+	current.SetAllowedDestAddressMask(client._da_mask);
+	current.SetAllowedSourceAddressMask(client._sa_mask);
 
-		users.AddRecord(current.GetName(),current);
-	}
+	_users.AddRecord(current.GetName(),current);
+}
 
+void CEIBServerUsersConf::SetConnectedClients()
+{
 	//initializing users db
 	CString file_name(CURRENT_CONF_FOLDER);
 	file_name += DEFAULT_USERS_DB_FILE;
-	users.Init(file_name);
-	users.Save();
+	_users.Init(file_name);
+	_users.Save();
 
 	CEIBServer::GetInstance().ReloadConfiguration();
 }
@@ -113,25 +154,25 @@ void CEIBServerUsersConf::GetConnectedClients()
 	CString client_ip;
 	int session_id;
 	CClientConf client;
-	const map<CString,CUser>& users = CEIBServer::GetInstance().GetUsersDB().GetUsersList();
-	map<CString,CUser>::const_iterator it = users.begin();
-	for(it = users.begin();it!= users.end();++it)
+	CUsersTableSnapshot users = CEIBServer::GetInstance().GetUsersDB().GetUsersTable();
+	CUsersTable::const_iterator it = users->begin();
+	for(it = users->begin();it!= users->end();++it)
 	{	
-		client._name = it->second.GetName();
-		client._password = it->second.GetPassword();
+		client._name = it->second->GetName();
+		client._password = it->second->GetPassword();
 
 		client._priviliges = 0;
 
-		if(it->second.IsReadPolicyAllowed())
+		if(it->second->IsReadPolicyAllowed())
 			client._priviliges |= USER_POLICY_READ_ACCESS;
-		if(it->second.IsWritePolicyAllowed())
+		if(it->second->IsWritePolicyAllowed())
 			client._priviliges |= USER_POLICY_WRITE_ACCESS;
-		if(it->second.IsWebAccessAllowed())
+		if(it->second->IsWebAccessAllowed())
 			client._priviliges |= USER_POLICY_WEB_ACCESS;
-		if(it->second.IsAdminAccessAllowed())
+		if(it->second->IsAdminAccessAllowed())
 			client._priviliges |= USER_POLICY_ADMIN_ACCESS;
-		client._sa_mask = it->second.GetSrcMask();
-		client._da_mask = it->second.GetDstMask();
+		client._sa_mask = it->second->GetSrcMask();
+		client._da_mask = it->second->GetDstMask();
 
 		if (CEIBServer::GetInstance().GetClientsManager()->IsClientConnected((*it).first,client_ip,session_id)){
 			client._connected = true;
@@ -5,6 +5,7 @@
 // and never conflict with the server's versions in other .cpp files.
 
 #include "Emulator-ng.h"
+#include "EmulatorWrapper.h"
 #include <cstdlib>
 #include <ctime>
 #include <thread>
@@ -81,3 +82,104 @@ void EmulatorGenerateRandomIndications(int count, int delay_ms)
         }
     }
 }
+
+bool EmulatorRunScenario(const char* file_name)
+{
+    return CEIBEmulator::GetInstance().RunScenario(file_name);
+}
+
+bool EmulatorWaitScenario(int timeout_ms)
+{
+    for (int elapsed = 0; elapsed < timeout_ms; elapsed += 20) {
+        if (!CEIBEmulator::GetInstance().IsScenarioRunning()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return false;
+}
+
+int EmulatorScenarioSentCount()
+{
+    return CEIBEmulator::GetInstance().GetScenarioSentCount();
+}
+
+std::string EmulatorScenarioRecordFile()
+{
+    return CEIBEmulator::GetInstance().GetScenarioRecordFile().GetBuffer();
+}
+
+int EmulatorLoadGroupTable(const char* file_name)
+{
+    try {
+        return CEIBEmulator::GetInstance().GetDB().LoadGroupTable(file_name);
+    } catch (...) {
+        return -1;
+    }
+}
+
+bool EmulatorSaveGroupTable(const char* file_name)
+{
+    try {
+        CEIBEmulator::GetInstance().GetDB().SaveGroupTable(file_name);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+int EmulatorGroupCount()
+{
+    return CEIBEmulator::GetInstance().GetDB().GetNumOfRecords();
+}
+
+bool EmulatorRemoveGroup(const char* group_address)
+{
+    CGroupObjectTable& table = CEIBEmulator::GetInstance().GetDB().GetTable();
+    unsigned short group = CEibAddress(group_address).ToByteArray();
+    const CGroupObject* obj = table.Get(group);
+    if (obj == NULL) {
+        return false;
+    }
+    table.ResetDevice(obj->phy);
+    return table.Remove(group);
+}
+
+int EmulatorGroupValue(const char* group_address, unsigned char* value, int max_len)
+{
+    int len = 0;
+    unsigned char* current = CEIBEmulator::GetInstance().GetDB().GetValueForGroup(CEibAddress(group_address), len);
+    if (current == NULL || len > max_len) {
+        return 0;
+    }
+    memcpy(value, current, len);
+    return len;
+}
+
+void EmulatorSetImpairment(const EmulatorImpairmentProfile& profile)
+{
+    CImpairmentProfile p;
+    p.drop = profile.drop;
+    p.duplicate = profile.duplicate;
+    p.reorder = profile.reorder;
+    p.reorder_window = profile.reorder_window;
+    p.ack_suppress = profile.ack_suppress;
+    p.delay = profile.delay;
+    p.delay_mean = profile.delay_mean;
+    p.delay_jitter = profile.delay_jitter;
+    p.seed = profile.seed;
+    CEIBEmulator::GetInstance().GetHandler().GetImpairment().SetProfile(p);
+}
+
+EmulatorImpairmentStats EmulatorGetImpairmentStats()
+{
+    CImpairmentStats s = CEIBEmulator::GetInstance().GetHandler().GetImpairment().GetStats();
+    EmulatorImpairmentStats stats;
+    stats.sent = s.sent;
+    stats.dropped = s.dropped;
+    stats.duplicated = s.duplicated;
+    stats.reordered = s.reordered;
+    stats.delayed = s.delayed;
+    stats.acks_suppressed = s.acks_suppressed;
+    return stats;
+}
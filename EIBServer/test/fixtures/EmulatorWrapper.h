@@ -11,6 +11,8 @@
 #ifndef EMULATOR_WRAPPER_H
 #define EMULATOR_WRAPPER_H
 
+#include <string>
+
 bool InitEmulator();           // CEIBEmulator::GetInstance().Init()
 void StartEmulator();          // CEIBEmulator::GetInstance().Run(NULL)
 void StopEmulator();           // CEIBEmulator::GetInstance().Close()
@@ -30,4 +32,51 @@ void EmulatorSendIndication(const char* group_address,
 // Uses physical address 15.15.255 to identify generated traffic.
 void EmulatorGenerateRandomIndications(int count, int delay_ms);
 
+// Load scenarios (see templates/Scenario.template).
+// EmulatorRunScenario returns false if the file cannot be loaded.
+// EmulatorWaitScenario returns false if the scenario is still running after timeout_ms.
+bool EmulatorRunScenario(const char* file_name);
+bool EmulatorWaitScenario(int timeout_ms);
+int EmulatorScenarioSentCount();
+std::string EmulatorScenarioRecordFile();
+
+// Merge a group table file (CSV or binary) into the emulator database.
+// Returns the number of objects read, or -1 if the file cannot be loaded.
+int EmulatorLoadGroupTable(const char* file_name);
+// Write the whole group table in the binary format. Returns false on error.
+bool EmulatorSaveGroupTable(const char* file_name);
+int EmulatorGroupCount();
+// Remove a group object and put the device that owned it back on the default profile.
+// Returns false if the group is unknown.
+bool EmulatorRemoveGroup(const char* group_address);
+// Current value of a group object. Returns its length, or 0 if the group is unknown.
+int EmulatorGroupValue(const char* group_address, unsigned char* value, int max_len);
+
+// Network impairments on the datagrams the emulator sends to the server
+// (see IMPAIR_* in templates/Emulator.conf.template). Setting a profile
+// resets the statistics. A default constructed profile disables the stage.
+struct EmulatorImpairmentProfile {
+    int drop = 0;
+    int duplicate = 0;
+    int reorder = 0;
+    int reorder_window = 0;
+    int ack_suppress = 0;
+    const char* delay = "none";
+    int delay_mean = 0;
+    int delay_jitter = 0;
+    unsigned int seed = 1;
+};
+
+struct EmulatorImpairmentStats {
+    int sent;
+    int dropped;
+    int duplicated;
+    int reordered;
+    int delayed;
+    int acks_suppressed;
+};
+
+void EmulatorSetImpairment(const EmulatorImpairmentProfile& profile);
+EmulatorImpairmentStats EmulatorGetImpairmentStats();
+
 #endif // EMULATOR_WRAPPER_H
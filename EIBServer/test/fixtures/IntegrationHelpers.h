@@ -31,6 +31,9 @@ public:
                  std::istreambuf_iterator<char>());
         }
 
+        //    Start without commands journaled by previous runs.
+        std::remove("conf/" SCHEDULER_JOURNAL_FILE);
+
         // 1. Init emulator (loads conf/Emulator.conf, conf/Emulator.db, binds UDP :3671)
         _emu_ok = InitEmulator();
         ASSERT_TRUE(_emu_ok) << "Emulator Init() failed";
@@ -53,7 +56,7 @@ public:
         CEIBServer::GetInstance().Start();
 
         // 7. Wait until the HTTPS server is actually accepting connections
-        WaitForWebServer(CEIBServer::GetInstance().GetConfig().GetWEBServerPort());
+        WaitForWebServer(CEIBServer::GetInstance().GetConfig()->GetWEBServerPort());
     }
 
 private:
@@ -206,6 +209,31 @@ private:
     }
 };
 
+// ---------------------------------------------------------------------------
+// SendGroupFrame -- queues a group telegram on the server's EIB interface.
+// Unlike /api/eib/send it can send a group read (a single zero byte).
+// ---------------------------------------------------------------------------
+inline void SendGroupFrame(const char* address, unsigned char* value, int len) {
+    CCemi_L_Data_Frame msg;
+    msg.SetMessageControl(L_DATA_REQ);
+    msg.SetAddilLength(0);
+    msg.SetCtrl1(0);
+    msg.SetCtrl2(6);
+    msg.SetPriority(PRIORITY_NORMAL);
+    msg.SetFrameFormatStandard();
+    msg.SetSrcAddress(CEibAddress());
+    msg.SetDestAddress(CEibAddress(CString(address)));
+    msg.SetValue(value, len);
+    CEIBServer::GetInstance().GetEIBInterface().GetOutputHandler()->Write(msg, NON_BLOCKING, NULL);
+}
+
+// ---------------------------------------------------------------------------
+// Received -- frames the server's EIB interface received from the bus so far.
+// ---------------------------------------------------------------------------
+inline int Received() {
+    return CEIBServer::GetInstance().GetEIBInterface().GetInterfaceStats()._total_received;
+}
+
 } // namespace IntegrationTest
 
 #endif // INTEGRATION_HELPERS_H
@@ -27,7 +27,9 @@ CEIBServer::CEIBServer():
     _clients_mgr(NULL),
     _dispatcher(NULL),
     _scheduler(NULL),
-    _interface(NULL)
+    _interface(NULL),
+    _conf_watcher(NULL),
+    _current_conf(&_conf)
 {
 }
 
@@ -56,6 +58,10 @@ void CEIBServer::Start() {}
 
 void CEIBServer::ReloadConfiguration() {}
 
+void CEIBServer::ReloadServerConfig() {}
+
+void CEIBServer::ReloadUsersDB() {}
+
 void CEIBServer::InteractiveConf() {}
 
 // ---------------------------------------------------------------------------
@@ -93,6 +99,7 @@ CEIBHandler::CEIBHandler(HANDLER_TYPE type):
 CEIBHandler::~CEIBHandler() {}
 
 void CEIBHandler::Write(const CCemi_L_Data_Frame&, BlockingMode, JTCMonitor*) {}
+int CEIBHandler::Write(const vector<CCemi_L_Data_Frame>& frames, BlockingMode) { return (int)frames.size(); }
 void CEIBHandler::run() {}
 void CEIBHandler::Close() {}
 void CEIBHandler::Suspend() {}
@@ -106,6 +113,7 @@ CEIBServerUsersConf::CEIBServerUsersConf() {}
 CEIBServerUsersConf::~CEIBServerUsersConf() {}
 void CEIBServerUsersConf::ToXml(CDataBuffer&) {}
 void CEIBServerUsersConf::FromXml(const CDataBuffer&) {}
+void CEIBServerUsersConf::FromXml(const char*, int) {}
 void CEIBServerUsersConf::GetConnectedClients() {}
 void CEIBServerUsersConf::SetConnectedClients() {}
 
@@ -0,0 +1,144 @@
+// ClientHandshakeTest.cpp -- Connection acceptance pipeline tests
+// (handshake workers, pending table, per-source rate limit, metrics).
+
+#include "IntegrationHelpers.h"
+#include "GenericServer.h"
+#include "LogFile.h"
+#include <memory>
+#include <vector>
+
+using namespace IntegrationTest;
+
+class ClientHandshakeTest : public ::testing::Test {
+protected:
+    CLogFile log;
+
+    void SetUp() override {
+        log.SetPrinterMethod(printf);
+        log.SetPrompt(false);
+    }
+
+    ConnectionResult Connect(CGenericServer& client, const char* user, const char* pass) {
+        client.Init(&log);
+        CServerConfigPtr conf = CEIBServer::GetInstance().GetConfig();
+        return client.OpenConnection("TEST", "127.0.0.1", conf->GetListeningPort(),
+            conf->GetInitialKey().GetBuffer(), "127.0.0.1", user, pass);
+    }
+
+    HandshakeStats Stats() {
+        HandshakeStats stats;
+        CEIBServer::GetInstance().GetClientsManager()->GetHandshakeStats(stats);
+        return stats;
+    }
+
+    // Handshake metrics are recorded by the worker right after the client
+    // received its last reply, so poll instead of reading them immediately.
+    template <typename Pred>
+    HandshakeStats WaitForStats(Pred pred) {
+        HandshakeStats stats = Stats();
+        for (int i = 0; i < 100 && !pred(stats); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            stats = Stats();
+        }
+        return stats;
+    }
+
+    void WaitForDisconnect(int expected_clients) {
+        for (int i = 0; i < 50; ++i) {
+            if (CEIBServer::GetInstance().GetClientsManager()->GetNumConnectedClients() <= expected_clients)
+                return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+};
+
+TEST_F(ClientHandshakeTest, SingleClientAcceptedAndMeasured)
+{
+    HandshakeStats before = Stats();
+
+    CGenericServer client(EIB_TYPE_GENERIC);
+    ASSERT_EQ(Connect(client, "admin", "admin123"), STATUS_CONN_OK);
+
+    HandshakeStats after = WaitForStats([&](const HandshakeStats& s) {
+        return s._accepted > before._accepted; });
+    EXPECT_EQ(after._accepted, before._accepted + 1);
+    EXPECT_GT(after._max_latency_ms, 0.0);
+    EXPECT_LE(after._min_latency_ms, after._max_latency_ms);
+
+    CString ip;
+    int session_id = 0;
+    EXPECT_TRUE(CEIBServer::GetInstance().GetClientsManager()->IsClientConnected("admin", ip, session_id));
+    EXPECT_EQ(session_id, client.GetSessionID());
+
+    client.Close();
+    WaitForDisconnect(0);
+}
+
+TEST_F(ClientHandshakeTest, WrongPasswordCountsAsFailed)
+{
+    HandshakeStats before = Stats();
+
+    CGenericServer client(EIB_TYPE_GENERIC);
+    EXPECT_NE(Connect(client, "admin", "wrong-password"), STATUS_CONN_OK);
+
+    // The worker unregisters the client after the failed authentication
+    HandshakeStats after = WaitForStats([&](const HandshakeStats& s) {
+        return s._failed > before._failed; });
+    EXPECT_EQ(after._failed, before._failed + 1);
+    EXPECT_EQ(after._accepted, before._accepted);
+    WaitForDisconnect(0);
+    EXPECT_EQ(CEIBServer::GetInstance().GetClientsManager()->GetNumConnectedClients(), 0);
+}
+
+TEST_F(ClientHandshakeTest, ConcurrentClientsAreAcceptedInParallel)
+{
+    // Stay within the per-source rate limit (all clients share 127.0.0.1)
+    const int num_clients = CEIBServer::GetInstance().GetConfig()->GetHandshakeRateLimit();
+    HandshakeStats before = Stats();
+    std::this_thread::sleep_for(std::chrono::milliseconds(HANDSHAKE_RATE_WINDOW_MS));
+
+    std::vector<std::unique_ptr<CGenericServer>> clients;
+    std::vector<ConnectionResult> results(num_clients, STATUS_NO_REPLY);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_clients; ++i)
+        clients.emplace_back(new CGenericServer(EIB_TYPE_GENERIC));
+    for (int i = 0; i < num_clients; ++i) {
+        threads.emplace_back([this, &clients, &results, i]() {
+            results[i] = Connect(*clients[i], "admin", "admin123");
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    for (int i = 0; i < num_clients; ++i)
+        EXPECT_EQ(results[i], STATUS_CONN_OK) << "client " << i;
+
+    HandshakeStats after = WaitForStats([&](const HandshakeStats& s) {
+        return s._accepted >= before._accepted + num_clients && s._pending == 0; });
+    EXPECT_EQ(after._accepted, before._accepted + num_clients);
+    EXPECT_EQ(after._pending, 0u);
+
+    for (auto& c : clients)
+        c->Close();
+    WaitForDisconnect(0);
+}
+
+TEST_F(ClientHandshakeTest, FloodFromOneSourceIsRateLimited)
+{
+    HandshakeStats before = Stats();
+    std::this_thread::sleep_for(std::chrono::milliseconds(HANDSHAKE_RATE_WINDOW_MS));
+
+    // Garbage datagrams are enough: the acceptor limits before anything is parsed
+    CServerConfigPtr conf = CEIBServer::GetInstance().GetConfig();
+    UDPSocket sock;
+    char junk[16] = {0};
+    const int flood = conf->GetHandshakeRateLimit() * 3;
+    for (int i = 0; i < flood; ++i)
+        sock.SendTo(junk, sizeof(junk), "127.0.0.1", conf->GetListeningPort());
+
+    // Every datagram is either refused by the limiter or fails to parse
+    HandshakeStats after = WaitForStats([&](const HandshakeStats& s) {
+        return (s._rate_limited - before._rate_limited) + (s._failed - before._failed) >= (unsigned int)flood; });
+    EXPECT_GE(after._rate_limited - before._rate_limited, (unsigned int)(flood - conf->GetHandshakeRateLimit()));
+    EXPECT_EQ(after._accepted, before._accepted);
+}
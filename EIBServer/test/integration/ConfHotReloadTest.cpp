@@ -0,0 +1,91 @@
+// ConfHotReloadTest.cpp -- Users.db changes are picked up without a restart.
+
+#include "IntegrationHelpers.h"
+#include <fstream>
+#include <thread>
+#include <chrono>
+
+using namespace IntegrationTest;
+
+class ConfHotReloadTest : public ::testing::Test {
+protected:
+    HttpTestClient http;
+    std::string _saved_users_db;
+
+    void SetUp() override {
+        std::ifstream in("conf/Users.db");
+        ASSERT_TRUE(in.is_open());
+        _saved_users_db.assign(
+            (std::istreambuf_iterator<char>(in)),
+             std::istreambuf_iterator<char>());
+    }
+
+    void TearDown() override {
+        WriteUsersDb(_saved_users_db);
+        CEIBServer::GetInstance().ReloadConfiguration();
+    }
+
+    void WriteUsersDb(const std::string& content) {
+        std::ofstream out("conf/Users.db", std::ios::trunc);
+        out << content;
+    }
+
+    // Polls until pred() holds (the watcher reloads asynchronously)
+    template <class Pred>
+    bool WaitFor(Pred pred, int timeout_ms = 5000) {
+        for (int waited = 0; waited < timeout_ms; waited += 50) {
+            if (pred()) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        return pred();
+    }
+};
+
+TEST_F(ConfHotReloadTest, NewUserCanLoginAfterFileChange)
+{
+    ASSERT_EQ(http.Login("hotuser", "hot123").GetLength(), 0);
+
+    WriteUsersDb(_saved_users_db +
+        "\n[hotuser]\n"
+        "PASSWORD = hot123\n"
+        "PRIVILIGES = 5\n"
+        "ALLOWED_SOURCE_MASK = 0xFFFF\n"
+        "ALLOWED_DEST_MASK = 0xFFFF\n");
+
+    EXPECT_TRUE(WaitFor([&] { return http.Login("hotuser", "hot123").GetLength() > 0; }))
+        << "Users.db change was not picked up";
+}
+
+TEST_F(ConfHotReloadTest, ExistingSessionSeesNewPolicy)
+{
+    CString sid = http.Login("readonly", "readonly123");
+    ASSERT_GT(sid.GetLength(), 0);
+    HttpResponse resp = http.Get("/api/session", sid);
+    ASSERT_NE(resp.body.Find("\"write\":false"), string::npos) << resp.body.GetBuffer();
+
+    // Grant write access to readonly (5 -> 7)
+    std::string content = _saved_users_db;
+    size_t block = content.find("[readonly]");
+    ASSERT_NE(block, std::string::npos);
+    size_t priv = content.find("PRIVILIGES = 5", block);
+    ASSERT_NE(priv, std::string::npos);
+    content.replace(priv, strlen("PRIVILIGES = 5"), "PRIVILIGES = 7");
+    WriteUsersDb(content);
+
+    // Same session, no new login
+    EXPECT_TRUE(WaitFor([&] {
+        return http.Get("/api/session", sid).body.Find("\"write\":true") != string::npos;
+    })) << "Session did not pick up the new policy";
+}
+
+TEST_F(ConfHotReloadTest, InvalidFileKeepsCurrentUsers)
+{
+    unsigned int generation = CEIBServer::GetInstance().GetUsersDB().GetGeneration();
+
+    // An empty database fails validation and must not replace the live one
+    WriteUsersDb("");
+    CEIBServer::GetInstance().ReloadUsersDB();
+
+    EXPECT_EQ(CEIBServer::GetInstance().GetUsersDB().GetGeneration(), generation);
+    EXPECT_GT(http.Login("admin", "admin123").GetLength(), 0);
+}
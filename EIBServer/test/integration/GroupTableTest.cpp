@@ -0,0 +1,113 @@
+// GroupTableTest.cpp -- Tests the Emulator-ng group object table.
+//
+// Loads a CSV group table with per device profiles into the live
+// emulator and checks that group reads are answered with the device
+// latency, that lost confirmations/responses never reach the server,
+// and that the binary export loads back.
+
+#include "IntegrationHelpers.h"
+#include <fstream>
+#include <string>
+
+using namespace IntegrationTest;
+
+namespace {
+
+const char* kCsvFile = "conf/TestGroupTable.csv";
+const char* kBinFile = "conf/TestGroupTable.bin";
+
+const char* kGroupTable =
+    "# group,phy,value[,latency_ms,jitter_ms,confirm_loss,response_loss]\n"
+    "group,phy,value\n"
+    "6/0/1,6.6.1,0x15,300,0,0,0\n"
+    "6/0/2,6.6.2,0x01,0,0,100,100\n"
+    "6/0/3,6.6.3,0x0A0B\n";
+
+}  // namespace
+
+class GroupTableTest : public ::testing::Test {
+protected:
+
+    static void SetUpTestSuite() {
+        std::ofstream out(kCsvFile, std::ios::trunc);
+        out << kGroupTable;
+    }
+
+    static void TearDownTestSuite() {
+        std::remove(kCsvFile);
+        std::remove(kBinFile);
+    }
+
+    void SetUp() override {
+        ASSERT_EQ(EmulatorLoadGroupTable(kCsvFile), 3);
+    }
+
+    // the emulator is shared by all suites: do not leave the lossy 6.6.2 behind
+    void TearDown() override {
+        EmulatorRemoveGroup("6/0/1");
+        EmulatorRemoveGroup("6/0/2");
+        EmulatorRemoveGroup("6/0/3");
+    }
+
+    void SendRead(const char* address) {
+        unsigned char apci = 0;
+        SendGroupFrame(address, &apci, 1);
+    }
+};
+
+TEST_F(GroupTableTest, CsvRowsAreMerged)
+{
+    // reloading the same rows replaces them instead of adding duplicates
+    int count = EmulatorGroupCount();
+    ASSERT_EQ(EmulatorLoadGroupTable(kCsvFile), 3);
+    EXPECT_EQ(EmulatorGroupCount(), count);
+    EXPECT_EQ(EmulatorLoadGroupTable("conf/NoSuchTable.csv"), -1);
+}
+
+TEST_F(GroupTableTest, ReadIsAnsweredAfterDeviceLatency)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    int before = Received();
+    SendRead("6/0/1");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(Received(), before) << "answered before the device latency";
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(700));
+    // confirmation + group response
+    EXPECT_GE(Received(), before + 2);
+}
+
+TEST_F(GroupTableTest, LostConfirmationAndResponseAreNotSent)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    int before = Received();
+    SendRead("6/0/2");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    EXPECT_EQ(Received(), before);
+}
+
+TEST_F(GroupTableTest, RemovedGroupIsNotAnswered)
+{
+    int count = EmulatorGroupCount();
+    unsigned char value[4];
+    EXPECT_TRUE(EmulatorRemoveGroup("6/0/3"));
+    EXPECT_FALSE(EmulatorRemoveGroup("6/0/3"));
+    EXPECT_EQ(EmulatorGroupCount(), count - 1);
+    EXPECT_EQ(EmulatorGroupValue("6/0/3", value, sizeof(value)), 0);
+}
+
+TEST_F(GroupTableTest, BinaryExportLoadsBack)
+{
+    int count = EmulatorGroupCount();
+    ASSERT_TRUE(EmulatorSaveGroupTable(kBinFile));
+    EXPECT_EQ(EmulatorLoadGroupTable(kBinFile), count);
+    EXPECT_EQ(EmulatorGroupCount(), count);
+
+    // a CSV file is not a binary table
+    std::ofstream out(kBinFile, std::ios::trunc);
+    out << kGroupTable;
+    out.close();
+    EXPECT_EQ(EmulatorLoadGroupTable(kBinFile), -1);
+}
@@ -0,0 +1,227 @@
+// ImpairmentTest.cpp -- EIBServer under emulated network impairments.
+//
+// Each test switches on one impairment of the emulator's impairment stage,
+// pushes telegrams through the tunnel and checks what reached the server
+// and how long it took. The stage is then switched off and the time until
+// the server receives fresh telegrams again is measured (recovery time).
+
+#include "IntegrationHelpers.h"
+#include <fstream>
+
+using namespace IntegrationTest;
+
+namespace {
+
+const char* kTableFile = "conf/TestImpairment.csv";
+const char* kGroup = "7/0/1";
+const char* kWriteGroup = "7/0/2";
+
+typedef std::chrono::steady_clock Clock;
+
+long long ElapsedMs(const Clock::time_point& start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+}
+
+}  // namespace
+
+class ImpairmentTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        std::ofstream out(kTableFile, std::ios::trunc);
+        out << kWriteGroup << ",7.7.2,0x80\n";
+        out.close();
+        EmulatorLoadGroupTable(kTableFile);
+    }
+
+    static void TearDownTestSuite() {
+        EmulatorSetImpairment(EmulatorImpairmentProfile());
+        std::remove(kTableFile);
+    }
+
+    void TearDown() override {
+        EmulatorSetImpairment(EmulatorImpairmentProfile());
+    }
+
+    void SendIndications(int count) {
+        unsigned char value = 0x81;
+        for (int i = 0; i < count; ++i) {
+            EmulatorSendIndication(kGroup, &value, 1);
+        }
+    }
+
+    // Waits until the server received `count` telegrams since `before`,
+    // not counting the ones the stage dropped. Returns false on timeout.
+    bool WaitDelivered(int before, int count, int timeout_ms) {
+        Clock::time_point start = Clock::now();
+        while (ElapsedMs(start) < timeout_ms) {
+            if (Received() - before + EmulatorGetImpairmentStats().dropped >= count) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    }
+
+    // Switches the stage off and sends an indication every 250 ms until the
+    // server receives one. Returns the milliseconds that took, or -1.
+    long long RecoveryTime(int timeout_ms = 15000) {
+        EmulatorSetImpairment(EmulatorImpairmentProfile());
+        Clock::time_point start = Clock::now();
+        int before = Received();
+        while (ElapsedMs(start) < timeout_ms) {
+            SendIndications(1);
+            for (int i = 0; i < 25; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                if (Received() > before) {
+                    return ElapsedMs(start);
+                }
+            }
+        }
+        return -1;
+    }
+};
+
+TEST_F(ImpairmentTest, Baseline)
+{
+    const int count = 20;
+    int before = Received();
+    Clock::time_point start = Clock::now();
+    SendIndications(count);
+    ASSERT_TRUE(WaitDelivered(before, count, 5000));
+    long long elapsed = ElapsedMs(start);
+
+    EXPECT_EQ(Received() - before, count);
+    EXPECT_LT(elapsed, 2000) << "throughput " << count * 1000.0 / (elapsed + 1) << " telegrams/s";
+}
+
+TEST_F(ImpairmentTest, DroppedRequestsCostAnAckTimeout)
+{
+    EmulatorImpairmentProfile profile;
+    profile.drop = 30;
+    EmulatorSetImpairment(profile);
+
+    const int count = 10;
+    int before = Received();
+    Clock::time_point start = Clock::now();
+    SendIndications(count);
+    ASSERT_TRUE(WaitDelivered(before, count, 20000));
+    long long elapsed = ElapsedMs(start);
+
+    EmulatorImpairmentStats stats = EmulatorGetImpairmentStats();
+    ASSERT_GT(stats.dropped, 0);
+    // a dropped telegram is not retransmitted, its sequence number is reused
+    EXPECT_EQ(Received() - before, count - stats.dropped);
+    // the emulator waits for the ack of every dropped telegram
+    EXPECT_GE(elapsed, stats.dropped * 900LL);
+
+    long long recovery = RecoveryTime();
+    EXPECT_GE(recovery, 0);
+    EXPECT_LT(recovery, 1000);
+}
+
+TEST_F(ImpairmentTest, DuplicatesAreIgnoredByServer)
+{
+    EmulatorImpairmentProfile profile;
+    profile.duplicate = 100;
+    EmulatorSetImpairment(profile);
+
+    const int count = 10;
+    int before = Received();
+    Clock::time_point start = Clock::now();
+    SendIndications(count);
+    ASSERT_TRUE(WaitDelivered(before, count, 5000));
+    long long elapsed = ElapsedMs(start);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    EXPECT_EQ(EmulatorGetImpairmentStats().duplicated, count);
+    EXPECT_EQ(Received() - before, count) << "duplicates reached the server";
+    EXPECT_LT(elapsed, 2000);
+
+    long long recovery = RecoveryTime();
+    EXPECT_GE(recovery, 0);
+    EXPECT_LT(recovery, 1000);
+}
+
+TEST_F(ImpairmentTest, DelayBoundsThroughput)
+{
+    EmulatorImpairmentProfile profile;
+    profile.delay = "constant";
+    profile.delay_mean = 50;
+    EmulatorSetImpairment(profile);
+
+    const int count = 10;
+    int before = Received();
+    Clock::time_point start = Clock::now();
+    SendIndications(count);
+    ASSERT_TRUE(WaitDelivered(before, count, 5000));
+    long long elapsed = ElapsedMs(start);
+
+    EXPECT_EQ(Received() - before, count);
+    // stop-and-wait: one delayed telegram in flight at a time
+    EXPECT_GE(elapsed, count * 50LL - 50);
+    EXPECT_LT(elapsed, 3000);
+    EXPECT_EQ(EmulatorGetImpairmentStats().delayed, count);
+
+    long long recovery = RecoveryTime();
+    EXPECT_GE(recovery, 0);
+    EXPECT_LT(recovery, 1000);
+}
+
+TEST_F(ImpairmentTest, ServerRecoversFromReordering)
+{
+    EmulatorImpairmentProfile profile;
+    profile.reorder = 50;
+    profile.reorder_window = 2;
+    EmulatorSetImpairment(profile);
+
+    const int count = 10;
+    int before = Received();
+    SendIndications(count);
+    // every telegram leaves the stage once (held ones after at most IMPAIRMENT_MAX_HOLD)
+    Clock::time_point start = Clock::now();
+    while (EmulatorGetImpairmentStats().sent < count && ElapsedMs(start) < 20000) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    EmulatorImpairmentStats stats = EmulatorGetImpairmentStats();
+    ASSERT_GT(stats.reordered, 0);
+    EXPECT_GT(Received() - before, 0);
+    EXPECT_LE(Received() - before, count);
+
+    // late sequence numbers make the server resynchronise (Reconnect() waits 3 s)
+    long long recovery = RecoveryTime();
+    EXPECT_GE(recovery, 0);
+    EXPECT_LT(recovery, 8000);
+}
+
+TEST_F(ImpairmentTest, ServerRecoversFromSuppressedAck)
+{
+    EmulatorImpairmentProfile profile;
+    profile.ack_suppress = 100;
+    EmulatorSetImpairment(profile);
+
+    unsigned char value = 0x81;
+    SendGroupFrame(kWriteGroup, &value, 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    EXPECT_EQ(EmulatorGetImpairmentStats().acks_suppressed, 1);
+
+    unsigned char current[14];
+    ASSERT_EQ(EmulatorGroupValue(kWriteGroup, current, sizeof(current)), 1);
+    EXPECT_EQ(current[0], 0x81) << "the request was processed, only its ack was lost";
+
+    // the server does not retransmit, so its next request carries the
+    // unacked sequence number and is acked and discarded as a repeat
+    EmulatorSetImpairment(EmulatorImpairmentProfile());
+    Clock::time_point start = Clock::now();
+    long long recovery = -1;
+    for (unsigned char v = 0x82; v < 0x90 && recovery < 0; ++v) {
+        SendGroupFrame(kWriteGroup, &v, 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        EmulatorGroupValue(kWriteGroup, current, sizeof(current));
+        if (current[0] == v) {
+            recovery = ElapsedMs(start);
+        }
+    }
+    EXPECT_GE(recovery, 0);
+    EXPECT_LT(recovery, 1000);
+}
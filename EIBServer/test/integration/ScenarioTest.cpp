@@ -0,0 +1,147 @@
+// ScenarioTest.cpp -- Tests the Emulator-ng load scenario engine.
+//
+// Runs small scenario files against the live emulator and checks the
+// record file: telegram count, pacing, and that a seeded scenario sends
+// the same telegrams on every run.
+
+#include "IntegrationHelpers.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace IntegrationTest;
+
+namespace {
+
+const char* kScenarioFile = "conf/TestScenario.conf";
+
+void WriteScenario(const std::string& content) {
+    std::ofstream out(kScenarioFile, std::ios::trunc);
+    out << content;
+}
+
+std::vector<std::string> ReadRecord(const std::string& file_name) {
+    std::vector<std::string> lines;
+    std::ifstream in(file_name.c_str());
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty()) lines.push_back(line);
+    }
+    return lines;
+}
+
+std::vector<std::string> Split(const std::string& line) {
+    std::vector<std::string> fields;
+    size_t start = 0, pos;
+    while ((pos = line.find(',', start)) != std::string::npos) {
+        fields.push_back(line.substr(start, pos - start));
+        start = pos + 1;
+    }
+    fields.push_back(line.substr(start));
+    return fields;
+}
+
+const char* kLoadScenario =
+    "[SCENARIO]\n"
+    "SEED = 7\n"
+    "PHY = 1.1.200\n"
+    "\n"
+    "[burst]\n"
+    "TYPE = SCENE\n"
+    "ADDRESS = 5/0/0\n"
+    "COUNT = 5\n"
+    "SPREAD = 20\n"
+    "VALUE = 0x01\n"
+    "\n"
+    "[sensors]\n"
+    "TYPE = STREAM\n"
+    "START = 10\n"
+    "DURATION = 100\n"
+    "ADDRESS = 5/1/0\n"
+    "COUNT = 2\n"
+    "RATE = 50\n"
+    "VALUE_LEN = 3\n"
+    "\n"
+    "[reads]\n"
+    "TYPE = READ_STORM\n"
+    "START = 50\n"
+    "ADDRESS = 5/2/0\n"
+    "COUNT = 3\n"
+    "SPREAD = 10\n";
+
+}  // namespace
+
+class ScenarioTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        std::remove(kScenarioFile);
+    }
+};
+
+TEST_F(ScenarioTest, RunsAllStepsAndRecordsTelegrams)
+{
+    WriteScenario(kLoadScenario);
+    ASSERT_TRUE(EmulatorRunScenario(kScenarioFile));
+    ASSERT_TRUE(EmulatorWaitScenario(5000)) << "Scenario did not complete";
+
+    // 5 scene writes + 2 addresses * 50/s * 100 ms + 3 reads
+    EXPECT_EQ(5 + 10 + 3, EmulatorScenarioSentCount());
+
+    std::vector<std::string> lines = ReadRecord(EmulatorScenarioRecordFile());
+    ASSERT_EQ(1u + 18u, lines.size());
+    EXPECT_EQ("seq,scheduled_us,actual_us,step,type,address,value", lines[0]);
+
+    long long last_scheduled = -1;
+    long long last_read = -1;
+    int reads = 0;
+    for (size_t i = 1; i < lines.size(); ++i) {
+        std::vector<std::string> f = Split(lines[i]);
+        ASSERT_EQ(7u, f.size()) << lines[i];
+        long long scheduled = std::stoll(f[1]);
+        long long actual = std::stoll(f[2]);
+        EXPECT_GE(scheduled, last_scheduled) << "telegrams must be sent in deadline order";
+        EXPECT_GE(actual, scheduled) << "a telegram must never be sent early";
+        last_scheduled = scheduled;
+        if (f[4] == "READ_STORM") {
+            ++reads;
+            last_read = scheduled;
+            EXPECT_EQ("0x00", f[6]);
+        }
+    }
+    EXPECT_EQ(3, reads);
+    // the last read is scheduled at START + 2/3 of SPREAD
+    EXPECT_EQ(50000 + 2 * 10000 / 3, last_read);
+    // the stream sends every 10 ms from 10 ms until before 110 ms
+    EXPECT_EQ(100000, last_scheduled);
+}
+
+TEST_F(ScenarioTest, SeededScenarioIsReproducible)
+{
+    WriteScenario(kLoadScenario);
+
+    std::vector<std::string> runs[2];
+    std::string records[2];
+    for (int run = 0; run < 2; ++run) {
+        ASSERT_TRUE(EmulatorRunScenario(kScenarioFile));
+        ASSERT_TRUE(EmulatorWaitScenario(5000));
+        records[run] = EmulatorScenarioRecordFile();
+        std::vector<std::string> lines = ReadRecord(records[run]);
+        for (size_t i = 1; i < lines.size(); ++i) {
+            std::vector<std::string> f = Split(lines[i]);
+            // everything but the actual send time
+            runs[run].push_back(f[1] + "," + f[3] + "," + f[5] + "," + f[6]);
+        }
+    }
+    ASSERT_FALSE(runs[0].empty());
+    EXPECT_EQ(runs[0], runs[1]);
+    // the second run must not overwrite the record of the first
+    EXPECT_NE(records[0], records[1]);
+}
+
+TEST_F(ScenarioTest, InvalidScenarioIsRejected)
+{
+    WriteScenario("[broken]\nTYPE = STREAM\nADDRESS = 5/0/0\n");
+    EXPECT_FALSE(EmulatorRunScenario(kScenarioFile));
+
+    EXPECT_FALSE(EmulatorRunScenario("conf/NoSuchScenario.conf"));
+}
@@ -11,15 +11,15 @@ protected:
 
 TEST_F(ServerLifecycleTest, ServerIsRunning)
 {
-    EXPECT_TRUE(CEIBServer::GetInstance().GetConfig().GetLoadOK());
+    EXPECT_TRUE(CEIBServer::GetInstance().GetConfig()->GetLoadOK());
 }
 
 TEST_F(ServerLifecycleTest, ConfigValuesCorrect)
 {
-    CServerConfig& conf = CEIBServer::GetInstance().GetConfig();
-    EXPECT_EQ(conf.GetListeningPort(), 15000);
-    EXPECT_EQ(conf.GetWEBServerPort(), 18080);
-    EXPECT_EQ(conf.GetEibDeviceAddress(), CString("127.0.0.1"));
+    CServerConfigPtr conf = CEIBServer::GetInstance().GetConfig();
+    EXPECT_EQ(conf->GetListeningPort(), 15000);
+    EXPECT_EQ(conf->GetWEBServerPort(), 18080);
+    EXPECT_EQ(conf->GetEibDeviceAddress(), CString("127.0.0.1"));
 }
 
 TEST_F(ServerLifecycleTest, UsersDBLoaded)
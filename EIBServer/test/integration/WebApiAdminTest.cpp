@@ -107,6 +107,34 @@ TEST_F(WebApiAdminTest, SetUsersAddsNewUser)
                          std::istreambuf_iterator<char>());
     EXPECT_NE(content.find("[newuser]"), std::string::npos)
         << "Users.db does not contain [newuser]. Content:\n" << content;
-    EXPECT_NE(content.find("PASSWORD = newpass"), std::string::npos)
-        << "Users.db does not contain newuser's password. Content:\n" << content;
+    EXPECT_EQ(content.find("newpass"), std::string::npos)
+        << "Users.db stores newuser's password in plain text. Content:\n" << content;
+    EXPECT_NE(content.find("PASSWORD = " USER_PASSWORD_HASH_PREFIX), std::string::npos)
+        << "Users.db does not contain a hashed password. Content:\n" << content;
+
+    // The reloaded database verifies the hashed password
+    EXPECT_GT(http.Login("newuser", "newpass").GetLength(), 0);
+    EXPECT_EQ(http.Login("newuser", "wrong").GetLength(), 0);
+}
+
+TEST_F(WebApiAdminTest, SetUsersRejectsMalformedXml)
+{
+    // The list is cut in the middle of a user: nothing may be applied
+    CString xml =
+        "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+        "<Root><EIB_SERVER_USERS_LIST>"
+        "<EIB_SERVER_USER>"
+            "<EIB_SERVER_USER_NAME>newuser</EIB_SERVER_USER_NAME>"
+            "<EIB_SERVER_USER_PASSWORD>newpass</EIB_SERVER_USER_PASSWORD>";
+
+    HttpResponse resp = http.PostXml("/api/admin/users", xml, admin_sid);
+    EXPECT_EQ(resp.status_code, 500)
+        << "Body: " << resp.body.GetBuffer();
+
+    std::ifstream db_file("conf/Users.db");
+    ASSERT_TRUE(db_file.is_open()) << "Could not open conf/Users.db";
+    std::string content((std::istreambuf_iterator<char>(db_file)),
+                         std::istreambuf_iterator<char>());
+    EXPECT_EQ(content, _saved_users_db);
+    EXPECT_GT(http.Login("admin", "admin123").GetLength(), 0);
 }
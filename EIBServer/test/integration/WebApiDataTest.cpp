@@ -58,3 +58,40 @@ TEST_F(WebApiDataTest, ScheduleCommand)
     EXPECT_EQ(resp.status_code, 200)
         << "Body: " << resp.body.GetBuffer();
 }
+
+TEST_F(WebApiDataTest, ScheduleCronCommandAndCancel)
+{
+    CString body("{\"address\":\"0/0/1\",\"value\":\"0x01\",\"cron\":\"0 7 * * 1-5\"}");
+    HttpResponse resp = http.Post("/api/eib/schedule", body, admin_sid);
+    ASSERT_EQ(resp.status_code, 200) << "Body: " << resp.body.GetBuffer();
+
+    // Send the id back exactly as the schedule API returned it
+    size_t pos = resp.body.Find("\"id\":");
+    ASSERT_NE(pos, string::npos) << "Body: " << resp.body.GetBuffer();
+    size_t end = resp.body.GetSTDString().find_first_of("},", pos);
+    ASSERT_NE(end, string::npos) << "Body: " << resp.body.GetBuffer();
+    CString cancel("{");
+    cancel += resp.body.SubString((int)pos, (int)(end - pos));
+    cancel += "}";
+    ASSERT_GT(atoi(resp.body.GetBuffer() + pos + 5), 0) << "Body: " << resp.body.GetBuffer();
+    resp = http.Post("/api/eib/schedule/cancel", cancel, admin_sid);
+    EXPECT_EQ(resp.status_code, 200) << "Body: " << resp.body.GetBuffer();
+
+    // Second cancel of the same id fails
+    resp = http.Post("/api/eib/schedule/cancel", cancel, admin_sid);
+    EXPECT_EQ(resp.status_code, 404);
+}
+
+TEST_F(WebApiDataTest, ScheduleSunOffsetMustBeANumber)
+{
+    CString body("{\"address\":\"0/0/1\",\"value\":\"0x01\",\"sun\":\"sunset\",\"offset\":\"soon\"}");
+    HttpResponse resp = http.Post("/api/eib/schedule", body, admin_sid);
+    EXPECT_EQ(resp.status_code, 400) << "Body: " << resp.body.GetBuffer();
+}
+
+TEST_F(WebApiDataTest, ScheduleInvalidCronRejected)
+{
+    CString body("{\"address\":\"0/0/1\",\"value\":\"0x01\",\"cron\":\"61 * * * *\"}");
+    HttpResponse resp = http.Post("/api/eib/schedule", body, admin_sid);
+    EXPECT_NE(resp.status_code, 200) << "Body: " << resp.body.GetBuffer();
+}
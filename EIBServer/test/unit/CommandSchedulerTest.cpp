@@ -64,6 +64,9 @@ protected:
 
 CCommandScheduler* CommandSchedulerTest::scheduler_ = nullptr;
 
+// JTC threads must be reference counted, never destroyed on the stack
+typedef JTCHandleT<CCommandScheduler> SchedulerHandle;
+
 TEST_F(CommandSchedulerTest, AddScheduledCommand_FutureTime_Succeeds)
 {
     CTime future;
@@ -97,3 +100,266 @@ TEST_F(CommandSchedulerTest, AddScheduledCommand_CurrentTime_Fails)
     CString err;
     EXPECT_FALSE(scheduler_->AddScheduledCommand(now, CEibAddress("1/2/3"), val, 2, err));
 }
+
+TEST_F(CommandSchedulerTest, ScheduleCommand_ReturnsIdAndCancels)
+{
+    unsigned char val[] = { 0x00, 0x81 };
+    CTime future;
+    future.SetNow();
+    future += 7200;
+
+    CString err;
+    unsigned int id = scheduler_->ScheduleCommand(ScheduledCommand(future, CEibAddress("1/2/4"), val, 2), err);
+    ASSERT_NE(id, 0u) << err.GetBuffer();
+
+    ScheduledCommand cmd;
+    ASSERT_TRUE(scheduler_->GetScheduledCommand(id, cmd));
+    EXPECT_EQ(cmd._time.GetTime(), future.GetTime());
+
+    EXPECT_TRUE(scheduler_->CancelScheduledCommand(id));
+    EXPECT_FALSE(scheduler_->GetScheduledCommand(id, cmd));
+    EXPECT_FALSE(scheduler_->CancelScheduledCommand(id));
+}
+
+TEST_F(CommandSchedulerTest, CollectDueCommands_OnlyDueOnesInOrder)
+{
+    SchedulerHandle sched = new CCommandScheduler();
+    unsigned char val[] = { 0x00, 0x80 };
+    time_t now = time(NULL);
+    CString err;
+
+    unsigned int late = sched->ScheduleCommand(ScheduledCommand(CTime(now + 200), CEibAddress("1/1/2"), val, 2), err);
+    unsigned int early = sched->ScheduleCommand(ScheduledCommand(CTime(now + 100), CEibAddress("1/1/1"), val, 2), err);
+    unsigned int cancelled = sched->ScheduleCommand(ScheduledCommand(CTime(now + 50), CEibAddress("1/1/3"), val, 2), err);
+    sched->ScheduleCommand(ScheduledCommand(CTime(now + 5000), CEibAddress("1/1/4"), val, 2), err);
+    ASSERT_TRUE(sched->CancelScheduledCommand(cancelled));
+    EXPECT_EQ(sched->GetNextDueTime(), now + 100);
+
+    vector<ScheduledCommand> due;
+    EXPECT_EQ(sched->CollectDueCommands(now + 300, due), 2);
+    ASSERT_EQ(due.size(), 2u);
+    EXPECT_EQ(due[0]._id, early);
+    EXPECT_EQ(due[1]._id, late);
+    EXPECT_EQ(sched->GetNumScheduledCommands(), 1);
+    EXPECT_EQ(sched->GetNextDueTime(), now + 5000);
+}
+
+TEST_F(CommandSchedulerTest, CronCommand_IsRescheduledAfterFiring)
+{
+    SchedulerHandle sched = new CCommandScheduler();
+    ScheduledCommand cmd;
+    cmd._type = SCHEDULE_CRON;
+    cmd._cron = "*/15 * * * *";
+    cmd._dst = CEibAddress("2/0/1");
+    cmd._value_len = 1;
+    cmd._value[0] = 0x01;
+
+    CString err;
+    unsigned int id = sched->ScheduleCommand(cmd, err);
+    ASSERT_NE(id, 0u) << err.GetBuffer();
+
+    time_t first = sched->GetNextDueTime();
+    vector<ScheduledCommand> due;
+    EXPECT_EQ(sched->CollectDueCommands(first, due), 1);
+    EXPECT_EQ(sched->GetNumScheduledCommands(), 1);
+    EXPECT_EQ(sched->GetNextDueTime(), first + 15 * 60);
+}
+
+TEST_F(CommandSchedulerTest, SunCommand_RequiresLocation)
+{
+    SchedulerHandle sched = new CCommandScheduler();
+    ScheduledCommand cmd;
+    cmd._type = SCHEDULE_SUNSET;
+    cmd._dst = CEibAddress("2/0/2");
+    cmd._value_len = 1;
+
+    CString err;
+    EXPECT_EQ(sched->ScheduleCommand(cmd, err), 0u);
+    EXPECT_TRUE(err.GetLength() > 0);
+
+    sched->SetLocation(52.52, 13.40);
+    err.Clear();
+    EXPECT_NE(sched->ScheduleCommand(cmd, err), 0u) << err.GetBuffer();
+    EXPECT_GT(sched->GetNextDueTime(), time(NULL));
+}
+
+TEST_F(CommandSchedulerTest, Journal_ReplaysLiveCommands)
+{
+    CString journal("CommandSchedulerTest.journal");
+    remove(journal.GetBuffer());
+    time_t now = time(NULL);
+    unsigned char val[] = { 0x00, 0x81 };
+    unsigned int kept, cron;
+    {
+        SchedulerHandle sched = new CCommandScheduler();
+        ASSERT_TRUE(sched->Init(journal));
+        CString err;
+        kept = sched->ScheduleCommand(ScheduledCommand(CTime(now + 3600), CEibAddress("3/1/7"), val, 2), err);
+        unsigned int removed = sched->ScheduleCommand(ScheduledCommand(CTime(now + 1800), CEibAddress("3/1/8"), val, 2), err);
+        ScheduledCommand cmd;
+        cmd._type = SCHEDULE_CRON;
+        cmd._cron = "0 7 * * 1-5";
+        cmd._dst = CEibAddress("3/1/9");
+        cmd._value_len = 1;
+        cron = sched->ScheduleCommand(cmd, err);
+        ASSERT_TRUE(sched->CancelScheduledCommand(removed));
+    }
+
+    SchedulerHandle replayed = new CCommandScheduler();
+    ASSERT_TRUE(replayed->Init(journal));
+    EXPECT_EQ(replayed->GetNumScheduledCommands(), 2);
+
+    ScheduledCommand cmd;
+    ASSERT_TRUE(replayed->GetScheduledCommand(kept, cmd));
+    EXPECT_EQ(cmd._time.GetTime(), now + 3600);
+    EXPECT_TRUE(cmd._dst == CEibAddress("3/1/7"));
+    EXPECT_TRUE(cmd._dst.IsGroupAddress());
+    ASSERT_EQ(cmd._value_len, 2);
+    EXPECT_EQ(cmd._value[1], 0x81);
+
+    ASSERT_TRUE(replayed->GetScheduledCommand(cron, cmd));
+    EXPECT_EQ(cmd._type, SCHEDULE_CRON);
+    EXPECT_STREQ(cmd._cron.GetBuffer(), "0 7 * * 1-5");
+
+    //new ids continue after the replayed ones
+    CString err;
+    EXPECT_GT(replayed->ScheduleCommand(ScheduledCommand(CTime(now + 60), CEibAddress("3/1/7"), val, 2), err), cron);
+    remove(journal.GetBuffer());
+}
+
+TEST_F(CommandSchedulerTest, Journal_EmptyValueAndBadRecords)
+{
+    CString journal("CommandSchedulerTest.journal");
+    remove(journal.GetBuffer());
+    time_t now = time(NULL);
+    unsigned int once, cron;
+    {
+        SchedulerHandle sched = new CCommandScheduler();
+        ASSERT_TRUE(sched->Init(journal));
+        CString err;
+        once = sched->ScheduleCommand(ScheduledCommand(CTime(now + 3600), CEibAddress("3/1/7"), NULL, 0), err);
+        ScheduledCommand cmd;
+        cmd._type = SCHEDULE_CRON;
+        cmd._cron = "0 7 * * 1-5";
+        cmd._dst = CEibAddress("3/1/9");
+        cmd._value_len = 0;
+        cron = sched->ScheduleCommand(cmd, err);
+        ASSERT_NE(cron, 0u) << err.GetBuffer();
+    }
+    // hand edited records: too long, odd length, not hex
+    FILE* f = fopen(journal.GetBuffer(), "a");
+    ASSERT_TRUE(f != NULL);
+    fprintf(f, "A 900 0 %lld 6407 1 0 %s\n", (long long)now + 3600, std::string(80, 'A').c_str());
+    fprintf(f, "A 901 0 %lld 6407 1 0 0A0B0C0D0E0F101112131415161718\n", (long long)now + 3600);
+    fprintf(f, "A 902 0 %lld 6407 1 0 ABC\n", (long long)now + 3600);
+    fprintf(f, "A 903 0 %lld 6407 1 0 zz\n", (long long)now + 3600);
+    fclose(f);
+
+    SchedulerHandle replayed = new CCommandScheduler();
+    ASSERT_TRUE(replayed->Init(journal));
+    EXPECT_EQ(replayed->GetNumScheduledCommands(), 2);
+
+    ScheduledCommand cmd;
+    ASSERT_TRUE(replayed->GetScheduledCommand(once, cmd));
+    EXPECT_EQ(cmd._value_len, 0);
+    ASSERT_TRUE(replayed->GetScheduledCommand(cron, cmd));
+    EXPECT_EQ(cmd._value_len, 0);
+    EXPECT_STREQ(cmd._cron.GetBuffer(), "0 7 * * 1-5");
+    remove(journal.GetBuffer());
+}
+
+// ---------------------------------------------------------------------------
+// CCronExpression
+// ---------------------------------------------------------------------------
+
+TEST(CronExpression, ParseRejectsInvalid)
+{
+    CCronExpression cron;
+    EXPECT_FALSE(cron.Parse(""));
+    EXPECT_FALSE(cron.Parse("* * * *"));
+    EXPECT_FALSE(cron.Parse("* * * * * *"));
+    EXPECT_FALSE(cron.Parse("60 * * * *"));
+    EXPECT_FALSE(cron.Parse("* 24 * * *"));
+    EXPECT_FALSE(cron.Parse("* * 0 * *"));
+    EXPECT_FALSE(cron.Parse("*/0 * * * *"));
+    EXPECT_FALSE(cron.Parse("5-1 * * * *"));
+    EXPECT_FALSE(cron.Parse("a * * * *"));
+    EXPECT_TRUE(cron.Parse("0,30 8-18/2 1 1-12 0-7"));
+}
+
+TEST(CronExpression, NextMatchesFields)
+{
+    CCronExpression cron;
+    ASSERT_TRUE(cron.Parse("30 14 * * *"));
+
+    time_t now = time(NULL);
+    time_t next = cron.Next(now);
+    ASSERT_GT(next, now);
+    EXPECT_LE(next, now + 25 * 3600);
+
+    struct tm tm;
+    localtime_r(&next, &tm);
+    EXPECT_EQ(tm.tm_hour, 14);
+    EXPECT_EQ(tm.tm_min, 30);
+    EXPECT_EQ(tm.tm_sec, 0);
+    //the following match is one day later
+    time_t after = cron.Next(next);
+    struct tm tm2;
+    localtime_r(&after, &tm2);
+    EXPECT_EQ(tm2.tm_hour, 14);
+    EXPECT_EQ(tm2.tm_min, 30);
+    EXPECT_NE(tm2.tm_mday, tm.tm_mday);
+}
+
+TEST(CronExpression, DayOfWeekAndDayOfMonth)
+{
+    CCronExpression weekdays;
+    ASSERT_TRUE(weekdays.Parse("0 0 * * 1-5"));
+    CCronExpression fridays_or_13th;
+    ASSERT_TRUE(fridays_or_13th.Parse("0 0 13 * 5"));
+
+    time_t t = time(NULL);
+    for (int i = 0; i < 20; ++i) {
+        t = weekdays.Next(t);
+        struct tm tm;
+        localtime_r(&t, &tm);
+        EXPECT_GE(tm.tm_wday, 1);
+        EXPECT_LE(tm.tm_wday, 5);
+    }
+
+    t = time(NULL);
+    for (int i = 0; i < 20; ++i) {
+        t = fridays_or_13th.Next(t);
+        struct tm tm;
+        localtime_r(&t, &tm);
+        EXPECT_TRUE(tm.tm_wday == 5 || tm.tm_mday == 13);
+    }
+}
+
+TEST(CronExpression, NeverMatchingReturnsZero)
+{
+    CCronExpression cron;
+    ASSERT_TRUE(cron.Parse("0 0 31 2 *"));
+    EXPECT_EQ(cron.Next(time(NULL)), 0);
+}
+
+// ---------------------------------------------------------------------------
+// CSunCalculator
+// ---------------------------------------------------------------------------
+
+TEST(SunCalculator, LondonMidsummer)
+{
+    // 2024-06-21 12:00 UTC. Sunrise 03:43 UTC, sunset 20:21 UTC
+    time_t day = 1718971200;
+    time_t sunrise, sunset;
+    ASSERT_TRUE(CSunCalculator::GetSunTimes(day, 51.5074, -0.1278, sunrise, sunset));
+    EXPECT_NEAR((double)sunrise, (double)(1718941380), 180.0);
+    EXPECT_NEAR((double)sunset, (double)(1719001260), 180.0);
+}
+
+TEST(SunCalculator, PolarDayHasNoSunset)
+{
+    time_t day = 1718971200;
+    time_t sunrise, sunset;
+    EXPECT_FALSE(CSunCalculator::GetSunTimes(day, 80.0, 15.0, sunrise, sunset));
+}
@@ -124,6 +124,9 @@ TEST(CUsersDB, OnReadRecordComplete_AddsToMap)
     EXPECT_EQ(db.GetNumOfUsers(), 1);
     CUser found;
     EXPECT_TRUE(db.AuthenticateUser("testuser", "pw", found));
+    // Plain text passwords read from file are hashed on load
+    EXPECT_TRUE(CUser::IsPasswordHash(found.GetPassword()));
+    EXPECT_FALSE(db.AuthenticateUser("testuser", "PW", found));
 }
 
 // ---------------------------------------------------------------------------
@@ -157,7 +160,11 @@ TEST(CUsersDB, OnSaveRecordStarted_SerializesAllFields)
         }
         if (kv.first == USER_PASSWORD_PARAM_NAME) {
             found_pass = true;
-            EXPECT_STREQ(kv.second.GetBuffer(), "pw");
+            // Plain text passwords are hashed on the way to disk
+            EXPECT_TRUE(CUser::IsPasswordHash(kv.second));
+            CUser stored;
+            stored.SetPassword(kv.second);
+            EXPECT_TRUE(stored.VerifyPassword("pw"));
         }
         if (kv.first == USER_ALLOWED_SOURCE_MASK) found_src = true;
         if (kv.first == USER_ALLOWED_DEST_MASK) found_dst = true;
@@ -167,3 +174,103 @@ TEST(CUsersDB, OnSaveRecordStarted_SerializesAllFields)
     EXPECT_TRUE(found_src);
     EXPECT_TRUE(found_dst);
 }
+
+// ---------------------------------------------------------------------------
+// Password hashing
+// ---------------------------------------------------------------------------
+
+TEST(CUser, HashPassword_VerifiesOnlyOriginal)
+{
+    CUser user;
+    user.SetPassword(CUser::HashPassword("s3cret"));
+    EXPECT_TRUE(CUser::IsPasswordHash(user.GetPassword()));
+    EXPECT_TRUE(user.VerifyPassword("s3cret"));
+    EXPECT_FALSE(user.VerifyPassword("s3cre"));
+    EXPECT_FALSE(user.VerifyPassword(""));
+}
+
+TEST(CUser, HashPassword_IsSalted)
+{
+    CString h1 = CUser::HashPassword("same");
+    CString h2 = CUser::HashPassword("same");
+    EXPECT_NE(h1, h2);
+}
+
+TEST(CUser, HashPassword_KeepsIterationCount)
+{
+    CUser user;
+    user.SetPassword(CUser::HashPassword("pw", 1000));
+    EXPECT_EQ(user.GetPassword().Find("$pbkdf2-sha256$1000$"), 0u);
+    EXPECT_TRUE(user.VerifyPassword("pw"));
+}
+
+TEST(CUser, VerifyPassword_MalformedHash)
+{
+    CUser user;
+    user.SetPassword(USER_PASSWORD_HASH_PREFIX "10$zz$00");
+    EXPECT_FALSE(user.VerifyPassword("pw"));
+    user.SetPassword(USER_PASSWORD_HASH_PREFIX "broken");
+    EXPECT_FALSE(user.VerifyPassword("pw"));
+}
+
+// ---------------------------------------------------------------------------
+// User snapshots
+// ---------------------------------------------------------------------------
+
+TEST_F(UsersDBTest, GetUserSnapshot_IsShared)
+{
+    CUserSnapshot s1 = db.GetUserSnapshot("alice");
+    CUserSnapshot s2 = db.GetUserSnapshot("alice");
+    ASSERT_TRUE(s1 != NULL);
+    EXPECT_EQ(s1.get(), s2.get());
+    EXPECT_STREQ(s1->GetName().GetBuffer(), "alice");
+    EXPECT_TRUE(db.GetUserSnapshot("charlie") == NULL);
+}
+
+TEST_F(UsersDBTest, AuthenticateUser_ReturnsSnapshot)
+{
+    CUserSnapshot user = db.AuthenticateUser("bob", "hunter2");
+    ASSERT_TRUE(user != NULL);
+    EXPECT_TRUE(user->IsWritePolicyAllowed());
+    EXPECT_TRUE(db.AuthenticateUser("bob", "wrong") == NULL);
+}
+
+TEST_F(UsersDBTest, AddRecord_RepublishesTable)
+{
+    CUsersTableSnapshot before = db.GetUsersTable();
+    unsigned int generation = db.GetGeneration();
+
+    CUser carol;
+    carol.SetName("carol");
+    db.AddRecord("carol", carol);
+
+    CUsersTableSnapshot after = db.GetUsersTable();
+    EXPECT_NE(db.GetGeneration(), generation);
+    EXPECT_EQ(before->size(), 2u);
+    EXPECT_EQ(after->size(), 3u);
+    EXPECT_TRUE(db.GetUserSnapshot("carol") != NULL);
+}
+
+TEST_F(UsersDBTest, Replace_PublishesNewRecords)
+{
+    CUserSnapshot old_alice = db.GetUserSnapshot("alice");
+
+    CUsersDB fresh;
+    CUser alice;
+    alice.SetName("alice");
+    alice.SetPassword("changed");
+    alice.SetPriviliges(USER_POLICY_READ_ACCESS | USER_POLICY_WRITE_ACCESS);
+    fresh.AddRecord("alice", alice);
+
+    unsigned int generation = db.GetGeneration();
+    db.Replace(fresh);
+    EXPECT_NE(db.GetGeneration(), generation);
+
+    // Old snapshots stay valid for readers still holding them
+    EXPECT_FALSE(old_alice->IsWritePolicyAllowed());
+    CUserSnapshot new_alice = db.GetUserSnapshot("alice");
+    ASSERT_TRUE(new_alice != NULL);
+    EXPECT_TRUE(new_alice->IsWritePolicyAllowed());
+    EXPECT_TRUE(db.GetUserSnapshot("bob") == NULL);
+    EXPECT_TRUE(db.AuthenticateUser("alice", "changed") != NULL);
+}
@@ -23,6 +23,15 @@ protected:
     int GetDigitValue(char c) {
         return CWebHandler::GetDigitValue(c);
     }
+    CString RecordJson(const CEIBRecord& rec, const char* time_format) {
+        httplib::Request req;
+        if (time_format) {
+            req.params.emplace("time_format", time_format);
+        }
+        CString json;
+        CWebHandler::AppendJsonRecord(json, rec, CWebHandler::GetJsonTimeFormat(req));
+        return json;
+    }
 };
 
 // ---------------------------------------------------------------------------
@@ -59,12 +68,19 @@ TEST_F(WebHandlerUtilTest, GetJsonField_EmptyValue)
     EXPECT_STREQ(GetJsonField(json, "user").GetBuffer(), "");
 }
 
-TEST_F(WebHandlerUtilTest, GetJsonField_NumericLookupFails)
+TEST_F(WebHandlerUtilTest, GetJsonField_BareNumbersAndBooleans)
 {
-    // GetJsonField expects "field":"value" pattern -- numeric values
-    // without quotes won't match the search pattern.
-    CString json = "{\"count\":42}";
-    EXPECT_STREQ(GetJsonField(json, "count").GetBuffer(), "");
+    CString json = "{\"count\":42,\"offset\": -30,\"on\":true,\"off\":false}";
+    EXPECT_STREQ(GetJsonField(json, "count").GetBuffer(), "42");
+    EXPECT_STREQ(GetJsonField(json, "offset").GetBuffer(), "-30");
+    EXPECT_STREQ(GetJsonField(json, "on").GetBuffer(), "true");
+    EXPECT_STREQ(GetJsonField(json, "off").GetBuffer(), "false");
+}
+
+TEST_F(WebHandlerUtilTest, GetJsonField_NullIsMissing)
+{
+    CString json = "{\"id\":null}";
+    EXPECT_STREQ(GetJsonField(json, "id").GetBuffer(), "");
 }
 
 // ---------------------------------------------------------------------------
@@ -237,3 +253,31 @@ TEST_F(WebHandlerUtilTest, GetDigitValue_Invalid)
     EXPECT_EQ(GetDigitValue('z'), -1);
     EXPECT_EQ(GetDigitValue(' '), -1);
 }
+
+// ---------------------------------------------------------------------------
+// History record time formats
+// ---------------------------------------------------------------------------
+
+TEST_F(WebHandlerUtilTest, HistoryRecordTimeFormats) {
+    CStatsDB db;
+    unsigned char value[] = {0x01, 0xab};
+    CEibAddress addr("1/2/3");
+    db.AddRecord(addr, value, 2, CTimeStamp(1, 966888449042000000LL));
+    CEIBObjectRecord rec;
+    ASSERT_TRUE(db.GetRecord(addr, rec));
+    const CEIBRecord& r = rec.GetHistory().front();
+
+    CString iso = RecordJson(r, "iso8601");
+    EXPECT_STREQ("{\"time\":\"2000-08-21T20:07:29.042Z\",\"time_ns\":966888449042000000,\"value\":\"0x1ab\"}",
+                 iso.GetBuffer());
+
+    CString ms = RecordJson(r, "epoch_ms");
+    EXPECT_STREQ("{\"time\":966888449042,\"time_ns\":966888449042000000,\"value\":\"0x1ab\"}",
+                 ms.GetBuffer());
+
+    CString def = RecordJson(r, NULL);
+    CString expected = "{\"time\":\"";
+    expected += r.GetTime().Format();
+    expected += "\",\"time_ns\":966888449042000000,\"value\":\"0x1ab\"}";
+    EXPECT_STREQ(expected.GetBuffer(), def.GetBuffer());
+}
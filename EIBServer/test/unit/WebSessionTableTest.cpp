@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include "WebSessionTable.h"
+
+// Sessions use a short idle timeout so the wheel (60 s per slot) is exercised
+// with a handful of ticks.
+static const int kTimeout = 300;
+static const time_t kStart = 1000000;
+
+TEST(WebSessionTableTest, InsertAndLookup)
+{
+    CWebSessionTable table(kTimeout);
+    table.Insert("abc", "alice", kStart);
+
+    WebSession session;
+    ASSERT_TRUE(table.Lookup("abc", session));
+    EXPECT_STREQ(session.user_name.GetBuffer(), "alice");
+    EXPECT_STREQ(session.session_id.GetBuffer(), "abc");
+    EXPECT_EQ(session.created, kStart);
+    EXPECT_EQ(table.GetNumSessions(), 1);
+
+    EXPECT_FALSE(table.Lookup("missing", session));
+}
+
+TEST(WebSessionTableTest, TouchReturnsUserAndRefreshes)
+{
+    CWebSessionTable table(kTimeout);
+    table.Insert("abc", "alice", kStart);
+
+    CString user;
+    ASSERT_TRUE(table.Touch("abc", kStart + 10, user));
+    EXPECT_STREQ(user.GetBuffer(), "alice");
+
+    WebSession session;
+    ASSERT_TRUE(table.Lookup("abc", session));
+    EXPECT_EQ(session.last_access, kStart + 10);
+}
+
+TEST(WebSessionTableTest, TouchRefusesIdleSessionBeforeWheelRuns)
+{
+    CWebSessionTable table(kTimeout);
+    table.Insert("abc", "alice", kStart);
+
+    CString user;
+    EXPECT_FALSE(table.Touch("abc", kStart + kTimeout + 1, user));
+    EXPECT_FALSE(table.Touch("missing", kStart, user));
+}
+
+TEST(WebSessionTableTest, RemoveDropsSession)
+{
+    CWebSessionTable table(kTimeout);
+    table.Insert("abc", "alice", kStart);
+    table.Remove("abc");
+
+    WebSession session;
+    EXPECT_FALSE(table.Lookup("abc", session));
+    EXPECT_EQ(table.GetNumSessions(), 0);
+    // The stale wheel entry is skipped without counting as expired
+    EXPECT_EQ(table.Expire(kStart + 2 * kTimeout), 0);
+}
+
+TEST(WebSessionTableTest, ExpireRemovesIdleSessions)
+{
+    CWebSessionTable table(kTimeout);
+    table.Insert("a", "alice", kStart);
+    table.Insert("b", "bob", kStart);
+
+    EXPECT_EQ(table.Expire(kStart + kTimeout - 1), 0);
+    EXPECT_EQ(table.GetNumSessions(), 2);
+
+    EXPECT_EQ(table.Expire(kStart + kTimeout + WEB_SESSION_WHEEL_TICK), 2);
+    EXPECT_EQ(table.GetNumSessions(), 0);
+}
+
+TEST(WebSessionTableTest, TouchedSessionIsRefiled)
+{
+    CWebSessionTable table(kTimeout);
+    table.Insert("a", "alice", kStart);
+    table.Insert("b", "bob", kStart);
+
+    CString user;
+    ASSERT_TRUE(table.Touch("a", kStart + 200, user));
+
+    // "b" expires in its original slot, "a" moves to a later one
+    EXPECT_EQ(table.Expire(kStart + kTimeout + WEB_SESSION_WHEEL_TICK), 1);
+    WebSession session;
+    EXPECT_TRUE(table.Lookup("a", session));
+    EXPECT_FALSE(table.Lookup("b", session));
+
+    EXPECT_EQ(table.Expire(kStart + 200 + kTimeout + WEB_SESSION_WHEEL_TICK), 1);
+    EXPECT_EQ(table.GetNumSessions(), 0);
+}
+
+TEST(WebSessionTableTest, ClockJumpOverWholeWheel)
+{
+    CWebSessionTable table(kTimeout);
+    table.Insert("a", "alice", kStart);
+
+    time_t later = kStart + (time_t)WEB_SESSION_WHEEL_TICK * WEB_SESSION_WHEEL_SLOTS * 3;
+    EXPECT_EQ(table.Expire(later), 1);
+    EXPECT_EQ(table.GetNumSessions(), 0);
+}
+
+TEST(WebSessionTableTest, ManySessionsAcrossShards)
+{
+    CWebSessionTable table(kTimeout);
+    for (int i = 0; i < 1000; ++i) {
+        CString sid("sid");
+        sid += i;
+        table.Insert(sid, "alice", kStart);
+    }
+    EXPECT_EQ(table.GetNumSessions(), 1000);
+
+    WebSession session;
+    EXPECT_TRUE(table.Lookup("sid500", session));
+
+    table.Clear();
+    EXPECT_EQ(table.GetNumSessions(), 0);
+    EXPECT_EQ(table.Expire(kStart + 2 * kTimeout), 0);
+}
+
+TEST(WebSessionTableTest, TimeoutIsClampedToWheelRange)
+{
+    CWebSessionTable table(24 * 3600);
+    EXPECT_EQ(table.GetTimeout(), WEB_SESSION_MAX_TIMEOUT);
+    EXPECT_GE(WEB_SESSION_MAX_TIMEOUT, WEB_SESSION_TIMEOUT);
+
+    // the session lives for the whole clamped timeout, not one wheel revolution less
+    table.Insert("a", "alice", kStart);
+    for (time_t t = kStart; t < kStart + WEB_SESSION_MAX_TIMEOUT; t += WEB_SESSION_WHEEL_TICK) {
+        EXPECT_EQ(table.Expire(t), 0);
+    }
+    EXPECT_EQ(table.Expire(kStart + WEB_SESSION_MAX_TIMEOUT + WEB_SESSION_WHEEL_TICK), 1);
+
+    CWebSessionTable zero(0);
+    EXPECT_EQ(zero.GetTimeout(), 1);
+}
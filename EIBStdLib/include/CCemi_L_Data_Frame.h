@@ -6,6 +6,7 @@
 #include "cEMI.h"
 #include "CemiFrame.h"
 #include "EIBAddress.h"
+#include "TimeStamp.h"
 
 enum CEMI_FRAME_PRIORITY
 {
@@ -70,6 +71,11 @@ public:
 	void SetCtrl2(unsigned char ctrl2) { _data.ctrl2 = ctrl2;}
 	void SetTPCI(unsigned char tpci) { _data.tpci = tpci; }
 	void SetAPCI(unsigned char apci) { _data.apci = apci; }
+	/*!
+	\brief Time the frame was received from the bus. Zero for frames built locally
+	*/
+	const CTimeStamp& GetTimeStamp() const { return _time_stamp; }
+	void SetTimeStamp(const CTimeStamp& time_stamp) { _time_stamp = time_stamp; }
 
 	CCemi_L_Data_Frame& operator=(const CCemi_L_Data_Frame& rhs);
 	void FillBufferWithFrameData(unsigned char* buffer, int max_length);
@@ -82,6 +88,7 @@ private:
 private:
 	CEMI_L_DATA_MESSAGE _data;
 	unsigned char* _addil_data;
+	CTimeStamp _time_stamp;
 };
 
 }
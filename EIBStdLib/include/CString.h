@@ -17,6 +17,8 @@
 
 #define IS_HEX_DIGIT(c) (IS_DECIMAL_DIGIT_CHAR(c) || ((int)c >= 65 && (int)c <= 70) || ((int)c >= 97 && (int)c <= 102))
 #define IS_DECIMAL_DIGIT_CHAR(c) ((int)c >= 48 && (int)c <= 57)
+//buffer size that holds any 64 bit number formatted by CString::FormatInt / FormatUInt
+#define MAX_INT_CHARS 24
 
 using namespace std;
 /*!
@@ -231,6 +233,32 @@ public:
 	\return CString - the current string plus the charcters added
 	*/
 	CString& operator+=(const uint64& str);
+	/*!
+	\brief Appends len characters in place, without a temporary CString
+	\fn CString& Append(const char* str, int len)
+	\return CString - the current string plus the charcters added
+	*/
+	CString& Append(const char* str, int len);
+	/*!
+	\brief Appends the decimal representation of a number in place, without temporary strings
+	\fn CString& AppendInt(int64 val)
+	\return CString - the current string plus the number added
+	*/
+	CString& AppendInt(int64 val);
+	/*!
+	\brief Appends the decimal representation of an unsigned number in place
+	\fn CString& AppendUInt(uint64 val)
+	\return CString - the current string plus the number added
+	*/
+	CString& AppendUInt(uint64 val);
+	/*!
+	\brief Appends the lower case hexadecimal representation of a number in place
+	\fn CString& AppendHex(uint64 val, int min_digits = 0, bool include_prefix = false)
+	\param min_digits - pad with leading zeros to at least this number of digits
+	\param include_prefix - prepend "0x"
+	\return CString - the current string plus the number added
+	*/
+	CString& AppendHex(uint64 val, int min_digits = 0, bool include_prefix = false);
 
 	operator const char*() { return _str.c_str(); }
 	/*!
@@ -439,10 +467,35 @@ public:
 	static CString ToHexFormat(unsigned int val, bool include_prefix = true);
 	static CString ToHexFormat(const char* buffer, int len, bool include_prefix = true);
 
+	/*!
+	\brief Writes the decimal representation of a number to a buffer. the result is not null terminated
+	\fn static int FormatInt(char* buffer, int64 val)
+	\param buffer - at least MAX_INT_CHARS bytes
+	\return int - the number of characters written
+	*/
+	static int FormatInt(char* buffer, int64 val);
+	/*!
+	\brief Writes the decimal representation of an unsigned number to a buffer. the result is not null terminated
+	\fn static int FormatUInt(char* buffer, uint64 val)
+	\param buffer - at least MAX_INT_CHARS bytes
+	\return int - the number of characters written
+	*/
+	static int FormatUInt(char* buffer, uint64 val);
+
 private:
-	static CString ToHexFormat(int n_left_padding, const CString& current, bool include_prefix);
+	template<class T> T ToSigned() const;
+	template<class T> T ToUnsigned() const;
+	template<class T> bool FromHexString(T& val, int max_len, bool exact_len) const;
 
 private:
 	string _str;
 };
+
+/*! \struct CStringHash
+	\brief Hash functor that allows CString to be used as the key of hashed containers
+*/
+struct EIB_STD_EXPORT CStringHash
+{
+	size_t operator()(const CString& str) const { return str.HashCode(); }
+};
 #endif
@@ -4,6 +4,7 @@
 #include "EibStdLib.h"
 #include "CString.h"
 #include "CException.h"
+#include <atomic>
 
 #define DEFAULT_TIME_STR_LEN 100
 
@@ -12,6 +13,7 @@ class EIB_STD_EXPORT CTime
 private:
 	time_t _time_val;
 	static bool _default_local_time;
+	static std::atomic<int> _zone_generation; //changes when the time zone is reloaded
 	static struct tm* EibTime(const time_t* timer);
 	static struct tm* EibGMTime(const time_t* timer);
 	static struct tm* EIBTtime_r(const time_t* timer, struct tm* res);
@@ -42,6 +44,8 @@ public:
 	void AddFormatToString(CString& result,bool get_local) const ;
 	CString Format() const; //Converts using static default preference
 	CString Format(bool get_local) const; //Converts using explicit local/UTC choice
+	CString FormatISO8601(bool get_local = false) const; //"2000-08-21T20:07:29Z" or with the local offset "2000-08-21T22:07:29+02:00"
+	int64 GetEpochMs() const { return (int64)_time_val * 1000; } //Milliseconds since the epoch
 
 	void SetNow();
 	void SetTimeZero();
@@ -0,0 +1,262 @@
+/*! \file ConnectionTable.h
+    \brief CConnectionTable Class - Header file
+
+	This is the header file for CConnectionTable class. The table is NOT Syncronized.
+
+*/
+
+#ifndef __CONNECTION_TABLE_HEADER__
+#define __CONNECTION_TABLE_HEADER__
+
+#include <time.h>
+#include <string.h>
+#include <vector>
+
+#define CONNECTION_TABLE_SIZE	255	// channel ids 1..255 (0 is never assigned)
+#define CONNECTION_WHEEL_SIZE	64	// timer wheel buckets (one per second)
+
+/*! \class CConnectionTable
+	\brief KNXnet/IP connection states indexed by channel id
+
+	Lookup by channel id is a direct array access. Free channel ids are kept in a FIFO free list,
+	so a released id is reused as late as possible. Connection timeouts are kept in a timer wheel
+	with one second buckets, so Expire() only looks at the connections that are about to time out.
+	Timeouts longer than the wheel stay in their bucket until their deadline is reached.
+*/
+template <class T>
+class CConnectionTable
+{
+public:
+	/*!Constructor*/
+	CConnectionTable(int max_connections = CONNECTION_TABLE_SIZE);
+	/*!Destructor. deletes all connection states*/
+	virtual ~CConnectionTable();
+
+	/*!
+	\brief Limit the number of concurrent connections (1..CONNECTION_TABLE_SIZE)
+	\fn void SetMaxConnections(int max_connections)
+	*/
+	void SetMaxConnections(int max_connections);
+	int GetMaxConnections() const { return _max_connections; }
+	int GetNumConnections() const { return (int)_active.size(); }
+	bool IsFull() const { return GetNumConnections() >= _max_connections; }
+
+	/*!
+	\brief Returns the state of a channel, or NULL if the channel is not allocated
+	\fn T* Get(int channel) const
+	*/
+	T* Get(int channel) const { return (channel > 0 && channel <= CONNECTION_TABLE_SIZE) ? _slots[channel] : NULL; }
+
+	/*!
+	\brief Allocates a new state with a free channel id
+	\fn T* Allocate(unsigned char& channel)
+	\return the new state, or NULL if the table is full
+	*/
+	T* Allocate(unsigned char& channel);
+	/*!
+	\brief Deletes the state of a channel and returns the channel id to the free list
+	\fn void Free(int channel)
+	*/
+	void Free(int channel);
+
+	/*!
+	\brief (Re)arms the timeout of a channel
+	\fn void SetTimeout(int channel, time_t deadline)
+	\param deadline absolute time at which the channel expires
+	*/
+	void SetTimeout(int channel, time_t deadline);
+	/*!
+	\brief Collects the channels whose deadline passed. the channels are not freed
+	\fn int Expire(time_t now, std::vector<unsigned char>& expired)
+	\return number of expired channels
+	*/
+	int Expire(time_t now, std::vector<unsigned char>& expired);
+
+	/*!
+	\brief Allocated channel ids (in no particular order). invalidated by Allocate() / Free()
+	\fn const std::vector<unsigned char>& GetChannels() const
+	*/
+	const std::vector<unsigned char>& GetChannels() const { return _active; }
+
+private:
+	void Link(int channel);
+	void Unlink(int channel);
+
+	int _max_connections;
+	T* _slots[CONNECTION_TABLE_SIZE + 1];
+
+	//free list (FIFO ring of channel ids)
+	unsigned char _free[CONNECTION_TABLE_SIZE];
+	int _free_head;
+	int _free_count;
+
+	//dense list of allocated channels, for iteration
+	std::vector<unsigned char> _active;
+	int _active_pos[CONNECTION_TABLE_SIZE + 1];
+
+	//timer wheel: intrusive doubly linked list per bucket. 0 terminates a list
+	unsigned char _wheel[CONNECTION_WHEEL_SIZE];
+	unsigned char _next[CONNECTION_TABLE_SIZE + 1];
+	unsigned char _prev[CONNECTION_TABLE_SIZE + 1];
+	time_t _deadline[CONNECTION_TABLE_SIZE + 1];
+	time_t _last_tick;
+};
+
+template <class T>
+CConnectionTable<T>::CConnectionTable(int max_connections) :
+_max_connections(CONNECTION_TABLE_SIZE),
+_free_head(0),
+_free_count(CONNECTION_TABLE_SIZE),
+_last_tick(0)
+{
+	SetMaxConnections(max_connections);
+	memset(_slots, 0, sizeof(_slots));
+	memset(_wheel, 0, sizeof(_wheel));
+	memset(_next, 0, sizeof(_next));
+	memset(_prev, 0, sizeof(_prev));
+	memset(_deadline, 0, sizeof(_deadline));
+	memset(_active_pos, 0, sizeof(_active_pos));
+	for(int i = 0; i < CONNECTION_TABLE_SIZE; i++){
+		_free[i] = (unsigned char)(i + 1);
+	}
+	_active.reserve(CONNECTION_TABLE_SIZE);
+}
+
+template <class T>
+CConnectionTable<T>::~CConnectionTable()
+{
+	for(int i = 1; i <= CONNECTION_TABLE_SIZE; i++){
+		if(_slots[i] != NULL){
+			delete _slots[i];
+		}
+	}
+}
+
+template <class T>
+void CConnectionTable<T>::SetMaxConnections(int max_connections)
+{
+	if(max_connections < 1){
+		max_connections = 1;
+	}
+	if(max_connections > CONNECTION_TABLE_SIZE){
+		max_connections = CONNECTION_TABLE_SIZE;
+	}
+	_max_connections = max_connections;
+}
+
+template <class T>
+T* CConnectionTable<T>::Allocate(unsigned char& channel)
+{
+	if(IsFull() || _free_count == 0){
+		return NULL;
+	}
+	channel = _free[_free_head];
+	_free_head = (_free_head + 1) % CONNECTION_TABLE_SIZE;
+	_free_count--;
+
+	T* s = new T();
+	_slots[channel] = s;
+	_active_pos[channel] = (int)_active.size();
+	_active.push_back(channel);
+	_deadline[channel] = 0;
+	return s;
+}
+
+template <class T>
+void CConnectionTable<T>::Free(int channel)
+{
+	if(Get(channel) == NULL){
+		return;
+	}
+	Unlink(channel);
+	delete _slots[channel];
+	_slots[channel] = NULL;
+
+	//swap-remove from the dense list
+	int pos = _active_pos[channel];
+	unsigned char last = _active.back();
+	_active[pos] = last;
+	_active_pos[last] = pos;
+	_active.pop_back();
+
+	_free[(_free_head + _free_count) % CONNECTION_TABLE_SIZE] = (unsigned char)channel;
+	_free_count++;
+}
+
+template <class T>
+void CConnectionTable<T>::Link(int channel)
+{
+	int bucket = (int)(_deadline[channel] % CONNECTION_WHEEL_SIZE);
+	_prev[channel] = 0;
+	_next[channel] = _wheel[bucket];
+	if(_wheel[bucket] != 0){
+		_prev[_wheel[bucket]] = (unsigned char)channel;
+	}
+	_wheel[bucket] = (unsigned char)channel;
+}
+
+template <class T>
+void CConnectionTable<T>::Unlink(int channel)
+{
+	if(_deadline[channel] == 0){
+		return;
+	}
+	int bucket = (int)(_deadline[channel] % CONNECTION_WHEEL_SIZE);
+	if(_prev[channel] != 0){
+		_next[_prev[channel]] = _next[channel];
+	}else{
+		_wheel[bucket] = _next[channel];
+	}
+	if(_next[channel] != 0){
+		_prev[_next[channel]] = _prev[channel];
+	}
+	_next[channel] = _prev[channel] = 0;
+	_deadline[channel] = 0;
+}
+
+template <class T>
+void CConnectionTable<T>::SetTimeout(int channel, time_t deadline)
+{
+	if(Get(channel) == NULL || deadline <= 0){
+		return;
+	}
+	Unlink(channel);
+	//a deadline in the past must land in a bucket that Expire() still visits
+	if(deadline <= _last_tick){
+		deadline = _last_tick + 1;
+	}
+	_deadline[channel] = deadline;
+	Link(channel);
+}
+
+template <class T>
+int CConnectionTable<T>::Expire(time_t now, std::vector<unsigned char>& expired)
+{
+	if(_last_tick == 0 || now - _last_tick >= CONNECTION_WHEEL_SIZE){
+		//first call or a long pause: look at every bucket once
+		_last_tick = now - CONNECTION_WHEEL_SIZE;
+	}
+	int count = 0;
+	//visit the buckets of the seconds that passed since the last call
+	for(time_t tick = _last_tick + 1; tick <= now; tick++)
+	{
+		int bucket = (int)(tick % CONNECTION_WHEEL_SIZE);
+		for(unsigned char c = _wheel[bucket]; c != 0; c = _next[c])
+		{
+			if(_deadline[c] <= now){
+				expired.push_back(c);
+				count++;
+			}
+		}
+	}
+	if(now > _last_tick){
+		_last_tick = now;
+	}
+	//disarm the expired channels so each one is reported once
+	for(int i = (int)expired.size() - count; i < (int)expired.size(); i++){
+		Unlink(expired[i]);
+	}
+	return count;
+}
+
+#endif
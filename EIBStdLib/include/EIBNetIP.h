@@ -64,6 +64,7 @@
 
 #define	ROUTING_INDICATION			0x0530
 #define	ROUTING_LOST_MESSAGE		0x0531
+#define	ROUTING_BUSY				0x0532
 
 /*
  * *************** connection types ***
@@ -192,7 +193,7 @@
  */
 
 #pragma pack(push)  /* push current alignment to stack */
-#pragma pack(1)     /* set alignment to 1 byte boundary */
+#pragma pack(1)     /* set alignment to 1 byte boundary */
 
 typedef struct EIB_STD_EXPORT{
     ::byte headersize;
@@ -320,6 +321,19 @@ typedef struct EIB_STD_EXPORT{
 typedef struct EIB_STD_EXPORT{
 } EIBNETIP_ROUTING_INDICATION;
 
+typedef struct EIB_STD_EXPORT{
+    ::byte structlength;
+    ::byte devicestate;
+    word lostmessages;
+} EIBNETIP_ROUTING_LOST_MESSAGE;
+
+typedef struct EIB_STD_EXPORT{
+    ::byte structlength;
+    ::byte devicestate;
+    word waittime;
+    word control;
+} EIBNETIP_ROUTING_BUSY;
+
 typedef struct EIB_STD_EXPORT{
 	EIBNETIP_HPAI discoveryendpoint;
 }EIBNETIP_SEARCH_REQUEST;
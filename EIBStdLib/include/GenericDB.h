@@ -2,19 +2,203 @@
 #define __GENERIC_DB_HEADER__
 
 #include <map>
+#include <list>
+#include <string>
 #include <fstream>
+#include <sstream>
 #include "CException.h"
 
-template<class K,class T>
+//storage options of CGenericDB, see SetStorageOptions()
+#define GENERIC_DB_SNAPSHOT		0x01	//keep a binary copy of the parsed file in <file>.snap
+#define GENERIC_DB_JOURNAL		0x02	//Save() appends the changes to <file>.journal
+
+#define GENERIC_DB_SNAPSHOT_EXT	".snap"
+#define GENERIC_DB_JOURNAL_EXT	".journal"
+#define GENERIC_DB_FORMAT_VERSION 1
+//the journal is folded into the file once it grows past the file and this size
+#define GENERIC_DB_JOURNAL_MIN_COMPACT 65536
+
+/*! \class CDBMappedFile
+	\brief Read only view of a whole file. The file is mapped into memory where the platform allows it and read
+	into a buffer otherwise
+*/
+class EIB_STD_EXPORT CDBMappedFile
+{
+public:
+	CDBMappedFile();
+	virtual ~CDBMappedFile();
+
+	/*!
+	\brief Opens the file
+	\return false if the file does not exist or cannot be read
+	*/
+	bool Open(const CString& file_name);
+	void Close();
+
+	const char* GetData() const { return _data; }
+	size_t GetSize() const { return _size; }
+
+private:
+	const char* _data;
+	size_t _size;
+	bool _mapped;
+	std::string _buf;
+};
+
+/*! \class CDBRecordWriter
+	\brief Writes records in the binary format of the snapshot and journal files of CGenericDB
+
+	Each entry is a tag byte followed by its strings, each written as a 32 bit little endian length and the bytes:
+	'N' name - a record starts, 'P' param value - a parameter of that record, 'E' - the record ends (journal),
+	'D' name - the record was deleted (journal), 'C' - all records were deleted (journal), 'Z' - end of snapshot
+*/
+class EIB_STD_EXPORT CDBRecordWriter
+{
+public:
+	CDBRecordWriter() {};
+	virtual ~CDBRecordWriter() {};
+
+	/*!
+	\brief Writes the file header: magic, format version and the identity of the text file the data belongs to
+	*/
+	void Header(const char* magic, uint64 text_size, uint64 text_hash);
+	void Name(const CString& name);
+	void Param(const CString& param, const CString& value);
+	void End() { _buf += 'E'; }
+	void Delete(const CString& name);
+	void DeleteAll() { _buf += 'C'; }
+	void Finish() { _buf += 'Z'; }
+	void Append(const CDBRecordWriter& other) { _buf += other._buf; }
+
+	const std::string& GetData() const { return _buf; }
+	size_t GetSize() const { return _buf.size(); }
+	bool IsEmpty() const { return _buf.empty(); }
+	void Clear() { _buf.clear(); }
+
+	/*!
+	\brief Writes the data to a file. A new file is written aside and renamed over the old one
+	\param append append to the file instead
+	*/
+	bool WriteFile(const CString& file_name, bool append) const;
+
+	/*!
+	\brief 64 bit FNV-1a hash, used to tie a snapshot or a journal to the content of the text file
+	*/
+	static uint64 Hash(const char* data, size_t length);
+
+private:
+	void String(const CString& str);
+	void UInt32(unsigned int val);
+	void UInt64(uint64 val);
+
+	std::string _buf;
+};
+
+/*! \class CDBRecordReader
+	\brief Reads what CDBRecordWriter wrote
+*/
+class EIB_STD_EXPORT CDBRecordReader
+{
+public:
+	CDBRecordReader(const char* data, size_t length);
+	virtual ~CDBRecordReader() {};
+
+	/*!
+	\brief Reads and checks the file header
+	\return false if the magic or version differ or the data belongs to another text file
+	*/
+	bool Header(const char* magic, uint64 text_size, uint64 text_hash);
+	/*!
+	\brief Reads the next entry
+	\return the tag of the entry, or 0 at the end of the data and at a truncated or unknown entry
+	*/
+	char Next(CString& first, CString& second);
+	/*!
+	\brief Offset of the first byte that was not read yet
+	*/
+	size_t GetPosition() const { return _pos; }
+	void SetPosition(size_t pos) { _pos = pos; }
+
+private:
+	bool String(CString& str);
+	bool UInt32(unsigned int& val);
+	bool UInt64(uint64& val);
+
+	const char* _data;
+	size_t _length;
+	size_t _pos;
+};
+
+/*! \class CDBJournal
+	\brief The changes read from the journal of a CGenericDB, by record name. Only the last change of each record is kept
+*/
+class EIB_STD_EXPORT CDBJournal
+{
+public:
+	typedef list<pair<CString, CString> > ParamList;
+	struct Entry
+	{
+		bool deleted;
+		ParamList params;
+	};
+	typedef map<CString, Entry> EntryMap;
+
+	CDBJournal() : _cleared(false), _complete(true) {};
+	virtual ~CDBJournal() {};
+
+	/*!
+	\brief Reads a journal. A record that was cut off by a crash while it was appended is dropped
+	\param size receives the size of the file
+	\return false if the file does not exist or belongs to another version of the text file
+	*/
+	bool Read(const CString& file_name, uint64 text_size, uint64 text_hash, size_t& size);
+
+	/*!
+	\brief Does the journal replace (or delete) the record of the text file named so?
+	*/
+	bool Replaces(const CString& name) const { return _cleared || _entries.find(name) != _entries.end(); }
+	const EntryMap& GetEntries() const { return _entries; }
+	bool IsEmpty() const { return !_cleared && _entries.empty(); }
+	/*!
+	\brief False if the journal ends with a partly written record
+	*/
+	bool IsComplete() const { return _complete; }
+
+private:
+	bool _cleared;
+	bool _complete;
+	EntryMap _entries;
+};
+
+/*! \class CGenericDB
+	\brief Database of records kept in a text file of blocks:
+
+	[record name]
+	param = value
+
+	The subclass translates records from and to the parameters through the OnRead... and OnSave... callbacks.
+	Index is the container of the records, keyed by K. It is sorted by default; an unordered_map (with CStringHash
+	for CString keys) gives constant time lookups where the order of the records does not matter.
+
+	Two storage options can be turned on with SetStorageOptions():
+	GENERIC_DB_SNAPSHOT - Load() writes the records it parsed to a binary file beside the text file, and reads them
+	from there (mapped into memory) as long as the text file is unchanged. The callbacks are still called for each record.
+	GENERIC_DB_JOURNAL - Save() appends the records that were added, edited or deleted since the last Load() or Save()
+	to a journal file beside the text file, instead of rewriting it. Load() applies the journal over the text file, and
+	the journal is folded into the text file (Compact()) once it grows bigger than it. Only changes made through
+	AddRecord(), DeleteRecord(), EditRecord() and Clear() are journaled. When the text file is edited by hand,
+	the journal written against the older version is dropped.
+*/
+template<class K, class T, class Index = map<K,T> >
 class CGenericDB
 {
 public:
-	CGenericDB(){};
+	CGenericDB() : _options(0), _loading(false), _journal_ok(false), _journal_size(0), _text_size(0), _text_hash(0) {};
 	virtual ~CGenericDB(){};
 
 	inline bool GetRecord(const K& key, T& record)
 	{
-		typename map<K,T>::iterator it;
+		typename Index::iterator it;
 		it = _data.find(key);
 		if (it != _data.end()){
 			record = it->second;
@@ -25,10 +209,14 @@ public:
 
 	bool AddRecord(const K& key, const T& record)
 	{
-		typename map<K,T>::iterator it;
+		typename Index::iterator it;
 		it = _data.find(key);
 		if (it == _data.end()){
-			_data.insert(pair<K,T>(key,record));
+			_data.insert(typename Index::value_type(key,record));
+			if(IsJournaling()){
+				JournalRecord(record, false);
+			}
+			OnRecordsChanged();
 			return true;
 		}
 		return false;
@@ -36,10 +224,14 @@ public:
 
 	bool DeleteRecord(const K& key)
 	{
-		typename map<K,T>::iterator it;
+		typename Index::iterator it;
 		it = _data.find(key);
 		if (it != _data.end()){
+			if(IsJournaling()){
+				JournalRecord(it->second, true);
+			}
 			_data.erase(it);
+			OnRecordsChanged();
 			return true;
 		}
 		return false;
@@ -55,7 +247,7 @@ public:
 		}
 		return false;
 	}
-	
+
 	//will be called for each parameter read from file
 	virtual void OnReadParamComplete(T& current_record, const CString& param,const CString& value) = 0;
 	//will be called for each record read from file
@@ -64,11 +256,15 @@ public:
 	virtual void OnReadRecordNameComplete(T& current_record, const CString& record_name) = 0;
 	//will be called for each record that to be saved to the file
 	virtual void OnSaveRecordStarted(const T& record,CString& record_name, list<pair<CString, CString> >& param_values) = 0;
+	//will be called after records were added or removed
+	virtual void OnRecordsChanged() {}
 
 	virtual void Init(const CString& file_name)
-	{ 
+	{
 		_file_name = file_name;
-		
+		_journal_ok = false;
+		_journal.Clear();
+
 		ifstream myfile;
 		myfile.open(_file_name.GetBuffer(),ios::in);
 		if (myfile.fail()){
@@ -82,118 +278,147 @@ public:
 
 	}
 
+	/*!
+	\brief Turns the snapshot and journal files on or off
+	\param options GENERIC_DB_SNAPSHOT and/or GENERIC_DB_JOURNAL
+	*/
+	void SetStorageOptions(int options)
+	{
+		_options = options;
+		_journal_ok = false;
+		_journal.Clear();
+	}
+	int GetStorageOptions() const { return _options; }
+
 	void Clear()
 	{
 		_data.clear();
+		if(IsJournaling()){
+			_journal.DeleteAll();
+		}
+		OnRecordsChanged();
 	}
 
 	bool Load()
 	{
-		ifstream myfile;
-		myfile.open(_file_name.GetBuffer(),ios::in);
-		if (myfile.fail()){
+		CDBMappedFile text;
+		if (!text.Open(_file_name)){
 			throw CEIBException(ConfigFileError, "Database file: %s not found!", _file_name.GetBuffer());
 			return false;
 		}
+		_text_size = text.GetSize();
+		_text_hash = (_options != 0) ? CDBRecordWriter::Hash(text.GetData(), text.GetSize()) : 0;
 
-			CString line;
-			int line_num = 0;
-			CString record_name;
-			T record;
-			bool first = true;
-			while (!myfile.eof())
-			{
-				line_num++;
-				getline(myfile,line.GetSTDString());
-
-			line.Trim();
-			line.Trim('\r');
-			line.Trim('\n');
+		CDBJournal journal;
+		_journal_size = 0;
+		if((_options & GENERIC_DB_JOURNAL) &&
+		   !journal.Read(GetJournalFileName(), _text_size, _text_hash, _journal_size)){
+			//missing, or written against another version of the file. the next Save() starts a new one
+			_journal_size = 0;
+		}
 
-			if(line.IsEmpty() || line[0] == '#')
-			{
-				continue;
-			}
-		
-			if(line[0] == '[' && line[line.GetLength() - 1] == ']')
+		_loading = true;
+		try
+		{
+			if(!(_options & GENERIC_DB_SNAPSHOT) || !LoadSnapshot(journal))
 			{
-				if(!first)
-				{
-					OnReadRecordComplete(record);
-					record_name.Clear();
-				}
-				record_name = line.SubString(1,line.GetLength() - 2);
-				OnReadRecordNameComplete(record,record_name);
-				first = false;
-			}
-			else if (line[0] == '[' || line[line.GetLength() - 1] == ']'){
-				myfile.close();
-				throw CEIBException(ConfigFileError, "Error in line %d. line is not valid Block line.", line_num);
-			}
-				else
-				{
-					const size_t line_length = static_cast<size_t>(line.GetLength());
-					const size_t index = static_cast<size_t>(line.FindFirstOf('='));
-					if (index == string::npos)
-					{
-						myfile.close();
-						throw CEIBException(ConfigFileError, "Error in line %d: missing \"=\" character", line_num);
-						return false;
-					}
-					if(index == line_length - 1){
-						myfile.close();
-						throw CEIBException(ConfigFileError, "Error in line %d: missing parameter value", line_num);
-					}
-					CString param_name = line.SubString(0, static_cast<int>(index));
-					CString param_value = line.SubString(static_cast<int>(index + 1), static_cast<int>(line_length - index - 1));
-					if(!record_name.IsEmpty())
-					{
-						param_name.Trim();
-					param_value.Trim();
-					OnReadParamComplete(record,param_name,param_value);
+				CDBRecordWriter snapshot;
+				if(_options & GENERIC_DB_SNAPSHOT){
+					snapshot.Header("EIBDBSNP", _text_size, _text_hash);
 				}
-				else
-				{
-					myfile.close();
-					throw CEIBException(ConfigFileError, "Error in line %d : Empty brackets", line_num);
+				ParseText(text, journal, (_options & GENERIC_DB_SNAPSHOT) ? &snapshot : NULL);
+				if(_options & GENERIC_DB_SNAPSHOT){
+					snapshot.Finish();
+					snapshot.WriteFile(_file_name + GENERIC_DB_SNAPSHOT_EXT, false);
 				}
 			}
-			}
-		if(!record_name.IsEmpty())
+			ReplayJournal(journal);
+		}
+		catch(...)
 		{
-			OnReadRecordComplete(record);
+			_loading = false;
+			throw;
 		}
-		myfile.close();
+		_loading = false;
+		_journal.Clear();
+		//a record cut off at the end of the journal is dropped by compacting on the next Save()
+		_journal_ok = (_options & GENERIC_DB_JOURNAL) && journal.IsComplete();
 		return true;
 	}
 
+	/*!
+	\brief Writes the records. With GENERIC_DB_JOURNAL only the changes since the last Load() or Save() are appended
+	to the journal, until it is due for compaction
+	*/
 	bool Save()
 	{
-		ofstream myfile;
-		myfile.open(_file_name.GetBuffer(),ios::out|ios::trunc);
-		if (myfile.fail()){	
-			return false;
+		if((_options & GENERIC_DB_JOURNAL) && _journal_ok)
+		{
+			if(_journal.IsEmpty()){
+				return true;
+			}
+			size_t limit = _text_size > GENERIC_DB_JOURNAL_MIN_COMPACT ? (size_t)_text_size : GENERIC_DB_JOURNAL_MIN_COMPACT;
+			if(_journal_size + _journal.GetSize() <= limit && AppendJournal()){
+				return true;
+			}
 		}
+		return Compact();
+	}
 
-		typename map<K,T>::iterator it;
+	/*!
+	\brief Rewrites the text file with all the records and empties the journal
+	*/
+	bool Compact()
+	{
+		std::string text;
+		typename Index::iterator it;
 
 		for ( it=_data.begin() ; it != _data.end(); it++ )
 		{
 			CString name;
 			list<pair<CString, CString> > params_values;
 			OnSaveRecordStarted(it->second,name,params_values);
-			myfile << "[" << name.GetBuffer() << "]" << endl;
+			text += '[';
+			text += name.GetSTDString();
+			text += "]\n";
 			//write the record data
 			list<pair<CString, CString> >::iterator pv_it;
 			for ( pv_it=params_values.begin() ; pv_it != params_values.end(); pv_it++ )
 			{
-				myfile << pv_it->first.GetBuffer() << " = " << pv_it->second << endl;
+				text += pv_it->first.GetSTDString();
+				text += " = ";
+				text += pv_it->second.GetSTDString();
+				text += '\n';
 			}
-			
-			myfile << endl;
+
+			text += '\n';
 		}
 
+		ofstream myfile;
+		myfile.open(_file_name.GetBuffer(),ios::out|ios::trunc);
+		if (myfile.fail()){
+			return false;
+		}
+		myfile.write(text.data(), static_cast<streamsize>(text.size()));
 		myfile.close();
+		if (myfile.fail()){
+			return false;
+		}
+
+		_journal.Clear();
+		_journal_ok = false;
+		if(_options != 0)
+		{
+			_text_size = text.size();
+			_text_hash = CDBRecordWriter::Hash(text.data(), text.size());
+		}
+		if(_options & GENERIC_DB_JOURNAL)
+		{
+			CDBRecordWriter journal;
+			journal.Header("EIBDBJRN", _text_size, _text_hash);
+			_journal_ok = journal.WriteFile(GetJournalFileName(), false);
+			_journal_size = journal.GetSize();
+		}
 		return true;
 	}
 
@@ -208,8 +433,219 @@ public:
 	}
 
 protected:
-	map<K,T> _data;
+	Index _data;
 	CString _file_name;
+
+private:
+	//records read from the file go through here on their way to the subclass
+	struct CReadState
+	{
+		CReadState(const CDBJournal& j, CDBRecordWriter* s) : first(true), skip(false), journal(j), snapshot(s) {};
+		T record;
+		CString record_name;
+		bool first;
+		//the journal replaces the current record
+		bool skip;
+		const CDBJournal& journal;
+		CDBRecordWriter* snapshot;
+	};
+
+	void ReadName(CReadState& state, const CString& name)
+	{
+		if(!state.first && !state.skip)
+		{
+			OnReadRecordComplete(state.record);
+		}
+		state.record_name = name;
+		state.skip = state.journal.Replaces(name);
+		if(!state.skip){
+			OnReadRecordNameComplete(state.record,state.record_name);
+		}
+		if(state.snapshot){
+			state.snapshot->Name(name);
+		}
+		state.first = false;
+	}
+
+	void ReadParam(CReadState& state, const CString& param, const CString& value)
+	{
+		if(!state.skip){
+			OnReadParamComplete(state.record,param,value);
+		}
+		if(state.snapshot){
+			state.snapshot->Param(param,value);
+		}
+	}
+
+	void ReadEnd(CReadState& state)
+	{
+		if(!state.record_name.IsEmpty() && !state.skip)
+		{
+			OnReadRecordComplete(state.record);
+		}
+	}
+
+	void ParseText(const CDBMappedFile& text, const CDBJournal& journal, CDBRecordWriter* snapshot)
+	{
+		istringstream myfile(std::string(text.GetData(), text.GetSize()));
+		CString line;
+		int line_num = 0;
+		CReadState state(journal, snapshot);
+		while (!myfile.eof())
+		{
+			line_num++;
+			getline(myfile,line.GetSTDString());
+
+			line.Trim();
+			line.Trim('\r');
+			line.Trim('\n');
+
+			if(line.IsEmpty() || line[0] == '#')
+			{
+				continue;
+			}
+
+			if(line[0] == '[' && line[line.GetLength() - 1] == ']')
+			{
+				ReadName(state, line.SubString(1,line.GetLength() - 2));
+			}
+			else if (line[0] == '[' || line[line.GetLength() - 1] == ']'){
+				throw CEIBException(ConfigFileError, "Error in line %d. line is not valid Block line.", line_num);
+			}
+			else
+			{
+				const size_t line_length = static_cast<size_t>(line.GetLength());
+				const size_t index = static_cast<size_t>(line.FindFirstOf('='));
+				if (index == string::npos)
+				{
+					throw CEIBException(ConfigFileError, "Error in line %d: missing \"=\" character", line_num);
+				}
+				if(index == line_length - 1){
+					throw CEIBException(ConfigFileError, "Error in line %d: missing parameter value", line_num);
+				}
+				CString param_name = line.SubString(0, static_cast<int>(index));
+				CString param_value = line.SubString(static_cast<int>(index + 1), static_cast<int>(line_length - index - 1));
+				if(!state.record_name.IsEmpty())
+				{
+					param_name.Trim();
+					param_value.Trim();
+					ReadParam(state,param_name,param_value);
+				}
+				else
+				{
+					throw CEIBException(ConfigFileError, "Error in line %d : Empty brackets", line_num);
+				}
+			}
+		}
+		ReadEnd(state);
+	}
+
+	//false if the snapshot is missing, damaged or older than the text file
+	bool LoadSnapshot(const CDBJournal& journal)
+	{
+		CDBMappedFile file;
+		if(!file.Open(_file_name + GENERIC_DB_SNAPSHOT_EXT)){
+			return false;
+		}
+		CDBRecordReader reader(file.GetData(), file.GetSize());
+		if(!reader.Header("EIBDBSNP", _text_size, _text_hash)){
+			return false;
+		}
+		//check the whole file before the first record is passed on
+		size_t start = reader.GetPosition();
+		CString first, second;
+		char tag;
+		while((tag = reader.Next(first,second)) == 'N' || tag == 'P') {}
+		if(tag != 'Z' || reader.GetPosition() != file.GetSize()){
+			return false;
+		}
+
+		reader.SetPosition(start);
+		CReadState state(journal, NULL);
+		while((tag = reader.Next(first,second)) != 'Z')
+		{
+			if(tag == 'N'){
+				ReadName(state,first);
+			}
+			else{
+				ReadParam(state,first,second);
+			}
+		}
+		ReadEnd(state);
+		return true;
+	}
+
+	void ReplayJournal(const CDBJournal& journal)
+	{
+		T record;
+		CDBJournal::EntryMap::const_iterator it;
+		for(it = journal.GetEntries().begin(); it != journal.GetEntries().end(); ++it)
+		{
+			if(it->second.deleted){
+				continue;
+			}
+			OnReadRecordNameComplete(record,it->first);
+			CDBJournal::ParamList::const_iterator pv_it;
+			for(pv_it = it->second.params.begin(); pv_it != it->second.params.end(); ++pv_it){
+				OnReadParamComplete(record,pv_it->first,pv_it->second);
+			}
+			OnReadRecordComplete(record);
+		}
+	}
+
+	bool IsJournaling() const
+	{
+		return (_options & GENERIC_DB_JOURNAL) && !_loading;
+	}
+
+	void JournalRecord(const T& record, bool deleted)
+	{
+		CString name;
+		list<pair<CString, CString> > params_values;
+		OnSaveRecordStarted(record,name,params_values);
+		if(deleted){
+			_journal.Delete(name);
+			return;
+		}
+		_journal.Name(name);
+		list<pair<CString, CString> >::iterator pv_it;
+		for ( pv_it=params_values.begin() ; pv_it != params_values.end(); pv_it++ )
+		{
+			//as the text file would give them back
+			CString param(pv_it->first), value(pv_it->second);
+			param.Trim();
+			value.Trim();
+			_journal.Param(param,value);
+		}
+		_journal.End();
+	}
+
+	bool AppendJournal()
+	{
+		CDBRecordWriter out;
+		if(_journal_size == 0){
+			out.Header("EIBDBJRN", _text_size, _text_hash);
+		}
+		out.Append(_journal);
+		if(!out.WriteFile(GetJournalFileName(), _journal_size != 0)){
+			return false;
+		}
+		_journal_size += out.GetSize();
+		_journal.Clear();
+		return true;
+	}
+
+	CString GetJournalFileName() const { return _file_name + GENERIC_DB_JOURNAL_EXT; }
+
+	int _options;
+	bool _loading;
+	//the journal file matches the text file and the records loaded or saved last
+	bool _journal_ok;
+	size_t _journal_size;
+	uint64 _text_size;
+	uint64 _text_hash;
+	//changes not saved yet
+	CDBRecordWriter _journal;
 };
 
 #endif
@@ -0,0 +1,28 @@
+#ifndef __ROUTING_BUSY_HEADER__
+#define __ROUTING_BUSY_HEADER__
+
+#include "EIBNetIP.h"
+#include "EibNetPacket.h"
+
+namespace EibStack
+{
+
+//Sent by a routing device whose incoming queue is filling up. the other devices
+//stop sending routing indications for the given wait time (milliseconds)
+class EIB_STD_EXPORT CRoutingBusy : public CEIBNetPacket<EIBNETIP_ROUTING_BUSY>
+{
+public:
+	CRoutingBusy(unsigned char devicestate, unsigned short waittime, unsigned short control = 0);
+	CRoutingBusy(unsigned char* data);
+	virtual ~CRoutingBusy();
+
+	unsigned char GetDeviceState() const { return _data.devicestate; }
+	unsigned short GetWaitTime() const { return _data.waittime; }
+	unsigned short GetControl() const { return _data.control; }
+
+	void FillBuffer(unsigned char* buffer, int max_length);
+};
+
+}
+
+#endif
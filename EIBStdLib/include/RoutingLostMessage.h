@@ -0,0 +1,26 @@
+#ifndef __ROUTING_LOST_MESSAGE_HEADER__
+#define __ROUTING_LOST_MESSAGE_HEADER__
+
+#include "EIBNetIP.h"
+#include "EibNetPacket.h"
+
+namespace EibStack
+{
+
+//Sent by a routing device that had to drop routing indications (queue overflow)
+class EIB_STD_EXPORT CRoutingLostMessage : public CEIBNetPacket<EIBNETIP_ROUTING_LOST_MESSAGE>
+{
+public:
+	CRoutingLostMessage(unsigned char devicestate, unsigned short lostmessages);
+	CRoutingLostMessage(unsigned char* data);
+	virtual ~CRoutingLostMessage();
+
+	unsigned char GetDeviceState() const { return _data.devicestate; }
+	unsigned short GetLostMessages() const { return _data.lostmessages; }
+
+	void FillBuffer(unsigned char* buffer, int max_length);
+};
+
+}
+
+#endif
@@ -22,6 +22,7 @@
 
 #include "EibStdLib.h"
 #include "CString.h"
+#include "TimeStamp.h"
 #include "Globals.h"
 
 using namespace std;
@@ -135,6 +136,11 @@ public:
 
   void SetNonBlocking();
 
+  /**
+   *   Descriptor for event loops (select, poll, epoll). The socket still owns it
+   */
+  int GetDescriptor() const { return sockDesc; }
+
   void GetError(CString& error_str);
 
 private:
@@ -358,6 +364,28 @@ public:
    */
   int RecvFrom(void *buffer, int bufferLen, CString &sourceAddress,int &sourcePort, int time_out);
 
+  /**
+   *   Read read up to bufferLen bytes data from this socket and report when
+   *   the datagram was received. The kernel receive time is used when
+   *   EnableReceiveTimeStamps() was called and the platform supports it,
+   *   otherwise the time the datagram was read.
+   *   @param buffer buffer to receive data
+   *   @param bufferLen maximum number of bytes to receive
+   *   @param sourceAddress address of datagram source
+   *   @param sourcePort port of data source
+   *   @param time_out max time to wait for socket to receive data
+   *   @param stamp receive time of the datagram
+   *   @return number of bytes received, 0 if the time out expired
+   *   @exception SocketException thrown if unable to receive datagram
+   */
+  int RecvFrom(void *buffer, int bufferLen, CString &sourceAddress,int &sourcePort, int time_out, CTimeStamp &stamp);
+
+  /**
+   *   Ask the kernel to time stamp incoming datagrams (SO_TIMESTAMPNS)
+   *   @return true if the platform supports it
+   */
+  bool EnableReceiveTimeStamps();
+
   /**
    *   Set the multicast TTL
    *   @param multicastTTL multicast TTL
@@ -5,6 +5,7 @@
 #include <map>
 #include "EibStdLib.h"
 #include "CTime.h"
+#include "TimeStamp.h"
 #include "EibNetwork.h"
 #include "DataBuffer.h"
 #include "ISerializeable.h"
@@ -28,6 +29,7 @@ public:
 	virtual ~CEIBRecord();
 	
 	const CTime& GetTime() const { return _time;}
+	const CTimeStamp& GetTimeStamp() const { return _time_stamp;}
 	const unsigned char* GetValue() const { return _value;}
 	unsigned char GetValueLength() const { return _value_len;}
 	void SetValueLength(unsigned char len) { _value_len = len;}
@@ -37,6 +39,7 @@ public:
 
 private:
 	CTime _time;
+	CTimeStamp _time_stamp;
 	unsigned char _value[MAX_EIB_VALUE_LEN];
 	unsigned char _value_len;
 };
@@ -48,7 +51,7 @@ public:
 	virtual ~CEIBObjectRecord();
 
 	void Print(CString& str) const;
-	void AddRecord(unsigned char* value, unsigned char value_len);
+	void AddRecord(unsigned char* value, unsigned char value_len, const CTimeStamp& time_stamp);
 	
 	int GetNumRecords() const { return (int)_history.size();};
 	
@@ -71,6 +74,7 @@ public:
 	void Init();
 	int GetTotalPacketsNum() { return _num_packets_received;}
 	void AddRecord(const CEibAddress& function, unsigned char* value, unsigned char value_len);
+	void AddRecord(const CEibAddress& function, unsigned char* value, unsigned char value_len, const CTimeStamp& time_stamp);
 
 	bool GetRecord(const CEibAddress& function, CEIBObjectRecord& record) const;
 
@@ -79,9 +83,15 @@ public:
 	static int GetMaxSize();
 	void Print(CString& str);
 
+	//time of the last telegram and the gap to the one before it
+	const CTimeStamp& GetLastTimeStamp() const { return _last_time_stamp;}
+	int64 GetLastGapNs() const { return _last_gap_ns;}
+
 private:
 	map<CEibAddress,CEIBObjectRecord> _db;
 	int _num_packets_received;
+	CTimeStamp _last_time_stamp;
+	int64 _last_gap_ns;
 };
 
 #endif
@@ -0,0 +1,105 @@
+#ifndef __TIME_STAMP_HEADER__
+#define __TIME_STAMP_HEADER__
+
+#include "EibStdLib.h"
+#include "CString.h"
+#include "CTime.h"
+
+#define NSEC_PER_SEC 1000000000LL
+#define NSEC_PER_MSEC 1000000LL
+
+/*! \class CTimeStamp
+	\brief Nanosecond point in time
+
+	Holds two readings of the same instant: the monotonic clock, which is used to measure intervals
+	(gaps between telegrams, latencies), and the real time clock, which is used to print the wall time.
+	The monotonic reading is never affected by changes to the system time.
+*/
+class EIB_STD_EXPORT CTimeStamp
+{
+public:
+	/*!
+	\brief Constructor. Creates a zero time stamp
+	*/
+	CTimeStamp();
+	/*!
+	\brief Constructor
+	\param mono_ns monotonic clock in nanoseconds
+	\param wall_ns real time clock in nanoseconds since the epoch
+	*/
+	CTimeStamp(int64 mono_ns, int64 wall_ns);
+
+	/*!
+	\brief Reads both clocks
+	\fn static CTimeStamp Now()
+	\return the current time
+	*/
+	static CTimeStamp Now();
+	/*!
+	\brief Reads the coarse clocks of the kernel (CLOCK_MONOTONIC_COARSE/CLOCK_REALTIME_COARSE).
+	Cheaper than Now() but only as precise as the scheduler tick (1-4 ms). Meant for hot paths
+	that only need a rough time.
+	\fn static CTimeStamp NowCached()
+	\return the current time
+	*/
+	static CTimeStamp NowCached();
+	/*!
+	\brief Builds a time stamp from a real time reading taken earlier (e.g. the kernel receive time
+	of a datagram). The monotonic reading is derived from the current offset between the clocks.
+	\fn static CTimeStamp FromWallTime(int64 wall_ns)
+	\param wall_ns real time clock in nanoseconds since the epoch
+	*/
+	static CTimeStamp FromWallTime(int64 wall_ns);
+
+	/*!
+	\brief Monotonic clock reading in nanoseconds
+	*/
+	int64 GetMonotonicNs() const { return _mono_ns; }
+	/*!
+	\brief Real time clock reading in nanoseconds since the epoch
+	*/
+	int64 GetWallNs() const { return _wall_ns; }
+	/*!
+	\brief Real time clock reading in whole seconds since the epoch
+	*/
+	time_t GetSeconds() const { return (time_t)(_wall_ns / NSEC_PER_SEC); }
+	/*!
+	\brief The wall time with a one second resolution
+	*/
+	CTime ToCTime() const { return CTime(GetSeconds()); }
+	/*!
+	\brief Real time clock reading in milliseconds since the epoch
+	*/
+	int64 GetEpochMs() const { return _wall_ns / NSEC_PER_MSEC; }
+	/*!
+	\brief Formats the wall time as ISO-8601 with milliseconds, e.g. "2000-08-21T20:07:29.042Z"
+	\fn CString FormatISO8601(bool get_local = false) const
+	\param get_local use the local time and offset instead of UTC
+	*/
+	CString FormatISO8601(bool get_local = false) const;
+	/*!
+	\brief Was this time stamp set?
+	*/
+	bool IsZero() const { return _mono_ns == 0 && _wall_ns == 0; }
+
+	/*!
+	\brief Nanoseconds passed from this time stamp till now (monotonic)
+	*/
+	int64 ElapsedNs() const;
+
+	/*!
+	\brief Monotonic distance between two time stamps in nanoseconds
+	*/
+	friend int64 operator-(const CTimeStamp& t1, const CTimeStamp& t2) { return t1._mono_ns - t2._mono_ns; }
+
+	bool operator==(const CTimeStamp& rhs) const { return _mono_ns == rhs._mono_ns; }
+	bool operator!=(const CTimeStamp& rhs) const { return _mono_ns != rhs._mono_ns; }
+	bool operator<(const CTimeStamp& rhs) const { return _mono_ns < rhs._mono_ns; }
+	bool operator>(const CTimeStamp& rhs) const { return _mono_ns > rhs._mono_ns; }
+
+private:
+	int64 _mono_ns;
+	int64 _wall_ns;
+};
+
+#endif
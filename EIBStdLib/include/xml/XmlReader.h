@@ -0,0 +1,173 @@
+#ifndef __XML_READER_HEADER__
+#define __XML_READER_HEADER__
+
+#include "EibStdLib.h"
+#include "CString.h"
+#include "xml/tinyxml.h"
+#include <string>
+#include <vector>
+
+//size of the pieces an attached buffer is copied into the reader in
+#define XML_READER_CHUNK_SIZE 4096
+
+/*!
+	\brief Result of CXmlReader::Read()
+*/
+enum EIB_STD_EXPORT XmlReadResult
+{
+	XML_READ_NONE,			//nothing was read yet
+	XML_READ_START_ELEMENT,	//an element was opened. name and attributes are available
+	XML_READ_END_ELEMENT,	//an element was closed (right after the start of an empty element)
+	XML_READ_TEXT,			//text or CDATA inside an element
+	XML_READ_MORE_DATA,		//the input ends in the middle of a construct, Feed() more
+	XML_READ_END,			//the whole document was read
+	XML_READ_ERROR			//the document is not well formed, see GetError()
+};
+
+class CXmlReader;
+
+/*! \class CXmlReaderHandler
+	\brief Callbacks of CXmlReader::Dispatch(). The reader passed to each callback holds the current event
+*/
+class EIB_STD_EXPORT CXmlReaderHandler
+{
+public:
+	virtual ~CXmlReaderHandler() {}
+
+	virtual void OnStartElement(const CXmlReader& /*reader*/) {}
+	virtual void OnEndElement(const CXmlReader& /*reader*/) {}
+	virtual void OnText(const CXmlReader& /*reader*/) {}
+};
+
+/*! \class CXmlReader
+	\brief Pull XML parser
+
+	Reads a document one event at a time (start of element, text, end of element) without building a tree,
+	so memory use is bounded by the biggest single tag or text rather than by the document. It uses the lexer
+	of tinyxml: names, entities and white space condensing behave as in CXmlDocument, and blank text is skipped
+	the same way. Comments, processing instructions and DOCTYPE are skipped.
+
+	The input is either attached to the reader (the constructor taking a buffer, which is then read in
+	XML_READER_CHUNK_SIZE pieces) or pushed with Feed() as it arrives, followed by Finish().
+*/
+class EIB_STD_EXPORT CXmlReader
+{
+public:
+	/*!
+	\brief Constructor. The input is given with Feed()
+	*/
+	CXmlReader();
+	/*!
+	\brief Constructor. Reads the document from a buffer owned by the caller, which must outlive the reader.
+	The buffer does not have to be null terminated
+	\param data the document
+	\param length length of the document in bytes
+	*/
+	CXmlReader(const char* data, int length);
+	virtual ~CXmlReader();
+
+	/*!
+	\brief Appends input. Only the part that was not read yet is kept
+	*/
+	void Feed(const char* data, int length);
+	/*!
+	\brief No more input will follow
+	*/
+	void Finish();
+	/*!
+	\brief Forget the document and the input, to read another one
+	*/
+	void Reset();
+
+	/*!
+	\brief Reads the next event
+	\fn XmlReadResult Read()
+	\return the event. XML_READ_END and XML_READ_ERROR are returned again by every later call
+	*/
+	XmlReadResult Read();
+	/*!
+	\brief Reads all the available events and passes them to the handler
+	\fn XmlReadResult Dispatch(CXmlReaderHandler& handler)
+	\return XML_READ_MORE_DATA, XML_READ_END or XML_READ_ERROR
+	*/
+	XmlReadResult Dispatch(CXmlReaderHandler& handler);
+
+	/*!
+	\brief Name of the element that was opened or closed
+	*/
+	const char* GetName() const { return _name.c_str(); }
+	/*!
+	\brief Is the current element named so?
+	*/
+	bool IsName(const char* name) const { return _name == name; }
+	/*!
+	\brief Text read by the last XML_READ_TEXT, with the entities decoded
+	*/
+	const char* GetText() const { return _text.c_str(); }
+	/*!
+	\brief Number of attributes of the element that was opened
+	*/
+	int GetAttributeCount() const { return (int)_attributes.size(); }
+	const char* GetAttributeName(int index) const { return _attributes[index].first.c_str(); }
+	const char* GetAttributeValue(int index) const { return _attributes[index].second.c_str(); }
+	/*!
+	\brief Value of an attribute of the element that was opened
+	\return the value or NULL if the element has no such attribute
+	*/
+	const char* GetAttribute(const char* name) const;
+	/*!
+	\brief Was the element written as <name/>? Its XML_READ_END_ELEMENT follows immediately
+	*/
+	bool IsEmptyElement() const { return _empty_element; }
+	/*!
+	\brief Nesting level of the current event: 1 for the root element and for the text directly inside it
+	*/
+	int GetDepth() const { return _depth; }
+	/*!
+	\brief Description of the error after XML_READ_ERROR
+	*/
+	const CString& GetError() const { return _error; }
+
+private:
+	XmlReadResult ReadToken();
+	XmlReadResult ReadOutsideRoot(const char* p, const char* end);
+	XmlReadResult ReadCharacters(const char* p, const char* end);
+	XmlReadResult ReadMarkup(const char* p, const char* end);
+	XmlReadResult ReadStartTag(const char* p, const char* tag_end);
+	XmlReadResult ReadEndTag(const char* p, const char* tag_end);
+	void ReadDeclaration(const char* p, const char* end);
+	XmlReadResult SetError(const char* msg, const char* p);
+	bool FillFromSource();
+	void Consume(const char* p) { _pos = p - _buf.c_str(); }
+
+	static const char* Find(const char* p, const char* end, const char* token);
+	static const char* FindTagEnd(const char* p, const char* end);
+	static bool IsBlank(const char* p, const char* end);
+
+	//unread input
+	std::string _buf;
+	size_t _pos;
+	//bytes dropped from the front of _buf, to report error offsets
+	size_t _offset;
+	//attached input, when given to the constructor
+	const char* _src;
+	int _src_length;
+	int _src_pos;
+	bool _finished;
+
+	TiXmlEncoding _encoding;
+	XmlReadResult _state;
+	bool _seen_root;
+	bool _pending_end;
+	bool _empty_element;
+	int _depth;
+	//names of the open elements
+	std::vector<TIXML_STRING> _open;
+
+	TIXML_STRING _name;
+	TIXML_STRING _text;
+	std::vector<std::pair<TIXML_STRING, TIXML_STRING> > _attributes;
+	CString _error;
+};
+
+#endif
@@ -47,7 +47,7 @@ public :
    }
 
    /// Retrieve the set of values
-   void v_get (int & i_out_1, int & i_out_2, int & i_out_3, TIXML_STRING & S_out)
+   void v_get (int & i_out_1, int & i_out_2, int & i_out_3, TIXML_STRING & S_out) const
    {
       i_out_1 = i_1;
       i_out_2 = i_2;
@@ -75,7 +75,7 @@ public :
    /// Get the current nb of stored elements
    int i_get_size () {return i_size;}
    /// Get one element from the placeholder
-   void v_get (int i_position, int & i_1, int & i_2, int & i_3, TIXML_STRING & S_out);
+   void v_get (int i_position, int & i_1, int & i_2, int & i_3, TIXML_STRING & S_out) const;
    /// Get the current position. See i_position.
    int i_get_position () {return i_position;}
    /// Set the position to an arbitrary value. See i_position.
@@ -42,6 +42,8 @@ distribution.
 #include <assert.h>
 #include <string.h>
 
+class TiXmlArena;
+
 /*	The support for explicit isn't that universal, and it isn't really
 	required - it is used to check that the TiXmlString class isn't incorrectly
 	used. Be nice to old compilers and macro it here:
@@ -225,22 +227,18 @@ class TiXmlString
 	struct Rep
 	{
 		size_type size, capacity;
+		TiXmlArena* arena;	// null when the rep is on the heap
 		char str[1];
 	};
 
-	void init(size_type sz, size_type cap)
+	// A new string goes to the arena of the current TiXmlArenaScope, if any.
+	void init(size_type sz, size_type cap) { init(sz, cap, current_arena()); }
+
+	void init(size_type sz, size_type cap, TiXmlArena* arena)
 	{
 		if (cap)
 		{
-			// Lee: the original form:
-			//	rep_ = static_cast<Rep*>(operator new(sizeof(Rep) + cap));
-			// doesn't work in some cases of new being overloaded. Switching
-			// to the normal allocation, although use an 'int' for systems
-			// that are overly picky about structure alignment.
-			const size_type bytesNeeded = sizeof(Rep) + cap;
-			const size_type intsNeeded = ( bytesNeeded + sizeof(int) - 1 ) / sizeof( int ); 
-			rep_ = reinterpret_cast<Rep*>( new int[ intsNeeded ] );
-
+			rep_ = allocate(cap, arena);
 			rep_->str[ rep_->size = sz ] = '\0';
 			rep_->capacity = cap;
 		}
@@ -252,14 +250,31 @@ class TiXmlString
 
 	void quit()
 	{
-		if (rep_ != &nullrep_)
+		if (rep_ == &nullrep_)
+		{
+			return;
+		}
+		if (rep_->arena == 0)
 		{
-			// The rep_ is really an array of ints. (see the allocator, above).
+			// The rep_ is really an array of ints. (see allocate()).
 			// Cast it back before delete, so the compiler won't incorrectly call destructors.
 			delete [] ( reinterpret_cast<int*>( rep_ ) );
 		}
+		else
+		{
+			release(rep_);
+		}
 	}
 
+	// Growing a string keeps it in the arena it already lives in.
+	TiXmlArena* arena() const { return rep_->arena ? rep_->arena : current_arena(); }
+
+	static TiXmlArena* current_arena();
+	static Rep* allocate(size_type cap, TiXmlArena* arena);
+	static void release(Rep* rep);
+	// Grows an arena rep in place, if it is the last allocation of its arena
+	bool grow(size_type cap);
+
 	Rep * rep_;
 	static Rep nullrep_;
 
@@ -108,6 +108,101 @@ struct TiXmlCursor
 };
 
 
+/**	A monotonic allocator for the nodes and strings of a TiXmlDocument.
+
+	Allocations are carved from a chain of large blocks and are never released
+	one by one: deleting a node that lives in an arena only runs its destructor.
+	All the memory is given back at once by Reset() or when the arena is destroyed.
+
+	An arena is used through TiXmlArenaScope: while a scope is open on a thread,
+	every TiXmlBase object and TiXmlString created on that thread is carved from
+	the scope's arena. A string that already lives in an arena keeps growing in
+	the same arena.
+
+	@sa TiXmlDocument::SetUseArena()
+*/
+class TiXmlArena
+{
+public:
+	enum
+	{
+		MIN_BLOCK_SIZE = 4 * 1024,
+		MAX_BLOCK_SIZE = 256 * 1024
+	};
+
+	TiXmlArena();
+	~TiXmlArena();
+
+	/// Returns size bytes, aligned for any TinyXml object. Never returns null.
+	void* Alloc( size_t size );
+	/// Extends p, of size bytes, to newSize bytes in place. Only possible for the
+	/// last allocation of the arena and if the block has room; returns false otherwise.
+	bool Grow( void* p, size_t size, size_t newSize );
+	/// Gives p, of size bytes, back if it is the last allocation of the arena.
+	/// Anything else stays allocated until Reset().
+	void Free( void* p, size_t size );
+
+	/// Releases everything allocated so far. Keeps the last block for reuse.
+	/// Nothing allocated from the arena may be used (or deleted) afterwards.
+	void Reset();
+
+	/// Bytes handed out by Alloc() since the last Reset().
+	size_t BytesUsed() const		{ return bytesUsed; }
+	/// Bytes held in blocks.
+	size_t BytesReserved() const	{ return bytesReserved; }
+	/// Number of blocks held.
+	int BlockCount() const			{ return blockCount; }
+
+	/// The arena of the innermost TiXmlArenaScope on this thread, or null.
+	static TiXmlArena* Current();
+
+private:
+	friend class TiXmlArenaScope;
+
+	TiXmlArena( const TiXmlArena& );			// not implemented.
+	void operator=( const TiXmlArena& );		// not allowed.
+
+	struct Block
+	{
+		Block* next;
+		size_t size;
+		size_t used;
+	};
+
+	static void SetCurrent( TiXmlArena* arena );
+	Block* NewBlock( size_t size );
+
+	Block* blocks;			// the block in use is first
+	size_t nextBlockSize;
+	size_t bytesUsed;
+	size_t bytesReserved;
+	int blockCount;
+};
+
+
+/**	Makes an arena (or the heap, for a null arena) the allocator of the
+	current thread until the scope ends. Scopes nest.
+*/
+class TiXmlArenaScope
+{
+public:
+	explicit TiXmlArenaScope( TiXmlArena* arena ) : previous( TiXmlArena::Current() )
+	{
+		TiXmlArena::SetCurrent( arena );
+	}
+	~TiXmlArenaScope()
+	{
+		TiXmlArena::SetCurrent( previous );
+	}
+
+private:
+	TiXmlArenaScope( const TiXmlArenaScope& );	// not implemented.
+	void operator=( const TiXmlArenaScope& );	// not allowed.
+
+	TiXmlArena* previous;
+};
+
+
 /**
 	If you call the Accept() method, it requires being passed a TiXmlVisitor
 	class to handle callbacks. For nodes that contain other nodes (Document, Element)
@@ -197,11 +292,20 @@ class TiXmlBase
 	friend class TiXmlNode;
 	friend class TiXmlElement;
 	friend class TiXmlDocument;
+	// the pull parser of EIBStdLib shares the lexer
+	friend class CXmlReader;
 
 public:
 	TiXmlBase()	:	userData(0)		{}
 	virtual ~TiXmlBase()			{}
 
+	/**	All TinyXml objects are allocated through these operators. Inside a
+		TiXmlArenaScope they come from the scope's arena, and deleting them
+		only runs the destructor.
+	*/
+	static void* operator new( size_t size );
+	static void operator delete( void* p );
+
 	/**	All TinyXml classes can print themselves to a filestream
 		or the string class (TiXmlString in non-STL mode, std::string
 		in STL mode.) Either or both cfile and str can be null.
@@ -692,6 +796,9 @@ public:
 		return const_cast< TiXmlDocument* >( (const_cast< const TiXmlNode* >(this))->GetDocument() );
 	}
 
+	/// The arena of the document this node belongs to, or null if it uses the heap.
+	TiXmlArena* GetArena() const;
+
 	/// Returns true if this node has no children.
 	bool NoChildren() const						{ return !firstChild; }
 
@@ -745,6 +852,9 @@ protected:
 	// and the assignment operator.
 	void CopyTo( TiXmlNode* target ) const;
 
+	// Clone a node that is about to become a child of this one, in this node's arena.
+	TiXmlNode* CloneChild( const TiXmlNode& node ) const;
+
 	#ifdef TIXML_USE_STL
 	    // The real work of the input operator.
 	virtual void StreamIn( std::istream* in, TIXML_STRING* tag ) = 0;
@@ -1398,7 +1508,21 @@ public:
 	TiXmlDocument( const TiXmlDocument& copy );
 	void operator=( const TiXmlDocument& copy );
 
-	virtual ~TiXmlDocument() {}
+	virtual ~TiXmlDocument();
+
+	/**	Carve the nodes and strings of this document from a TiXmlArena instead
+		of allocating each one from the heap. Parsing a large document then costs
+		a few block allocations, and destroying it frees the blocks in one shot.
+
+		Changing the mode deletes the current content of the document. Nodes of an
+		arena document must not outlive it: to move a node to another document
+		use InsertEndChild() (which copies) rather than LinkEndChild().
+	*/
+	void SetUseArena( bool use );
+	/// Is this document allocated from an arena?
+	bool UseArena() const					{ return arena != 0; }
+	/// The arena of this document, or null.
+	TiXmlArena* Arena() const				{ return arena; }
 
 	/** Load a file using the current document value.
 		Returns true if successful. Will delete any existing
@@ -1548,6 +1672,7 @@ private:
 	int tabsize;
 	TiXmlCursor errorLocation;
 	bool useMicrosoftBOM;		// the UTF-8 BOM were found when read. Note this, and try to write.
+	TiXmlArena* arena;
 };
 
 
@@ -37,6 +37,7 @@ distribution.
 
 #include "xml/action_store.h"
 #include "xml/xpath_expression.h"
+#include "xml/xpath_program.h"
 #include "xml/xpath_stream.h"
 #include "xml/xpath_stack.h"
 
@@ -48,11 +49,13 @@ class execution_error {public : execution_error (int i_) {i=i_;} int i;};
 class error_not_yet : public execution_error {public : error_not_yet () : execution_error (-2){}};
 
 /// XPath execution class
-class xpath_processor : public xpath_stream
+class xpath_processor
 {
 public :
-   /// Constructor
+   /// Constructor. The expression is compiled through xpath_program_cache::xpc_get_global
    xpath_processor (const TiXmlNode * XNp_source_tree, const char * cp_xpath_expr);
+   /// Constructor, for an expression compiled beforehand
+   xpath_processor (const TiXmlNode * XNp_source_tree, const xpath_program_ptr & xpp_in_program);
    virtual ~ xpath_processor () {}
    expression_result er_compute_xpath ();
    TIXML_STRING S_compute_xpath ();
@@ -66,11 +69,16 @@ public :
    enum {e_no_error, e_error_syntax, e_error_overflow, e_error_execution, e_error_stack} e_error;
 
 protected :
-   virtual void v_action (xpath_construct , unsigned , unsigned , const char * );
-   virtual int i_get_action_counter ();
-
    xpath_stack xs_stack;
-   action_store as_action_store;
+   /// The compiled expression, shared with the cache
+   xpath_program_ptr xpp_program;
+   /// Position of the next action to execute in the program
+   int i_action_position;
+   void v_init (const TiXmlNode * XNp_source_tree);
+   void v_get_action (int i_position, int & i_1, int & i_2, int & i_3, TIXML_STRING & S_out)
+   {
+      xpp_program -> v_get_action (i_position, i_1, i_2, i_3, S_out);
+   }
    void v_execute_stack ();
    void v_pop_one_action (xpath_construct & xc_action, unsigned & u_sub, unsigned & u_ref, TIXML_STRING & S_literal);
    void v_execute_one (xpath_construct xc_rule, bool o_skip_only);
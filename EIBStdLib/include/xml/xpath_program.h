@@ -0,0 +1,110 @@
+/**
+   \file xpath_program.h
+   Compiled XPath expressions for the TinyXPath project
+*/
+
+#ifndef __XPATH_PROGRAM_H
+#define __XPATH_PROGRAM_H
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "xml/action_store.h"
+#include "xml/xpath_stream.h"
+#include "CMutex.h"
+
+namespace TinyXPath
+{
+
+class xpath_program;
+
+/// A compiled expression, shared by the cache and the processors evaluating it
+typedef std::shared_ptr<const xpath_program> xpath_program_ptr;
+
+/// Default number of expressions kept by xpath_program_cache
+#define XPATH_PROGRAM_CACHE_SIZE 128
+
+/**
+   An XPath expression decoded once : the lexical and syntax decoding produce the list of
+   actions that xpath_processor executes. The program does not depend on any document and
+   is never modified after construction, so it can be evaluated any number of times, from
+   any number of threads, against any document.
+*/
+class xpath_program : public xpath_stream
+{
+public :
+   /// Decodes the expression. Syntax errors are kept in e_error, they are reported by the evaluation
+   xpath_program (const char * cp_xpath_expr);
+   virtual ~ xpath_program () {}
+
+   /// Compiles an expression, bypassing the cache
+   static xpath_program_ptr xpp_compile (const char * cp_xpath_expr);
+
+   /// The source text of the expression
+   const TIXML_STRING & S_get_expression () const {return S_expression;}
+   /// Number of actions of the program
+   int i_get_nb_action () const {return i_nb_action;}
+   /// Get one action of the program
+   void v_get_action (int i_position, int & i_1, int & i_2, int & i_3, TIXML_STRING & S_out) const
+   {
+      as_action_store . v_get (i_position, i_1, i_2, i_3, S_out);
+   }
+
+   enum {e_no_error, e_error_syntax, e_error_overflow} e_error;
+
+protected :
+   virtual void v_action (xpath_construct , unsigned , unsigned , const char * );
+   virtual int i_get_action_counter ();
+
+   action_store as_action_store;
+   int i_nb_action;
+   TIXML_STRING S_expression;
+} ;
+
+/**
+   LRU cache of compiled expressions, keyed by the expression text. \n
+   Configuration lookups use a handful of expressions over and over : with the cache
+   each one is decoded once. Thread safe.
+*/
+class xpath_program_cache
+{
+public :
+   xpath_program_cache (unsigned u_in_capacity = XPATH_PROGRAM_CACHE_SIZE);
+
+   /// The program of an expression, compiled on a miss. Evicts the least recently used one when full
+   xpath_program_ptr xpp_get (const char * cp_xpath_expr);
+
+   /// Change the number of expressions kept. 0 disables the cache
+   void v_set_capacity (unsigned u_in_capacity);
+   unsigned u_get_capacity ();
+   /// Number of expressions in the cache
+   unsigned u_get_size ();
+   /// Lookups served from the cache
+   unsigned long ul_get_hits ();
+   /// Lookups that had to compile
+   unsigned long ul_get_misses ();
+   /// Drop all the programs
+   void v_clear ();
+
+   /// The cache used by xpath_processor and the static xpath functions
+   static xpath_program_cache & xpc_get_global ();
+
+protected :
+   typedef std::list<xpath_program_ptr> program_list;
+   typedef std::unordered_map<std::string, program_list::iterator> program_index;
+
+   void v_trim ();
+
+   /// Most recently used first
+   program_list pl_lru;
+   program_index pi_index;
+   unsigned u_capacity;
+   unsigned long ul_hits;
+   unsigned long ul_misses;
+   CMutex m_lock;
+} ;
+
+}
+
+#endif
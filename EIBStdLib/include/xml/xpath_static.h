@@ -42,6 +42,14 @@ namespace TinyXPath
    extern TiXmlNode * XNp_xpath_node (const TiXmlNode * XNp_source_tree, const char * cp_xpath_expr);
    extern TiXmlAttribute * XAp_xpath_attribute (const TiXmlNode * XNp_source_tree, const char * cp_xpath_expr);
 
+   // no check static functions, for an expression compiled beforehand
+   extern int i_xpath_int (const TiXmlNode * XNp_source_tree, const xpath_program_ptr & xpp_program);
+   extern double d_xpath_double (const TiXmlNode * XNp_source_tree, const xpath_program_ptr & xpp_program);
+   extern bool o_xpath_bool (const TiXmlNode * XNp_source_tree, const xpath_program_ptr & xpp_program);
+   extern TIXML_STRING S_xpath_string (const TiXmlNode * XNp_source_tree, const xpath_program_ptr & xpp_program);
+   extern TiXmlNode * XNp_xpath_node (const TiXmlNode * XNp_source_tree, const xpath_program_ptr & xpp_program);
+   extern TiXmlAttribute * XAp_xpath_attribute (const TiXmlNode * XNp_source_tree, const xpath_program_ptr & xpp_program);
+
    // check static functions
    extern bool o_xpath_int (const TiXmlNode * XNp_source_tree, const char * cp_xpath_expr, int & i_res);
    extern bool o_xpath_double (const TiXmlNode * XNp_source_tree, const char * cp_xpath_expr, double & d_res);
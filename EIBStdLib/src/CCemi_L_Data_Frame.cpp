@@ -4,7 +4,8 @@
 using namespace EibStack;
 
 CCemi_L_Data_Frame::CCemi_L_Data_Frame(const CCemi_L_Data_Frame& rhs) :
-_addil_data(NULL)
+_addil_data(NULL),
+_time_stamp(rhs._time_stamp)
 {
 	_data = rhs._data;
 	CopyAddilData(rhs._data.apci_length, rhs._addil_data);
@@ -240,6 +241,7 @@ CCemi_L_Data_Frame& CCemi_L_Data_Frame::operator=(const CCemi_L_Data_Frame& rhs)
 {
 	_data = rhs._data;
 	CopyAddilData(rhs._data.apci_length, rhs._addil_data);
+	_time_stamp = rhs._time_stamp;
 	return *this;
 }
 
@@ -1,6 +1,207 @@
 #include "CString.h"
 #include "CException.h"
 #include "Utils.h"
+#include <ctype.h>
+#include <limits>
+
+//two digit lookup for the decimal formatting
+static const char DIGIT_PAIRS[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+//reads an optionally signed number the way istream >> does: leading white space is skipped and
+//parsing stops at the first character that is not a digit. returns false if there is no digit
+static bool ParseMagnitude(const char* p, int base, uint64& mag, bool& negative, bool& overflow)
+{
+	mag = 0;
+	negative = false;
+	overflow = false;
+	while(isspace((unsigned char)*p)){
+		++p;
+	}
+	if(*p == '-' || *p == '+'){
+		negative = (*p == '-');
+		++p;
+	}
+	bool digits = false;
+	for(;;++p)
+	{
+		int d;
+		if(*p >= '0' && *p <= '9') d = *p - '0';
+		else if(base == 16 && *p >= 'a' && *p <= 'f') d = *p - 'a' + 10;
+		else if(base == 16 && *p >= 'A' && *p <= 'F') d = *p - 'A' + 10;
+		else break;
+		digits = true;
+		if(mag > (~(uint64)0 - d) / base){
+			overflow = true;
+		}else{
+			mag = mag * base + d;
+		}
+	}
+	return digits;
+}
+
+//out of range values are clamped like istream >> does
+template<class T>
+static T ClampSigned(uint64 mag, bool negative, bool overflow)
+{
+	const uint64 max = (uint64)numeric_limits<T>::max();
+	if(negative){
+		if(overflow || mag > max + 1){
+			return numeric_limits<T>::min();
+		}
+		return mag == max + 1 ? numeric_limits<T>::min() : (T)-(int64)mag;
+	}
+	if(overflow || mag > max){
+		return numeric_limits<T>::max();
+	}
+	return (T)mag;
+}
+
+//negative values wrap around like strtoul, out of range values give the maximum
+template<class T>
+static T ClampUnsigned(uint64 mag, bool negative, bool overflow)
+{
+	const uint64 max = (uint64)numeric_limits<T>::max();
+	if(overflow || mag > max){
+		return numeric_limits<T>::max();
+	}
+	return negative ? (T)(0 - mag) : (T)mag;
+}
+
+template<class T>
+T CString::ToSigned() const
+{
+	uint64 mag;
+	bool negative, overflow;
+	if(!ParseMagnitude(_str.c_str(), 10, mag, negative, overflow)){
+		return 0;
+	}
+	return ClampSigned<T>(mag, negative, overflow);
+}
+
+template<class T>
+T CString::ToUnsigned() const
+{
+	uint64 mag;
+	bool negative, overflow;
+	if(!ParseMagnitude(_str.c_str(), 10, mag, negative, overflow)){
+		return 0;
+	}
+	return ClampUnsigned<T>(mag, negative, overflow);
+}
+
+template<class T>
+bool CString::FromHexString(T& val, int max_len, bool exact_len) const
+{
+	int len = GetLength();
+	if ((exact_len ? len != max_len : len > max_len) || len < 2 || _str[0] != '0' || (_str[1] != 'x' && _str[1] != 'X')){
+		return false;
+	}
+
+	for (int counter = 2; counter < len; ++counter){
+		if (!IS_HEX_DIGIT(_str[counter])){
+			return false;
+		}
+	}
+
+	uint64 mag;
+	bool negative, overflow;
+	if(!ParseMagnitude(_str.c_str() + 2, 16, mag, negative, overflow)){
+		val = 0;
+	}else if(numeric_limits<T>::is_signed){
+		val = ClampSigned<T>(mag, negative, overflow);
+	}else{
+		val = ClampUnsigned<T>(mag, negative, overflow);
+	}
+	return true;
+}
+
+int CString::FormatUInt(char* buffer, uint64 val)
+{
+	char tmp[MAX_INT_CHARS];
+	char* p = tmp + sizeof(tmp);
+	while(val >= 100){
+		int i = (int)(val % 100) * 2;
+		val /= 100;
+		*--p = DIGIT_PAIRS[i + 1];
+		*--p = DIGIT_PAIRS[i];
+	}
+	if(val >= 10){
+		int i = (int)val * 2;
+		*--p = DIGIT_PAIRS[i + 1];
+		*--p = DIGIT_PAIRS[i];
+	}else{
+		*--p = (char)('0' + val);
+	}
+	int len = (int)(tmp + sizeof(tmp) - p);
+	memcpy(buffer, p, len);
+	return len;
+}
+
+int CString::FormatInt(char* buffer, int64 val)
+{
+	if(val < 0){
+		*buffer = '-';
+		return FormatUInt(buffer + 1, 0 - (uint64)val) + 1;
+	}
+	return FormatUInt(buffer, (uint64)val);
+}
+
+CString& CString::Append(const char* str, int len)
+{
+	_str.append(str, len);
+	return *this;
+}
+
+CString& CString::AppendInt(int64 val)
+{
+	char buf[MAX_INT_CHARS];
+	_str.append(buf, FormatInt(buf, val));
+	return *this;
+}
+
+CString& CString::AppendUInt(uint64 val)
+{
+	char buf[MAX_INT_CHARS];
+	_str.append(buf, FormatUInt(buf, val));
+	return *this;
+}
+
+CString& CString::AppendHex(uint64 val, int min_digits, bool include_prefix)
+{
+	char buf[MAX_INT_CHARS];
+	char* p = buf + sizeof(buf);
+	do{
+		*--p = HEX_DIGITS[val & 0xF];
+		val >>= 4;
+	}while(val != 0);
+	if(include_prefix){
+		_str.append("0x", 2);
+	}
+	int len = (int)(buf + sizeof(buf) - p);
+	if(min_digits > len){
+		_str.append(min_digits - len, '0');
+	}
+	_str.append(p, len);
+	return *this;
+}
+
+//default ostream formatting of doubles
+static int FormatDouble(char* buffer, int size, double val)
+{
+	return snprintf(buffer, size, "%g", val);
+}
 
 CString::CString()
 {
@@ -60,37 +261,28 @@ CString::CString(const CString& rhs)
 
 CString::CString(int str)
 {
-	ostringstream os;
-	os << str;
-	_str = os.str();
+	AppendInt(str);
 }
 
 CString::CString(unsigned int str)
 {
-	ostringstream os;
-	os << str;
-	_str = os.str();
+	AppendUInt(str);
 }
 
 CString::CString(size_t str)
 {
-	ostringstream os;
-	os << str;
-	_str = os.str();
+	AppendUInt(str);
 }
 
 CString::CString(int64 str)
 {
-	ostringstream os;
-	os << str;
-	_str = os.str();
+	AppendInt(str);
 }
 
 CString::CString(double str)
 {
-	ostringstream os;
-	os << str;
-	_str = os.str();
+	char buf[32];
+	_str.assign(buf, FormatDouble(buf, sizeof(buf), str));
 }
 
 CString::~CString()
@@ -179,42 +371,29 @@ CString& CString::operator+=(unsigned char c)
 
 CString& CString::operator+=(const int& str)
 {
-	ostringstream os;
-	os << str;
-	_str += os.str();
-	return *this;
+	return AppendInt(str);
 }
 
 
 CString& CString::operator+=(const unsigned int& str)
 {
-	ostringstream os;
-	os << str;
-	_str += os.str();
-	return *this;
+	return AppendUInt(str);
 }
 
 CString& CString::operator+=(const int64& str)
 {
-	ostringstream os;
-	os << str;
-	_str += os.str();
-	return *this;
+	return AppendInt(str);
 }
 
 CString& CString::operator+=(const uint64& str)
 {
-	ostringstream os;
-	os << str;
-	_str += os.str();
-	return *this;
+	return AppendUInt(str);
 }
 
 CString& CString::operator+=(const double& str)
 {
-	ostringstream os;
-	os << str;
-	_str += os.str();
+	char buf[32];
+	_str.append(buf, FormatDouble(buf, sizeof(buf), str));
 	return *this;
 }
 
@@ -380,57 +559,46 @@ CString& CString::operator+=(const char& str)
 
 char CString::ToChar() const
 {
-	char val;
-	istringstream is(_str);
-	is >> val;
-	return val;
+	//first character that is not a white space
+	const char* p = _str.c_str();
+	while(isspace((unsigned char)*p)){
+		++p;
+	}
+	return (char)*p;
 }
 
 unsigned char CString::ToUChar() const
 {
-	unsigned char val;
-	istringstream is(_str);
-	is >> val;
-	return val;
+	//first character that is not a white space
+	const char* p = _str.c_str();
+	while(isspace((unsigned char)*p)){
+		++p;
+	}
+	return (unsigned char)*p;
 }
 
 int CString::ToInt() const
 {
-	int val;
-	istringstream is(_str);
-	is >> val;
-	return val;
+	return ToSigned<int>();
 }
 
 unsigned int CString::ToUInt() const
 {
-	unsigned int val;
-	istringstream is(_str);
-	is >> val;
-	return val;
+	return ToUnsigned<unsigned int>();
 }
 
 int64 CString::ToInt64() const
 {
-	int64 val;
-	istringstream is(_str);
-	is >> val;
-	return val;
+	return ToSigned<int64>();
 }
 uint64 CString::ToUInt64() const
 {
-	uint64 val;
-	istringstream is(_str);
-	is >> val;
-	return val;
+	return ToUnsigned<uint64>();
 }
 
 double CString::ToDouble() const
 {
-	double val;
-	istringstream is(_str);
-	is >> val;
-	return val;
+	return strtod(_str.c_str(), NULL);
 }
 
 bool CString::ToBool()  const
@@ -443,33 +611,21 @@ bool CString::ToBool()  const
 
 short CString::ToShort() const
 {
-	short val;
-	istringstream is(_str);
-	is >> val;
-	return val;
+	return ToSigned<short>();
 }
 
 unsigned short CString::ToUShort() const
 {
-	unsigned short val;
-	istringstream is(_str);
-	is >> val;
-	return val;
+	return ToUnsigned<unsigned short>();
 }
 
 long CString::ToLong() const
 {
-	long val;
-	istringstream is(_str);
-	is >> val;
-	return val;
+	return ToSigned<long>();
 }
 unsigned long CString::ToULong() const
 {
-	unsigned long val;
-	istringstream is(_str);
-	is >> val;
-	return val;
+	return ToUnsigned<unsigned long>();
 }
 
 int CString::ToByteArray(char* buffer, int max_len) const
@@ -519,36 +675,12 @@ int CString::ToByteArray(char* buffer, int max_len) const
 
 bool CString::ShortFromHexString(short& val) const
 {
-	if (GetLength() != 6 || _str[0] != '0' || (_str[1] != 'x' && _str[1] != 'X')){
-		return false;
-	}
-
-	for (int counter = 2; counter < GetLength(); ++counter){
-		if (!IS_HEX_DIGIT(_str[counter])){
-			return false;
-		}
-	}
-
-	istringstream is(_str);
-	is >> hex >> val;
-	return true;
+	return FromHexString(val, 6, true);
 }
 
 bool CString::UShortFromHexString(unsigned short& val) const
 {
-	if (GetLength() > 6 || _str[0] != '0' || (_str[1] != 'x' && _str[1] != 'X')){
-		return false;
-	}
-
-	for (int counter = 2; counter < GetLength(); ++counter){
-		if (!IS_HEX_DIGIT(_str[counter])){
-			return false;
-		}
-	}
-
-	istringstream is(_str);
-	is >> hex >> val;
-	return true;
+	return FromHexString(val, 6, false);
 }
 
 bool CString::BitFromHexString(unsigned char& val) const
@@ -561,51 +693,17 @@ bool CString::BitFromHexString(unsigned char& val) const
 
 bool CString::UCharFromHexString(unsigned char& val) const
 {
-	if (GetLength() > 4 || _str[0] != '0' || (_str[1] != 'x' && _str[1] != 'X')){
-		return false;
-	}
-
-	for (int counter = 2; counter < GetLength(); ++counter){
-		if (!IS_HEX_DIGIT(_str[counter])){
-			return false;
-		}
-	}
-	val = (unsigned char)strtol(_str.c_str(),NULL,16);
-	return true;
+	return FromHexString(val, 4, false);
 }
 
 bool CString::IntFromHexString(int& val) const
 {
-	if (GetLength() != 10 || _str[0] != '0' || (_str[1] != 'x' && _str[1] != 'X')){
-		return false;
-	}
-
-	for (int counter = 2; counter < GetLength(); ++counter){
-		if (!IS_HEX_DIGIT(_str[counter])){
-			return false;
-		}
-	}
-
-	istringstream is(_str);
-	is >> hex >> val;
-	return true;
+	return FromHexString(val, 10, true);
 }
 
 bool CString::UIntFromHexString(unsigned int& val) const
 {
-	if (GetLength() != 10 || _str[0] != '0' || (_str[1] != 'x' && _str[1] != 'X')){
-		return false;
-	}
-
-	for (int counter = 2; counter < GetLength(); ++counter){
-		if (!IS_HEX_DIGIT(_str[counter])){
-			return false;
-		}
-	}
-
-	istringstream is(_str);
-	is >> hex >> val;
-	return true;
+	return FromHexString(val, 10, true);
 }
 
 unsigned int CString::HashCode() const
@@ -623,57 +721,46 @@ unsigned int CString::HashCode() const
 
 CString CString::ToHexFormat(char val, bool include_prefix)
 {
-	return ToHexFormat(sizeof(char) * 2,ToHex((int)val), include_prefix);
+	//sign extended like the int it used to be formatted as
+	return CString().AppendHex((unsigned int)(int)val, sizeof(char) * 2, include_prefix);
 }
 
 CString CString::ToHexFormat(unsigned char val, bool include_prefix)
 {
-	return ToHexFormat(sizeof(unsigned char) * 2,ToHex((unsigned int)val), include_prefix);
+	return CString().AppendHex(val, sizeof(unsigned char) * 2, include_prefix);
 }
 
 CString CString::ToHexFormat(short val, bool include_prefix)
 {
-	return ToHexFormat(sizeof(short) * 2,ToHex(val), include_prefix);
+	return CString().AppendHex((unsigned short)val, sizeof(short) * 2, include_prefix);
 }
 
 CString CString::ToHexFormat(unsigned short val, bool include_prefix)
 {
-	return ToHexFormat(sizeof(unsigned short) * 2,ToHex(val), include_prefix);
+	return CString().AppendHex(val, sizeof(unsigned short) * 2, include_prefix);
 }
 
 CString CString::ToHexFormat(int val, bool include_prefix)
 {
-	return ToHexFormat(sizeof(unsigned int) * 2,ToHex(val), include_prefix);
+	return CString().AppendHex((unsigned int)val, sizeof(unsigned int) * 2, include_prefix);
 }
 
 CString CString::ToHexFormat(unsigned int val, bool include_prefix)
 {
-	return ToHexFormat(sizeof(unsigned int) * 2,ToHex(val), include_prefix);
-}
-
-CString CString::ToHexFormat(int wanted_length, const CString& current, bool include_prefix)
-{
-	if (wanted_length > current.GetLength()){
-		CString res = include_prefix ? "0x" : EMPTY_STRING;
-		for(int i=0; i < wanted_length - current.GetLength(); ++i){
-			res += '0';
-		}
-		res += current;
-		return res;
-	}
-	else{
-		if(include_prefix)
-			return (CString("0x") + current);
-		else
-			return current;
-	}
+	return CString().AppendHex(val, sizeof(unsigned int) * 2, include_prefix);
 }
 
 CString CString::ToHexFormat(const char* buffer, int len, bool include_prefix)
 {
-	CString res = include_prefix ? "0x" : EMPTY_STRING;
+	CString res;
+	res._str.reserve(len * 2 + 2);
+	if(include_prefix){
+		res._str.append("0x", 2);
+	}
 	for(int i = 0; i < len; ++i){
-		res += ToHexFormat(sizeof(char) * 2, ToHex(buffer[i] & 0xFF), false);
+		unsigned char b = (unsigned char)buffer[i];
+		res._str += HEX_DIGITS[b >> 4];
+		res._str += HEX_DIGITS[b & 0xF];
 	}
 	return res;
 }
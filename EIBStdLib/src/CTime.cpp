@@ -1,6 +1,141 @@
 #include "CTime.h"
 
 bool CTime::_default_local_time = true;
+std::atomic<int> CTime::_zone_generation(0);
+
+//Formatting a time is dominated by localtime()/strftime(). Every thread keeps the text of the last minute
+//it formatted (for each format and zone) and only patches the seconds while the time stays in that minute.
+//Zone offsets and DST changes are whole minutes, so the rest of the text stays valid.
+#define TIME_SECONDS_OFFSET 17 //both "Mon Aug 21 20:07:29 2000" and "2000-08-21T20:07:29Z" keep the seconds here
+#define TIME_TEXT_SIZE 26 //the longest text, "2000-08-21T20:07:29+02:00", and its terminator
+
+typedef struct TimeFormatCache
+{
+	bool valid;
+	int generation;
+	time_t minute;
+	int length;
+	char text[32];
+}TimeFormatCache;
+
+//[format][local]
+static thread_local TimeFormatCache _format_cache[2][2];
+
+static const char* const WEEK_DAYS[] = {"Sun","Mon","Tue","Wed","Thu","Fri","Sat"};
+static const char* const MONTHS[] = {"Jan","Feb","Mar","Apr","May","Jun","Jul","Aug","Sep","Oct","Nov","Dec"};
+
+static char* PutTwoDigits(char* p, int val)
+{
+	*p++ = (char)('0' + val / 10);
+	*p++ = (char)('0' + val % 10);
+	return p;
+}
+
+//Renders without strftime(), which costs more than localtime() itself. Returns the length
+static int RenderTime(time_t tt, bool get_local, bool iso, char* buffer, int size)
+{
+	if (size < TIME_TEXT_SIZE) {
+		if (size > 0) {
+			buffer[0] = '\0';
+		}
+		return 0;
+	}
+
+	struct tm tm_struct;
+#ifdef WIN32
+	struct tm* res = get_local ? localtime(&tt) : gmtime(&tt);
+	if (res == NULL) {
+		buffer[0] = '\0';
+		return 0;
+	}
+	tm_struct = *res;
+#else
+	if ((get_local ? localtime_r(&tt, &tm_struct) : gmtime_r(&tt, &tm_struct)) == NULL) {
+		buffer[0] = '\0';
+		return 0;
+	}
+#endif
+
+	int year = tm_struct.tm_year + 1900;
+	if (year < 0 || year > 9999) {
+		//out of the fixed width formats
+		buffer[0] = '\0';
+		return 0;
+	}
+
+	char* p = buffer;
+	if (!iso) {
+		// We keep the format of ctime, for example "Mon Aug 21 20:07:29 2000"
+		memcpy(p, WEEK_DAYS[tm_struct.tm_wday], 3);
+		p[3] = ' ';
+		memcpy(p + 4, MONTHS[tm_struct.tm_mon], 3);
+		p[7] = ' ';
+		p = PutTwoDigits(p + 8, tm_struct.tm_mday);
+		*p++ = ' ';
+		p = PutTwoDigits(p, tm_struct.tm_hour);
+		*p++ = ':';
+		p = PutTwoDigits(p, tm_struct.tm_min);
+		*p++ = ':';
+		p = PutTwoDigits(p, tm_struct.tm_sec);
+		*p++ = ' ';
+		p = PutTwoDigits(p, year / 100);
+		p = PutTwoDigits(p, year % 100);
+		*p = '\0';
+		return (int)(p - buffer);
+	}
+
+	p = PutTwoDigits(p, year / 100);
+	p = PutTwoDigits(p, year % 100);
+	*p++ = '-';
+	p = PutTwoDigits(p, tm_struct.tm_mon + 1);
+	*p++ = '-';
+	p = PutTwoDigits(p, tm_struct.tm_mday);
+	*p++ = 'T';
+	p = PutTwoDigits(p, tm_struct.tm_hour);
+	*p++ = ':';
+	p = PutTwoDigits(p, tm_struct.tm_min);
+	*p++ = ':';
+	p = PutTwoDigits(p, tm_struct.tm_sec);
+	if (!get_local) {
+		*p++ = 'Z';
+		*p = '\0';
+		return (int)(p - buffer);
+	}
+#ifdef WIN32
+	long offset = -_timezone + (tm_struct.tm_isdst > 0 ? 3600 : 0);
+#else
+	long offset = tm_struct.tm_gmtoff;
+#endif
+	*p++ = offset < 0 ? '-' : '+';
+	offset = offset < 0 ? -offset : offset;
+	p = PutTwoDigits(p, (int)(offset / 3600));
+	*p++ = ':';
+	p = PutTwoDigits(p, (int)((offset / 60) % 60));
+	*p = '\0';
+	return (int)(p - buffer);
+}
+
+static void AppendCachedTime(CString& result, time_t tt, bool get_local, bool iso, int generation)
+{
+	TimeFormatCache& cache = _format_cache[iso ? 1 : 0][get_local ? 1 : 0];
+	int sec = (int)(((tt % 60) + 60) % 60);
+	time_t minute = tt - sec;
+
+	if (!cache.valid || cache.minute != minute || cache.generation != generation) {
+		cache.length = RenderTime(minute, get_local, iso, cache.text, sizeof(cache.text));
+		cache.minute = minute;
+		cache.generation = generation;
+		cache.valid = cache.length > TIME_SECONDS_OFFSET + 1;
+		if (!cache.valid) {
+			result.Append(cache.text, cache.length);
+			return;
+		}
+	}
+
+	cache.text[TIME_SECONDS_OFFSET] = (char)('0' + sec / 10);
+	cache.text[TIME_SECONDS_OFFSET + 1] = (char)('0' + sec % 10);
+	result.Append(cache.text, cache.length);
+}
 
 void CTime::Initialize()
 {
@@ -9,6 +144,7 @@ void CTime::Initialize()
 #else
 	tzset(); // set the time zone
 #endif
+	++_zone_generation;
 }
 
 /**
@@ -177,47 +313,14 @@ CString CTime::Format(bool get_local) const
 }
 void CTime::AddFormatToString(CString& result,bool get_local) const
 {
-	char strDest[25];
-	size_t maxsize = 25;
-	time_t tt = GetTime();
-	struct tm *tm_struct;
-	// Using thread safe functions
-	if (!get_local) {
-		// Use gmtime for UTC format
-#ifdef WIN32
-		tm_struct = EibGMTime(&tt);
-#else
-		tm_struct = new struct tm();
-		if (!tm_struct) {
-			return ;
-		}
-		EibGMTime_r(&tt, tm_struct);
-#endif
-	} else {
-		// Use localtime for local time format
-#ifdef WIN32
-		tm_struct = EibTime(&tt);
-#else
-		tm_struct = new struct tm();
-		if (!tm_struct) {
-			return ;
-		}
-		EIBTtime_r(&tt, tm_struct);
-#endif
-	}
-
-	// We keep the format of ctime, for example "Mon Aug 21 20:07:29 2000"
-	(void) strftime(strDest, maxsize, "%a %b %d %H:%M:%S %Y", tm_struct);
-
-#ifndef WIN32
-	delete tm_struct;
-#endif
+	AppendCachedTime(result, GetTime(), get_local, false, _zone_generation);
+}
 
-	// Supporting UNIX time format.
-	if (strDest[8] == ' ') {
-		strDest[8] = '0';
-	}
-	result += strDest ;
+CString CTime::FormatISO8601(bool get_local) const
+{
+	CString result;
+	AppendCachedTime(result, GetTime(), get_local, true, _zone_generation);
+	return result;
 }
 
 //Sets the time value to be 'now'
@@ -508,6 +611,7 @@ bool CTime::SetTimeZone(const int timezone)
 	tzi.Bias = -(long)(timezone);
 	if (!SetTimeZoneInformation(&tzi))
 		return false;
+	++_zone_generation;
 	return true;
 #else
 	if (system("tzselect > /var/tmp/tz_out.txt") != 0) {
@@ -558,6 +662,7 @@ bool CTime::SetTimeZoneName(const CString& timezone)
 		}
 	}
 	*/
+	++_zone_generation;
 	return true;
 }
 #endif
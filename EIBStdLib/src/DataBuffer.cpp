@@ -59,8 +59,8 @@ CDataBuffer& CDataBuffer::operator+=(const char* str)
 }
 CDataBuffer& CDataBuffer::operator+=(const int& str)
 {
-	CString s(str);
-	this->Add(s.GetBuffer(),s.GetLength());
+	char buf[MAX_INT_CHARS];
+	this->Add(buf,CString::FormatInt(buf,str));
 	return *this;
 }
 
@@ -72,8 +72,8 @@ CDataBuffer& CDataBuffer::operator+=(const CString& str)
 
 CDataBuffer& CDataBuffer::operator+=(const int64& str)
 {
-	CString s(str);
-	this->Add(s.GetBuffer(),s.GetLength());
+	char buf[MAX_INT_CHARS];
+	this->Add(buf,CString::FormatInt(buf,str));
 	return *this;
 }
 
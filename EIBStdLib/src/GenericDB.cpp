@@ -0,0 +1,303 @@
+#include "GenericDB.h"
+#include <stdio.h>
+#include <string.h>
+#ifndef WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+CDBMappedFile::CDBMappedFile() : _data(NULL), _size(0), _mapped(false)
+{
+}
+
+CDBMappedFile::~CDBMappedFile()
+{
+	Close();
+}
+
+bool CDBMappedFile::Open(const CString& file_name)
+{
+	Close();
+#ifndef WIN32
+	int fd = open(file_name.GetBuffer(), O_RDONLY);
+	if (fd < 0){
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0){
+		close(fd);
+		return false;
+	}
+	_size = static_cast<size_t>(st.st_size);
+	if (_size > 0){
+		void* addr = mmap(NULL, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr != MAP_FAILED){
+			_data = static_cast<const char*>(addr);
+			_mapped = true;
+			close(fd);
+			return true;
+		}
+	}
+	close(fd);
+	_size = 0;
+#endif
+	//empty file, or no mapping on this platform
+	ifstream file(file_name.GetBuffer(), ios::in | ios::binary);
+	if (file.fail()){
+		return false;
+	}
+	ostringstream content;
+	content << file.rdbuf();
+	_buf = content.str();
+	_data = _buf.data();
+	_size = _buf.size();
+	return true;
+}
+
+void CDBMappedFile::Close()
+{
+#ifndef WIN32
+	if (_mapped){
+		munmap(const_cast<char*>(_data), _size);
+	}
+#endif
+	_buf.clear();
+	_data = NULL;
+	_size = 0;
+	_mapped = false;
+}
+
+void CDBRecordWriter::Header(const char* magic, uint64 text_size, uint64 text_hash)
+{
+	_buf.append(magic, 8);
+	UInt32(GENERIC_DB_FORMAT_VERSION);
+	UInt64(text_size);
+	UInt64(text_hash);
+}
+
+void CDBRecordWriter::Name(const CString& name)
+{
+	_buf += 'N';
+	String(name);
+}
+
+void CDBRecordWriter::Param(const CString& param, const CString& value)
+{
+	_buf += 'P';
+	String(param);
+	String(value);
+}
+
+void CDBRecordWriter::Delete(const CString& name)
+{
+	_buf += 'D';
+	String(name);
+}
+
+void CDBRecordWriter::String(const CString& str)
+{
+	UInt32(static_cast<unsigned int>(str.GetLength()));
+	_buf.append(str.GetBuffer(), str.GetLength());
+}
+
+void CDBRecordWriter::UInt32(unsigned int val)
+{
+	for (int i = 0; i < 4; ++i){
+		_buf += static_cast<char>((val >> (8 * i)) & 0xFF);
+	}
+}
+
+void CDBRecordWriter::UInt64(uint64 val)
+{
+	UInt32(static_cast<unsigned int>(val & 0xFFFFFFFF));
+	UInt32(static_cast<unsigned int>(val >> 32));
+}
+
+bool CDBRecordWriter::WriteFile(const CString& file_name, bool append) const
+{
+	if (append){
+		ofstream file(file_name.GetBuffer(), ios::out | ios::binary | ios::app);
+		if (!file.is_open()){
+			return false;
+		}
+		file.write(_buf.data(), static_cast<streamsize>(_buf.size()));
+		file.flush();
+		return file.good();
+	}
+
+	//a reader never sees a half written file
+	CString tmp_name = file_name + ".tmp";
+	{
+		ofstream file(tmp_name.GetBuffer(), ios::out | ios::binary | ios::trunc);
+		if (!file.is_open()){
+			return false;
+		}
+		file.write(_buf.data(), static_cast<streamsize>(_buf.size()));
+		file.close();
+		if (file.fail()){
+			remove(tmp_name.GetBuffer());
+			return false;
+		}
+	}
+#ifdef WIN32
+	remove(file_name.GetBuffer());
+#endif
+	if (rename(tmp_name.GetBuffer(), file_name.GetBuffer()) != 0){
+		remove(tmp_name.GetBuffer());
+		return false;
+	}
+	return true;
+}
+
+uint64 CDBRecordWriter::Hash(const char* data, size_t length)
+{
+	uint64 hash = 14695981039346656037ULL;
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < length; ++i){
+		hash ^= p[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+CDBRecordReader::CDBRecordReader(const char* data, size_t length) :
+_data(data),
+_length(length),
+_pos(0)
+{
+}
+
+bool CDBRecordReader::Header(const char* magic, uint64 text_size, uint64 text_hash)
+{
+	if (_length - _pos < 8 || memcmp(_data + _pos, magic, 8) != 0){
+		return false;
+	}
+	_pos += 8;
+	unsigned int version;
+	uint64 size, hash;
+	if (!UInt32(version) || !UInt64(size) || !UInt64(hash)){
+		return false;
+	}
+	return version == GENERIC_DB_FORMAT_VERSION && size == text_size && hash == text_hash;
+}
+
+char CDBRecordReader::Next(CString& first, CString& second)
+{
+	if (_pos >= _length){
+		return 0;
+	}
+	size_t start = _pos;
+	char tag = _data[_pos++];
+	bool ok;
+	switch (tag)
+	{
+	case 'N':
+	case 'D':
+		ok = String(first);
+		break;
+	case 'P':
+		ok = String(first) && String(second);
+		break;
+	case 'E':
+	case 'C':
+	case 'Z':
+		ok = true;
+		break;
+	default:
+		ok = false;
+		break;
+	}
+	if (!ok){
+		_pos = start;
+		return 0;
+	}
+	return tag;
+}
+
+bool CDBRecordReader::String(CString& str)
+{
+	unsigned int len;
+	if (!UInt32(len) || _length - _pos < len){
+		return false;
+	}
+	str.GetSTDString().assign(_data + _pos, len);
+	_pos += len;
+	return true;
+}
+
+bool CDBRecordReader::UInt32(unsigned int& val)
+{
+	if (_length - _pos < 4){
+		return false;
+	}
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(_data + _pos);
+	val = p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<unsigned int>(p[3]) << 24);
+	_pos += 4;
+	return true;
+}
+
+bool CDBRecordReader::UInt64(uint64& val)
+{
+	unsigned int low, high;
+	if (!UInt32(low) || !UInt32(high)){
+		return false;
+	}
+	val = (static_cast<uint64>(high) << 32) | low;
+	return true;
+}
+
+bool CDBJournal::Read(const CString& file_name, uint64 text_size, uint64 text_hash, size_t& size)
+{
+	_cleared = false;
+	_complete = true;
+	_entries.clear();
+	size = 0;
+
+	CDBMappedFile file;
+	if (!file.Open(file_name)){
+		return false;
+	}
+	CDBRecordReader reader(file.GetData(), file.GetSize());
+	if (!reader.Header("EIBDBJRN", text_size, text_hash)){
+		return false;
+	}
+	size = file.GetSize();
+
+	CString first, second;
+	char tag;
+	while ((tag = reader.Next(first, second)) != 0)
+	{
+		if (tag == 'C'){
+			_cleared = true;
+			_entries.clear();
+		}
+		else if (tag == 'D'){
+			Entry& entry = _entries[first];
+			entry.deleted = true;
+			entry.params.clear();
+		}
+		else if (tag == 'N'){
+			//the record counts only once its end was written
+			CString name = first;
+			ParamList params;
+			while ((tag = reader.Next(first, second)) == 'P'){
+				params.push_back(pair<CString, CString>(first, second));
+			}
+			if (tag != 'E'){
+				//cut off, also when the cut fell between two entries
+				_complete = false;
+				return true;
+			}
+			Entry& entry = _entries[name];
+			entry.deleted = false;
+			entry.params.swap(params);
+		}
+		else{
+			break;
+		}
+	}
+	_complete = (tag == 0 && reader.GetPosition() == file.GetSize());
+	return true;
+}
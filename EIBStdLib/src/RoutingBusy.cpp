@@ -0,0 +1,37 @@
+#include "RoutingBusy.h"
+
+using namespace EibStack;
+
+CRoutingBusy::CRoutingBusy(unsigned char devicestate, unsigned short waittime, unsigned short control) :
+CEIBNetPacket<EIBNETIP_ROUTING_BUSY>(ROUTING_BUSY)
+{
+	_data.structlength = sizeof(EIBNETIP_ROUTING_BUSY);
+	_data.devicestate = devicestate;
+	_data.waittime = waittime;
+	_data.control = control;
+}
+
+CRoutingBusy::CRoutingBusy(unsigned char* data) :
+CEIBNetPacket<EIBNETIP_ROUTING_BUSY>(data)
+{
+	_data.structlength = data[0];
+	_data.devicestate = data[1];
+	_data.waittime = (data[2] << 8) | data[3];
+	_data.control = (data[4] << 8) | data[5];
+}
+
+CRoutingBusy::~CRoutingBusy()
+{
+}
+
+void CRoutingBusy::FillBuffer(unsigned char* buffer, int max_length)
+{
+	CEIBNetPacket<EIBNETIP_ROUTING_BUSY>::FillBuffer(buffer,max_length);
+	unsigned char* tmp_ptr = buffer + GetHeaderSize();
+	tmp_ptr[0] = _data.structlength;
+	tmp_ptr[1] = _data.devicestate;
+	tmp_ptr[2] = (unsigned char)(_data.waittime >> 8);
+	tmp_ptr[3] = (unsigned char)(_data.waittime & 0xFF);
+	tmp_ptr[4] = (unsigned char)(_data.control >> 8);
+	tmp_ptr[5] = (unsigned char)(_data.control & 0xFF);
+}
@@ -0,0 +1,33 @@
+#include "RoutingLostMessage.h"
+
+using namespace EibStack;
+
+CRoutingLostMessage::CRoutingLostMessage(unsigned char devicestate, unsigned short lostmessages) :
+CEIBNetPacket<EIBNETIP_ROUTING_LOST_MESSAGE>(ROUTING_LOST_MESSAGE)
+{
+	_data.structlength = sizeof(EIBNETIP_ROUTING_LOST_MESSAGE);
+	_data.devicestate = devicestate;
+	_data.lostmessages = lostmessages;
+}
+
+CRoutingLostMessage::CRoutingLostMessage(unsigned char* data) :
+CEIBNetPacket<EIBNETIP_ROUTING_LOST_MESSAGE>(data)
+{
+	_data.structlength = data[0];
+	_data.devicestate = data[1];
+	_data.lostmessages = (data[2] << 8) | data[3];
+}
+
+CRoutingLostMessage::~CRoutingLostMessage()
+{
+}
+
+void CRoutingLostMessage::FillBuffer(unsigned char* buffer, int max_length)
+{
+	CEIBNetPacket<EIBNETIP_ROUTING_LOST_MESSAGE>::FillBuffer(buffer,max_length);
+	unsigned char* tmp_ptr = buffer + GetHeaderSize();
+	tmp_ptr[0] = _data.structlength;
+	tmp_ptr[1] = _data.devicestate;
+	tmp_ptr[2] = (unsigned char)(_data.lostmessages >> 8);
+	tmp_ptr[3] = (unsigned char)(_data.lostmessages & 0xFF);
+}
@@ -574,6 +574,79 @@ int UDPSocket::RecvFrom(void *buffer, int bufferLen, CString &sourceAddress,int
   return rtn;
 }
 
+int UDPSocket::RecvFrom(void *buffer, int bufferLen, CString &sourceAddress,int &sourcePort, int time_out, CTimeStamp &stamp)
+{
+#ifdef SO_TIMESTAMPNS
+  if((unsigned)time_out != INFINITE){
+    fd_set rfds;
+    struct timeval tv;
+    initSockFileDescriptors(sockDesc,&rfds,&tv,time_out);
+    if (select(sockDesc + 1,&rfds,NULL,NULL,&tv) < 0){
+      CString tmp;
+      GetError(tmp);
+      throw SocketException(tmp.GetBuffer(), true);
+    }
+    if(!FD_ISSET(sockDesc,&rfds)){
+      return 0;
+    }
+  }
+
+  sockaddr_in clntAddr;
+  struct iovec iov;
+  struct msghdr msg;
+  char control[CMSG_SPACE(sizeof(struct timespec))];
+  iov.iov_base = buffer;
+  iov.iov_len = bufferLen;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = &clntAddr;
+  msg.msg_namelen = sizeof(clntAddr);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  int rtn;
+  if ((rtn = recvmsg(sockDesc, &msg, 0)) < 0)
+  {
+    CString tmp;
+    GetError(tmp);
+    throw SocketException(tmp.GetBuffer(), true);
+  }
+  sourceAddress = inet_ntoa(clntAddr.sin_addr);
+  sourcePort = ntohs(clntAddr.sin_port);
+
+  stamp = CTimeStamp();
+  for (struct cmsghdr* c = CMSG_FIRSTHDR(&msg); c != NULL; c = CMSG_NXTHDR(&msg, c))
+  {
+    if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS){
+      struct timespec ts;
+      memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+      stamp = CTimeStamp::FromWallTime((int64)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec);
+    }
+  }
+  if (stamp.IsZero()){
+    stamp = CTimeStamp::Now();
+  }
+  return rtn;
+#else
+  int rtn = RecvFrom(buffer,bufferLen,sourceAddress,sourcePort,time_out);
+  if (rtn > 0){
+    stamp = CTimeStamp::Now();
+  }
+  return rtn;
+#endif
+}
+
+bool UDPSocket::EnableReceiveTimeStamps()
+{
+#ifdef SO_TIMESTAMPNS
+  int flag = 1;
+  return setsockopt(sockDesc, SOL_SOCKET, SO_TIMESTAMPNS, (raw_type *)&flag, sizeof(flag)) == 0;
+#else
+  return false;
+#endif
+}
+
 void UDPSocket::SetMulticastTTL(unsigned char multicastTTL){
   if (setsockopt(sockDesc, IPPROTO_IP, IP_MULTICAST_TTL,(raw_type *) &multicastTTL, sizeof(multicastTTL)) < 0)
   {
@@ -4,7 +4,7 @@
 int MAX_NUM_OBJECT_HISTORY = DEFAULT_MAX_NUM_OBJECT_VALUE_HISTORY;
 int MAX_NUM_OBJECTS = DEFAULT_MAX_NUM_OBJECTS_HISTORY;
 
-CStatsDB::CStatsDB() : _num_packets_received(0)
+CStatsDB::CStatsDB() : _num_packets_received(0), _last_gap_ns(0)
 {
 }
 
@@ -17,6 +17,11 @@ void CStatsDB::Init()
 }
 
 void CStatsDB::AddRecord(const CEibAddress& function, unsigned char* value, unsigned char value_len)
+{
+	AddRecord(function, value, value_len, CTimeStamp::NowCached());
+}
+
+void CStatsDB::AddRecord(const CEibAddress& function, unsigned char* value, unsigned char value_len, const CTimeStamp& time_stamp)
 {	
 	map<CEibAddress,CEIBObjectRecord>::iterator it;
 	it = _db.find(function);
@@ -26,11 +31,16 @@ void CStatsDB::AddRecord(const CEibAddress& function, unsigned char* value, unsi
 		}
 		CEIBObjectRecord rec;
 		rec.SetFunction(function);
-		rec.AddRecord(value, value_len);
+		rec.AddRecord(value, value_len, time_stamp);
 		_db.insert(pair<CEibAddress,CEIBObjectRecord>(function,rec));
 	}else{
-		it->second.AddRecord(value, value_len);
+		it->second.AddRecord(value, value_len, time_stamp);
+	}
+
+	if(!_last_time_stamp.IsZero()){
+		_last_gap_ns = time_stamp - _last_time_stamp;
 	}
+	_last_time_stamp = time_stamp;
 
 	++_num_packets_received;
 	
@@ -70,7 +80,7 @@ CEIBObjectRecord::~CEIBObjectRecord()
 {
 }
 
-void CEIBObjectRecord::AddRecord(unsigned char* value, unsigned char value_len)
+void CEIBObjectRecord::AddRecord(unsigned char* value, unsigned char value_len, const CTimeStamp& time_stamp)
 {
 	if ((int)_history.size() == MAX_NUM_OBJECT_HISTORY){
 		_history.pop_back();
@@ -78,7 +88,8 @@ void CEIBObjectRecord::AddRecord(unsigned char* value, unsigned char value_len)
 	
 	CEIBRecord rec;
 	memcpy(rec._value,value,value_len);
-	rec._time.SetNow();
+	rec._time.SetTime(time_stamp.GetSeconds());
+	rec._time_stamp = time_stamp;
 	rec.SetValueLength(value_len);
 	_history.push_front(rec);
 }
@@ -102,6 +113,7 @@ CEIBRecord::CEIBRecord()
 
 CEIBRecord::CEIBRecord(const CEIBRecord& rhs):
 _time(rhs._time),
+_time_stamp(rhs._time_stamp),
 _value_len(rhs._value_len)
 {
 	memcpy(_value,rhs._value,_value_len);
@@ -0,0 +1,106 @@
+#include "TimeStamp.h"
+
+#ifdef WIN32
+//100ns intervals between 1601-01-01 and 1970-01-01
+#define FILETIME_UNIX_EPOCH 116444736000000000LL
+
+static int64 ReadMonotonic(bool coarse)
+{
+	if(coarse){
+		return (int64)GetTickCount64() * NSEC_PER_MSEC;
+	}
+	static LARGE_INTEGER freq = {0};
+	if(freq.QuadPart == 0){
+		QueryPerformanceFrequency(&freq);
+	}
+	LARGE_INTEGER count;
+	QueryPerformanceCounter(&count);
+	return (int64)(count.QuadPart / freq.QuadPart) * NSEC_PER_SEC +
+		   (int64)(count.QuadPart % freq.QuadPart) * NSEC_PER_SEC / freq.QuadPart;
+}
+
+static int64 ReadWall(bool coarse)
+{
+	FILETIME ft;
+	GetSystemTimeAsFileTime(&ft);
+	int64 t = ((int64)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+	return (t - FILETIME_UNIX_EPOCH) * 100;
+}
+#else
+static int64 ReadClock(clockid_t id)
+{
+	struct timespec ts;
+	clock_gettime(id, &ts);
+	return (int64)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static int64 ReadMonotonic(bool coarse)
+{
+#ifdef CLOCK_MONOTONIC_COARSE
+	if(coarse){
+		return ReadClock(CLOCK_MONOTONIC_COARSE);
+	}
+#endif
+	return ReadClock(CLOCK_MONOTONIC);
+}
+
+static int64 ReadWall(bool coarse)
+{
+#ifdef CLOCK_REALTIME_COARSE
+	if(coarse){
+		return ReadClock(CLOCK_REALTIME_COARSE);
+	}
+#endif
+	return ReadClock(CLOCK_REALTIME);
+}
+#endif
+
+CTimeStamp::CTimeStamp() :
+_mono_ns(0),
+_wall_ns(0)
+{
+}
+
+CTimeStamp::CTimeStamp(int64 mono_ns, int64 wall_ns) :
+_mono_ns(mono_ns),
+_wall_ns(wall_ns)
+{
+}
+
+CTimeStamp CTimeStamp::Now()
+{
+	return CTimeStamp(ReadMonotonic(false), ReadWall(false));
+}
+
+CTimeStamp CTimeStamp::NowCached()
+{
+	return CTimeStamp(ReadMonotonic(true), ReadWall(true));
+}
+
+CTimeStamp CTimeStamp::FromWallTime(int64 wall_ns)
+{
+	CTimeStamp now = Now();
+	int64 age = now._wall_ns - wall_ns;
+	//the wall clock may have been stepped in between
+	if(age < 0){
+		age = 0;
+	}
+	return CTimeStamp(now._mono_ns - age, wall_ns);
+}
+
+CString CTimeStamp::FormatISO8601(bool get_local) const
+{
+	CString iso = ToCTime().FormatISO8601(get_local);
+	//"2000-08-21T20:07:29" is followed by the zone
+	CString res = iso.SubString(0, 19);
+	char ms[8];
+	snprintf(ms, sizeof(ms), ".%03d", (int)(GetEpochMs() % 1000));
+	res += ms;
+	res += iso.SubString(19, iso.GetLength() - 19);
+	return res;
+}
+
+int64 CTimeStamp::ElapsedNs() const
+{
+	return ReadMonotonic(false) - _mono_ns;
+}
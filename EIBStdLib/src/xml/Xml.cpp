@@ -4,6 +4,7 @@ CXmlDocument::CXmlDocument(const char* xml_str) :
 _doc(NULL)
 {
 	_doc = new TiXmlDocument();
+	_doc->SetUseArena(true);
 	Parse(xml_str);
 }
 
@@ -11,14 +12,11 @@ CXmlDocument::CXmlDocument() :
 _doc(NULL)
 {
 	_doc = new TiXmlDocument();
-	
-	TiXmlDeclaration* decl = new TiXmlDeclaration("1.0","UTF-8","no");
-	_doc->InsertEndChild(*decl);
-	delete decl;
+	_doc->SetUseArena(true);
 
-	TiXmlElement* root_elem = new TiXmlElement(DEFAULT_XML_DOCUMENT_ROOT);
-	_doc->InsertEndChild(*root_elem);
-	delete root_elem;
+	TiXmlArenaScope scope(_doc->Arena());
+	_doc->LinkEndChild(new TiXmlDeclaration("1.0","UTF-8","no"));
+	_doc->LinkEndChild(new TiXmlElement(DEFAULT_XML_DOCUMENT_ROOT));
 }
 
 
@@ -26,6 +24,7 @@ CXmlDocument::CXmlDocument(const CString& xml_str) :
 _doc(NULL)
 {
 	_doc = new TiXmlDocument();
+	_doc->SetUseArena(true);
 	Parse(xml_str);
 }
 
@@ -125,19 +124,17 @@ CString CXmlElement::GetValue()
 
 CXmlElement CXmlElement::InsertChild(const char* elem_name)
 {
-	TiXmlNode* temp = new TiXmlElement(elem_name);
-	TiXmlElement* res = (TiXmlElement*)this->_elem->InsertEndChild(*temp);
-	delete temp;
+	//build the child right in the arena of the document instead of cloning a temporary
+	TiXmlArenaScope scope(_elem->GetArena());
 
 	CXmlElement inserted_elem;
-	inserted_elem._elem = res;
+	inserted_elem._elem = this->_elem->LinkEndChild(new TiXmlElement(elem_name));
 	return inserted_elem;
 }
 
 void CXmlElement::SetValue(const char* val)
 {
-	TiXmlText* text = new TiXmlText(val);
-	_elem->InsertEndChild(*text);
-	delete text;
+	TiXmlArenaScope scope(_elem->GetArena());
+	_elem->LinkEndChild(new TiXmlText(val));
 }
 
@@ -0,0 +1,430 @@
+#include "xml/XmlReader.h"
+
+CXmlReader::CXmlReader()
+{
+	Reset();
+}
+
+CXmlReader::CXmlReader(const char* data, int length)
+{
+	Reset();
+	_src = data;
+	_src_length = length;
+}
+
+CXmlReader::~CXmlReader()
+{
+}
+
+void CXmlReader::Reset()
+{
+	_buf.clear();
+	_pos = 0;
+	_offset = 0;
+	_src = NULL;
+	_src_length = 0;
+	_src_pos = 0;
+	_finished = false;
+	_encoding = TIXML_ENCODING_UTF8;
+	_state = XML_READ_NONE;
+	_seen_root = false;
+	_pending_end = false;
+	_empty_element = false;
+	_depth = 0;
+	_open.clear();
+	_name = "";
+	_text = "";
+	_attributes.clear();
+	_error = "";
+}
+
+void CXmlReader::Feed(const char* data, int length)
+{
+	//drop what was read already, so the buffer only holds the construct in progress
+	if(_pos > 0){
+		_buf.erase(0, _pos);
+		_offset += _pos;
+		_pos = 0;
+	}
+	_buf.append(data, length);
+}
+
+void CXmlReader::Finish()
+{
+	_finished = true;
+}
+
+bool CXmlReader::FillFromSource()
+{
+	if(_src == NULL || _finished){
+		return false;
+	}
+	if(_src_pos == _src_length){
+		_finished = true;
+		return true;
+	}
+	int len = _src_length - _src_pos;
+	if(len > XML_READER_CHUNK_SIZE){
+		len = XML_READER_CHUNK_SIZE;
+	}
+	Feed(_src + _src_pos, len);
+	_src_pos += len;
+	return true;
+}
+
+XmlReadResult CXmlReader::Read()
+{
+	if(_state == XML_READ_END || _state == XML_READ_ERROR){
+		return _state;
+	}
+	if(_pending_end){
+		_pending_end = false;
+		_open.pop_back();
+		_state = XML_READ_END_ELEMENT;
+		return _state;
+	}
+
+	XmlReadResult res;
+	do
+	{
+		res = ReadToken();
+	}while(res == XML_READ_NONE || (res == XML_READ_MORE_DATA && FillFromSource()));
+
+	_state = res;
+	return res;
+}
+
+XmlReadResult CXmlReader::Dispatch(CXmlReaderHandler& handler)
+{
+	for(;;)
+	{
+		XmlReadResult res = Read();
+		switch(res)
+		{
+		case XML_READ_START_ELEMENT:
+			handler.OnStartElement(*this);
+			break;
+		case XML_READ_END_ELEMENT:
+			handler.OnEndElement(*this);
+			break;
+		case XML_READ_TEXT:
+			handler.OnText(*this);
+			break;
+		default:
+			return res;
+		}
+	}
+}
+
+const char* CXmlReader::GetAttribute(const char* name) const
+{
+	for(size_t i = 0; i < _attributes.size(); ++i){
+		if(_attributes[i].first == name){
+			return _attributes[i].second.c_str();
+		}
+	}
+	return NULL;
+}
+
+XmlReadResult CXmlReader::ReadToken()
+{
+	const char* p = _buf.c_str() + _pos;
+	const char* end = _buf.c_str() + _buf.length();
+
+	if(p == end){
+		if(!_finished){
+			return XML_READ_MORE_DATA;
+		}
+		if(!_open.empty()){
+			return SetError("The document ends inside an element", p);
+		}
+		if(!_seen_root){
+			return SetError("The document has no root element", p);
+		}
+		return XML_READ_END;
+	}
+	if(*p == '<'){
+		return ReadMarkup(p, end);
+	}
+	if(_open.empty()){
+		return ReadOutsideRoot(p, end);
+	}
+	return ReadCharacters(p, end);
+}
+
+XmlReadResult CXmlReader::ReadOutsideRoot(const char* p, const char* end)
+{
+	//UTF-8 byte order mark: ef bb bf
+	if(_offset + _pos == 0 && (unsigned char)*p == 0xefU){
+		if(end - p < 3){
+			return _finished ? SetError("Invalid character", p) : XML_READ_MORE_DATA;
+		}
+		if((unsigned char)p[1] == 0xbbU && (unsigned char)p[2] == 0xbfU){
+			Consume(p + 3);
+			return XML_READ_NONE;
+		}
+	}
+
+	const char* q = p;
+	while(q < end && TiXmlBase::IsWhiteSpace(*q)){
+		++q;
+	}
+	if(q < end && *q != '<'){
+		//like TiXmlDocument, stop at anything after the root element that is not markup
+		if(_seen_root){
+			Consume(end);
+			return XML_READ_END;
+		}
+		return SetError("Text outside of the root element", q);
+	}
+	Consume(q);
+	return XML_READ_NONE;
+}
+
+XmlReadResult CXmlReader::ReadCharacters(const char* p, const char* end)
+{
+	if(memchr(p, '<', end - p) == NULL){
+		return _finished ? SetError("The document ends inside an element", p) : XML_READ_MORE_DATA;
+	}
+
+	const char* q = TiXmlBase::ReadText(p, &_text, true, "<", false, _encoding);
+	if(q == NULL){
+		return SetError("Invalid character", p);
+	}
+	//leave the '<' for the next token
+	Consume(q - 1);
+	if(IsBlank(_text.c_str(), _text.c_str() + _text.length())){
+		return XML_READ_NONE;
+	}
+	_depth = (int)_open.size();
+	return XML_READ_TEXT;
+}
+
+XmlReadResult CXmlReader::ReadMarkup(const char* p, const char* end)
+{
+	static const char* comment = "<!--";
+	static const char* cdata = "<![CDATA[";
+
+	size_t avail = end - p;
+	//too short to tell a comment or CDATA from a DOCTYPE yet
+	if(avail < 2 ||
+	   (p[1] == '!' && ((avail < strlen(comment) && memcmp(p, comment, avail) == 0) ||
+						(avail < strlen(cdata) && memcmp(p, cdata, avail) == 0))))
+	{
+		return _finished ? SetError("The document ends inside a tag", p) : XML_READ_MORE_DATA;
+	}
+
+	const char* q;
+	if(p[1] == '?'){
+		q = Find(p + 2, end, "?>");
+		if(q == NULL){
+			return _finished ? SetError("The document ends inside a declaration", p) : XML_READ_MORE_DATA;
+		}
+		if(TiXmlBase::StringEqual(p, "<?xml", true, _encoding)){
+			ReadDeclaration(p, q);
+		}
+		Consume(q + 2);
+		return XML_READ_NONE;
+	}
+	if(TiXmlBase::StringEqual(p, comment, false, _encoding)){
+		q = Find(p + strlen(comment), end, "-->");
+		if(q == NULL){
+			return _finished ? SetError("The document ends inside a comment", p) : XML_READ_MORE_DATA;
+		}
+		Consume(q + 3);
+		return XML_READ_NONE;
+	}
+	if(TiXmlBase::StringEqual(p, cdata, false, _encoding)){
+		q = Find(p + strlen(cdata), end, "]]>");
+		if(q == NULL){
+			return _finished ? SetError("The document ends inside CDATA", p) : XML_READ_MORE_DATA;
+		}
+		if(_open.empty()){
+			return SetError("CDATA outside of the root element", p);
+		}
+		p += strlen(cdata);
+		_text.assign(p, q - p);
+		Consume(q + 3);
+		if(IsBlank(p, q)){
+			return XML_READ_NONE;
+		}
+		_depth = (int)_open.size();
+		return XML_READ_TEXT;
+	}
+	if(p[1] == '!'){
+		//DOCTYPE and the like are skipped, as TiXmlUnknown keeps them
+		q = (const char*)memchr(p, '>', avail);
+		if(q == NULL){
+			return _finished ? SetError("The document ends inside a tag", p) : XML_READ_MORE_DATA;
+		}
+		Consume(q + 1);
+		return XML_READ_NONE;
+	}
+
+	if(p[1] == '/'){
+		q = (const char*)memchr(p, '>', avail);
+	}
+	else{
+		q = FindTagEnd(p, end);
+	}
+	if(q == NULL){
+		return _finished ? SetError("The document ends inside a tag", p) : XML_READ_MORE_DATA;
+	}
+	return p[1] == '/' ? ReadEndTag(p, q) : ReadStartTag(p, q);
+}
+
+XmlReadResult CXmlReader::ReadStartTag(const char* p, const char* tag_end)
+{
+	_empty_element = false;
+	_attributes.clear();
+
+	const char* q = TiXmlBase::ReadName(p + 1, &_name, _encoding);
+	if(q == NULL || _name.empty()){
+		return SetError("Error reading element name", p);
+	}
+
+	for(;;)
+	{
+		q = TiXmlBase::SkipWhiteSpace(q, _encoding);
+		if(q == tag_end){
+			break;
+		}
+		if(*q == '/' && q + 1 == tag_end){
+			_empty_element = true;
+			break;
+		}
+
+		std::pair<TIXML_STRING, TIXML_STRING> attr;
+		q = TiXmlBase::ReadName(q, &attr.first, _encoding);
+		if(q == NULL || attr.first.empty()){
+			return SetError("Error reading attributes", p);
+		}
+		q = TiXmlBase::SkipWhiteSpace(q, _encoding);
+		if(*q != '='){
+			return SetError("Error reading attributes", q);
+		}
+		q = TiXmlBase::SkipWhiteSpace(q + 1, _encoding);
+		if(*q == '\"' || *q == '\''){
+			char quote[2] = { *q, 0 };
+			q = TiXmlBase::ReadText(q + 1, &attr.second, false, quote, false, _encoding);
+			if(q == NULL || q > tag_end){
+				return SetError("Error reading attributes", p);
+			}
+		}
+		else{
+			//unquoted values are accepted, as TiXmlAttribute does
+			const char* value = q;
+			while(q < tag_end && !TiXmlBase::IsWhiteSpace(*q) && *q != '/'){
+				++q;
+			}
+			if(q == value){
+				return SetError("Error reading attributes", q);
+			}
+			attr.second.assign(value, q - value);
+		}
+		_attributes.push_back(attr);
+	}
+
+	_seen_root = true;
+	_open.push_back(_name);
+	_depth = (int)_open.size();
+	_pending_end = _empty_element;
+	Consume(tag_end + 1);
+	return XML_READ_START_ELEMENT;
+}
+
+XmlReadResult CXmlReader::ReadEndTag(const char* p, const char* tag_end)
+{
+	_empty_element = false;
+	_attributes.clear();
+
+	const char* q = TiXmlBase::ReadName(p + 2, &_name, _encoding);
+	if(q == NULL || TiXmlBase::SkipWhiteSpace(q, _encoding) != tag_end){
+		return SetError("Error reading end tag", p);
+	}
+	if(_open.empty() || !(_open.back() == _name)){
+		return SetError("Unexpected end tag", p);
+	}
+	_depth = (int)_open.size();
+	_open.pop_back();
+	Consume(tag_end + 1);
+	return XML_READ_END_ELEMENT;
+}
+
+void CXmlReader::ReadDeclaration(const char* p, const char* end)
+{
+	//the encoding is legacy when it is given and is not UTF-8, as in TiXmlDocument
+	const char* q = Find(p, end, "encoding");
+	if(q == NULL){
+		return;
+	}
+	q = TiXmlBase::SkipWhiteSpace(q + strlen("encoding"), _encoding);
+	if(q >= end || *q != '='){
+		return;
+	}
+	q = TiXmlBase::SkipWhiteSpace(q + 1, _encoding);
+	if(q >= end || (*q != '\"' && *q != '\'')){
+		return;
+	}
+	++q;
+	if(!TiXmlBase::StringEqual(q, "UTF-8", true, TIXML_ENCODING_UNKNOWN) &&
+	   !TiXmlBase::StringEqual(q, "UTF8", true, TIXML_ENCODING_UNKNOWN))
+	{
+		_encoding = TIXML_ENCODING_LEGACY;
+	}
+}
+
+XmlReadResult CXmlReader::SetError(const char* msg, const char* p)
+{
+	char err[128];
+	snprintf(err, sizeof(err), "%s at offset %lu", msg, (unsigned long)(_offset + (p - _buf.c_str())));
+	_error = err;
+	_state = XML_READ_ERROR;
+	return XML_READ_ERROR;
+}
+
+const char* CXmlReader::Find(const char* p, const char* end, const char* token)
+{
+	size_t len = strlen(token);
+	while((size_t)(end - p) >= len){
+		p = (const char*)memchr(p, token[0], end - p - len + 1);
+		if(p == NULL){
+			return NULL;
+		}
+		if(memcmp(p, token, len) == 0){
+			return p;
+		}
+		++p;
+	}
+	return NULL;
+}
+
+const char* CXmlReader::FindTagEnd(const char* p, const char* end)
+{
+	//a '>' inside a quoted attribute value does not end the tag
+	char quote = 0;
+	for(++p; p < end; ++p){
+		if(quote){
+			if(*p == quote){
+				quote = 0;
+			}
+		}
+		else if(*p == '\"' || *p == '\''){
+			quote = *p;
+		}
+		else if(*p == '>'){
+			return p;
+		}
+	}
+	return NULL;
+}
+
+bool CXmlReader::IsBlank(const char* p, const char* end)
+{
+	for(; p < end; ++p){
+		if(!TiXmlBase::IsWhiteSpace(*p)){
+			return false;
+		}
+	}
+	return true;
+}
@@ -80,7 +80,7 @@ void action_store::v_add (int i_1, int i_2, int i_3, const char * cp_string)
 }
 
 /// Get one element from the placeholder
-void action_store::v_get (int i_entry, int & i_1, int & i_2, int & i_3, TIXML_STRING & S_out)
+void action_store::v_get (int i_entry, int & i_1, int & i_2, int & i_3, TIXML_STRING & S_out) const
 {
    assert (i_entry >= 0 && i_entry < i_size);
    assert (aipp_list [i_entry]);
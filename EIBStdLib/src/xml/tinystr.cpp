@@ -29,22 +29,69 @@ distribution.
 
 #ifndef TIXML_USE_STL
 
-#include "xml/tinystr.h"
+#include "xml/tinyxml.h"
 
 // Error value for find primitive
 const TiXmlString::size_type TiXmlString::npos = static_cast< TiXmlString::size_type >(-1);
 
 
 // Null rep.
-TiXmlString::Rep TiXmlString::nullrep_ = { 0, 0, { '\0' } };
+TiXmlString::Rep TiXmlString::nullrep_ = { 0, 0, 0, { '\0' } };
+
+
+TiXmlArena* TiXmlString::current_arena()
+{
+	return TiXmlArena::Current();
+}
+
+
+TiXmlString::Rep* TiXmlString::allocate(size_type cap, TiXmlArena* arena)
+{
+	const size_type bytesNeeded = sizeof(Rep) + cap;
+	Rep* rep;
+	if (arena)
+	{
+		rep = static_cast<Rep*>( arena->Alloc(bytesNeeded) );
+	}
+	else
+	{
+		// Lee: the original form:
+		//	rep_ = static_cast<Rep*>(operator new(sizeof(Rep) + cap));
+		// doesn't work in some cases of new being overloaded. Switching
+		// to the normal allocation, although use an 'int' for systems
+		// that are overly picky about structure alignment.
+		const size_type intsNeeded = ( bytesNeeded + sizeof(int) - 1 ) / sizeof( int );
+		rep = reinterpret_cast<Rep*>( new int[ intsNeeded ] );
+	}
+	rep->arena = arena;
+	return rep;
+}
+
+
+void TiXmlString::release(Rep* rep)
+{
+	// A temporary that is dropped right away is given back to the arena
+	rep->arena->Free(rep, sizeof(Rep) + rep->capacity);
+}
+
+
+bool TiXmlString::grow(size_type cap)
+{
+	if (rep_->arena && rep_->arena->Grow(rep_, sizeof(Rep) + rep_->capacity, sizeof(Rep) + cap))
+	{
+		rep_->capacity = cap;
+		return true;
+	}
+	return false;
+}
 
 
 void TiXmlString::reserve (size_type cap)
 {
-	if (cap > capacity())
+	if (cap > capacity() && !grow(cap))
 	{
 		TiXmlString tmp;
-		tmp.init(length(), cap);
+		tmp.init(length(), cap, arena());
 		memcpy(tmp.start(), data(), length());
 		swap(tmp);
 	}
@@ -54,10 +101,14 @@ void TiXmlString::reserve (size_type cap)
 TiXmlString& TiXmlString::assign(const char* str, size_type len)
 {
 	size_type cap = capacity();
+	if (len > cap && grow(len))
+	{
+		cap = len;
+	}
 	if (len > cap || cap > 3*(len + 8))
 	{
 		TiXmlString tmp;
-		tmp.init(len);
+		tmp.init(len, len, arena());
 		memcpy(tmp.start(), str, len);
 		swap(tmp);
 	}
@@ -34,6 +34,177 @@ distribution.
 
 bool TiXmlBase::condenseWhiteSpace = true;
 
+// The arena of the innermost TiXmlArenaScope of each thread
+static thread_local TiXmlArena* currentArena = 0;
+
+// Every allocation of the arena and of TiXmlBase::operator new is aligned to this
+union TiXmlAllocHeader
+{
+	TiXmlArena* arena;	// null for objects on the heap
+	double		alignDouble;
+	long long	alignLong;
+};
+
+static size_t AlignSize( size_t size )
+{
+	return ( size + sizeof( TiXmlAllocHeader ) - 1 ) & ~( sizeof( TiXmlAllocHeader ) - 1 );
+}
+
+
+TiXmlArena::TiXmlArena() :
+	blocks( 0 ),
+	nextBlockSize( MIN_BLOCK_SIZE ),
+	bytesUsed( 0 ),
+	bytesReserved( 0 ),
+	blockCount( 0 )
+{
+}
+
+
+TiXmlArena::~TiXmlArena()
+{
+	while ( blocks )
+	{
+		Block* next = blocks->next;
+		::operator delete( blocks );
+		blocks = next;
+	}
+}
+
+
+TiXmlArena* TiXmlArena::Current()
+{
+	return currentArena;
+}
+
+
+void TiXmlArena::SetCurrent( TiXmlArena* arena )
+{
+	currentArena = arena;
+}
+
+
+TiXmlArena::Block* TiXmlArena::NewBlock( size_t size )
+{
+	Block* block = static_cast< Block* >( ::operator new( AlignSize( sizeof( Block ) ) + size ) );
+	block->next = 0;
+	block->size = AlignSize( sizeof( Block ) ) + size;
+	block->used = AlignSize( sizeof( Block ) );
+	bytesReserved += block->size;
+	++blockCount;
+	return block;
+}
+
+
+void* TiXmlArena::Alloc( size_t size )
+{
+	size = AlignSize( size ? size : 1 );
+	bytesUsed += size;
+
+	if ( !blocks || blocks->size - blocks->used < size )
+	{
+		if ( size > nextBlockSize / 4 )
+		{
+			// A large string gets a block of its own, linked behind the block
+			// in use so the space left there is not lost.
+			Block* block = NewBlock( size );
+			char* p = reinterpret_cast< char* >( block ) + block->used;
+			block->used = block->size;
+			if ( blocks )
+			{
+				block->next = blocks->next;
+				blocks->next = block;
+			}
+			else
+			{
+				blocks = block;
+			}
+			return p;
+		}
+		// Each block is twice the size of the previous one, so a large
+		// document needs only a few of them.
+		Block* block = NewBlock( nextBlockSize );
+		block->next = blocks;
+		blocks = block;
+		if ( nextBlockSize < MAX_BLOCK_SIZE )
+			nextBlockSize *= 2;
+	}
+
+	char* p = reinterpret_cast< char* >( blocks ) + blocks->used;
+	blocks->used += size;
+	return p;
+}
+
+
+bool TiXmlArena::Grow( void* p, size_t size, size_t newSize )
+{
+	size = AlignSize( size ? size : 1 );
+	newSize = AlignSize( newSize );
+	if ( !blocks || static_cast< char* >( p ) + size != reinterpret_cast< char* >( blocks ) + blocks->used )
+		return false;
+	if ( newSize > size && blocks->size - blocks->used < newSize - size )
+		return false;
+	blocks->used = blocks->used + newSize - size;
+	bytesUsed = bytesUsed + newSize - size;
+	return true;
+}
+
+
+void TiXmlArena::Free( void* p, size_t size )
+{
+	size = AlignSize( size ? size : 1 );
+	if ( blocks && static_cast< char* >( p ) + size == reinterpret_cast< char* >( blocks ) + blocks->used )
+	{
+		blocks->used -= size;
+		bytesUsed -= size;
+	}
+}
+
+
+void TiXmlArena::Reset()
+{
+	if ( !blocks )
+		return;
+	Block* keep = blocks;
+	blocks = blocks->next;
+	while ( blocks )
+	{
+		Block* next = blocks->next;
+		::operator delete( blocks );
+		blocks = next;
+	}
+	keep->next = 0;
+	keep->used = AlignSize( sizeof( Block ) );
+	blocks = keep;
+	bytesUsed = 0;
+	bytesReserved = keep->size;
+	blockCount = 1;
+}
+
+
+void* TiXmlBase::operator new( size_t size )
+{
+	TiXmlArena* arena = currentArena;
+	TiXmlAllocHeader* header;
+	if ( arena )
+		header = static_cast< TiXmlAllocHeader* >( arena->Alloc( sizeof( TiXmlAllocHeader ) + size ) );
+	else
+		header = static_cast< TiXmlAllocHeader* >( ::operator new( sizeof( TiXmlAllocHeader ) + size ) );
+	header->arena = arena;
+	return header + 1;
+}
+
+
+void TiXmlBase::operator delete( void* p )
+{
+	if ( !p )
+		return;
+	TiXmlAllocHeader* header = static_cast< TiXmlAllocHeader* >( p ) - 1;
+	// Memory of the arena is released with the arena
+	if ( !header->arena )
+		::operator delete( header );
+}
+
 // Microsoft compiler security
 FILE* TiXmlFOpen( const char* filename, const char* mode )
 {
@@ -164,6 +335,20 @@ void TiXmlNode::CopyTo( TiXmlNode* target ) const
 }
 
 
+TiXmlArena* TiXmlNode::GetArena() const
+{
+	const TiXmlDocument* doc = GetDocument();
+	return doc ? doc->Arena() : 0;
+}
+
+
+TiXmlNode* TiXmlNode::CloneChild( const TiXmlNode& node ) const
+{
+	TiXmlArenaScope scope( GetArena() );
+	return node.Clone();
+}
+
+
 void TiXmlNode::Clear()
 {
 	TiXmlNode* node = firstChild;
@@ -215,7 +400,7 @@ TiXmlNode* TiXmlNode::InsertEndChild( const TiXmlNode& addThis )
 		if ( GetDocument() ) GetDocument()->SetError( TIXML_ERROR_DOCUMENT_TOP_ONLY, 0, 0, TIXML_ENCODING_UNKNOWN );
 		return 0;
 	}
-	TiXmlNode* node = addThis.Clone();
+	TiXmlNode* node = CloneChild( addThis );
 	if ( !node )
 		return 0;
 
@@ -234,7 +419,7 @@ TiXmlNode* TiXmlNode::InsertBeforeChild( TiXmlNode* beforeThis, const TiXmlNode&
 		return 0;
 	}
 
-	TiXmlNode* node = addThis.Clone();
+	TiXmlNode* node = CloneChild( addThis );
 	if ( !node )
 		return 0;
 	node->parent = this;
@@ -266,7 +451,7 @@ TiXmlNode* TiXmlNode::InsertAfterChild( TiXmlNode* afterThis, const TiXmlNode& a
 		return 0;
 	}
 
-	TiXmlNode* node = addThis.Clone();
+	TiXmlNode* node = CloneChild( addThis );
 	if ( !node )
 		return 0;
 	node->parent = this;
@@ -292,7 +477,7 @@ TiXmlNode* TiXmlNode::ReplaceChild( TiXmlNode* replaceThis, const TiXmlNode& wit
 	if ( replaceThis->parent != this )
 		return 0;
 
-	TiXmlNode* node = withThis.Clone();
+	TiXmlNode* node = CloneChild( withThis );
 	if ( !node )
 		return 0;
 
@@ -881,14 +1066,14 @@ const char* TiXmlElement::GetText() const
 }
 
 
-TiXmlDocument::TiXmlDocument() : TiXmlNode( TiXmlNode::DOCUMENT )
+TiXmlDocument::TiXmlDocument() : TiXmlNode( TiXmlNode::DOCUMENT ), arena( 0 )
 {
 	tabsize = 4;
 	useMicrosoftBOM = false;
 	ClearError();
 }
 
-TiXmlDocument::TiXmlDocument( const char * documentName ) : TiXmlNode( TiXmlNode::DOCUMENT )
+TiXmlDocument::TiXmlDocument( const char * documentName ) : TiXmlNode( TiXmlNode::DOCUMENT ), arena( 0 )
 {
 	tabsize = 4;
 	useMicrosoftBOM = false;
@@ -898,7 +1083,7 @@ TiXmlDocument::TiXmlDocument( const char * documentName ) : TiXmlNode( TiXmlNode
 
 
 #ifdef TIXML_USE_STL
-TiXmlDocument::TiXmlDocument( const std::string& documentName ) : TiXmlNode( TiXmlNode::DOCUMENT )
+TiXmlDocument::TiXmlDocument( const std::string& documentName ) : TiXmlNode( TiXmlNode::DOCUMENT ), arena( 0 )
 {
 	tabsize = 4;
 	useMicrosoftBOM = false;
@@ -908,7 +1093,7 @@ TiXmlDocument::TiXmlDocument( const std::string& documentName ) : TiXmlNode( TiX
 #endif
 
 
-TiXmlDocument::TiXmlDocument( const TiXmlDocument& copy ) : TiXmlNode( TiXmlNode::DOCUMENT )
+TiXmlDocument::TiXmlDocument( const TiXmlDocument& copy ) : TiXmlNode( TiXmlNode::DOCUMENT ), arena( 0 )
 {
 	copy.CopyTo( this );
 }
@@ -917,10 +1102,37 @@ TiXmlDocument::TiXmlDocument( const TiXmlDocument& copy ) : TiXmlNode( TiXmlNode
 void TiXmlDocument::operator=( const TiXmlDocument& copy )
 {
 	Clear();
+	if ( arena )
+		arena->Reset();
 	copy.CopyTo( this );
 }
 
 
+TiXmlDocument::~TiXmlDocument()
+{
+	// The children may live in the arena, delete them while it is still there
+	Clear();
+	delete arena;
+}
+
+
+void TiXmlDocument::SetUseArena( bool use )
+{
+	if ( use == ( arena != 0 ) )
+		return;
+	Clear();
+	if ( use )
+	{
+		arena = new TiXmlArena();
+	}
+	else
+	{
+		delete arena;
+		arena = 0;
+	}
+}
+
+
 bool TiXmlDocument::LoadFile( TiXmlEncoding encoding )
 {
 	// See STL_STRING_BUG below.
@@ -980,6 +1192,8 @@ bool TiXmlDocument::LoadFile( FILE* file, TiXmlEncoding encoding )
 
 	// Delete the existing data:
 	Clear();
+	if ( arena )
+		arena->Reset();
 	location.Clear();
 
 	// Get the file size, so we can pre-allocate the string. HUGE speed impact.
@@ -1126,11 +1340,12 @@ void TiXmlDocument::CopyTo( TiXmlDocument* target ) const
 	target->tabsize = tabsize;
 	target->errorLocation = errorLocation;
 	target->useMicrosoftBOM = useMicrosoftBOM;
+	target->SetUseArena( arena != 0 );
 
 	TiXmlNode* node = 0;
 	for ( node = firstChild; node; node = node->NextSibling() )
 	{
-		target->LinkEndChild( node->Clone() );
+		target->LinkEndChild( target->CloneChild( *node ) );
 	}	
 }
 
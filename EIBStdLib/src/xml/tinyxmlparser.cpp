@@ -705,6 +705,9 @@ const char* TiXmlDocument::Parse( const char* p, TiXmlParsingData* prevData, TiX
 {
 	ClearError();
 
+	// Everything created while parsing goes to the arena of the document (or the heap)
+	TiXmlArenaScope scope( arena );
+
 	// Parse away, at the document level. Since a document
 	// contains nothing but other tags, most of what happens
 	// here is skipping white space.
@@ -804,7 +807,12 @@ void TiXmlDocument::SetError( int err, const char* pError, TiXmlParsingData* dat
 	assert( err > 0 && err < TIXML_ERROR_STRING_COUNT );
 	error   = true;
 	errorId = err;
-	errorDesc = errorString[ errorId ];
+	{
+		// The document keeps its own strings on the heap, so that Reset() of the arena
+		// never leaves them dangling
+		TiXmlArenaScope heap( 0 );
+		errorDesc = errorString[ errorId ];
+	}
 
 	errorLocation.Clear();
 	if ( pError && data )
@@ -1081,10 +1089,6 @@ const char* TiXmlElement::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 		return 0;
 	}
 
-    TIXML_STRING endTag ("</");
-	endTag += value;
-	endTag += ">";
-
 	// Check for and read attributes. Also look for an empty
 	// tag or an end tag.
 	while ( p && *p )
@@ -1121,10 +1125,13 @@ const char* TiXmlElement::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 				return 0;
 			}
 
-			// We should find the end tag now
-			if ( StringEqual( p, endTag.c_str(), false, encoding ) )
+			// We should find the end tag "</value>" now. It is matched in place
+			// rather than built as a string that lives as long as the children.
+			if (    p[0] == '<' && p[1] == '/'
+				 && strncmp( p + 2, value.c_str(), value.length() ) == 0
+				 && p[ 2 + value.length() ] == '>' )
 			{
-				p += endTag.length();
+				p += value.length() + 3;
 				return p;
 			}
 			else
@@ -45,9 +45,24 @@ using namespace TinyXPath;
 xpath_processor::xpath_processor (
    const TiXmlNode * XNp_source_tree,  ///< Source XML tree
    const char * cp_xpath_expr)         ///< XPath expression
-      : xpath_stream (cp_xpath_expr)
 {
-   if (XNp_source_tree && cp_xpath_expr)
+   if (cp_xpath_expr)
+      xpp_program = xpath_program_cache::xpc_get_global () . xpp_get (cp_xpath_expr);
+   v_init (XNp_source_tree);
+}
+
+/// xpath_processor constructor
+xpath_processor::xpath_processor (
+   const TiXmlNode * XNp_source_tree,           ///< Source XML tree
+   const xpath_program_ptr & xpp_in_program)    ///< Compiled XPath expression
+      : xpp_program (xpp_in_program)
+{
+   v_init (XNp_source_tree);
+}
+
+void xpath_processor::v_init (const TiXmlNode * XNp_source_tree)
+{
+   if (XNp_source_tree && xpp_program)
       XNp_base = XNp_source_tree;
    else
       XNp_base = NULL;
@@ -56,6 +71,7 @@ xpath_processor::xpath_processor (
    XEp_context = NULL;
    o_is_context_by_name = false;
    XNp_base_parent = NULL;
+   i_action_position = 0;
 }
 
 /// Compute an XPath expression, and return the number of nodes in the resulting node set.
@@ -135,6 +151,9 @@ expression_result xpath_processor::er_compute_xpath ()
 {
    try
    {
+      if (! XNp_base)
+         // no correct initialization of the xpath_processor object
+         throw execution_error (1);
       XNp_base_parent = XNp_base -> Parent ();
       if (! XNp_base_parent)
          // no correct initialization of the xpath_processor object
@@ -143,8 +162,11 @@ expression_result xpath_processor::er_compute_xpath ()
       if (XNp_base -> ToElement ())
          XEp_context = XNp_base -> ToElement ();
 
-      // Decode XPath expression
-      v_evaluate ();
+      // The XPath expression was decoded when its program was compiled
+      if (xpp_program -> e_error == xpath_program::e_error_syntax)
+         throw syntax_error ();
+      if (xpp_program -> e_error == xpath_program::e_error_overflow)
+         throw syntax_overflow ();
 
       // Compute result
       v_execute_stack ();
@@ -227,30 +249,10 @@ double xpath_processor::d_compute_xpath ()
    return d_res;
 }
 
-/// Callback from the XPath decoder : a rule has to be applied
-void xpath_processor::v_action (
-	xpath_construct xc_rule,      ///< XPath Rule 
-	unsigned u_sub,               ///< Rule sub number
-	unsigned u_variable,          ///< Parameter, depends on the rule
-	const char * cp_literal)      ///< Input literal, depends on the rule
-{
-   as_action_store . v_add (xc_rule, u_sub, u_variable, cp_literal);
-   #ifdef TINYXPATH_DEBUG
-      printf ("Action %2d : %s (%d,%d,%s)\n", as_action_store . i_get_size () - 1, cp_disp_construct (xc_rule), u_sub, u_variable, cp_literal);
-   #endif
-}
-
-/// Internal use. Retrieves the current action counter
-int xpath_processor::i_get_action_counter ()
-{
-   // callback for current stack position
-   return as_action_store . i_get_size ();
-}
-
-/// Internal use. Executes the XPath expression. The executions starts at the end of the as_action_store list
+/// Internal use. Executes the XPath expression. The executions starts at the end of the program
 void xpath_processor::v_execute_stack () 
 {
-   as_action_store . v_set_position (as_action_store . i_get_size () - 1);
+   i_action_position = xpp_program -> i_get_nb_action () - 1;
    v_execute_one (xpath_expr, false);
 }
 
@@ -263,11 +265,11 @@ void xpath_processor::v_pop_one_action (
 {
    int i_1, i_2, i_3;
 
-   as_action_store . v_get (as_action_store . i_get_position (), i_1, i_2, i_3, S_literal);
+   v_get_action (i_action_position, i_1, i_2, i_3, S_literal);
    xc_action = (xpath_construct) i_1;
    u_sub = i_2;
    u_ref = i_3;
-   as_action_store . v_dec_position ();
+   i_action_position--;
 }
 
 /// Executes one XPath rule
@@ -1005,12 +1007,12 @@ void xpath_processor::v_execute_absolute_path (
       TIXML_STRING S_lit;
 
       // compute position of the first (absolute) step
-      i_current = as_action_store . i_get_position ();
+      i_current = i_action_position;
       if (o_everywhere)
          i_relative = i_current - 2;
       else
          i_relative = i_current - 1;
-      as_action_store . v_get (i_relative, i_1, i_2, i_3, S_lit);
+      v_get_action (i_relative, i_1, i_2, i_3, S_lit);
       if (i_1 == xpath_relative_location_path)
       {
          o_do_last = true;
@@ -1022,8 +1024,7 @@ void xpath_processor::v_execute_absolute_path (
          i_first = i_relative;
       }
       // i_first = i_3 - 1;
-      as_action_store . i_get_position ();
-      as_action_store . v_set_position (i_first);
+      i_action_position = i_first;
       if (o_everywhere)
          i_relative_action = -1;
       else
@@ -1034,12 +1035,12 @@ void xpath_processor::v_execute_absolute_path (
       do
       {
          i_relative--;
-         as_action_store . v_get (i_relative, i_1, i_2, i_3, S_lit);
+         v_get_action (i_relative, i_1, i_2, i_3, S_lit);
          if (i_1 != xpath_relative_location_path)
             o_end = true;
          else
          {
-            as_action_store . v_set_position (i_3 - 1);
+            i_action_position = i_3 - 1;
             v_execute_step (i_relative_action, false);
          }
       } while (! o_end);
@@ -1048,11 +1049,11 @@ void xpath_processor::v_execute_absolute_path (
       {
          // apply last one
 
-         as_action_store . v_set_position (i_relative);
+         i_action_position = i_relative;
          v_execute_step (i_relative_action, false);
       }
       // resume the execution after the whole path construction
-      as_action_store . v_set_position ((int) u_end_action - 1);
+      i_action_position = (int) u_end_action - 1;
    }
 }
 
@@ -1104,22 +1105,22 @@ void xpath_processor ::v_execute_step (
    v_pop_one_action (xc_action, u_sub, u_variable, S_literal);
 
    // Skip the predicates
-   i_pred_store = as_action_store . i_get_position ();
+   i_pred_store = i_action_position;
    for (u_pred = 0; u_pred < u_variable; u_pred++)
       v_execute_one (xpath_predicate, true);
-   i_node_store = as_action_store . i_get_position ();
+   i_node_store = i_action_position;
 
    // Skip the node test
    v_execute_one (xpath_node_test, true);
 
    // Run the axis
    v_execute_one (xpath_axis_specifier, o_skip_only);
-   i_end_store = as_action_store . i_get_position ();
+   i_end_store = i_action_position;
 
    // Run the node test
-   as_action_store . v_set_position (i_node_store);
+   i_action_position = i_node_store;
    v_execute_one (xpath_node_test, o_skip_only);
-   as_action_store . v_set_position (i_pred_store);
+   i_action_position = i_pred_store;
 
    if (! o_skip_only)
    {
@@ -1283,7 +1284,7 @@ void xpath_processor ::v_execute_step (
                XEp_elem = ns_target . XNp_get_node_in_set (u_node) -> ToElement ();
                if (XEp_elem)
                {
-                  as_action_store . v_set_position (i_pred_store);
+                  i_action_position = i_pred_store;
                   if (o_check_predicate (XEp_elem, o_by_name))
                      ns_after_predicate . v_add_node_in_set (XEp_elem);
                }
@@ -1294,7 +1295,7 @@ void xpath_processor ::v_execute_step (
       else
          v_push_node_set (& ns_target);
    }
-   as_action_store . v_set_position (i_end_store);
+   i_action_position = i_end_store;
 }
 
 /// Spec extract :
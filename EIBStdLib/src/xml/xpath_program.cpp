@@ -0,0 +1,161 @@
+/**
+   \file xpath_program.cpp
+   Compiled XPath expressions for the TinyXPath project
+*/
+
+#include "xml/xpath_program.h"
+
+namespace TinyXPath
+{
+
+/// xpath_program constructor : the lexical and syntax decoding of the expression
+xpath_program::xpath_program (const char * cp_xpath_expr)
+   : xpath_stream (cp_xpath_expr), S_expression (cp_xpath_expr)
+{
+   e_error = e_no_error;
+   try
+   {
+      v_evaluate ();
+   }
+   catch (syntax_error)
+   {
+      e_error = e_error_syntax;
+   }
+   catch (syntax_overflow)
+   {
+      e_error = e_error_overflow;
+   }
+   i_nb_action = as_action_store . i_get_size ();
+}
+
+xpath_program_ptr xpath_program::xpp_compile (const char * cp_xpath_expr)
+{
+   return xpath_program_ptr (new xpath_program (cp_xpath_expr));
+}
+
+/// Callback from the XPath decoder : a rule has to be applied
+void xpath_program::v_action (
+	xpath_construct xc_rule,      ///< XPath Rule
+	unsigned u_sub,               ///< Rule sub number
+	unsigned u_variable,          ///< Parameter, depends on the rule
+	const char * cp_literal)      ///< Input literal, depends on the rule
+{
+   as_action_store . v_add (xc_rule, u_sub, u_variable, cp_literal);
+   #ifdef TINYXPATH_DEBUG
+      printf ("Action %2d : %s (%d,%d,%s)\n", as_action_store . i_get_size () - 1, cp_disp_construct (xc_rule), u_sub, u_variable, cp_literal);
+   #endif
+}
+
+/// Internal use. Retrieves the current action counter
+int xpath_program::i_get_action_counter ()
+{
+   return as_action_store . i_get_size ();
+}
+
+/// xpath_program_cache constructor
+xpath_program_cache::xpath_program_cache (unsigned u_in_capacity)
+{
+   u_capacity = u_in_capacity;
+   ul_hits = 0;
+   ul_misses = 0;
+}
+
+xpath_program_ptr xpath_program_cache::xpp_get (const char * cp_xpath_expr)
+{
+   std::string S_key (cp_xpath_expr);
+
+   m_lock . Lock ();
+   program_index::iterator pi_it = pi_index . find (S_key);
+   if (pi_it != pi_index . end ())
+   {
+      // move to the front of the LRU list
+      pl_lru . splice (pl_lru . begin (), pl_lru, pi_it -> second);
+      xpath_program_ptr xpp_res = * pi_it -> second;
+      ul_hits++;
+      m_lock . Release ();
+      return xpp_res;
+   }
+   ul_misses++;
+   m_lock . Release ();
+
+   // compile outside of the lock, other threads keep using the cache meanwhile
+   xpath_program_ptr xpp_new = xpath_program::xpp_compile (cp_xpath_expr);
+
+   m_lock . Lock ();
+   if (u_capacity && pi_index . find (S_key) == pi_index . end ())
+   {
+      pl_lru . push_front (xpp_new);
+      pi_index [S_key] = pl_lru . begin ();
+      v_trim ();
+   }
+   m_lock . Release ();
+   return xpp_new;
+}
+
+/// Evict the least recently used programs. Called with the lock held
+void xpath_program_cache::v_trim ()
+{
+   while (pl_lru . size () > u_capacity)
+   {
+      pi_index . erase (std::string (pl_lru . back () -> S_get_expression () . c_str ()));
+      pl_lru . pop_back ();
+   }
+}
+
+void xpath_program_cache::v_set_capacity (unsigned u_in_capacity)
+{
+   m_lock . Lock ();
+   u_capacity = u_in_capacity;
+   v_trim ();
+   m_lock . Release ();
+}
+
+unsigned xpath_program_cache::u_get_capacity ()
+{
+   m_lock . Lock ();
+   unsigned u_res = u_capacity;
+   m_lock . Release ();
+   return u_res;
+}
+
+unsigned xpath_program_cache::u_get_size ()
+{
+   m_lock . Lock ();
+   unsigned u_res = (unsigned) pl_lru . size ();
+   m_lock . Release ();
+   return u_res;
+}
+
+unsigned long xpath_program_cache::ul_get_hits ()
+{
+   m_lock . Lock ();
+   unsigned long ul_res = ul_hits;
+   m_lock . Release ();
+   return ul_res;
+}
+
+unsigned long xpath_program_cache::ul_get_misses ()
+{
+   m_lock . Lock ();
+   unsigned long ul_res = ul_misses;
+   m_lock . Release ();
+   return ul_res;
+}
+
+void xpath_program_cache::v_clear ()
+{
+   m_lock . Lock ();
+   pi_index . clear ();
+   pl_lru . clear ();
+   ul_hits = 0;
+   ul_misses = 0;
+   m_lock . Release ();
+}
+
+xpath_program_cache & xpath_program_cache::xpc_get_global ()
+{
+   static xpath_program_cache xpc_global;
+   return xpc_global;
+}
+
+}
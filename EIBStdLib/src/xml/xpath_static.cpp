@@ -83,6 +83,52 @@ namespace TinyXPath
       return xp_proc . XAp_get_xpath_attribute (0);
    }
 
+   /// Static function to compute a compiled integer XPath expression, without an error check
+   int i_xpath_int (const TiXmlNode * XNp_source_tree, const xpath_program_ptr & xpp_program)
+   {
+      xpath_processor xp_proc (XNp_source_tree, xpp_program);
+      return xp_proc . i_compute_xpath ();
+   }
+
+   /// Static function to compute a compiled double XPath expression, without an error check
+   double d_xpath_double (const TiXmlNode * XNp_source_tree, const xpath_program_ptr & xpp_program)
+   {
+      xpath_processor xp_proc (XNp_source_tree, xpp_program);
+      return xp_proc . d_compute_xpath ();
+   }
+
+   /// Static function to compute a compiled bool XPath expression, without an error check
+   bool o_xpath_bool (const TiXmlNode * XNp_source_tree, const xpath_program_ptr & xpp_program)
+   {
+      xpath_processor xp_proc (XNp_source_tree, xpp_program);
+      return xp_proc . o_compute_xpath ();
+   }
+
+   /// Static function to compute a compiled string XPath expression, without an error check
+   TIXML_STRING S_xpath_string (const TiXmlNode * XNp_source_tree, const xpath_program_ptr & xpp_program)
+   {
+      xpath_processor xp_proc (XNp_source_tree, xpp_program);
+      return xp_proc . S_compute_xpath ();
+   }
+
+   /// Static function to compute a compiled node XPath expression, without an error check
+   TiXmlNode * XNp_xpath_node (const TiXmlNode * XNp_source_tree, const xpath_program_ptr & xpp_program)
+   {
+      xpath_processor xp_proc (XNp_source_tree, xpp_program);
+      if (! xp_proc . u_compute_xpath_node_set ())
+         return NULL;
+      return xp_proc . XNp_get_xpath_node (0);
+   }
+
+   /// Static function to compute a compiled attribute XPath expression, without an error check
+   TiXmlAttribute * XAp_xpath_attribute (const TiXmlNode * XNp_source_tree, const xpath_program_ptr & xpp_program)
+   {
+      xpath_processor xp_proc (XNp_source_tree, xpp_program);
+      if (! xp_proc . u_compute_xpath_node_set ())
+         return NULL;
+      return xp_proc . XAp_get_xpath_attribute (0);
+   }
+
    /// Static function to compute an integer XPath expression, with an error check
    bool o_xpath_int (const TiXmlNode * XNp_source_tree, const char * cp_xpath_expr, int & i_res)
    {
@@ -0,0 +1,152 @@
+// CStringBench.cpp -- CString numeric conversion cost.
+//
+// Compares the CString conversions with the ostringstream/istringstream
+// code they replaced. Not part of ctest; run eibstdlib_cstring_bench by
+// hand.
+//
+//   format   : CString(int), CString(int64), CString(double)
+//   parse    : ToInt(), ToUInt64(), UShortFromHexString()
+//   concat   : building "key=value;" lines with += and AppendInt()
+//   hex      : ToHexFormat() of integers and of a buffer
+
+#include "CString.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Keeps the optimizer from dropping the measured work
+volatile long g_sink;
+
+template <class Fn>
+double NsPerOp(long n, Fn fn)
+{
+    Clock::time_point start = Clock::now();
+    for (long i = 0; i < n; ++i)
+        fn(i);
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+}
+
+std::string StreamInt(long long v)
+{
+    std::ostringstream os;
+    os << v;
+    return os.str();
+}
+
+std::string StreamDouble(double v)
+{
+    std::ostringstream os;
+    os << v;
+    return os.str();
+}
+
+template <class T>
+T StreamParse(const std::string& s)
+{
+    T v = 0;
+    std::istringstream is(s);
+    is >> v;
+    return v;
+}
+
+std::string StreamHex(unsigned int v, int width)
+{
+    std::ostringstream os;
+    os << "0x" << std::hex << std::setw(width) << std::setfill('0') << v;
+    return os.str();
+}
+
+void Row(const char* name, double old_ns, double new_ns)
+{
+    printf("%-28s %12.1f %12.1f %8.1fx\n", name, old_ns, new_ns, old_ns / new_ns);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    long scale = argc > 1 ? atol(argv[1]) : 1;
+    if (scale <= 0)
+        scale = 1;
+    long n = 1000000 * scale;
+
+    printf("%-28s %12s %12s %9s\n", "ns/op", "stream", "CString", "speedup");
+
+    Row("format int",
+        NsPerOp(n, [](long i) { g_sink += StreamInt((int)(i * 7919)).size(); }),
+        NsPerOp(n, [](long i) { g_sink += CString((int)(i * 7919)).GetLength(); }));
+    Row("format int64",
+        NsPerOp(n, [](long i) { g_sink += StreamInt(i * 1000000007LL).size(); }),
+        NsPerOp(n, [](long i) { g_sink += CString((int64)(i * 1000000007LL)).GetLength(); }));
+    Row("format double",
+        NsPerOp(n, [](long i) { g_sink += StreamDouble(i * 0.37).size(); }),
+        NsPerOp(n, [](long i) { g_sink += CString(i * 0.37).GetLength(); }));
+
+    std::string s_int = "-1234567", s_u64 = "18446744073709551000";
+    CString c_int(s_int.c_str()), c_u64(s_u64.c_str()), c_hex("0xBEEF");
+    Row("parse int",
+        NsPerOp(n, [&](long) { g_sink += StreamParse<int>(s_int); }),
+        NsPerOp(n, [&](long) { g_sink += c_int.ToInt(); }));
+    Row("parse uint64",
+        NsPerOp(n, [&](long) { g_sink += (long)StreamParse<unsigned long long>(s_u64); }),
+        NsPerOp(n, [&](long) { g_sink += (long)c_u64.ToUInt64(); }));
+    Row("parse hex ushort",
+        NsPerOp(n, [](long) {
+            unsigned short v = 0;
+            std::istringstream is("0xBEEF");
+            is >> std::hex >> v;
+            g_sink += v;
+        }),
+        NsPerOp(n, [&](long) {
+            unsigned short v = 0;
+            c_hex.UShortFromHexString(v);
+            g_sink += v;
+        }));
+
+    long lines = n / 10;
+    Row("concat 10 fields",
+        NsPerOp(lines, [](long i) {
+            std::string line;
+            for (int f = 0; f < 10; ++f) {
+                line += "field=";
+                line += StreamInt(i + f);
+                line += ';';
+            }
+            g_sink += line.size();
+        }),
+        NsPerOp(lines, [](long i) {
+            CString line;
+            for (int f = 0; f < 10; ++f) {
+                line += "field=";
+                line.AppendInt(i + f);
+                line += ';';
+            }
+            g_sink += line.GetLength();
+        }));
+
+    Row("hex format int",
+        NsPerOp(n, [](long i) { g_sink += StreamHex((unsigned int)i, 8).size(); }),
+        NsPerOp(n, [](long i) { g_sink += CString::ToHexFormat((int)i).GetLength(); }));
+
+    char frame[32];
+    for (int i = 0; i < (int)sizeof(frame); ++i)
+        frame[i] = (char)(i * 37);
+    Row("hex format 32 byte buffer",
+        NsPerOp(n / 10, [&](long) {
+            std::string res = "0x";
+            for (int i = 0; i < (int)sizeof(frame); ++i)
+                res += StreamHex(frame[i] & 0xFF, 2).substr(2);
+            g_sink += res.size();
+        }),
+        NsPerOp(n / 10, [&](long) {
+            g_sink += CString::ToHexFormat(frame, sizeof(frame)).GetLength();
+        }));
+    return 0;
+}
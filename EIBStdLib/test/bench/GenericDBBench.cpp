@@ -0,0 +1,160 @@
+// GenericDBBench.cpp -- cost of loading and saving a CGenericDB file.
+//
+// Builds a database of 20k records (times scale) with four parameters
+// each, in the shape of Users.db. Not part of ctest; run
+// eibstdlib_genericdb_bench by hand.
+//
+//   load text     : Load() parsing the text file
+//   load snapshot : Load() reading the binary snapshot of the same file
+//   save full     : Save() rewriting the text file after one edit
+//   save journal  : Save() appending the one edit to the journal
+//   lookup        : GetRecord() on the sorted and on the hashed index
+
+#include "GenericDB.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Record {
+    CString name;
+    CString password;
+    int priority;
+    int mask;
+};
+
+template <class Index = std::map<CString, Record> >
+class BenchDB : public CGenericDB<CString, Record, Index> {
+public:
+    void OnReadParamComplete(Record& rec, const CString& param, const CString& value) override {
+        if (param == "PASSWORD")
+            rec.password = value;
+        else if (param == "PRIORITY")
+            rec.priority = value.ToInt();
+        else if (param == "MASK")
+            rec.mask = value.ToInt();
+    }
+    void OnReadRecordComplete(Record& rec) override { this->AddRecord(rec.name, rec); }
+    void OnReadRecordNameComplete(Record& rec, const CString& name) override { rec.name = name; }
+    void OnSaveRecordStarted(const Record& rec, CString& name, list<pair<CString, CString> >& params) override {
+        name = rec.name;
+        params.push_back(pair<CString, CString>("PASSWORD", rec.password));
+        params.push_back(pair<CString, CString>("PRIORITY", CString(rec.priority)));
+        params.push_back(pair<CString, CString>("MASK", CString(rec.mask)));
+        params.push_back(pair<CString, CString>("ALLOWED", "true"));
+    }
+};
+
+double Ms(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+Record MakeRecord(int i)
+{
+    Record rec;
+    rec.name = "user";
+    rec.name += i;
+    rec.password = "3c9909afec25354d551dae21590bb26e38d53f2173b8d3dc3eee4c047e7ab1c1";
+    rec.priority = i % 10;
+    rec.mask = 0xFFFF;
+    return rec;
+}
+
+volatile long g_sink;
+
+template <class DB>
+double LookupNs(DB& db, int records)
+{
+    Record rec;
+    const int n = 1000000;
+    std::vector<CString> keys;
+    for (int i = 0; i < 1024; ++i)
+        keys.push_back(MakeRecord((i * 7919) % records).name);
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < n; ++i)
+        g_sink += db.GetRecord(keys[i & 1023], rec) ? 1 : 0;
+    return Ms(start) * 1e6 / n;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    long scale = argc > 1 ? atol(argv[1]) : 1;
+    if (scale <= 0)
+        scale = 1;
+    int records = (int)(20000 * scale);
+
+    char path_template[] = "/tmp/eib_genericdb_bench_XXXXXX";
+    int fd = mkstemp(path_template);
+    if (fd < 0)
+        return 1;
+    close(fd);
+    CString path(path_template);
+
+    {
+        BenchDB<> db;
+        db.Init(path);
+        for (int i = 0; i < records; ++i)
+            db.AddRecord(MakeRecord(i).name, MakeRecord(i));
+        db.Save();
+    }
+
+    BenchDB<> text_db;
+    text_db.Init(path);
+    Clock::time_point start = Clock::now();
+    text_db.Load();
+    double load_text = Ms(start);
+
+    {
+        BenchDB<> writer;
+        writer.Init(path);
+        writer.SetStorageOptions(GENERIC_DB_SNAPSHOT);
+        writer.Load();  // writes the snapshot
+    }
+    BenchDB<> snap_db;
+    snap_db.Init(path);
+    snap_db.SetStorageOptions(GENERIC_DB_SNAPSHOT);
+    start = Clock::now();
+    snap_db.Load();
+    double load_snap = Ms(start);
+
+    text_db.EditRecord("user7", MakeRecord(7));
+    start = Clock::now();
+    text_db.Save();
+    double save_full = Ms(start);
+
+    BenchDB<> journal_db;
+    journal_db.Init(path);
+    journal_db.SetStorageOptions(GENERIC_DB_JOURNAL);
+    journal_db.Load();
+    journal_db.EditRecord("user7", MakeRecord(7));
+    start = Clock::now();
+    journal_db.Save();
+    double save_journal = Ms(start);
+
+    BenchDB<std::unordered_map<CString, Record, CStringHash> > hashed_db;
+    hashed_db.Init(path);
+    hashed_db.Load();
+
+    printf("%d records\n", records);
+    printf("%-16s %10.2f ms\n", "load text", load_text);
+    printf("%-16s %10.2f ms\n", "load snapshot", load_snap);
+    printf("%-16s %10.2f ms\n", "save full", save_full);
+    printf("%-16s %10.3f ms\n", "save journal", save_journal);
+    printf("%-16s %10.1f ns (map) %10.1f ns (unordered_map)\n", "lookup", LookupNs(text_db, records),
+           LookupNs(hashed_db, records));
+
+    unlink(path.GetBuffer());
+    unlink((path + GENERIC_DB_SNAPSHOT_EXT).GetBuffer());
+    unlink((path + GENERIC_DB_JOURNAL_EXT).GetBuffer());
+    return 0;
+}
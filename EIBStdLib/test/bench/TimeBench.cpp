@@ -0,0 +1,75 @@
+// TimeBench.cpp -- CTime formatting cost.
+//
+// Compares CTime::Format() and FormatISO8601(), which cache the text of
+// the current minute, with calling localtime_r()/strftime() for every
+// time stamp. Not part of ctest; run eibstdlib_time_bench by hand.
+//
+//   same second : every call formats the same time (log lines)
+//   history     : consecutive telegrams a few seconds apart
+//   spread      : times hours apart, the cache misses every time
+
+#include "CTime.h"
+#include "TimeStamp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <chrono>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+volatile long g_sink;
+
+template <class Fn>
+double NsPerOp(long n, Fn fn)
+{
+    Clock::time_point start = Clock::now();
+    for (long i = 0; i < n; ++i)
+        fn(i);
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+}
+
+CString Strftime(time_t tt)
+{
+    struct tm tm_struct;
+    char buf[32];
+    localtime_r(&tt, &tm_struct);
+    strftime(buf, sizeof(buf), "%a %b %d %H:%M:%S %Y", &tm_struct);
+    return CString(buf);
+}
+
+void Row(const char* name, double old_ns, double new_ns)
+{
+    printf("%-28s %12.1f %12.1f %8.1fx\n", name, old_ns, new_ns, old_ns / new_ns);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    long scale = argc > 1 ? atol(argv[1]) : 1;
+    if (scale <= 0)
+        scale = 1;
+    long n = 1000000 * scale;
+    time_t base = time(NULL);
+
+    printf("%-28s %12s %12s %9s\n", "ns/op", "strftime", "CTime", "speedup");
+
+    Row("same second",
+        NsPerOp(n, [&](long) { g_sink += Strftime(base).GetLength(); }),
+        NsPerOp(n, [&](long) { g_sink += CTime(base).Format(true).GetLength(); }));
+    Row("history (3s apart)",
+        NsPerOp(n, [&](long i) { g_sink += Strftime(base + i * 3).GetLength(); }),
+        NsPerOp(n, [&](long i) { g_sink += CTime(base + i * 3).Format(true).GetLength(); }));
+    Row("spread (1h apart)",
+        NsPerOp(n, [&](long i) { g_sink += Strftime(base + i * 3600).GetLength(); }),
+        NsPerOp(n, [&](long i) { g_sink += CTime(base + i * 3600).Format(true).GetLength(); }));
+
+    CTimeStamp now = CTimeStamp::Now();
+    printf("\n%-28s %12.1f\n", "ISO-8601 UTC",
+           NsPerOp(n, [&](long i) { g_sink += CTime(base + i * 3).FormatISO8601().GetLength(); }));
+    printf("%-28s %12.1f\n", "ISO-8601 with ms",
+           NsPerOp(n, [&](long) { g_sink += now.FormatISO8601().GetLength(); }));
+    return 0;
+}
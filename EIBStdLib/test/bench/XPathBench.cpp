@@ -0,0 +1,87 @@
+// XPathBench.cpp -- cost of evaluating XPath expressions.
+//
+// Evaluates a few typical configuration queries against a server
+// configuration with a users list, 100k times each at scale 1. Not part
+// of ctest; run eibstdlib_xpath_bench by hand.
+//
+//   decode   : the expression is decoded for every evaluation (what every
+//              call did before expressions were compiled)
+//   cached   : the string API, which finds the program in the global cache
+//   compiled : a program compiled once and passed to the evaluation
+
+#include "xml/xpath_static.h"
+#include "xml/xpath_program.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+
+using namespace TinyXPath;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+volatile long g_sink;
+
+template <class Fn>
+double NsPerOp(long n, Fn fn)
+{
+    Clock::time_point start = Clock::now();
+    for (long i = 0; i < n; ++i)
+        fn(i);
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+}
+
+void Row(const char* name, double decode_ns, double cached_ns, double compiled_ns)
+{
+    printf("%-40s %10.0f %10.0f %10.0f %8.1fx %8.1fx\n", name, decode_ns, cached_ns, compiled_ns,
+           decode_ns / cached_ns, decode_ns / compiled_ns);
+}
+
+std::string Conf()
+{
+    std::string xml = "<?xml version=\"1.0\"?><Conf>"
+                      "<EIBServer><Name>EIBServer</Name><ListenPort>50000</ListenPort>"
+                      "<LogLevel>3</LogLevel><LogFile>EIBServer.log</LogFile></EIBServer>"
+                      "<Users>";
+    for (int i = 0; i < 20; ++i) {
+        xml += "<User name=\"user" + std::to_string(i) + "\" priority=\"" + std::to_string(i % 5) + "\">";
+        xml += "<Password>secret</Password><Mask>0xFFFF</Mask></User>";
+    }
+    xml += "</Users></Conf>";
+    return xml;
+}
+
+const char* kQueries[] = {
+    "/Conf/EIBServer/ListenPort/text()",
+    "/Conf/EIBServer/LogFile/text()",
+    "//User[@name='user12']/Password/text()",
+    "count(/Conf/Users/User[@priority=0])",
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    long scale = argc > 1 ? atol(argv[1]) : 1;
+    if (scale <= 0)
+        scale = 1;
+    long n = 100000 * scale;
+
+    std::string xml = Conf();
+    TiXmlDocument doc;
+    doc.Parse(xml.c_str());
+    const TiXmlNode* root = doc.RootElement();
+
+    printf("%-40s %10s %10s %10s %9s %9s\n", "ns/op", "decode", "cached", "compiled", "cached", "compiled");
+
+    for (const char* query : kQueries) {
+        xpath_program_ptr prog = xpath_program::xpp_compile(query);
+        Row(query,
+            NsPerOp(n, [&](long) { g_sink += S_xpath_string(root, xpath_program::xpp_compile(query)).length(); }),
+            NsPerOp(n, [&](long) { g_sink += S_xpath_string(root, query).length(); }),
+            NsPerOp(n, [&](long) { g_sink += S_xpath_string(root, prog).length(); }));
+    }
+    return 0;
+}
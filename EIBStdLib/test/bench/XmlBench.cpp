@@ -0,0 +1,185 @@
+// XmlBench.cpp -- cost of building, parsing and printing a DOM.
+//
+// Compares a TiXmlDocument that allocates every node and string from the
+// heap with one that carves them from its arena. The document is a users
+// list and a bus monitor address list of about 1 MB, like the ones the
+// admin web interface sends. Not part of ctest; run eibstdlib_xml_bench
+// by hand.
+//
+//   parse        : Parse() of the text, then destroying the document
+//   parse+print  : the same plus serialising it with TiXmlPrinter
+//   build+print  : building it with CXmlElement::InsertChild()/SetValue()
+//                  (arena) or with InsertEndChild() of temporaries (heap)
+
+#include "xml/Xml.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+volatile long g_sink;
+
+template <class Fn>
+double MsPerOp(long n, Fn fn)
+{
+    Clock::time_point start = Clock::now();
+    for (long i = 0; i < n; ++i)
+        fn(i);
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / n;
+}
+
+void Row(const char* name, double old_ms, double new_ms)
+{
+    printf("%-28s %12.2f %12.2f %8.1fx\n", name, old_ms, new_ms, old_ms / new_ms);
+}
+
+const int kUsers = 600;
+const int kAddresses = 1600;
+
+std::string UserField(int user, int field)
+{
+    static const char* values[] = { "user", "secret", "false", "0", "255", "192.168.0.", "0xFFFF", "0x00FF" };
+    return values[field] + std::to_string(field == 0 || field == 5 ? user : 0);
+}
+
+const char* kUserTags[] = {
+    "EIB_SERVER_USER_NAME", "EIB_SERVER_USER_PASSWORD", "EIB_SERVER_USER_IS_CONNECTED",
+    "EIB_SERVER_USER_SESSION_ID", "EIB_SERVER_USER_PRIVILIGES", "EIB_SERVER_USER_IP_ADDRESS",
+    "EIB_SERVER_USER_SOURCE_ADDR_MASK", "EIB_SERVER_USER_DST_ADDR_MASK"
+};
+
+const char* kAddressTags[] = {
+    "EIB_BUS_MON_ADDRESS_STR", "EIB_BUS_MON_IS_ADDRESS_LOGICAL", "EIB_BUS_MON_ADDR_LAST_RECVED_TIME",
+    "EIB_BUS_MON_LAST_ADDR_VALUE", "EIB_BUS_MON_ADDRESSES_COUNT"
+};
+
+std::string AddressField(int addr, int field)
+{
+    switch (field) {
+    case 0: return std::to_string(addr / 2048) + "/" + std::to_string(addr / 256 % 8) + "/" + std::to_string(addr % 256);
+    case 1: return "true";
+    case 2: return "Mon Aug 21 20:07:29 2000";
+    case 3: return "0x" + std::to_string(addr % 100);
+    default: return std::to_string(addr % 1000);
+    }
+}
+
+// What the conf classes do: InsertChild()/SetValue() on a CXmlDocument
+void BuildCXml(CXmlDocument& doc)
+{
+    CXmlElement users = doc.RootElement().InsertChild("EIB_SERVER_USERS_LIST");
+    for (int u = 0; u < kUsers; ++u) {
+        CXmlElement user = users.InsertChild("EIB_SERVER_USER");
+        for (int f = 0; f < 8; ++f)
+            user.InsertChild(kUserTags[f]).SetValue(UserField(u, f).c_str());
+    }
+    CXmlElement addresses = doc.RootElement().InsertChild("EIB_BUS_MON_ADDRESSES_LIST");
+    for (int a = 0; a < kAddresses; ++a) {
+        CXmlElement address = addresses.InsertChild("EIB_BUS_MON_ADDRESS");
+        for (int f = 0; f < 5; ++f)
+            address.InsertChild(kAddressTags[f]).SetValue(AddressField(a, f).c_str());
+    }
+}
+
+// What CXmlElement did before: a heap temporary cloned by InsertEndChild()
+TiXmlNode* InsertCloned(TiXmlNode* parent, const char* name)
+{
+    TiXmlElement* temp = new TiXmlElement(name);
+    TiXmlNode* res = parent->InsertEndChild(*temp);
+    delete temp;
+    return res;
+}
+
+void SetCloned(TiXmlNode* elem, const char* value)
+{
+    TiXmlText* text = new TiXmlText(value);
+    elem->InsertEndChild(*text);
+    delete text;
+}
+
+void BuildHeap(TiXmlDocument& doc)
+{
+    TiXmlNode* root = InsertCloned(&doc, "Root");
+    TiXmlNode* users = InsertCloned(root, "EIB_SERVER_USERS_LIST");
+    for (int u = 0; u < kUsers; ++u) {
+        TiXmlNode* user = InsertCloned(users, "EIB_SERVER_USER");
+        for (int f = 0; f < 8; ++f)
+            SetCloned(InsertCloned(user, kUserTags[f]), UserField(u, f).c_str());
+    }
+    TiXmlNode* addresses = InsertCloned(root, "EIB_BUS_MON_ADDRESSES_LIST");
+    for (int a = 0; a < kAddresses; ++a) {
+        TiXmlNode* address = InsertCloned(addresses, "EIB_BUS_MON_ADDRESS");
+        for (int f = 0; f < 5; ++f)
+            SetCloned(InsertCloned(address, kAddressTags[f]), AddressField(a, f).c_str());
+    }
+}
+
+long Print(const TiXmlDocument& doc)
+{
+    TiXmlPrinter printer;
+    printer.SetLineBreak("\r\n");
+    printer.SetIndent("\t");
+    doc.Accept(&printer);
+    return (long)printer.Size();
+}
+
+long ParseAndPrint(const std::string& xml, bool arena, bool print)
+{
+    TiXmlDocument doc;
+    doc.SetUseArena(arena);
+    doc.Parse(xml.c_str());
+    return print ? Print(doc) : (long)doc.FirstChild()->Type();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    long scale = argc > 1 ? atol(argv[1]) : 1;
+    if (scale <= 0)
+        scale = 1;
+    long n = 20 * scale;
+
+    std::string xml;
+    {
+        CXmlDocument doc;
+        BuildCXml(doc);
+        CDataBuffer buf;
+        doc.ToString(buf);
+        xml.assign((const char*)buf.GetBuffer(), buf.GetLength());
+    }
+    {
+        TiXmlDocument doc;
+        doc.SetUseArena(true);
+        doc.Parse(xml.c_str());
+        printf("document: %zu bytes, arena: %zu bytes used in %d blocks\n\n", xml.size(),
+               doc.Arena()->BytesUsed(), doc.Arena()->BlockCount());
+    }
+
+    printf("%-28s %12s %12s %9s\n", "ms/op", "heap", "arena", "speedup");
+
+    Row("parse",
+        MsPerOp(n, [&](long) { g_sink += ParseAndPrint(xml, false, false); }),
+        MsPerOp(n, [&](long) { g_sink += ParseAndPrint(xml, true, false); }));
+    Row("parse+print",
+        MsPerOp(n, [&](long) { g_sink += ParseAndPrint(xml, false, true); }),
+        MsPerOp(n, [&](long) { g_sink += ParseAndPrint(xml, true, true); }));
+    Row("build+print",
+        MsPerOp(n, [&](long) {
+            TiXmlDocument doc;
+            BuildHeap(doc);
+            g_sink += Print(doc);
+        }),
+        MsPerOp(n, [&](long) {
+            CXmlDocument doc;
+            BuildCXml(doc);
+            CDataBuffer buf;
+            doc.ToString(buf);
+            g_sink += buf.GetLength();
+        }));
+    return 0;
+}
@@ -317,6 +317,61 @@ TEST_F(CStringTest, ToHexFormat_ConvertsIntToHex) {
     EXPECT_TRUE(hex.Find("ff") != string::npos || hex.Find("FF") != string::npos);
 }
 
+TEST_F(CStringTest, ToHexFormat_PadsAndKeepsSignExtension) {
+    EXPECT_STREQ("0x0a", CString::ToHexFormat((unsigned char)10).GetBuffer());
+    EXPECT_STREQ("0a", CString::ToHexFormat((unsigned char)10, false).GetBuffer());
+    EXPECT_STREQ("0xffff", CString::ToHexFormat((short)-1).GetBuffer());
+    EXPECT_STREQ("0xfffffffe", CString::ToHexFormat(-2).GetBuffer());
+    EXPECT_STREQ("0xffffffff", CString::ToHexFormat((char)-1).GetBuffer());
+    EXPECT_STREQ("0x01ab00", CString::ToHexFormat("\x01\xab\x00", 3).GetBuffer());
+}
+
+// Numeric Append Tests
+TEST_F(CStringTest, AppendInt_AppendsDecimal) {
+    CString str("v=");
+    str.AppendInt(-42).AppendUInt(7);
+    EXPECT_STREQ("v=-427", str.GetBuffer());
+
+    EXPECT_STREQ("-9223372036854775808", CString().AppendInt(LLONG_MIN).GetBuffer());
+    EXPECT_STREQ("18446744073709551615", CString().AppendUInt(ULLONG_MAX).GetBuffer());
+    EXPECT_STREQ("0", CString((int64)0).GetBuffer());
+}
+
+TEST_F(CStringTest, AppendHex_PadsAndPrefixes) {
+    EXPECT_STREQ("ff", CString().AppendHex(255).GetBuffer());
+    EXPECT_STREQ("0x00ff", CString().AppendHex(255, 4, true).GetBuffer());
+    EXPECT_STREQ("0", CString().AppendHex(0).GetBuffer());
+}
+
+TEST_F(CStringTest, ToInt_StreamCompatibleEdgeCases) {
+    EXPECT_EQ(42, CString("  +42").ToInt());
+    EXPECT_EQ(12, CString("12x").ToInt());
+    EXPECT_EQ(0, CString("abc").ToInt());
+    EXPECT_EQ(0, CString("").ToInt());
+    EXPECT_EQ(INT_MAX, CString("99999999999").ToInt());
+    EXPECT_EQ(INT_MIN, CString("-99999999999").ToInt());
+    EXPECT_EQ(32767, CString("40000").ToShort());
+    EXPECT_EQ(LLONG_MIN, CString("-9223372036854775808").ToInt64());
+    EXPECT_EQ(UINT_MAX, CString("-1").ToUInt());
+    EXPECT_EQ(UINT_MAX, CString("4294967296").ToUInt());
+    EXPECT_EQ(ULLONG_MAX, CString("18446744073709551615").ToUInt64());
+}
+
+TEST_F(CStringTest, FromHexString_ParsesAndValidates) {
+    unsigned short us = 0;
+    EXPECT_TRUE(CString("0xBEEF").UShortFromHexString(us));
+    EXPECT_EQ(0xBEEF, us);
+    unsigned int ui = 0;
+    EXPECT_TRUE(CString("0xFFFFFFFF").UIntFromHexString(ui));
+    EXPECT_EQ(0xFFFFFFFFu, ui);
+    unsigned char uc = 0;
+    EXPECT_FALSE(CString("0x1G").UCharFromHexString(uc));
+    EXPECT_FALSE(CString("12").UCharFromHexString(uc));
+    EXPECT_FALSE(CString("").UCharFromHexString(uc));
+    int i = 0;
+    EXPECT_FALSE(CString("0x1234").IntFromHexString(i));
+}
+
 // GetBuffer Tests
 TEST_F(CStringTest, GetBuffer_ReturnsValidPointer) {
     CString str("Test");
@@ -425,3 +425,36 @@ TEST_F(CTimeTest, Y2038_ArithmeticAcross2038Boundary) {
         << "Arithmetic across 2^31 boundary should produce correct result";
     EXPECT_TRUE(after > before_boundary);
 }
+
+// Formatting is cached per minute; the output must stay identical to strftime
+TEST_F(CTimeTest, Format_CachedOutputMatchesStrftime) {
+    time_t start = 1700000000 - 150; // crosses several minutes, an hour and a day is covered below
+    for (int utc = 0; utc < 2; ++utc) {
+        for (time_t t = start; t < start + 200; t += 7) {
+            for (time_t tt : {t, t + 86400 * 30, t - 1}) {
+                struct tm tm_struct;
+                if (utc) gmtime_r(&tt, &tm_struct); else localtime_r(&tt, &tm_struct);
+                char expected[32];
+                strftime(expected, sizeof(expected), "%a %b %d %H:%M:%S %Y", &tm_struct);
+                if (expected[8] == ' ') expected[8] = '0';
+                EXPECT_STREQ(expected, CTime(tt).Format(utc == 0).GetBuffer()) << "t=" << tt;
+            }
+        }
+    }
+}
+
+TEST_F(CTimeTest, FormatISO8601_UtcAndLocal) {
+    CTime t((time_t)966888449); // 2000-08-21T20:07:29Z
+    EXPECT_STREQ("2000-08-21T20:07:29Z", t.FormatISO8601().GetBuffer());
+    CTime t2((time_t)966888450);
+    EXPECT_STREQ("2000-08-21T20:07:30Z", t2.FormatISO8601(false).GetBuffer());
+
+    CString local = t.FormatISO8601(true);
+    ASSERT_EQ(25, local.GetLength()) << local.GetBuffer();
+    EXPECT_TRUE(local[19] == '+' || local[19] == '-');
+    EXPECT_EQ(':', local[22]);
+}
+
+TEST_F(CTimeTest, GetEpochMs) {
+    EXPECT_EQ(966888449000LL, CTime((time_t)966888449).GetEpochMs());
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <set>
+#include "ConnectionTable.h"
+#include "../fixtures/TestHelpers.h"
+
+using namespace EIBStdLibTest;
+
+namespace {
+
+struct TestState {
+    TestState() : value(0) { ++live; }
+    ~TestState() { --live; }
+    int value;
+    static int live;
+};
+int TestState::live = 0;
+
+} // namespace
+
+class ConnectionTableTest : public BaseTestFixture {};
+
+TEST_F(ConnectionTableTest, AllocateAssignsUniqueNonZeroChannels) {
+    CConnectionTable<TestState> table;
+    std::set<int> channels;
+    for (int i = 0; i < CONNECTION_TABLE_SIZE; ++i) {
+        unsigned char channel = 0;
+        TestState* s = table.Allocate(channel);
+        ASSERT_TRUE(s != NULL);
+        EXPECT_NE(0, channel);
+        EXPECT_EQ(s, table.Get(channel));
+        channels.insert(channel);
+    }
+    EXPECT_EQ(CONNECTION_TABLE_SIZE, (int)channels.size());
+    EXPECT_TRUE(table.IsFull());
+
+    unsigned char channel = 0;
+    EXPECT_TRUE(table.Allocate(channel) == NULL);
+    EXPECT_TRUE(table.Get(0) == NULL);
+}
+
+TEST_F(ConnectionTableTest, MaxConnectionsIsEnforcedAndClamped) {
+    CConnectionTable<TestState> table(2);
+    unsigned char c1, c2, c3;
+    ASSERT_TRUE(table.Allocate(c1) != NULL);
+    ASSERT_TRUE(table.Allocate(c2) != NULL);
+    EXPECT_TRUE(table.Allocate(c3) == NULL);
+
+    table.SetMaxConnections(1000);
+    EXPECT_EQ(CONNECTION_TABLE_SIZE, table.GetMaxConnections());
+    table.SetMaxConnections(0);
+    EXPECT_EQ(1, table.GetMaxConnections());
+}
+
+TEST_F(ConnectionTableTest, FreedChannelIsReusedLast) {
+    CConnectionTable<TestState> table(4);
+    unsigned char first, second;
+    table.Allocate(first);
+    table.Allocate(second);
+    table.Free(first);
+    EXPECT_TRUE(table.Get(first) == NULL);
+    EXPECT_EQ(1, table.GetNumConnections());
+
+    unsigned char next;
+    table.Allocate(next);
+    EXPECT_NE(first, next);
+    EXPECT_NE(second, next);
+}
+
+TEST_F(ConnectionTableTest, FreeDeletesStateAndUpdatesChannelList) {
+    int live_before = TestState::live;
+    {
+        CConnectionTable<TestState> table;
+        unsigned char a, b, c;
+        table.Allocate(a);
+        table.Allocate(b);
+        table.Allocate(c);
+        EXPECT_EQ(live_before + 3, TestState::live);
+
+        table.Free(b);
+        table.Free(b); // second free is ignored
+        EXPECT_EQ(live_before + 2, TestState::live);
+
+        std::set<int> listed(table.GetChannels().begin(), table.GetChannels().end());
+        EXPECT_EQ(2u, listed.size());
+        EXPECT_TRUE(listed.count(a) == 1);
+        EXPECT_TRUE(listed.count(c) == 1);
+    }
+    // destructor deletes the remaining states
+    EXPECT_EQ(live_before, TestState::live);
+}
+
+TEST_F(ConnectionTableTest, ExpireReportsOnlyDueChannelsOnce) {
+    CConnectionTable<TestState> table;
+    time_t now = 1000000;
+    unsigned char soon, later, never;
+    table.Allocate(soon);
+    table.Allocate(later);
+    table.Allocate(never);
+    table.SetTimeout(soon, now + 5);
+    table.SetTimeout(later, now + 200); // longer than the wheel
+
+    std::vector<unsigned char> expired;
+    EXPECT_EQ(0, table.Expire(now, expired));
+    EXPECT_EQ(0, table.Expire(now + 4, expired));
+    EXPECT_EQ(1, table.Expire(now + 5, expired));
+    ASSERT_EQ(1u, expired.size());
+    EXPECT_EQ(soon, expired[0]);
+
+    expired.clear();
+    EXPECT_EQ(0, table.Expire(now + 100, expired));
+    EXPECT_EQ(1, table.Expire(now + 201, expired));
+    ASSERT_EQ(1u, expired.size());
+    EXPECT_EQ(later, expired[0]);
+
+    // reported channels are disarmed
+    expired.clear();
+    EXPECT_EQ(0, table.Expire(now + 500, expired));
+}
+
+TEST_F(ConnectionTableTest, RearmedOrFreedChannelDoesNotExpire) {
+    CConnectionTable<TestState> table;
+    time_t now = 2000000;
+    unsigned char a, b;
+    table.Allocate(a);
+    table.Allocate(b);
+    table.SetTimeout(a, now + 10);
+    table.SetTimeout(b, now + 10);
+    std::vector<unsigned char> none;
+    table.Expire(now, none);
+
+    table.SetTimeout(a, now + 30);
+    table.Free(b);
+
+    std::vector<unsigned char> expired;
+    EXPECT_EQ(0, table.Expire(now + 20, expired));
+    EXPECT_EQ(1, table.Expire(now + 30, expired));
+    EXPECT_EQ(a, expired[0]);
+}
@@ -6,6 +6,9 @@
 #include <cstdio>
 #include <fstream>
 #include <list>
+#include <sstream>
+#include <string>
+#include <unordered_map>
 #include <unistd.h>
 
 using namespace EIBStdLibTest;
@@ -20,9 +23,10 @@ struct GenericRecord {
     GenericRecord() : value(0), enabled(false) {}
 };
 
-class TestGenericDB : public CGenericDB<CString, GenericRecord> {
+template <class Index = std::map<CString, GenericRecord> >
+class BasicTestGenericDB : public CGenericDB<CString, GenericRecord, Index> {
 public:
-    void SetFileWithoutCreate(const CString& file_name) { _file_name = file_name; }
+    void SetFileWithoutCreate(const CString& file_name) { this->_file_name = file_name; }
 
     void OnReadParamComplete(GenericRecord& current_record, const CString& param, const CString& value) override {
         if (param == "value") {
@@ -35,7 +39,7 @@ public:
     }
 
     void OnReadRecordComplete(GenericRecord& current_record) override {
-        AddRecord(current_record.key, current_record);
+        this->AddRecord(current_record.key, current_record);
         current_record = GenericRecord();
     }
 
@@ -54,6 +58,9 @@ public:
     }
 };
 
+typedef BasicTestGenericDB<> TestGenericDB;
+typedef BasicTestGenericDB<std::unordered_map<CString, GenericRecord, CStringHash> > HashedTestGenericDB;
+
 CString MakeTempPath(const char* pattern) {
     char temp_template[96] = {0};
     strncpy(temp_template, pattern, sizeof(temp_template) - 1);
@@ -71,6 +78,34 @@ void WriteFile(const CString& path, const char* data) {
     ASSERT_TRUE(file.is_open());
     file << data;
 }
+
+std::string ReadFile(const CString& path) {
+    std::ifstream file(path.GetBuffer(), std::ios::in | std::ios::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+void WriteBinaryFile(const CString& path, const std::string& data) {
+    std::ofstream file(path.GetBuffer(), std::ios::out | std::ios::binary | std::ios::trunc);
+    ASSERT_TRUE(file.is_open());
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+void RemoveDB(const CString& path) {
+    unlink(path.GetBuffer());
+    unlink((path + GENERIC_DB_SNAPSHOT_EXT).GetBuffer());
+    unlink((path + GENERIC_DB_JOURNAL_EXT).GetBuffer());
+}
+
+GenericRecord MakeRecord(const char* key, int value, const char* text) {
+    GenericRecord rec;
+    rec.key = key;
+    rec.value = value;
+    rec.enabled = true;
+    rec.text = text;
+    return rec;
+}
 }  // namespace
 
 class GenericDBTest : public BaseTestFixture {};
@@ -272,3 +307,340 @@ TEST_F(GenericDBTest, Load_CommentsWhitespaceAndCrlf_AreHandled) {
 
     unlink(path.GetBuffer());
 }
+
+// -----------------------------------------------------------------------
+// Snapshot
+// -----------------------------------------------------------------------
+
+TEST_F(GenericDBTest, Snapshot_IsUsedWhileTextIsUnchanged) {
+    CString path = MakeTempPath("/tmp/eib_genericdb_snap_XXXXXX");
+    WriteFile(path, "[rec]\nvalue = 9\ntext = alpha\n");
+
+    TestGenericDB db;
+    db.SetFileWithoutCreate(path);
+    db.SetStorageOptions(GENERIC_DB_SNAPSHOT);
+    ASSERT_TRUE(db.Load());
+    CString snap = path + GENERIC_DB_SNAPSHOT_EXT;
+    std::string image = ReadFile(snap);
+    ASSERT_FALSE(image.empty());
+
+    // a value changed in the snapshot only shows that the text was not parsed
+    size_t pos = image.find("alpha");
+    ASSERT_NE(std::string::npos, pos);
+    image.replace(pos, 5, "omega");
+    WriteBinaryFile(snap, image);
+
+    TestGenericDB loaded;
+    loaded.SetFileWithoutCreate(path);
+    loaded.SetStorageOptions(GENERIC_DB_SNAPSHOT);
+    ASSERT_TRUE(loaded.Load());
+    GenericRecord rec;
+    ASSERT_TRUE(loaded.GetRecord("rec", rec));
+    EXPECT_EQ(9, rec.value);
+    EXPECT_STREQ("omega", rec.text.GetBuffer());
+
+    RemoveDB(path);
+}
+
+TEST_F(GenericDBTest, Snapshot_StaleOrDamagedFallsBackToText) {
+    CString path = MakeTempPath("/tmp/eib_genericdb_snap_stale_XXXXXX");
+    WriteFile(path, "[rec]\nvalue = 1\n");
+    TestGenericDB db;
+    db.SetFileWithoutCreate(path);
+    db.SetStorageOptions(GENERIC_DB_SNAPSHOT);
+    ASSERT_TRUE(db.Load());
+
+    // edited by hand
+    WriteFile(path, "[rec]\nvalue = 2\n[other]\nvalue = 3\n");
+    TestGenericDB edited;
+    edited.SetFileWithoutCreate(path);
+    edited.SetStorageOptions(GENERIC_DB_SNAPSHOT);
+    ASSERT_TRUE(edited.Load());
+    EXPECT_EQ(2, edited.GetNumOfRecords());
+    GenericRecord rec;
+    ASSERT_TRUE(edited.GetRecord("rec", rec));
+    EXPECT_EQ(2, rec.value);
+
+    // cut off
+    CString snap = path + GENERIC_DB_SNAPSHOT_EXT;
+    std::string image = ReadFile(snap);
+    ASSERT_GT(image.size(), 10u);
+    WriteBinaryFile(snap, image.substr(0, image.size() - 3));
+    TestGenericDB damaged;
+    damaged.SetFileWithoutCreate(path);
+    damaged.SetStorageOptions(GENERIC_DB_SNAPSHOT);
+    ASSERT_TRUE(damaged.Load());
+    EXPECT_EQ(2, damaged.GetNumOfRecords());
+    EXPECT_EQ(image, ReadFile(snap));
+
+    RemoveDB(path);
+}
+
+TEST_F(GenericDBTest, Snapshot_KeepsParseErrors) {
+    CString path = MakeTempPath("/tmp/eib_genericdb_snap_err_XXXXXX");
+    WriteFile(path, "[rec]\nvalue 7\n");
+    TestGenericDB db;
+    db.SetFileWithoutCreate(path);
+    db.SetStorageOptions(GENERIC_DB_SNAPSHOT);
+
+    EXPECT_THROW(db.Load(), CEIBException);
+    EXPECT_EQ(-1, access((path + GENERIC_DB_SNAPSHOT_EXT).GetBuffer(), F_OK));
+    RemoveDB(path);
+}
+
+// -----------------------------------------------------------------------
+// Journal
+// -----------------------------------------------------------------------
+
+TEST_F(GenericDBTest, Journal_SaveAppendsChangesAndLoadReplaysThem) {
+    CString path = MakeTempPath("/tmp/eib_genericdb_journal_XXXXXX");
+    TestGenericDB db;
+    db.Init(path);
+    db.SetStorageOptions(GENERIC_DB_JOURNAL | GENERIC_DB_SNAPSHOT);
+    ASSERT_TRUE(db.Load());
+    ASSERT_TRUE(db.AddRecord("a", MakeRecord("a", 1, "one")));
+    ASSERT_TRUE(db.AddRecord("b", MakeRecord("b", 2, "two")));
+    ASSERT_TRUE(db.Save());
+    std::string text = ReadFile(path);
+    EXPECT_EQ("", text);
+
+    ASSERT_TRUE(db.EditRecord("a", MakeRecord("a", 10, "ten")));
+    ASSERT_TRUE(db.DeleteRecord("b"));
+    ASSERT_TRUE(db.AddRecord("c", MakeRecord("c", 3, "three")));
+    ASSERT_TRUE(db.Save());
+    EXPECT_EQ(text, ReadFile(path));
+
+    TestGenericDB loaded;
+    loaded.SetFileWithoutCreate(path);
+    loaded.SetStorageOptions(GENERIC_DB_JOURNAL | GENERIC_DB_SNAPSHOT);
+    ASSERT_TRUE(loaded.Load());
+    EXPECT_EQ(2, loaded.GetNumOfRecords());
+    GenericRecord rec;
+    ASSERT_TRUE(loaded.GetRecord("a", rec));
+    EXPECT_EQ(10, rec.value);
+    EXPECT_STREQ("ten", rec.text.GetBuffer());
+    EXPECT_FALSE(loaded.GetRecord("b", rec));
+    ASSERT_TRUE(loaded.GetRecord("c", rec));
+    EXPECT_EQ(3, rec.value);
+
+    // nothing changed since the load
+    std::string journal = ReadFile(path + GENERIC_DB_JOURNAL_EXT);
+    ASSERT_TRUE(loaded.Save());
+    EXPECT_EQ(journal, ReadFile(path + GENERIC_DB_JOURNAL_EXT));
+
+    // compacting folds the journal into the text
+    ASSERT_TRUE(loaded.Compact());
+    EXPECT_NE(std::string::npos, ReadFile(path).find("[c]"));
+    EXPECT_EQ(std::string::npos, ReadFile(path).find("[b]"));
+    EXPECT_LT(ReadFile(path + GENERIC_DB_JOURNAL_EXT).size(), journal.size());
+
+    TestGenericDB compacted;
+    compacted.SetFileWithoutCreate(path);
+    compacted.SetStorageOptions(GENERIC_DB_JOURNAL);
+    ASSERT_TRUE(compacted.Load());
+    EXPECT_EQ(2, compacted.GetNumOfRecords());
+    ASSERT_TRUE(compacted.GetRecord("a", rec));
+    EXPECT_EQ(10, rec.value);
+
+    RemoveDB(path);
+}
+
+TEST_F(GenericDBTest, Journal_CompactsOnceBiggerThanText) {
+    CString path = MakeTempPath("/tmp/eib_genericdb_journal_compact_XXXXXX");
+    TestGenericDB db;
+    db.Init(path);
+    db.SetStorageOptions(GENERIC_DB_JOURNAL);
+    ASSERT_TRUE(db.Load());
+    ASSERT_TRUE(db.AddRecord("a", MakeRecord("a", 0, "x")));
+    ASSERT_TRUE(db.Save());
+
+    size_t max_journal = 0;
+    for (int i = 1; i <= 3000; ++i) {
+        ASSERT_TRUE(db.EditRecord("a", MakeRecord("a", i, "x")));
+        ASSERT_TRUE(db.Save());
+        max_journal = std::max(max_journal, ReadFile(path + GENERIC_DB_JOURNAL_EXT).size());
+    }
+    EXPECT_LE(max_journal, (size_t)GENERIC_DB_JOURNAL_MIN_COMPACT);
+    EXPECT_NE(std::string::npos, ReadFile(path).find("value = "));
+
+    TestGenericDB loaded;
+    loaded.SetFileWithoutCreate(path);
+    loaded.SetStorageOptions(GENERIC_DB_JOURNAL);
+    ASSERT_TRUE(loaded.Load());
+    GenericRecord rec;
+    ASSERT_TRUE(loaded.GetRecord("a", rec));
+    EXPECT_EQ(3000, rec.value);
+
+    RemoveDB(path);
+}
+
+TEST_F(GenericDBTest, Journal_ClearIsJournaled) {
+    CString path = MakeTempPath("/tmp/eib_genericdb_journal_clear_XXXXXX");
+    TestGenericDB db;
+    db.Init(path);
+    db.SetStorageOptions(GENERIC_DB_JOURNAL);
+    ASSERT_TRUE(db.Load());
+    ASSERT_TRUE(db.AddRecord("a", MakeRecord("a", 1, "one")));
+    ASSERT_TRUE(db.AddRecord("b", MakeRecord("b", 2, "two")));
+    ASSERT_TRUE(db.Save());
+    db.Clear();
+    ASSERT_TRUE(db.AddRecord("c", MakeRecord("c", 3, "three")));
+    ASSERT_TRUE(db.Save());
+
+    TestGenericDB loaded;
+    loaded.SetFileWithoutCreate(path);
+    loaded.SetStorageOptions(GENERIC_DB_JOURNAL);
+    ASSERT_TRUE(loaded.Load());
+    EXPECT_EQ(1, loaded.GetNumOfRecords());
+    GenericRecord rec;
+    EXPECT_TRUE(loaded.GetRecord("c", rec));
+
+    RemoveDB(path);
+}
+
+TEST_F(GenericDBTest, Journal_DroppedWhenTextIsEditedByHand) {
+    CString path = MakeTempPath("/tmp/eib_genericdb_journal_edit_XXXXXX");
+    TestGenericDB db;
+    db.Init(path);
+    db.SetStorageOptions(GENERIC_DB_JOURNAL);
+    ASSERT_TRUE(db.Load());
+    ASSERT_TRUE(db.AddRecord("a", MakeRecord("a", 1, "one")));
+    ASSERT_TRUE(db.Save());
+    ASSERT_TRUE(db.AddRecord("b", MakeRecord("b", 2, "two")));
+    ASSERT_TRUE(db.Save());
+
+    WriteFile(path, "[z]\nvalue = 26\n");
+    TestGenericDB loaded;
+    loaded.SetFileWithoutCreate(path);
+    loaded.SetStorageOptions(GENERIC_DB_JOURNAL);
+    ASSERT_TRUE(loaded.Load());
+    EXPECT_EQ(1, loaded.GetNumOfRecords());
+    GenericRecord rec;
+    EXPECT_TRUE(loaded.GetRecord("z", rec));
+
+    RemoveDB(path);
+}
+
+TEST_F(GenericDBTest, Journal_RecordCutOffByCrashIsDropped) {
+    CString path = MakeTempPath("/tmp/eib_genericdb_journal_cut_XXXXXX");
+    TestGenericDB db;
+    db.Init(path);
+    db.SetStorageOptions(GENERIC_DB_JOURNAL);
+    ASSERT_TRUE(db.Load());
+    ASSERT_TRUE(db.Save());
+    ASSERT_TRUE(db.AddRecord("a", MakeRecord("a", 1, "one")));
+    ASSERT_TRUE(db.Save());
+    ASSERT_TRUE(db.AddRecord("b", MakeRecord("b", 2, "two")));
+    ASSERT_TRUE(db.Save());
+
+    CString journal = path + GENERIC_DB_JOURNAL_EXT;
+    std::string data = ReadFile(journal);
+    WriteBinaryFile(journal, data.substr(0, data.size() - 2));
+
+    TestGenericDB loaded;
+    loaded.SetFileWithoutCreate(path);
+    loaded.SetStorageOptions(GENERIC_DB_JOURNAL);
+    ASSERT_TRUE(loaded.Load());
+    EXPECT_EQ(1, loaded.GetNumOfRecords());
+    GenericRecord rec;
+    EXPECT_TRUE(loaded.GetRecord("a", rec));
+
+    // the next save does not append behind the broken record
+    ASSERT_TRUE(loaded.AddRecord("c", MakeRecord("c", 3, "three")));
+    ASSERT_TRUE(loaded.Save());
+    TestGenericDB reloaded;
+    reloaded.SetFileWithoutCreate(path);
+    reloaded.SetStorageOptions(GENERIC_DB_JOURNAL);
+    ASSERT_TRUE(reloaded.Load());
+    EXPECT_EQ(2, reloaded.GetNumOfRecords());
+    EXPECT_TRUE(reloaded.GetRecord("c", rec));
+
+    RemoveDB(path);
+}
+
+TEST_F(GenericDBTest, Journal_RecordCutAtEntryBoundaryIsDropped) {
+    CString path = MakeTempPath("/tmp/eib_genericdb_journal_boundary_XXXXXX");
+    TestGenericDB db;
+    db.Init(path);
+    db.SetStorageOptions(GENERIC_DB_JOURNAL);
+    ASSERT_TRUE(db.Load());
+    ASSERT_TRUE(db.Save());
+    ASSERT_TRUE(db.AddRecord("a", MakeRecord("a", 1, "one")));
+    ASSERT_TRUE(db.Save());
+    ASSERT_TRUE(db.AddRecord("b", MakeRecord("b", 2, "two")));
+    ASSERT_TRUE(db.Save());
+
+    // only the end marker of "b" is missing, every entry before it is whole
+    CString journal = path + GENERIC_DB_JOURNAL_EXT;
+    std::string data = ReadFile(journal);
+    ASSERT_EQ('E', data[data.size() - 1]);
+    WriteBinaryFile(journal, data.substr(0, data.size() - 1));
+
+    TestGenericDB loaded;
+    loaded.SetFileWithoutCreate(path);
+    loaded.SetStorageOptions(GENERIC_DB_JOURNAL);
+    ASSERT_TRUE(loaded.Load());
+    EXPECT_EQ(1, loaded.GetNumOfRecords());
+    GenericRecord rec;
+    EXPECT_FALSE(loaded.GetRecord("b", rec));
+
+    // the next save compacts instead of appending behind the open record
+    ASSERT_TRUE(loaded.AddRecord("c", MakeRecord("c", 3, "three")));
+    ASSERT_TRUE(loaded.Save());
+    EXPECT_NE(std::string::npos, ReadFile(path).find("[c]"));
+    TestGenericDB reloaded;
+    reloaded.SetFileWithoutCreate(path);
+    reloaded.SetStorageOptions(GENERIC_DB_JOURNAL);
+    ASSERT_TRUE(reloaded.Load());
+    EXPECT_EQ(2, reloaded.GetNumOfRecords());
+    EXPECT_TRUE(reloaded.GetRecord("a", rec));
+    EXPECT_TRUE(reloaded.GetRecord("c", rec));
+
+    RemoveDB(path);
+}
+
+TEST_F(GenericDBTest, Journal_SaveWithoutLoadRewritesText) {
+    CString path = MakeTempPath("/tmp/eib_genericdb_journal_noload_XXXXXX");
+    WriteFile(path, "[old]\nvalue = 1\n");
+    TestGenericDB db;
+    db.SetFileWithoutCreate(path);
+    db.SetStorageOptions(GENERIC_DB_JOURNAL);
+    ASSERT_TRUE(db.AddRecord("new", MakeRecord("new", 2, "two")));
+    ASSERT_TRUE(db.Save());
+
+    std::string text = ReadFile(path);
+    EXPECT_EQ(std::string::npos, text.find("[old]"));
+    EXPECT_NE(std::string::npos, text.find("[new]"));
+    RemoveDB(path);
+}
+
+// -----------------------------------------------------------------------
+// Hash index
+// -----------------------------------------------------------------------
+
+TEST_F(GenericDBTest, HashIndex_RoundTrip) {
+    CString path = MakeTempPath("/tmp/eib_genericdb_hash_XXXXXX");
+    HashedTestGenericDB db;
+    db.Init(path);
+    for (int i = 0; i < 100; ++i) {
+        CString key("rec");
+        key += i;
+        ASSERT_TRUE(db.AddRecord(key, MakeRecord(key.GetBuffer(), i, "x")));
+    }
+    ASSERT_TRUE(db.EditRecord("rec7", MakeRecord("rec7", 700, "y")));
+    ASSERT_TRUE(db.DeleteRecord("rec8"));
+    ASSERT_TRUE(db.Save());
+
+    HashedTestGenericDB loaded;
+    loaded.SetFileWithoutCreate(path);
+    ASSERT_TRUE(loaded.Load());
+    EXPECT_EQ(99, loaded.GetNumOfRecords());
+    GenericRecord rec;
+    ASSERT_TRUE(loaded.GetRecord("rec7", rec));
+    EXPECT_EQ(700, rec.value);
+    EXPECT_FALSE(loaded.GetRecord("rec8", rec));
+    ASSERT_TRUE(loaded.GetRecord("rec99", rec));
+    EXPECT_EQ(99, rec.value);
+
+    RemoveDB(path);
+}
@@ -9,6 +9,8 @@
 #include "DescriptionRequest.h"
 #include "SearchRequest.h"
 #include "TunnelAck.h"
+#include "RoutingBusy.h"
+#include "RoutingLostMessage.h"
 #include "HPAI.h"
 #include "CRI_CRD.h"
 #include "../fixtures/TestHelpers.h"
@@ -161,3 +163,37 @@ TEST_F(ProtocolPacketRoundTripTest, TunnelingAck_RoundTripPreservesStatusAndSequ
     EXPECT_EQ(E_NO_ERROR, parsed.GetStatus());
     EXPECT_STREQ("No error", parsed.GetStatusString().GetBuffer());
 }
+
+TEST_F(ProtocolPacketRoundTripTest, RoutingBusy_RoundTripUsesNetworkByteOrder) {
+    CRoutingBusy busy(0x01, 0x0164, 0);
+    std::vector<unsigned char> raw = Serialize(busy);
+
+    ASSERT_EQ(HEADER_SIZE_10 + 6, static_cast<int>(raw.size()));
+    EXPECT_EQ(0x05, raw[2]);
+    EXPECT_EQ(0x32, raw[3]);
+    EXPECT_EQ(6, raw[6]);
+    EXPECT_EQ(0x01, raw[8]);
+    EXPECT_EQ(0x64, raw[9]);
+
+    unsigned char* ptr = raw.data();
+    CRoutingBusy parsed(ptr);
+
+    EXPECT_EQ(0x01, parsed.GetDeviceState());
+    EXPECT_EQ(0x0164, parsed.GetWaitTime());
+    EXPECT_EQ(0, parsed.GetControl());
+}
+
+TEST_F(ProtocolPacketRoundTripTest, RoutingLostMessage_RoundTripPreservesCount) {
+    CRoutingLostMessage lost(0x00, 300);
+    std::vector<unsigned char> raw = Serialize(lost);
+
+    ASSERT_EQ(HEADER_SIZE_10 + 4, static_cast<int>(raw.size()));
+    EXPECT_EQ(0x05, raw[2]);
+    EXPECT_EQ(0x31, raw[3]);
+
+    unsigned char* ptr = raw.data();
+    CRoutingLostMessage parsed(ptr);
+
+    EXPECT_EQ(0x00, parsed.GetDeviceState());
+    EXPECT_EQ(300, parsed.GetLostMessages());
+}
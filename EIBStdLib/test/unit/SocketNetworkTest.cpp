@@ -155,6 +155,36 @@ TEST_F(SocketNetworkTest, UdpRecvFrom_TimeoutReturnsZero) {
     }
 }
 
+TEST_F(SocketNetworkTest, UdpRecvFrom_ReportsReceiveTimeStamp) {
+    try {
+        UDPSocket receiver("127.0.0.1", 0);
+        int receiver_port = receiver.GetLocalPort();
+        receiver.EnableReceiveTimeStamps();
+
+        UDPSocket sender;
+        CTimeStamp before = CTimeStamp::Now();
+        sender.SendTo("hi", 2, "127.0.0.1", receiver_port);
+
+        char recv_buf[8] = {0};
+        CString source_address;
+        int source_port = 0;
+        CTimeStamp stamp;
+
+        int got = receiver.RecvFrom(recv_buf, sizeof(recv_buf), source_address, source_port, 1000, stamp);
+        ASSERT_EQ(2, got);
+        EXPECT_FALSE(stamp.IsZero());
+        // the kernel stamp is converted from the real time clock, allow for rounding
+        EXPECT_GE(stamp - before, -1000000);
+        EXPECT_LE(stamp - CTimeStamp::Now(), 0);
+        EXPECT_EQ(0, receiver.RecvFrom(recv_buf, sizeof(recv_buf), source_address, source_port, 20, stamp));
+    } catch (const SocketException& ex) {
+        if (IsPermissionRestricted(ex)) {
+            GTEST_SKIP() << "Socket operations restricted in this environment: " << ex.what();
+        }
+        throw;
+    }
+}
+
 TEST_F(SocketNetworkTest, ResolveService_NumericStringReturnsPortValue) {
     EXPECT_EQ(3671, Socket::ResolveService("3671"));
 }
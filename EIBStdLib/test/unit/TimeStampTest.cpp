@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include "TimeStamp.h"
+#include "StatsDB.h"
+#include "CCemi_L_Data_Frame.h"
+#include "../fixtures/TestHelpers.h"
+#include <chrono>
+#include <thread>
+
+using namespace EIBStdLibTest;
+
+class TimeStampTest : public BaseTestFixture {};
+
+TEST_F(TimeStampTest, DefaultIsZero) {
+    CTimeStamp ts;
+    EXPECT_TRUE(ts.IsZero());
+    EXPECT_EQ(0, ts.GetMonotonicNs());
+    EXPECT_EQ(0, ts.GetWallNs());
+}
+
+TEST_F(TimeStampTest, NowIsMonotonicAndMatchesWallClock) {
+    CTimeStamp t1 = CTimeStamp::Now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    CTimeStamp t2 = CTimeStamp::Now();
+
+    EXPECT_FALSE(t1.IsZero());
+    EXPECT_GE(t2 - t1, 5 * NSEC_PER_MSEC);
+    EXPECT_TRUE(t1 < t2);
+    EXPECT_GE(t1.ElapsedNs(), t2 - t1);
+    EXPECT_LE(std::abs((long long)(t1.GetSeconds() - time(NULL))), 1);
+    EXPECT_EQ(t1.GetSeconds(), t1.ToCTime().GetTime());
+}
+
+TEST_F(TimeStampTest, CachedClockIsCloseToPreciseClock) {
+    CTimeStamp precise = CTimeStamp::Now();
+    CTimeStamp cached = CTimeStamp::NowCached();
+    // the coarse clocks lag by at most a scheduler tick
+    EXPECT_LT(std::abs((long long)(precise - cached)), 50 * NSEC_PER_MSEC);
+    EXPECT_LT(std::abs((long long)(precise.GetWallNs() - cached.GetWallNs())), 50 * NSEC_PER_MSEC);
+}
+
+TEST_F(TimeStampTest, FromWallTimeDerivesMonotonicReading) {
+    CTimeStamp now = CTimeStamp::Now();
+    CTimeStamp earlier = CTimeStamp::FromWallTime(now.GetWallNs() - 20 * NSEC_PER_MSEC);
+    EXPECT_EQ(now.GetWallNs() - 20 * NSEC_PER_MSEC, earlier.GetWallNs());
+    EXPECT_NEAR((double)(now - earlier), (double)(20 * NSEC_PER_MSEC), (double)(5 * NSEC_PER_MSEC));
+}
+
+TEST_F(TimeStampTest, FrameCopiesCarryTimeStamp) {
+    unsigned char data[] = {0x80};
+    CCemi_L_Data_Frame frame(L_DATA_IND, CEibAddress("1.1.1"), CEibAddress("1/1/1"), data, 1);
+    EXPECT_TRUE(frame.GetTimeStamp().IsZero());
+
+    CTimeStamp ts(123, 456);
+    frame.SetTimeStamp(ts);
+    CCemi_L_Data_Frame copy(frame);
+    EXPECT_EQ(123, copy.GetTimeStamp().GetMonotonicNs());
+    CCemi_L_Data_Frame assigned;
+    assigned = frame;
+    EXPECT_EQ(456, assigned.GetTimeStamp().GetWallNs());
+}
+
+TEST_F(TimeStampTest, StatsDBKeepsRecordTimesAndGap) {
+    CStatsDB db;
+    unsigned char value[] = {0x01};
+    CEibAddress addr("1/2/3");
+    CTimeStamp first(10 * NSEC_PER_SEC, 1700000000LL * NSEC_PER_SEC);
+    CTimeStamp second(10 * NSEC_PER_SEC + 2500000, 1700000000LL * NSEC_PER_SEC + 2500000);
+
+    db.AddRecord(addr, value, 1, first);
+    EXPECT_EQ(0, db.GetLastGapNs());
+    db.AddRecord(addr, value, 1, second);
+    EXPECT_EQ(2500000, db.GetLastGapNs());
+    EXPECT_TRUE(db.GetLastTimeStamp() == second);
+
+    CEIBObjectRecord rec;
+    ASSERT_TRUE(db.GetRecord(addr, rec));
+    ASSERT_EQ(2, rec.GetNumRecords());
+    EXPECT_TRUE(rec.GetHistory().front().GetTimeStamp() == second);
+    EXPECT_EQ((time_t)1700000000, rec.GetHistory().front().GetTime().GetTime());
+}
+
+TEST_F(TimeStampTest, FormatISO8601WithMilliseconds) {
+    CTimeStamp ts(1, 966888449042000000LL);
+    EXPECT_EQ(966888449042LL, ts.GetEpochMs());
+    EXPECT_STREQ("2000-08-21T20:07:29.042Z", ts.FormatISO8601().GetBuffer());
+}
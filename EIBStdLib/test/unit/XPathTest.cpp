@@ -0,0 +1,199 @@
+// XPathTest.cpp -- Tests for TinyXPath evaluation through compiled
+// programs and the expression cache.
+
+#include <gtest/gtest.h>
+#include "xml/xpath_static.h"
+#include "xml/xpath_program.h"
+#include "../fixtures/TestHelpers.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace EIBStdLibTest;
+using namespace TinyXPath;
+
+namespace {
+
+const char* kConf =
+    "<?xml version=\"1.0\"?>"
+    "<Conf>"
+    "<Server name=\"eib\" port=\"50000\"><Log level=\"3\">log.txt</Log></Server>"
+    "<Users>"
+    "<User name=\"admin\" priority=\"1\"/>"
+    "<User name=\"guest\" priority=\"5\"/>"
+    "<User name=\"web\" priority=\"3\"/>"
+    "</Users>"
+    "</Conf>";
+
+const char* kOtherConf =
+    "<?xml version=\"1.0\"?>"
+    "<Conf>"
+    "<Server name=\"relay\" port=\"6720\"><Log level=\"1\">relay.txt</Log></Server>"
+    "<Users><User name=\"root\" priority=\"0\"/></Users>"
+    "</Conf>";
+
+} // namespace
+
+class XPathTest : public BaseTestFixture {
+protected:
+    void SetUp() override {
+        BaseTestFixture::SetUp();
+        doc.Parse(kConf);
+        ASSERT_FALSE(doc.Error());
+        other.Parse(kOtherConf);
+        ASSERT_FALSE(other.Error());
+    }
+
+    TiXmlDocument doc;
+    TiXmlDocument other;
+};
+
+// -----------------------------------------------------------------------
+// Compiled programs
+// -----------------------------------------------------------------------
+
+TEST_F(XPathTest, CompiledProgramMatchesStringExpression) {
+    const char* exprs[] = {
+        "/Conf/Server/@name",
+        "/Conf/Server/Log/text()",
+        "count(//User)",
+        "//User[@priority=5]/@name",
+        "sum(//User/@priority)",
+        "concat(/Conf/Server/@name,':',/Conf/Server/@port)",
+    };
+    for (const char* expr : exprs) {
+        xpath_program_ptr prog = xpath_program::xpp_compile(expr);
+        ASSERT_EQ(xpath_program::e_no_error, prog->e_error) << expr;
+        EXPECT_STREQ(S_xpath_string(doc.RootElement(), expr).c_str(),
+                     S_xpath_string(doc.RootElement(), prog).c_str()) << expr;
+    }
+}
+
+TEST_F(XPathTest, CompiledProgramTypedResults) {
+    EXPECT_EQ(3, i_xpath_int(doc.RootElement(), xpath_program::xpp_compile("count(//User)")));
+    EXPECT_DOUBLE_EQ(9.0, d_xpath_double(doc.RootElement(), xpath_program::xpp_compile("sum(//User/@priority)")));
+    EXPECT_TRUE(o_xpath_bool(doc.RootElement(), xpath_program::xpp_compile("/Conf/Server/@port = 50000")));
+
+    TiXmlNode* node = XNp_xpath_node(doc.RootElement(), xpath_program::xpp_compile("//User[@name='web']"));
+    ASSERT_NE(nullptr, node);
+    EXPECT_STREQ("3", node->ToElement()->Attribute("priority"));
+
+    TiXmlAttribute* attr = XAp_xpath_attribute(doc.RootElement(), xpath_program::xpp_compile("/Conf/Server/@port"));
+    ASSERT_NE(nullptr, attr);
+    EXPECT_STREQ("50000", attr->Value());
+}
+
+TEST_F(XPathTest, NoMatchReturnsNull) {
+    xpath_program_ptr prog = xpath_program::xpp_compile("//Missing");
+    EXPECT_EQ(nullptr, XNp_xpath_node(doc.RootElement(), prog));
+}
+
+TEST_F(XPathTest, ProgramIsReusedAcrossDocuments) {
+    xpath_program_ptr prog = xpath_program::xpp_compile("/Conf/Server/Log/text()");
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_STREQ("log.txt", S_xpath_string(doc.RootElement(), prog).c_str());
+        EXPECT_STREQ("relay.txt", S_xpath_string(other.RootElement(), prog).c_str());
+    }
+}
+
+TEST_F(XPathTest, ProcessorEvaluatesTwice) {
+    xpath_processor proc(doc.RootElement(), xpath_program::xpp_compile("count(//User)"));
+    EXPECT_EQ(3, proc.i_compute_xpath());
+    EXPECT_EQ(3, proc.i_compute_xpath());
+}
+
+TEST_F(XPathTest, SyntaxErrorIsReported) {
+    xpath_program_ptr prog = xpath_program::xpp_compile("1 +");
+    EXPECT_NE(xpath_program::e_no_error, prog->e_error);
+
+    xpath_processor proc(doc.RootElement(), prog);
+    proc.S_compute_xpath();
+    EXPECT_NE(xpath_processor::e_no_error, proc.e_error);
+
+    TIXML_STRING res;
+    EXPECT_FALSE(o_xpath_string(doc.RootElement(), "1 +", res));
+}
+
+TEST_F(XPathTest, SharedProgramAcrossThreads) {
+    xpath_program_ptr prog = xpath_program::xpp_compile("//User[@priority=3]/@name");
+    std::vector<std::thread> threads;
+    std::vector<int> failures(4, 0);
+    for (int t = 0; t < 4; ++t) {
+        threads.push_back(std::thread([&, t]() {
+            TiXmlDocument local;
+            local.Parse(kConf);
+            for (int i = 0; i < 200; ++i) {
+                if (S_xpath_string(local.RootElement(), prog) != "web")
+                    failures[t]++;
+            }
+        }));
+    }
+    for (std::thread& th : threads)
+        th.join();
+    for (int t = 0; t < 4; ++t)
+        EXPECT_EQ(0, failures[t]);
+}
+
+// -----------------------------------------------------------------------
+// Cache
+// -----------------------------------------------------------------------
+
+TEST_F(XPathTest, CacheHitsAndMisses) {
+    xpath_program_cache cache(4);
+    xpath_program_ptr p1 = cache.xpp_get("/Conf/Server/@name");
+    xpath_program_ptr p2 = cache.xpp_get("/Conf/Server/@name");
+    EXPECT_EQ(p1.get(), p2.get());
+    EXPECT_EQ(1u, cache.ul_get_misses());
+    EXPECT_EQ(1u, cache.ul_get_hits());
+    EXPECT_EQ(1u, cache.u_get_size());
+    EXPECT_STREQ("/Conf/Server/@name", p1->S_get_expression().c_str());
+}
+
+TEST_F(XPathTest, CacheEvictsLeastRecentlyUsed) {
+    xpath_program_cache cache(2);
+    xpath_program_ptr a = cache.xpp_get("/a");
+    cache.xpp_get("/b");
+    cache.xpp_get("/a");        // /b is now the oldest
+    cache.xpp_get("/c");        // evicts /b
+    EXPECT_EQ(2u, cache.u_get_size());
+    EXPECT_EQ(a.get(), cache.xpp_get("/a").get());
+    unsigned long misses = cache.ul_get_misses();
+    cache.xpp_get("/b");
+    EXPECT_EQ(misses + 1, cache.ul_get_misses());
+}
+
+TEST_F(XPathTest, CacheShrinkAndDisable) {
+    xpath_program_cache cache(8);
+    cache.xpp_get("/a");
+    cache.xpp_get("/b");
+    cache.xpp_get("/c");
+    cache.v_set_capacity(1);
+    EXPECT_EQ(1u, cache.u_get_size());
+
+    cache.v_set_capacity(0);
+    EXPECT_EQ(0u, cache.u_get_size());
+    xpath_program_ptr p1 = cache.xpp_get("/a");
+    xpath_program_ptr p2 = cache.xpp_get("/a");
+    EXPECT_NE(p1.get(), p2.get());
+    EXPECT_EQ(0u, cache.u_get_size());
+
+    cache.v_clear();
+    EXPECT_EQ(0u, cache.ul_get_hits());
+    EXPECT_EQ(0u, cache.ul_get_misses());
+}
+
+TEST_F(XPathTest, EvictedProgramStaysValid) {
+    xpath_program_cache cache(1);
+    xpath_program_ptr prog = cache.xpp_get("count(//User)");
+    cache.xpp_get("/Conf");
+    EXPECT_EQ(1u, cache.u_get_size());
+    EXPECT_EQ(3, i_xpath_int(doc.RootElement(), prog));
+}
+
+TEST_F(XPathTest, StringExpressionsGoThroughGlobalCache) {
+    xpath_program_cache& cache = xpath_program_cache::xpc_get_global();
+    unsigned long hits = cache.ul_get_hits();
+    S_xpath_string(doc.RootElement(), "/Conf/Users/User[1]/@name");
+    EXPECT_STREQ("admin", S_xpath_string(doc.RootElement(), "/Conf/Users/User[1]/@name").c_str());
+    EXPECT_GT(cache.ul_get_hits(), hits);
+}
@@ -178,3 +178,161 @@ TEST_F(XmlParserTest, ParseMultipleSiblings) {
     EXPECT_STREQ("alice", first.FirstChildElement("Name").GetValue().GetBuffer());
     EXPECT_STREQ("admin", first.FirstChildElement("Role").GetValue().GetBuffer());
 }
+
+// -----------------------------------------------------------------------
+// Arena allocated documents
+// -----------------------------------------------------------------------
+
+namespace {
+
+std::string PrintDoc(const TiXmlDocument& doc) {
+    TiXmlPrinter printer;
+    doc.Accept(&printer);
+    return printer.CStr();
+}
+
+const char* kArenaXml =
+    "<?xml version=\"1.0\"?>"
+    "<Root><UserList>"
+    "<User id=\"1\" enabled=\"yes\"><Name>alice</Name><!-- admin --><Mask>0xFFFF</Mask></User>"
+    "<User id=\"2\"><Name>bob &amp; co</Name><Data><![CDATA[<raw>]]></Data></User>"
+    "</UserList></Root>";
+
+} // namespace
+
+TEST_F(XmlParserTest, ArenaDocumentMatchesHeapDocument) {
+    TiXmlDocument heap;
+    heap.Parse(kArenaXml);
+    ASSERT_FALSE(heap.Error());
+
+    TiXmlDocument arena;
+    arena.SetUseArena(true);
+    ASSERT_TRUE(arena.UseArena());
+    arena.Parse(kArenaXml);
+    ASSERT_FALSE(arena.Error());
+
+    EXPECT_EQ(PrintDoc(heap), PrintDoc(arena));
+    EXPECT_GT(arena.Arena()->BytesUsed(), 0u);
+    EXPECT_GE(arena.Arena()->BytesReserved(), arena.Arena()->BytesUsed());
+}
+
+TEST_F(XmlParserTest, ArenaDocumentCanBeModified) {
+    TiXmlDocument doc;
+    doc.SetUseArena(true);
+    doc.Parse(kArenaXml);
+    ASSERT_FALSE(doc.Error());
+
+    TiXmlElement* list = doc.RootElement()->FirstChildElement("UserList");
+    ASSERT_NE(list, nullptr);
+    TiXmlElement* alice = list->FirstChildElement("User");
+    ASSERT_NE(alice, nullptr);
+    TiXmlElement* bob = alice->NextSiblingElement("User");
+    ASSERT_NE(bob, nullptr);
+
+    // Strings that live in the arena grow and shrink in place or in the arena
+    alice->SetAttribute("id", "a much longer identifier than the one parsed");
+    alice->SetValue("Administrator");
+    alice->RemoveAttribute("enabled");
+
+    // Nodes inserted from the heap are cloned into the arena
+    TiXmlElement extra("Extra");
+    extra.SetAttribute("k", 7);
+    ASSERT_NE(list->InsertEndChild(extra), nullptr);
+
+    // Removing a node only runs its destructor
+    ASSERT_TRUE(list->RemoveChild(bob));
+
+    std::string out = PrintDoc(doc);
+    EXPECT_NE(out.find("<Administrator id=\"a much longer identifier than the one parsed\">"), std::string::npos) << out;
+    EXPECT_EQ(out.find("enabled"), std::string::npos) << out;
+    EXPECT_EQ(out.find("bob"), std::string::npos) << out;
+    EXPECT_NE(out.find("<Extra k=\"7\" />"), std::string::npos) << out;
+}
+
+TEST_F(XmlParserTest, ArenaDocumentCopyOutlivesSource) {
+    std::string expected;
+    TiXmlDocument* copy = nullptr;
+    TiXmlDocument assigned;
+    {
+        TiXmlDocument doc;
+        doc.SetUseArena(true);
+        doc.Parse(kArenaXml);
+        expected = PrintDoc(doc);
+
+        copy = new TiXmlDocument(doc);
+        assigned = doc;
+    }
+    EXPECT_TRUE(copy->UseArena());
+    EXPECT_TRUE(assigned.UseArena());
+    EXPECT_EQ(expected, PrintDoc(*copy));
+    EXPECT_EQ(expected, PrintDoc(assigned));
+    delete copy;
+}
+
+TEST_F(XmlParserTest, ArenaReleasedOnReload) {
+    FILE* file = tmpfile();
+    ASSERT_NE(file, nullptr);
+    fputs(kArenaXml, file);
+
+    TiXmlDocument doc;
+    doc.SetUseArena(true);
+    ASSERT_TRUE(doc.LoadFile(file));
+    size_t used = doc.Arena()->BytesUsed();
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(doc.LoadFile(file));
+    }
+    fclose(file);
+
+    EXPECT_EQ(used, doc.Arena()->BytesUsed());
+    EXPECT_EQ(1, doc.Arena()->BlockCount());
+    EXPECT_NE(PrintDoc(doc).find("bob &amp; co"), std::string::npos);
+}
+
+TEST_F(XmlParserTest, ArenaErrorOutlivesReload) {
+    TiXmlDocument doc;
+    doc.SetUseArena(true);
+    doc.Parse("<Root><Open></Root>");
+    ASSERT_TRUE(doc.Error());
+    std::string desc = doc.ErrorDesc();
+
+    doc.Clear();
+    doc.Arena()->Reset();
+    EXPECT_EQ(desc, doc.ErrorDesc());
+}
+
+TEST_F(XmlParserTest, ArenaLargeValues) {
+    std::string big(100000, 'x');
+    std::string xml = "<Root><Big>" + big + "</Big><Small>s</Small></Root>";
+
+    TiXmlDocument doc;
+    doc.SetUseArena(true);
+    doc.Parse(xml.c_str());
+    ASSERT_FALSE(doc.Error());
+
+    EXPECT_EQ(big, doc.RootElement()->FirstChildElement("Big")->GetText());
+    EXPECT_STREQ("s", doc.RootElement()->FirstChildElement("Small")->GetText());
+}
+
+TEST_F(XmlParserTest, CXmlDocumentBuildsInArena) {
+    CXmlDocument doc;
+    CXmlElement list = doc.RootElement().InsertChild("UserList");
+    for (int i = 0; i < 100; ++i) {
+        CXmlElement user = list.InsertChild("User");
+        user.InsertChild("Name").SetValue(CString("user") + CString(i));
+        user.InsertChild("Priviliges").SetValue(i);
+    }
+
+    CDataBuffer xml;
+    doc.ToString(xml);
+    CString text((const char*)xml.GetBuffer(), xml.GetLength());
+
+    CXmlDocument parsed(text);
+    CXmlElement user = parsed.RootElement().FirstChildElement("UserList").FirstChildElement("User");
+    int count = 0;
+    while (user.IsValid()) {
+        EXPECT_EQ(CString("user") + CString(count), user.FirstChildElement("Name").GetValue());
+        ++count;
+        user = user.NextSibling("User");
+    }
+    EXPECT_EQ(100, count);
+}
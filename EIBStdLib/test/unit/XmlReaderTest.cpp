@@ -0,0 +1,243 @@
+// XmlReaderTest.cpp -- Tests for CXmlReader, the pull parser that reads
+// a document without building a DOM.
+
+#include <gtest/gtest.h>
+#include "xml/XmlReader.h"
+#include "../fixtures/TestHelpers.h"
+#include <cstring>
+#include <string>
+
+using namespace EIBStdLibTest;
+
+class XmlReaderTest : public BaseTestFixture {
+protected:
+    // Reads the whole document and returns one line per event
+    static std::string Trace(CXmlReader& reader) {
+        std::string out;
+        for (;;) {
+            XmlReadResult res = reader.Read();
+            switch (res) {
+            case XML_READ_START_ELEMENT:
+                out += "<" + std::string(reader.GetName());
+                for (int i = 0; i < reader.GetAttributeCount(); ++i)
+                    out += " " + std::string(reader.GetAttributeName(i)) + "=" + reader.GetAttributeValue(i);
+                out += ">" + std::to_string(reader.GetDepth()) + "\n";
+                break;
+            case XML_READ_END_ELEMENT:
+                out += "</" + std::string(reader.GetName()) + ">" + std::to_string(reader.GetDepth()) + "\n";
+                break;
+            case XML_READ_TEXT:
+                out += "'" + std::string(reader.GetText()) + "'\n";
+                break;
+            case XML_READ_END:
+                return out;
+            default:
+                return out + "ERROR " + reader.GetError().GetBuffer();
+            }
+        }
+    }
+
+    static std::string Trace(const char* xml) {
+        CXmlReader reader(xml, (int)strlen(xml));
+        return Trace(reader);
+    }
+};
+
+// -----------------------------------------------------------------------
+// Events
+// -----------------------------------------------------------------------
+
+TEST_F(XmlReaderTest, ElementsTextAndAttributes) {
+    const char* xml =
+        "<?xml version=\"1.0\"?>\n"
+        "<Root>\n"
+        "  <User name=\"admin\" level='3'>\n"
+        "    <Password>secret</Password>\n"
+        "  </User>\n"
+        "  <Empty a=\"1\"/>\n"
+        "</Root>\n";
+
+    EXPECT_EQ("<Root>1\n"
+              "<User name=admin level=3>2\n"
+              "<Password>3\n"
+              "'secret'\n"
+              "</Password>3\n"
+              "</User>2\n"
+              "<Empty a=1>2\n"
+              "</Empty>2\n"
+              "</Root>1\n",
+              Trace(xml));
+}
+
+TEST_F(XmlReaderTest, EmptyElementFlag) {
+    const char* xml = "<a><b/><c></c></a>";
+    CXmlReader reader(xml, (int)strlen(xml));
+    ASSERT_EQ(XML_READ_START_ELEMENT, reader.Read());
+    ASSERT_EQ(XML_READ_START_ELEMENT, reader.Read());
+    EXPECT_TRUE(reader.IsEmptyElement());
+    ASSERT_EQ(XML_READ_END_ELEMENT, reader.Read());
+    EXPECT_TRUE(reader.IsName("b"));
+    ASSERT_EQ(XML_READ_START_ELEMENT, reader.Read());
+    EXPECT_FALSE(reader.IsEmptyElement());
+    ASSERT_EQ(XML_READ_END_ELEMENT, reader.Read());
+    ASSERT_EQ(XML_READ_END_ELEMENT, reader.Read());
+    EXPECT_EQ(XML_READ_END, reader.Read());
+    EXPECT_EQ(XML_READ_END, reader.Read());
+}
+
+TEST_F(XmlReaderTest, EntitiesAreDecoded) {
+    EXPECT_EQ("<a t=x<y&z>1\n'1 > 0 & \"ok\"'\n</a>1\n",
+              Trace("<a t=\"x&lt;y&amp;z\">1 &gt; 0 &amp; &quot;ok&quot;</a>"));
+}
+
+TEST_F(XmlReaderTest, WhiteSpaceIsCondensedLikeTheDom) {
+    const char* xml = "<a>  one\n   two  </a>";
+    TiXmlDocument doc;
+    doc.Parse(xml);
+    ASSERT_NE(nullptr, doc.RootElement());
+    const char* dom = doc.RootElement()->GetText();
+
+    CXmlReader reader(xml, (int)strlen(xml));
+    ASSERT_EQ(XML_READ_START_ELEMENT, reader.Read());
+    ASSERT_EQ(XML_READ_TEXT, reader.Read());
+    EXPECT_STREQ(dom, reader.GetText());
+    EXPECT_STREQ("one two", reader.GetText());
+}
+
+TEST_F(XmlReaderTest, CommentsDoctypeAndCData) {
+    EXPECT_EQ("<a>1\n'x<y'\n</a>1\n",
+              Trace("\xEF\xBB\xBF<!DOCTYPE a><!-- c --><a><!-- <b> --><![CDATA[x<y]]></a><!-- end -->"));
+}
+
+TEST_F(XmlReaderTest, GetAttribute) {
+    const char* xml = "<a x=\"1\" y=\"2\"/>";
+    CXmlReader reader(xml, (int)strlen(xml));
+    ASSERT_EQ(XML_READ_START_ELEMENT, reader.Read());
+    EXPECT_STREQ("2", reader.GetAttribute("y"));
+    EXPECT_EQ(nullptr, reader.GetAttribute("z"));
+}
+
+TEST_F(XmlReaderTest, QuotedGreaterThanInAttribute) {
+    EXPECT_EQ("<a expr=x > 1>1\n</a>1\n", Trace("<a expr=\"x > 1\"></a>"));
+}
+
+// -----------------------------------------------------------------------
+// Errors
+// -----------------------------------------------------------------------
+
+TEST_F(XmlReaderTest, MismatchedEndTag) {
+    std::string trace = Trace("<a><b></a>");
+    EXPECT_NE(std::string::npos, trace.find("ERROR Unexpected end tag at offset 6")) << trace;
+}
+
+TEST_F(XmlReaderTest, TruncatedDocument) {
+    EXPECT_NE(std::string::npos, Trace("<a><b>text").find("ERROR"));
+    EXPECT_NE(std::string::npos, Trace("<a><b").find("ERROR"));
+    EXPECT_NE(std::string::npos, Trace("").find("ERROR"));
+}
+
+TEST_F(XmlReaderTest, ErrorIsSticky) {
+    const char* xml = "<a></b><c/>";
+    CXmlReader reader(xml, (int)strlen(xml));
+    EXPECT_EQ(XML_READ_START_ELEMENT, reader.Read());
+    EXPECT_EQ(XML_READ_ERROR, reader.Read());
+    EXPECT_EQ(XML_READ_ERROR, reader.Read());
+}
+
+TEST_F(XmlReaderTest, JunkAfterRootIsIgnored) {
+    EXPECT_EQ("<a>1\n</a>1\n", Trace("<a></a> trailing"));
+}
+
+// -----------------------------------------------------------------------
+// Streaming
+// -----------------------------------------------------------------------
+
+TEST_F(XmlReaderTest, FeedOneByteAtATime) {
+    const char* xml =
+        "<?xml version=\"1.0\"?><!-- users --><Root><User name=\"a&amp;b\">"
+        "<![CDATA[raw]]><Mask>0xFFFF</Mask></User><Empty/></Root>";
+    std::string expected = Trace(xml);
+
+    CXmlReader reader;
+    std::string out;
+    size_t len = strlen(xml);
+    for (size_t i = 0; i < len; ++i) {
+        reader.Feed(xml + i, 1);
+        XmlReadResult res;
+        while ((res = reader.Read()) != XML_READ_MORE_DATA) {
+            ASSERT_NE(XML_READ_ERROR, res) << reader.GetError().GetBuffer();
+            if (res == XML_READ_START_ELEMENT)
+                out += "<" + std::string(reader.GetName());
+            else if (res == XML_READ_TEXT)
+                out += "'" + std::string(reader.GetText()) + "'";
+        }
+    }
+    reader.Finish();
+    while (reader.Read() == XML_READ_END_ELEMENT) {}
+    EXPECT_EQ(XML_READ_END, reader.Read());
+    EXPECT_EQ("<Root<User'raw'<Mask'0xFFFF'<Empty", out);
+    EXPECT_EQ("<Root>1\n<User name=a&b>2\n'raw'\n<Mask>3\n'0xFFFF'\n</Mask>3\n</User>2\n<Empty>2\n</Empty>2\n</Root>1\n",
+              expected);
+}
+
+namespace {
+
+class CountingHandler : public CXmlReaderHandler {
+public:
+    CountingHandler() : users(0), max_depth(0) {}
+    virtual void OnStartElement(const CXmlReader& reader) {
+        if (reader.IsName("User"))
+            ++users;
+        if (reader.GetDepth() > max_depth)
+            max_depth = reader.GetDepth();
+    }
+    virtual void OnText(const CXmlReader& reader) { last_text = reader.GetText(); }
+
+    int users;
+    int max_depth;
+    std::string last_text;
+};
+
+} // namespace
+
+TEST_F(XmlReaderTest, DispatchLargeDocument) {
+    std::string xml = "<Root><Users>";
+    for (int i = 0; i < 5000; ++i)
+        xml += "<User><Name>user" + std::to_string(i) + "</Name></User>";
+    xml += "</Users></Root>";
+
+    CountingHandler handler;
+    CXmlReader reader(xml.c_str(), (int)xml.length());
+    EXPECT_EQ(XML_READ_END, reader.Dispatch(handler));
+    EXPECT_EQ(5000, handler.users);
+    EXPECT_EQ(4, handler.max_depth);
+    EXPECT_EQ("user4999", handler.last_text);
+}
+
+TEST_F(XmlReaderTest, DispatchFedInChunks) {
+    const char* xml = "<Root><User/><User>x</User><User/></Root>";
+    CountingHandler handler;
+    CXmlReader reader;
+    reader.Feed(xml, 10);
+    EXPECT_EQ(XML_READ_MORE_DATA, reader.Dispatch(handler));
+    reader.Feed(xml + 10, (int)strlen(xml) - 10);
+    reader.Finish();
+    EXPECT_EQ(XML_READ_END, reader.Dispatch(handler));
+    EXPECT_EQ(3, handler.users);
+}
+
+TEST_F(XmlReaderTest, ResetReadsAnotherDocument) {
+    CXmlReader reader;
+    reader.Feed("<a>", 3);
+    reader.Finish();
+    EXPECT_EQ(XML_READ_START_ELEMENT, reader.Read());
+    EXPECT_EQ(XML_READ_ERROR, reader.Read());
+
+    reader.Reset();
+    reader.Feed("<b/>", 4);
+    reader.Finish();
+    EXPECT_EQ(XML_READ_START_ELEMENT, reader.Read());
+    EXPECT_TRUE(reader.IsName("b"));
+    EXPECT_EQ(XML_READ_END_ELEMENT, reader.Read());
+    EXPECT_EQ(XML_READ_END, reader.Read());
+}
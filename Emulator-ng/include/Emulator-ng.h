@@ -10,6 +10,7 @@
 #include "EmulatorHandler.h"
 #include "EmulatorDB.h"
 #include "EmulatorCmd.h"
+#include "EmulatorScenario.h"
 
 using namespace std;
 
@@ -64,6 +65,16 @@ public:
 	
 	void InteractiveConf();
 
+	/*!
+	\brief Starts running a scenario file. a running scenario is stopped first
+	\fn bool RunScenario(const CString& file_name)
+	*/
+	bool RunScenario(const CString& file_name);
+	void StopScenario();
+	bool IsScenarioRunning();
+	int GetScenarioSentCount();
+	CString GetScenarioRecordFile();
+
 
 private:
 	static CEIBEmulator _instance;
@@ -71,6 +82,7 @@ private:
 	CLogFile _log;
 	CEmulatorHandler _handler;
 	CEmulatorDB _db;
+	CEmulatorScenarioHandle _scenario;
 };
 
 #endif
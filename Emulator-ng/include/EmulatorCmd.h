@@ -11,6 +11,8 @@ public:
 	static void PrintAvailableCmds();
 	static void HandleSendCommand();
 	static void HandleGenerateCommand();
+	static void HandleScenarioCommand();
+	static void HandleGroupTableCommand(bool export_table);
 };
 
 #endif
@@ -6,6 +6,7 @@
 #include "EIBAddress.h"
 #include "EmulatorConfig.h"
 #include "CCemi_L_Data_Frame.h"
+#include "EmulatorGroupTable.h"
 
 using namespace EibStack;
 
@@ -45,12 +46,20 @@ private:
 	char _val[MAX_EIB_VAL];
 };
 
+/*! \class CEmulatorDB
+	\brief Group entries of Emulator.db, kept in a dense CGroupObjectTable
+
+	The block file parser of CGenericDB is used to read Emulator.db only. The records themselves
+	live in the group object table, so the tunnel request path never walks the map.
+*/
 class CEmulatorDB : public CGenericDB<int,CGroupEntry>
 {
 public:
 	CEmulatorDB();
 	virtual ~CEmulatorDB();
 
+	virtual void Init(const CString& file_name);
+
 	virtual void OnReadParamComplete(CGroupEntry& current_record, const CString& param,const CString& value);
 	virtual void OnReadRecordComplete(CGroupEntry& current_record);
 	virtual void OnReadRecordNameComplete(CGroupEntry& current_record, const CString& record_name);
@@ -62,10 +71,22 @@ public:
 
 	bool GetGroupEntryByIndex(int index, CGroupEntry& ge);
 
+	/*!
+	\brief Merges a CSV or binary group table file into the database
+	\fn int LoadGroupTable(const CString& file_name)
+	\return number of group objects read
+	*/
+	int LoadGroupTable(const CString& file_name);
+	void SaveGroupTable(const CString& file_name) const { _table.SaveBinary(file_name); }
+
+	CGroupObjectTable& GetTable() { return _table; }
+	int GetNumOfRecords() const { return _table.GetCount(); }
+	bool IsEmpty() const { return _table.GetCount() == 0; }
+
 	void Print() const;
 
 private:
-
+	CGroupObjectTable _table;
 };
 
 #endif
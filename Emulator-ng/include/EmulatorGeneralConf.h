@@ -1,5 +1,6 @@
 CONF_ENTRY(int,EibPort,"EIB_PORT",3671)
 CONF_ENTRY(int,LogLevel,"LOG_LEVEL",3)
+CONF_ENTRY(int,MaxConnections,"MAX_CONNECTIONS",2)
 #ifdef WIN32
 CONF_ENTRY(int,ListenInterface,"LISTEN_INTERFACE",1)
 #elif defined(__APPLE__)
@@ -7,3 +8,17 @@ CONF_ENTRY(CString,ListenInterface,"LISTEN_INTERFACE","en0")
 #else
 CONF_ENTRY(CString,ListenInterface,"LISTEN_INTERFACE","eth0")
 #endif
+CONF_ENTRY(CString,GroupTableFile,"GROUP_TABLE_FILE","none")
+CONF_ENTRY(int,DeviceLatency,"DEVICE_LATENCY",0)
+CONF_ENTRY(int,DeviceJitter,"DEVICE_JITTER",0)
+CONF_ENTRY(int,ConfirmLoss,"CONFIRM_LOSS",0)
+CONF_ENTRY(int,ResponseLoss,"RESPONSE_LOSS",0)
+CONF_ENTRY(int,ImpairDrop,"IMPAIR_DROP",0)
+CONF_ENTRY(int,ImpairDuplicate,"IMPAIR_DUPLICATE",0)
+CONF_ENTRY(int,ImpairReorder,"IMPAIR_REORDER",0)
+CONF_ENTRY(int,ImpairReorderWindow,"IMPAIR_REORDER_WINDOW",0)
+CONF_ENTRY(int,ImpairAckSuppress,"IMPAIR_ACK_SUPPRESS",0)
+CONF_ENTRY(CString,ImpairDelay,"IMPAIR_DELAY","none")
+CONF_ENTRY(int,ImpairDelayMean,"IMPAIR_DELAY_MEAN",0)
+CONF_ENTRY(int,ImpairDelayJitter,"IMPAIR_DELAY_JITTER",0)
+CONF_ENTRY(int,ImpairSeed,"IMPAIR_SEED",0)
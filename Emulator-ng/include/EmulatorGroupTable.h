@@ -0,0 +1,90 @@
+#ifndef __EMULATOR_GROUP_TABLE_HEADER__
+#define __EMULATOR_GROUP_TABLE_HEADER__
+
+#include "CString.h"
+#include "EIBAddress.h"
+#include <vector>
+
+using namespace EibStack;
+
+#define GROUP_TABLE_SIZE	0x10000		//one slot per group address
+#define DEVICE_TABLE_SIZE	0x10000		//one slot per physical address
+#define GROUP_TABLE_MAGIC	"EMUG"
+#define GROUP_TABLE_VERSION	1
+#define GROUP_OBJECT_MAX_VAL 14
+
+/*! \struct CDeviceProfile
+	\brief Timing and loss model of an emulated device (by physical address)
+*/
+typedef struct
+{
+	unsigned short latency;		//ms before the device answers
+	unsigned short jitter;		//ms of random extra delay (0..jitter)
+	unsigned char confirm_loss;	//% of L_DATA_CON frames that are not sent
+	unsigned char response_loss;//% of read requests that are not answered
+}CDeviceProfile;
+
+/*! \struct CGroupObject
+	\brief Current value of a group address and the device that owns it
+*/
+typedef struct
+{
+	bool valid;
+	unsigned char len;
+	unsigned short phy;
+	char value[GROUP_OBJECT_MAX_VAL];
+}CGroupObject;
+
+/*! \class CGroupObjectTable
+	\brief Dense group object table indexed by the raw group address
+
+	Lookups on the tunnel request path are a single array access. The table can be filled from
+	Emulator.db, from a CSV export (group,phy,value[,latency,jitter,confirm_loss,response_loss])
+	or from the compact binary format written by SaveBinary().
+*/
+class CGroupObjectTable
+{
+public:
+	CGroupObjectTable();
+	virtual ~CGroupObjectTable();
+
+	/*!
+	\brief Profile of devices that are not listed in a table file
+	\fn void SetDefaultProfile(const CDeviceProfile& profile)
+	*/
+	void SetDefaultProfile(const CDeviceProfile& profile);
+
+	CGroupObject* Get(unsigned short group) { return _objects[group].valid ? &_objects[group] : NULL; }
+	const CGroupObject* Get(unsigned short group) const { return _objects[group].valid ? &_objects[group] : NULL; }
+	const CDeviceProfile& GetDevice(unsigned short phy) const { return _devices[phy]; }
+	int GetCount() const { return _count; }
+
+	//returns false if the group already exists
+	bool Add(unsigned short group, unsigned short phy, const char* value, int len);
+	//returns false if the group does not exist
+	bool Remove(unsigned short group);
+	void SetValue(CGroupObject* obj, const char* value, int len);
+	void SetDevice(unsigned short phy, const CDeviceProfile& profile);
+	//the device goes back to the default profile
+	void ResetDevice(unsigned short phy);
+	void Clear();
+
+	/*!
+	\brief Loads a CSV (.csv) or binary table file. existing objects with the same address are replaced
+	\fn int Load(const CString& file_name)
+	\return number of objects read
+	*/
+	int Load(const CString& file_name);
+	int LoadCSV(const CString& file_name);
+	int LoadBinary(const CString& file_name);
+	void SaveBinary(const CString& file_name) const;
+
+private:
+	std::vector<CGroupObject> _objects;
+	std::vector<CDeviceProfile> _devices;
+	std::vector<bool> _custom_device; //profile came from a table file
+	CDeviceProfile _default;
+	int _count;
+};
+
+#endif
@@ -5,9 +5,12 @@
 #include "JTC.h"
 #include "Socket.h"
 #include "EmulatorDB.h"
+#include "ConnectionTable.h"
+#include "EmulatorImpairment.h"
 #include <queue>
-
-#define MAX_CONNS 2
+#include <map>
+#include <random>
+#include <chrono>
 
 class CEmulatorInputHandler;
 class CRelayDataInputHandler;
@@ -28,13 +31,14 @@ public:
 	
 	void DisconnectClients();
 	void SendIndication(const CGroupEntry& ge);
+	void SendDelayed(const CCemi_L_Data_Frame& frame, int delay_ms);
 	bool HasConnectedClients() const;
+	CEmulatorImpairment& GetImpairment() { return *_impairment; }
 
 private:
 	typedef struct
 	{
 		bool		  is_connected;
-		unsigned char id;
 		unsigned char channelid;
 		unsigned char recv_sequence;
 		unsigned char send_sequence;
@@ -44,7 +48,7 @@ private:
 		CString _remote_data_addr;
 		int 	_remote_data_port;
 		JTCMonitor state_monitor;
-		CTime 	   _timeout;
+		time_t	   _timeout; //renewed by heartbeats. the connection table re-arms lazily
 	}ConnectionState;
 
 private:
@@ -64,6 +68,7 @@ public:
 		int GetLocalCtrlPort() const { return _local_port; }
 		const CString& GetLocalCtrlAddr() const { return _local_addr; }
 		void SetParent(CEmulatorHandler* relay) { _emulator = relay; }
+		UDPSocket& GetSocket() { return _sock; }
 
 		bool SendTunnelToClient(const CCemi_L_Data_Frame& frame, ConnectionState* s, bool wait4ack);
 		void DisconnectClient(ConnectionState* s);
@@ -77,6 +82,8 @@ public:
 		void HandleDisconnectResponse(unsigned char* buffer, int max_len);
 		void HandleTunnelAck(unsigned char* buffer, int max_len);
 		void HandleDescriptionRequest(unsigned char* buffer, int max_len);
+		//rolls the loss percentage of a device profile
+		bool Lost(int percent);
 
 	private:
 		CEmulatorHandler* _emulator;
@@ -84,6 +91,7 @@ public:
 		UDPSocket _sock;
 		CString _local_addr; //used for Control + Data channels
 		int _local_port; //used for Control + Data channels
+		std::mt19937 _prng; //loss and jitter rolls. used by this thread only
 	};
 
 	//This handler will be response of receiving data from the EIBServer and writing 
@@ -98,12 +106,15 @@ public:
 		void Close();
 		void SetParent(CEmulatorHandler* relay) { _emulator = relay; }
 		void EnqueueFrame(const CGroupEntry& ge);
+		//broadcasts a frame after the device latency
+		void EnqueueDelayed(const CCemi_L_Data_Frame& frame, int delay_ms);
 
 	private:
 		CEmulatorHandler* _emulator;
 		bool _stop;
 		JTCMonitor _mon;
 		queue<CGroupEntry> _q;
+		multimap<std::chrono::steady_clock::time_point, CCemi_L_Data_Frame> _delayed;
 	};
 
 	typedef JTCHandleT<CEmulatorHandler::CEmulatorInputHandler> CEmulatorInputHandlerHandle;
@@ -124,7 +135,9 @@ private:
 	CLogFile* _log_file;
 	CEmulatorInputHandlerHandle _input_handler;
 	CEmulatorOutputHandlerHandle _data_output_handler;
-	ConnectionState* _states[MAX_CONNS];
+	CEmulatorImpairmentHandle _impairment;
+	CConnectionTable<ConnectionState> _states; //guarded by this monitor
+	time_t _last_cleanup;
 };
 
 #endif
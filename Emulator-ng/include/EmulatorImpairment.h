@@ -0,0 +1,109 @@
+#ifndef __EMULATOR_IMPAIRMENT_HEADER__
+#define __EMULATOR_IMPAIRMENT_HEADER__
+
+#include "CString.h"
+#include "JTC.h"
+#include "Socket.h"
+#include <vector>
+#include <map>
+#include <deque>
+#include <random>
+#include <chrono>
+
+#define IMPAIRMENT_MAX_HOLD	2000	//ms a reordered datagram waits for later datagrams before it is released
+
+/*! \struct CImpairmentProfile
+	\brief Network impairments applied to the datagrams the emulator sends to its clients
+*/
+typedef struct
+{
+	int drop;				//% of tunnel requests that are never sent
+	int duplicate;			//% of tunnel requests that are sent twice
+	int reorder;			//% of tunnel requests that are held back
+	int reorder_window;		//number of later datagrams a held tunnel request is sent after
+	int ack_suppress;		//% of tunnel acks that are never sent
+	CString delay;			//delay distribution: none, constant, uniform, normal or exponential
+	int delay_mean;			//ms
+	int delay_jitter;		//ms. half width (uniform) or standard deviation (normal)
+	unsigned int seed;		//0 seeds the rolls from the clock
+}CImpairmentProfile;
+
+/*! \struct CImpairmentStats
+	\brief What the impairment stage did since the last profile change
+*/
+typedef struct
+{
+	int sent;
+	int dropped;
+	int duplicated;
+	int reordered;
+	int delayed;
+	int acks_suppressed;
+}CImpairmentStats;
+
+/*! \class CEmulatorImpairment
+	\brief Impairment stage between the emulator handlers and the UDP socket
+
+	Without an active profile datagrams are sent right away by the calling thread. Otherwise every
+	datagram is scheduled at its due time (now + sampled delay) and sent by this thread, so random
+	delays may reorder datagrams the way a real network does. Control channel messages do not go
+	through the stage.
+*/
+class CEmulatorImpairment : public JTCThread, public JTCMonitor
+{
+public:
+	CEmulatorImpairment();
+	virtual ~CEmulatorImpairment();
+
+	void Init(UDPSocket* sock);
+	virtual void run();
+	void Close();
+
+	/*!
+	\brief Replaces the active profile and resets the statistics. queued datagrams are kept
+	\fn void SetProfile(const CImpairmentProfile& profile)
+	*/
+	void SetProfile(const CImpairmentProfile& profile);
+	bool IsEnabled();
+	CImpairmentStats GetStats();
+
+	void SendTunnelRequest(const unsigned char* buffer, int len, const CString& addr, int port);
+	void SendAck(const unsigned char* buffer, int len, const CString& addr, int port);
+
+	static void ResetProfile(CImpairmentProfile& profile);
+
+private:
+	typedef struct
+	{
+		std::vector<unsigned char> data;
+		CString addr;
+		int port;
+	}Datagram;
+
+	typedef struct
+	{
+		Datagram datagram;
+		int remaining;		//later datagrams to wait for
+		std::chrono::steady_clock::time_point since;
+	}HeldDatagram;
+
+	void Send(const unsigned char* buffer, int len, const CString& addr, int port, bool is_ack);
+	void Schedule(const Datagram& d, const std::chrono::steady_clock::time_point& due);
+	void ReleaseHeld(bool all, const std::chrono::steady_clock::time_point& due);
+	bool Roll(int percent);
+	int SampleDelay();
+
+private:
+	bool _stop;
+	bool _enabled;
+	UDPSocket* _sock;
+	CImpairmentProfile _profile;
+	CImpairmentStats _stats;
+	std::mt19937 _prng;
+	std::multimap<std::chrono::steady_clock::time_point, Datagram> _scheduled;
+	std::deque<HeldDatagram> _held;
+};
+
+typedef JTCHandleT<CEmulatorImpairment> CEmulatorImpairmentHandle;
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef __EMULATOR_SCENARIO_HEADER__
+#define __EMULATOR_SCENARIO_HEADER__
+
+#include "CString.h"
+#include "GenericDB.h"
+#include "EIBAddress.h"
+#include "JTC.h"
+#include "EmulatorDB.h"
+#include <vector>
+#include <random>
+#include <chrono>
+#include <fstream>
+
+using namespace EibStack;
+
+#define SCENARIO_SETTINGS	"SCENARIO"	//block with the scenario wide settings (SEED, PHY)
+#define SCENARIO_SPIN_US	2000		//the last microseconds before a deadline are spun instead of slept
+#define SCENARIO_MAX_RATE	100000.0	//telegrams per second a single step may ask for
+
+/*! \class CScenarioStep
+	\brief One block of a scenario file: a traffic source with its own timing
+*/
+class CScenarioStep
+{
+public:
+	typedef enum
+	{
+		SCENE,		//bursts of COUNT group writes spread over SPREAD ms, every PERIOD ms
+		READ_STORM,	//like SCENE, with group read requests
+		STREAM,		//COUNT addresses, each sending RATE telegrams per second
+		DIURNAL,	//random addresses at a rate that follows a day curve (MIN_RATE..MAX_RATE) of PERIOD ms
+		UNKNOWN
+	}StepType;
+
+	CScenarioStep();
+	virtual ~CScenarioStep();
+
+	void Reset();
+	static StepType ParseType(const CString& type);
+	static const char* GetTypeName(StepType type);
+
+	CString _name;
+	StepType _type;
+	int _start;			//ms from the scenario start
+	int _duration;		//ms. 0 for a single SCENE/READ_STORM burst
+	int _period;		//ms between bursts / length of a day
+	int _spread;		//ms a burst is spread over
+	int _count;			//number of consecutive group addresses starting at _address
+	double _rate;
+	double _min_rate;
+	CEibAddress _address;
+	CEibAddress _phy;
+	bool _has_phy;
+	int _value_len;		//length of random values
+	short _fixed_len;	//length of VALUE, 0 for random values
+	char _value[MAX_EIB_VAL];
+};
+
+/*! \class CScenarioFile
+	\brief Parser of the declarative scenario file (same block format as Emulator.db)
+
+	[SCENARIO]
+	SEED = 42
+	PHY = 15.15.255
+
+	[lights]
+	TYPE = SCENE
+	START = 0
+	DURATION = 60000
+	PERIOD = 10000
+	ADDRESS = 1/0/0
+	COUNT = 20
+	SPREAD = 50
+*/
+class CScenarioFile : public CGenericDB<CString,CScenarioStep>
+{
+public:
+	CScenarioFile();
+	virtual ~CScenarioFile();
+
+	void Load(const CString& file_name);
+
+	virtual void OnReadParamComplete(CScenarioStep& current_record, const CString& param,const CString& value);
+	virtual void OnReadRecordComplete(CScenarioStep& current_record);
+	virtual void OnReadRecordNameComplete(CScenarioStep& current_record, const CString& record_name);
+	virtual void OnSaveRecordStarted(const CScenarioStep& record,CString& record_name, list<pair<CString, CString> >& param_values);
+
+	unsigned int GetSeed() const { return _seed; }
+	const CEibAddress& GetPhyAddress() const { return _phy; }
+	void GetSteps(std::vector<CScenarioStep>& steps) const;
+
+private:
+	unsigned int _seed;
+	CEibAddress _phy;
+};
+
+/*! \class CEmulatorScenario
+	\brief Runs a scenario file: sends the telegrams of all its steps at their exact offsets
+
+	Deadlines are absolute offsets from the scenario start (steady clock), so pacing errors do not
+	accumulate. Random addresses and values come from a PRNG seeded with SEED and are drawn in
+	deadline order, so two runs of the same file send the same telegrams at the same offsets.
+	Every telegram is recorded (scheduled and actual offset in microseconds) to a CSV file.
+*/
+class CEmulatorScenario : public JTCThread, public JTCMonitor
+{
+public:
+	CEmulatorScenario();
+	virtual ~CEmulatorScenario();
+
+	/*!
+	\brief Parses the scenario file and opens the record file
+	\fn void Init(const CString& file_name, const CString& record_file)
+	*/
+	void Init(const CString& file_name, const CString& record_file);
+	virtual void run();
+	void Close();
+
+	bool IsRunning();
+	int GetSentCount();
+	const CString& GetRecordFile() const { return _record_file; }
+
+private:
+	typedef struct
+	{
+		CScenarioStep step;
+		long long next;		//us from the scenario start. < 0 when the step is done
+		long long index;	//telegrams sent so far
+	}StepRunner;
+
+	void Schedule(StepRunner& r);
+	void Fire(StepRunner& r, long long scheduled, long long actual);
+	void WaitUntil(const std::chrono::steady_clock::time_point& deadline);
+	double DiurnalRate(const CScenarioStep& step, long long offset) const;
+	unsigned int Random(unsigned int range);
+
+private:
+	bool _stop;
+	bool _running;
+	int _sent;
+	std::vector<StepRunner> _runners;
+	std::mt19937 _prng;
+	CEibAddress _phy;
+	CString _record_file;
+	std::ofstream _record;
+	long long _max_late;
+	long long _total_late;
+};
+
+typedef JTCHandleT<CEmulatorScenario> CEmulatorScenarioHandle;
+
+#endif
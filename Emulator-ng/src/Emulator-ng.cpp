@@ -1,5 +1,6 @@
 #include "Emulator-ng.h"
 #include "cli.h"
+#include "Utils.h"
 
 static JTCInitialize s_jtc_init;
 CEIBEmulator CEIBEmulator::_instance;
@@ -27,6 +28,8 @@ void CEIBEmulator::Close()
 	LOG_INFO("Saving Configuration file...");
 	_conf.Save(EMULATOR_CONF_FILE_NAME);
 
+	StopScenario();
+
 	//close the heart beat thread
 	LOG_INFO("Closing Emulator module...");
 	_handler.Close();
@@ -74,6 +77,22 @@ bool CEIBEmulator::Init()
 		res = false;
 	END_CATCH
 
+	START_TRY
+		CDeviceProfile profile;
+		profile.latency = (unsigned short)_conf.GetDeviceLatency();
+		profile.jitter = (unsigned short)_conf.GetDeviceJitter();
+		profile.confirm_loss = (unsigned char)_conf.GetConfirmLoss();
+		profile.response_loss = (unsigned char)_conf.GetResponseLoss();
+		_db.GetTable().SetDefaultProfile(profile);
+		if(_conf.GetGroupTableFile() != "none"){
+			int count = _db.LoadGroupTable(_conf.GetGroupTableFile());
+			LOG_INFO("Loading group table %s (%d objects)...Successful.", _conf.GetGroupTableFile().GetBuffer(), count);
+		}
+	END_TRY_START_CATCH(e)
+		LOG_ERROR("Loading group table...Failed. Reason: %s",e.what());
+		res = false;
+	END_CATCH
+
 	START_TRY
 		_handler.Init(&_conf,&_log);
 		LOG_INFO("Initializing EIB Emulator handler...Successful.");
@@ -93,6 +112,55 @@ bool CEIBEmulator::Init()
 	return res;
 }
 
+bool CEIBEmulator::RunScenario(const CString& file_name)
+{
+	StopScenario();
+
+	//the time stamp has a one minute resolution. never overwrite the record of an earlier run
+	CString time_str;
+	CUtils::GetTimeStrForFile(time_str);
+	CString record_file = CURRENT_LOGS_FOLDER + "Scenario_" + time_str + ".csv";
+	for(int seq = 2; ifstream(record_file.GetBuffer()).is_open(); ++seq){
+		record_file = CURRENT_LOGS_FOLDER + "Scenario_" + time_str + "_" + CString(seq) + ".csv";
+	}
+	CEmulatorScenarioHandle scenario = new CEmulatorScenario();
+	START_TRY
+		scenario->Init(file_name, record_file);
+	END_TRY_START_CATCH(e)
+		LOG_ERROR("Cannot run scenario %s. Reason: %s", file_name.GetBuffer(), e.what());
+		return false;
+	END_CATCH
+
+	_scenario = scenario;
+	_scenario->start();
+	return true;
+}
+
+void CEIBEmulator::StopScenario()
+{
+	if(!_scenario){
+		return;
+	}
+	_scenario->Close();
+	_scenario->join();
+	_scenario = NULL;
+}
+
+bool CEIBEmulator::IsScenarioRunning()
+{
+	return _scenario && _scenario->IsRunning();
+}
+
+int CEIBEmulator::GetScenarioSentCount()
+{
+	return _scenario ? _scenario->GetSentCount() : 0;
+}
+
+CString CEIBEmulator::GetScenarioRecordFile()
+{
+	return _scenario ? _scenario->GetRecordFile() : EMPTY_STRING;
+}
+
 CEIBEmulator& CEIBEmulator::GetInstance()
 {
 	return _instance;
@@ -23,6 +23,10 @@ void CEmulatorCmd::PrintAvailableCmds()
 	LOG_SCREEN("s - Send indication to specific group\n");
 	LOG_SCREEN("g - Generate random indications\n");
 	LOG_SCREEN("d - Disconnect any connected client\n");
+	LOG_SCREEN("r - Run a load scenario file\n");
+	LOG_SCREEN("x - Stop the running scenario\n");
+	LOG_SCREEN("l - Load a group table file (CSV or binary)\n");
+	LOG_SCREEN("e - Export the group table to a binary file\n");
 }
 
 void CEmulatorCmd::StartLoop()
@@ -45,6 +49,12 @@ void CEmulatorCmd::StartLoop()
 			HandleGenerateCommand();
 		}else if (input == "d"){
 			CEIBEmulator::GetInstance().GetHandler().DisconnectClients();
+		}else if (input == "r"){
+			HandleScenarioCommand();
+		}else if (input == "x"){
+			CEIBEmulator::GetInstance().StopScenario();
+		}else if (input == "l" || input == "e"){
+			HandleGroupTableCommand(input == "e");
 		}else{
 			LOG_SCREEN("Unknown command. [Press '?' for list of available commands]\n");
 		}
@@ -109,6 +119,35 @@ void CEmulatorCmd::HandleGenerateCommand()
 	LOG_SCREEN("Sent %d random indication(s).\n", count);
 }
 
+void CEmulatorCmd::HandleScenarioCommand()
+{
+	CString file_name;
+	ConsoleCLI::GetCString("Scenario file: ", file_name, "Scenario.conf");
+	if(CEIBEmulator::GetInstance().RunScenario(file_name)){
+		LOG_SCREEN("Running scenario %s. Recording to %s\n", file_name.GetBuffer(),
+				   CEIBEmulator::GetInstance().GetScenarioRecordFile().GetBuffer());
+	}
+}
+
+void CEmulatorCmd::HandleGroupTableCommand(bool export_table)
+{
+	CEmulatorDB& db = CEIBEmulator::GetInstance().GetDB();
+	CString file_name;
+	START_TRY
+		if(export_table){
+			ConsoleCLI::GetCString("Binary file: ", file_name, "GroupTable.bin");
+			db.SaveGroupTable(file_name);
+			LOG_SCREEN("Exported %d group objects to %s\n", db.GetNumOfRecords(), file_name.GetBuffer());
+		}else{
+			ConsoleCLI::GetCString("Group table file: ", file_name, "GroupTable.csv");
+			int count = db.LoadGroupTable(file_name);
+			LOG_SCREEN("Loaded %d group objects from %s\n", count, file_name.GetBuffer());
+		}
+	END_TRY_START_CATCH(e)
+		LOG_ERROR("Group table error: %s", e.what());
+	END_CATCH
+}
+
 void CEmulatorCmd::HandleSendCommand()
 {
 	CEmulatorHandler& handler = CEIBEmulator::GetInstance().GetHandler();
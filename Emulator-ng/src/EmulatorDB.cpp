@@ -70,18 +70,32 @@ void CEmulatorDB::OnReadParamComplete(CGroupEntry& current_record, const CString
 	}
 }
 
+void CEmulatorDB::Init(const CString& file_name)
+{
+	CGenericDB<int,CGroupEntry>::Init(file_name);
+	//Emulator.db is only read. parse it once and start from Emulator.db.snap after that
+	SetStorageOptions(GENERIC_DB_SNAPSHOT);
+	_table.Clear();
+}
+
 void CEmulatorDB::OnReadRecordComplete(CGroupEntry& current_record)
 {
 	if(current_record.GetValueLen() == 0){
 		throw CEIBException(ConfigFileError,"Configuration file error. Group entry %s is missing value entry", current_record.GetAddress().ToString().GetBuffer());
 	}
-	if(!AddRecord(current_record.GetAddress().ToByteArray(), current_record)){
+	if(!_table.Add(current_record.GetAddress().ToByteArray(), current_record.GetPhyAddress().ToByteArray(),
+				   current_record.GetValue(), current_record.GetValueLen())){
 		throw CEIBException(ConfigFileError,"Configuration file error. Duplicate Group entry: %s", current_record.GetAddress().ToString().GetBuffer());
 	}
 
 	current_record.Reset();
 }
 
+int CEmulatorDB::LoadGroupTable(const CString& file_name)
+{
+	return _table.Load(file_name);
+}
+
 void CEmulatorDB::OnReadRecordNameComplete(CGroupEntry& current_record, const CString& record_name)
 {
 	START_TRY
@@ -101,20 +115,19 @@ void CEmulatorDB::OnSaveRecordStarted(const CGroupEntry& record,CString& record_
 
 void CEmulatorDB::SetValueForGroup(const CEibAddress& address, const CCemi_L_Data_Frame& cemi)
 {
-	map<int,CGroupEntry>::iterator it = _data.find(address.ToByteArray());
-	if(it == _data.end()){
+	CGroupObject* obj = _table.Get(address.ToByteArray());
+	if(obj == NULL){
 		return;
 	}
 	unsigned char apci = cemi.GetAPCI();
 	if(cemi.GetValueLength() > 1){
-		static unsigned char* data[MAX_EIB_VAL];
-		memcpy(&data[0], &apci, 1);
-		memcpy(&data[1], cemi.GetAddilData(), cemi.GetValueLength() - 1);
-		it->second.SetValue((const char*)data, cemi.GetValueLength());
-		it->second.SetValueLen(cemi.GetValueLength());
+		char data[MAX_EIB_VAL];
+		int len = cemi.GetValueLength() > MAX_EIB_VAL ? MAX_EIB_VAL : cemi.GetValueLength();
+		data[0] = (char)apci;
+		memcpy(&data[1], cemi.GetAddilData(), len - 1);
+		_table.SetValue(obj, data, len);
 	}else if(cemi.GetValueLength() == 1) {
-		it->second.SetValue((const char*)&apci, 1);
-		it->second.SetValueLen(1);
+		_table.SetValue(obj, (const char*)&apci, 1);
 	}else{
 		throw CEIBException(EibPacketError,"Packet is missing value");
 	}
@@ -123,12 +136,8 @@ void CEmulatorDB::SetValueForGroup(const CEibAddress& address, const CCemi_L_Dat
 const CEibAddress& CEmulatorDB::GetPhyForGroup(const CEibAddress& address)
 {
 	static CEibAddress phy((unsigned int)0, false);
-	map<int,CGroupEntry>::iterator it = _data.find(address.ToByteArray());
-	if(it == _data.end()){
-		phy.Set((unsigned int)0, false);
-		return phy;
-	}
-	phy.Set(it->second.GetPhyAddress().ToByteArray(), false);
+	CGroupObject* obj = _table.Get(address.ToByteArray());
+	phy.Set(obj == NULL ? 0 : obj->phy, false);
 	return phy;
 }
 
@@ -136,27 +145,33 @@ unsigned char* CEmulatorDB::GetValueForGroup(const CEibAddress& address, int& le
 {
 	static unsigned char current_value[MAX_EIB_VAL];
 
-	map<int,CGroupEntry>::iterator it = _data.find(address.ToByteArray());
-	if(it == _data.end()){
+	CGroupObject* obj = _table.Get(address.ToByteArray());
+	if(obj == NULL){
 		len = 0;
 		return NULL;
 	}
-	len = it->second.GetValueLen();
-	memcpy(current_value, it->second.GetValue(), len);
+	len = obj->len;
+	memcpy(current_value, obj->value, len);
 	return current_value;
 }
 
 bool CEmulatorDB::GetGroupEntryByIndex(int index, CGroupEntry& ge)
 {
-	if(index > (int)_data.size() || index < 0){
+	if(index > _table.GetCount() || index < 0){
 		return false;
 	}
-	map<int,CGroupEntry>::const_iterator it;
 	int i = 1;
-	for( it = _data.begin(); it != _data.end(); ++it)
+	for(int group = 0; group < GROUP_TABLE_SIZE; group++)
 	{
+		CGroupObject* obj = _table.Get(group);
+		if(obj == NULL){
+			continue;
+		}
 		if(index == i){
-			ge = it->second;
+			ge.SetAddress(CEibAddress((unsigned int)group, true));
+			ge.SetPhyAddress(CEibAddress((unsigned int)obj->phy, false));
+			ge.SetValue(obj->value, obj->len);
+			ge.SetValueLen(obj->len);
 			return true;
 		}
 		++i;
@@ -166,13 +181,21 @@ bool CEmulatorDB::GetGroupEntryByIndex(int index, CGroupEntry& ge)
 
 void CEmulatorDB::Print() const
 {
-	map<int,CGroupEntry>::const_iterator it;
+	CGroupEntry ge;
 	int i = 1;
 	LOG_SCREEN("---------------------------------------\n");
-	for( it = _data.begin(); it != _data.end(); ++it)
+	for(int group = 0; group < GROUP_TABLE_SIZE; group++)
 	{
+		const CGroupObject* obj = _table.Get(group);
+		if(obj == NULL){
+			continue;
+		}
+		ge.SetAddress(CEibAddress((unsigned int)group, true));
+		ge.SetPhyAddress(CEibAddress((unsigned int)obj->phy, false));
+		ge.SetValue(obj->value, obj->len);
+		ge.SetValueLen(obj->len);
 		LOG_SCREEN("%d. ", i++);
-		it->second.Print();
+		ge.Print();
 		LOG_SCREEN("\n");
 	}
 	LOG_SCREEN("---------------------------------------");
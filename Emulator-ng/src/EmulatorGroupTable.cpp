@@ -0,0 +1,279 @@
+#include "EmulatorGroupTable.h"
+#include "StringTokenizer.h"
+#include "CException.h"
+#include <fstream>
+#include <string.h>
+
+CGroupObjectTable::CGroupObjectTable() :
+_count(0)
+{
+	memset(&_default, 0, sizeof(_default));
+	Clear();
+}
+
+CGroupObjectTable::~CGroupObjectTable()
+{
+}
+
+void CGroupObjectTable::Clear()
+{
+	CGroupObject empty;
+	memset(&empty, 0, sizeof(empty));
+	_objects.assign(GROUP_TABLE_SIZE, empty);
+	_devices.assign(DEVICE_TABLE_SIZE, _default);
+	_custom_device.assign(DEVICE_TABLE_SIZE, false);
+	_count = 0;
+}
+
+void CGroupObjectTable::SetDefaultProfile(const CDeviceProfile& profile)
+{
+	_default = profile;
+	for(int i = 0; i < DEVICE_TABLE_SIZE; i++){
+		if(!_custom_device[i]){
+			_devices[i] = _default;
+		}
+	}
+}
+
+bool CGroupObjectTable::Add(unsigned short group, unsigned short phy, const char* value, int len)
+{
+	CGroupObject& obj = _objects[group];
+	if(obj.valid){
+		return false;
+	}
+	obj.valid = true;
+	obj.phy = phy;
+	SetValue(&obj, value, len);
+	_count++;
+	return true;
+}
+
+bool CGroupObjectTable::Remove(unsigned short group)
+{
+	CGroupObject& obj = _objects[group];
+	if(!obj.valid){
+		return false;
+	}
+	memset(&obj, 0, sizeof(obj));
+	_count--;
+	return true;
+}
+
+void CGroupObjectTable::SetValue(CGroupObject* obj, const char* value, int len)
+{
+	if(len > GROUP_OBJECT_MAX_VAL){
+		len = GROUP_OBJECT_MAX_VAL;
+	}
+	memcpy(obj->value, value, len);
+	obj->len = (unsigned char)len;
+}
+
+void CGroupObjectTable::SetDevice(unsigned short phy, const CDeviceProfile& profile)
+{
+	_devices[phy] = profile;
+	_custom_device[phy] = true;
+}
+
+void CGroupObjectTable::ResetDevice(unsigned short phy)
+{
+	_devices[phy] = _default;
+	_custom_device[phy] = false;
+}
+
+int CGroupObjectTable::Load(const CString& file_name)
+{
+	CString ext(file_name);
+	ext.ToLower();
+	if(ext.EndsWith(".csv")){
+		return LoadCSV(file_name);
+	}
+	return LoadBinary(file_name);
+}
+
+int CGroupObjectTable::LoadCSV(const CString& file_name)
+{
+	ifstream f(file_name.GetBuffer());
+	if(f.fail()){
+		throw CEIBException(FileError, "Group table file \"%s\" not found", file_name.GetBuffer());
+	}
+
+	CString line;
+	int line_num = 0, loaded = 0;
+	while(getline(f, line.GetSTDString()))
+	{
+		line_num++;
+		line.Trim();
+		line.Trim('\r');
+		//comments and the header line
+		if(line.IsEmpty() || line[0] < '0' || line[0] > '9'){
+			continue;
+		}
+
+		StringTokenizer tok(line, ",");
+		if(tok.CountTokens() < 3){
+			throw CEIBException(ConfigFileError, "Group table error in line %d: expected group,phy,value", line_num);
+		}
+		CString group_str = tok.NextToken();
+		CString phy_str = tok.NextToken();
+		CString value_str = tok.NextToken();
+		group_str.Trim();
+		phy_str.Trim();
+		value_str.Trim();
+
+		CEibAddress group(group_str);
+		CEibAddress phy(phy_str);
+		if(!group.IsGroupAddress() || phy.IsGroupAddress()){
+			throw CEIBException(ConfigFileError, "Group table error in line %d: wrong address type", line_num);
+		}
+		char value[GROUP_OBJECT_MAX_VAL];
+		int len = value_str.ToByteArray(value, sizeof(value));
+		if(len <= 0){
+			throw CEIBException(ConfigFileError, "Group table error in line %d: missing value", line_num);
+		}
+
+		CGroupObject& obj = _objects[group.ToByteArray()];
+		if(!obj.valid){
+			obj.valid = true;
+			_count++;
+		}
+		obj.phy = phy.ToByteArray();
+		SetValue(&obj, value, len);
+
+		if(tok.HasMoreTokens()){
+			CDeviceProfile profile = _default;
+			profile.latency = (unsigned short)tok.NextIntToken();
+			if(tok.HasMoreTokens()) profile.jitter = (unsigned short)tok.NextIntToken();
+			if(tok.HasMoreTokens()) profile.confirm_loss = (unsigned char)tok.NextIntToken();
+			if(tok.HasMoreTokens()) profile.response_loss = (unsigned char)tok.NextIntToken();
+			if(profile.confirm_loss > 100 || profile.response_loss > 100){
+				throw CEIBException(ConfigFileError, "Group table error in line %d: loss must be 0 - 100 %%", line_num);
+			}
+			SetDevice(obj.phy, profile);
+		}
+		loaded++;
+	}
+	return loaded;
+}
+
+static void WriteU16(ofstream& f, unsigned int v)
+{
+	f.put((char)(v & 0xFF));
+	f.put((char)((v >> 8) & 0xFF));
+}
+
+static void WriteU32(ofstream& f, unsigned int v)
+{
+	WriteU16(f, v & 0xFFFF);
+	WriteU16(f, v >> 16);
+}
+
+static unsigned int ReadU16(ifstream& f)
+{
+	unsigned char b[2] = { 0 };
+	f.read((char*)b, 2);
+	return b[0] | (b[1] << 8);
+}
+
+static unsigned int ReadU32(ifstream& f)
+{
+	unsigned int lo = ReadU16(f);
+	return lo | (ReadU16(f) << 16);
+}
+
+void CGroupObjectTable::SaveBinary(const CString& file_name) const
+{
+	ofstream f(file_name.GetBuffer(), ios::out | ios::binary | ios::trunc);
+	if(f.fail()){
+		throw CEIBException(FileError, "Cannot create group table file \"%s\"", file_name.GetBuffer());
+	}
+
+	//all numbers are little endian
+	f.write(GROUP_TABLE_MAGIC, 4);
+	f.put((char)GROUP_TABLE_VERSION);
+	WriteU32(f, _count);
+	for(int i = 0; i < GROUP_TABLE_SIZE; i++)
+	{
+		const CGroupObject& obj = _objects[i];
+		if(!obj.valid){
+			continue;
+		}
+		WriteU16(f, i);
+		WriteU16(f, obj.phy);
+		f.put((char)obj.len);
+		f.write(obj.value, obj.len);
+	}
+
+	int devices = 0;
+	for(int i = 0; i < DEVICE_TABLE_SIZE; i++){
+		if(_custom_device[i]) devices++;
+	}
+	WriteU32(f, devices);
+	for(int i = 0; i < DEVICE_TABLE_SIZE; i++)
+	{
+		if(!_custom_device[i]){
+			continue;
+		}
+		const CDeviceProfile& d = _devices[i];
+		WriteU16(f, i);
+		WriteU16(f, d.latency);
+		WriteU16(f, d.jitter);
+		f.put((char)d.confirm_loss);
+		f.put((char)d.response_loss);
+	}
+}
+
+int CGroupObjectTable::LoadBinary(const CString& file_name)
+{
+	ifstream f(file_name.GetBuffer(), ios::in | ios::binary);
+	if(f.fail()){
+		throw CEIBException(FileError, "Group table file \"%s\" not found", file_name.GetBuffer());
+	}
+
+	char magic[4];
+	f.read(magic, 4);
+	int version = f.get();
+	if(!f || memcmp(magic, GROUP_TABLE_MAGIC, 4) != 0 || version != GROUP_TABLE_VERSION){
+		throw CEIBException(ConfigFileError, "\"%s\" is not a group table file", file_name.GetBuffer());
+	}
+
+	unsigned int objects = ReadU32(f);
+	if(objects > GROUP_TABLE_SIZE){
+		throw CEIBException(ConfigFileError, "Corrupted group table file \"%s\"", file_name.GetBuffer());
+	}
+	for(unsigned int i = 0; i < objects; i++)
+	{
+		unsigned short group = (unsigned short)ReadU16(f);
+		unsigned short phy = (unsigned short)ReadU16(f);
+		int len = f.get();
+		char value[GROUP_OBJECT_MAX_VAL];
+		if(!f || len <= 0 || len > GROUP_OBJECT_MAX_VAL || !f.read(value, len)){
+			throw CEIBException(ConfigFileError, "Corrupted group table file \"%s\"", file_name.GetBuffer());
+		}
+		CGroupObject& obj = _objects[group];
+		if(!obj.valid){
+			obj.valid = true;
+			_count++;
+		}
+		obj.phy = phy;
+		SetValue(&obj, value, len);
+	}
+
+	unsigned int devices = ReadU32(f);
+	if(!f || devices > DEVICE_TABLE_SIZE){
+		throw CEIBException(ConfigFileError, "Corrupted group table file \"%s\"", file_name.GetBuffer());
+	}
+	for(unsigned int i = 0; i < devices; i++)
+	{
+		unsigned short phy = (unsigned short)ReadU16(f);
+		CDeviceProfile d;
+		d.latency = (unsigned short)ReadU16(f);
+		d.jitter = (unsigned short)ReadU16(f);
+		d.confirm_loss = (unsigned char)f.get();
+		d.response_loss = (unsigned char)f.get();
+		if(!f){
+			throw CEIBException(ConfigFileError, "Corrupted group table file \"%s\"", file_name.GetBuffer());
+		}
+		SetDevice(phy, d);
+	}
+	return (int)objects;
+}
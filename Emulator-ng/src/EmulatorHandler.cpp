@@ -15,23 +15,19 @@ using namespace EibStack;
 
 CEmulatorHandler::CEmulatorHandler() :
 _server_conf(NULL),
-_log_file(NULL)
+_log_file(NULL),
+_last_cleanup(0)
 {
 	_input_handler = new CEmulatorInputHandler();
 	_data_output_handler = new CEmulatorOutputHandler();
+	_impairment = new CEmulatorImpairment();
 
 	_input_handler->SetParent(this);
 	_data_output_handler->SetParent(this);
-	memset(_states, 0, sizeof(_states));
 }
 
 CEmulatorHandler::~CEmulatorHandler()
 {
-	for(int i = 0; i < MAX_CONNS; i++){
-		if(_states[i] != NULL){
-			delete _states[i];
-		}
-	}
 }
 
 void CEmulatorHandler::InitState(CEmulatorHandler::ConnectionState* s)
@@ -39,14 +35,12 @@ void CEmulatorHandler::InitState(CEmulatorHandler::ConnectionState* s)
 	if(s == NULL)
 		return;
 
-	s->id = 0;
 	s->is_connected = false;
 	s->channelid = 0;
 	s->recv_sequence = 0;
 	s->send_sequence = 0;
 	s->ack_received = false;
-	s->_timeout.SetNow();
-	s->_timeout += HEARTBEAT_REQUEST_TIME_OUT;
+	s->_timeout = time(NULL) + HEARTBEAT_REQUEST_TIME_OUT;
 }
 
 void CEmulatorHandler::SendIndication(const CGroupEntry& ge)
@@ -54,14 +48,14 @@ void CEmulatorHandler::SendIndication(const CGroupEntry& ge)
 	_data_output_handler->EnqueueFrame(ge);
 }
 
+void CEmulatorHandler::SendDelayed(const CCemi_L_Data_Frame& frame, int delay_ms)
+{
+	_data_output_handler->EnqueueDelayed(frame, delay_ms);
+}
+
 bool CEmulatorHandler::HasConnectedClients() const
 {
-	for(int i = 0; i < MAX_CONNS; i++){
-		if(_states[i] != NULL){
-			return true;
-		}
-	}
-	return false;
+	return _states.GetNumConnections() > 0;
 }
 
 void CEmulatorHandler::Init(CEmulatorConfig* server_conf, CLogFile* log_file)
@@ -69,7 +63,24 @@ void CEmulatorHandler::Init(CEmulatorConfig* server_conf, CLogFile* log_file)
 	_log_file = log_file;
 	_server_conf = server_conf;
 
+	_states.SetMaxConnections(_server_conf->GetMaxConnections());
 	_input_handler->Init();
+
+	CImpairmentProfile profile;
+	profile.drop = _server_conf->GetImpairDrop();
+	profile.duplicate = _server_conf->GetImpairDuplicate();
+	profile.reorder = _server_conf->GetImpairReorder();
+	profile.reorder_window = _server_conf->GetImpairReorderWindow();
+	profile.ack_suppress = _server_conf->GetImpairAckSuppress();
+	profile.delay = _server_conf->GetImpairDelay();
+	profile.delay_mean = _server_conf->GetImpairDelayMean();
+	profile.delay_jitter = _server_conf->GetImpairDelayJitter();
+	profile.seed = (unsigned int)_server_conf->GetImpairSeed();
+	_impairment->Init(&_input_handler->GetSocket());
+	_impairment->SetProfile(profile);
+	if(_impairment->IsEnabled()){
+		LOG_INFO("Network impairments are enabled.");
+	}
 }
 
 void CEmulatorHandler::Close()
@@ -80,6 +91,9 @@ void CEmulatorHandler::Close()
 	_data_output_handler->Close();
 	_data_output_handler->join();
 
+	_impairment->Close();
+	_impairment->join();
+
 	_input_handler->Close();
 	_input_handler->join();
 
@@ -89,16 +103,16 @@ void CEmulatorHandler::Close()
 	// during static destruction when JTC may no longer be valid.
 	_input_handler = NULL;
 	_data_output_handler = NULL;
+	_impairment = NULL;
 }
 
 void CEmulatorHandler::DisconnectClients()
 {
 	JTCSynchronized s(*this);
-	for(int i = 0; i < MAX_CONNS; i++)
+	const vector<unsigned char>& channels = _states.GetChannels();
+	for(unsigned int i = 0; i < channels.size(); i++)
 	{
-		if(_states[i] != NULL){
-			_input_handler->DisconnectClient(_states[i]);
-		}
+		_input_handler->DisconnectClient(_states.Get(channels[i]));
 	}
 }
 
@@ -106,21 +120,19 @@ void CEmulatorHandler::Start()
 {
 	_input_handler->start();
 	_data_output_handler->start();
+	_impairment->start();
 }
 
 void CEmulatorHandler::Broadcast(const CCemi_L_Data_Frame& frame)
 {
 	//lock this object so if cleanup occured it will wait
 	JTCSynchronized s(*this);
-	bool sent = false;
-	for(int i = 0; i < MAX_CONNS; i++)
+	const vector<unsigned char>& channels = _states.GetChannels();
+	for(unsigned int i = 0; i < channels.size(); i++)
 	{
-		if(_states[i] != NULL){
-			SendTunnelToClient(frame, _states[i], true);
-			sent = true;
-		}
+		SendTunnelToClient(frame, _states.Get(channels[i]), true);
 	}
-	if(!sent){
+	if(channels.empty()){
 		LOG_ERROR("\nNo client connected.");
 	}
 }
@@ -129,55 +141,48 @@ void CEmulatorHandler::CheckConnectionsCleanup()
 {
 	//lock this object so if broadcast occured it will wait
 	JTCSynchronized s(*this);
-	
-	//check if any connection has expired
-	for(int i = 0; i < MAX_CONNS; i++)
+
+	//timeouts have a one second resolution
+	time_t now = time(NULL);
+	if(now == _last_cleanup){
+		return;
+	}
+	_last_cleanup = now;
+
+	vector<unsigned char> expired;
+	_states.Expire(now, expired);
+	for(unsigned int i = 0; i < expired.size(); i++)
 	{
-		if(_states[i] != NULL && _states[i]->_timeout.SecondsTo() == 0){
-			// Connection timeout. force close connection
-			LOG_ERROR("[Connection timeout] Closing connection with client %d.", _states[i]->channelid);
-			FreeConnection(_states[i]);
+		ConnectionState* state = _states.Get(expired[i]);
+		if(state->_timeout > now){
+			//a heartbeat arrived since the timeout was armed
+			_states.SetTimeout(expired[i], state->_timeout);
+			continue;
 		}
+		// Connection timeout. force close connection
+		LOG_ERROR("[Connection timeout] Closing connection with client %d.", expired[i]);
+		FreeConnection(state);
 	}
 }
 
 CEmulatorHandler::ConnectionState* CEmulatorHandler::GetState(int channel)
 {
-	for(int i = 0; i < MAX_CONNS; i++)
-	{
-		if(_states[i] != NULL && channel == _states[i]->channelid){
-			return _states[i];
-		}
-	}
-	return NULL;	
+	return _states.Get(channel);
 }
 
 CEmulatorHandler::ConnectionState* CEmulatorHandler::AllocateNewState(const CString& source_ip, int sourc_port)
 {
-	CEmulatorHandler::ConnectionState* s = NULL;
-	for(int i = 0; i < MAX_CONNS; i++)
-	{
-		if(_states[i] == NULL){
-			//allocate memory
-			s = new CEmulatorHandler::ConnectionState();
-			InitState(s);
-			_states[i] = s;
-			//set the connection id
-			s->id = i;
-			srand((unsigned)time(0));
-			unsigned char channelid = 0;
-			do
-			{
-				//assign new channel id (make sure its unique)
-				channelid = rand() % 0xFF;
-			}while(GetState(channelid) != NULL);
-			s->channelid = channelid;
-			break;
-		}
-	}
+	JTCSynchronized sync(*this);
+
+	unsigned char channelid = 0;
+	CEmulatorHandler::ConnectionState* s = _states.Allocate(channelid);
 	if(s == NULL){
-		LOG_ERROR("Error: EIBEmulator is already connected to max number of clients.");
+		LOG_ERROR("Error: EIBEmulator is already connected to max number of clients (%d).", _states.GetMaxConnections());
+		return NULL;
 	}
+	InitState(s);
+	s->channelid = channelid;
+	_states.SetTimeout(channelid, s->_timeout);
 	return s;
 }
 
@@ -186,11 +191,10 @@ void CEmulatorHandler::FreeConnection(CEmulatorHandler::ConnectionState* s)
 	if(s == NULL){
 		return;
 	}
-	CEmulatorHandler::ConnectionState* ptr = GetState(s->channelid);
-	if(ptr != NULL){
-		int id = ptr->id;
-		_states[id] = NULL;
-		delete ptr;
+	JTCSynchronized sync(*this);
+	int id = s->channelid;
+	if(_states.Get(id) == s){
+		_states.Free(id);
 		LOG_DEBUG("Resources for Connection %d Cleaned successfuly.",id);
 	}
 }
@@ -202,7 +206,8 @@ JTCThread("CEmulatorInputHandler"),
 _emulator(NULL),
 _stop(false),
 _local_addr(EMPTY_STRING),
-_local_port(0)
+_local_port(0),
+_prng((unsigned int)time(NULL))
 {
 
 }
@@ -357,6 +362,7 @@ void CEmulatorHandler::CEmulatorInputHandler::HandleTunnelRequest(unsigned char*
 		bool send_con = false;
 		bool send_ind = false;
 		bool is_read_req = false;
+		int delay = 0;
 
 		{
 		JTCSynchronized sync(s->state_monitor);
@@ -368,6 +374,14 @@ void CEmulatorHandler::CEmulatorInputHandler::HandleTunnelRequest(unsigned char*
 			LOG_ERROR("[Received] [Tunnel Request] Error: Wrong channel id (sending error ack)");
 			return;
 		}
+		if((unsigned char)(req.GetSequenceNumber() + 1) == s->recv_sequence){
+			//repeated request (our ack was lost) -> ack it again and discard the frame
+			CTunnelingAck ack(s->channelid, req.GetSequenceNumber(), E_NO_ERROR);
+			ack.FillBuffer(buffer, max_len);
+			_emulator->GetImpairment().SendAck(buffer, ack.GetTotalSize(), s->_remote_data_addr, s->_remote_data_port);
+			LOG_DEBUG("[Received] [Tunnel Request] Repeated sequence %d (sending ack, ignoring frame)", req.GetSequenceNumber());
+			return;
+		}
 		if(req.GetSequenceNumber() != s->recv_sequence){
 			//wrong sequence number -> send error ack
 			CTunnelingAck ack(s->channelid, 0, E_SEQUENCE_NUMBER);
@@ -401,33 +415,38 @@ void CEmulatorHandler::CEmulatorInputHandler::HandleTunnelRequest(unsigned char*
 		s->recv_sequence++;
 		ack.FillBuffer(buffer, max_len);
 		//We send the ACK back over the Data channel (the channel that the request was received from)
-		_sock.SendTo(buffer, ack.GetTotalSize(), s->_remote_data_addr,s->_remote_data_port);
+		_emulator->GetImpairment().SendAck(buffer, ack.GetTotalSize(), s->_remote_data_addr,s->_remote_data_port);
 
 		//now we are going to check the contents of this tunnel request
 		//1. Is it read request
 		//2. Is it write request
 		const CCemi_L_Data_Frame& cemi = req.GetcEMI();
 		CEibAddress dst = cemi.GetDestAddress();
-		const CEibAddress& src = CEIBEmulator::GetInstance().GetDB().GetPhyForGroup(dst);
+		CGroupObjectTable& table = CEIBEmulator::GetInstance().GetDB().GetTable();
+		const CGroupObject* obj = table.Get(dst.ToByteArray());
+		CEibAddress src((unsigned int)(obj == NULL ? 0 : obj->phy), false);
+		const CDeviceProfile& device = table.GetDevice(src.ToByteArray());
 
 		con_frame = CCemi_L_Data_Frame(cemi);
 		con_frame.SetMessageControl(L_DATA_CON);
 		con_frame.SetDestAddress(dst);
 		con_frame.SetSrcAddress(src);
-		send_con = true;
+		send_con = !Lost(device.confirm_loss);
+		delay = device.latency;
+		if(device.jitter > 0){
+			delay += (int)(_prng() % (device.jitter + 1));
+		}
 
 		if(cemi.GetValueLength() == 1 && cemi.GetAPCI() == 0 && cemi.GetTPCI() == 0){
-			//this is group read request. we now look in the db
+			//this is group read request. the device answers with the current value of the object
 			is_read_req = true;
 
-			int len;
-			unsigned char* result = CEIBEmulator::GetInstance().GetDB().GetValueForGroup(dst, len);
-			if(len > 0 && result != NULL){
+			if(obj != NULL && !Lost(device.response_loss)){
 				ind_frame = CCemi_L_Data_Frame(L_DATA_IND,
 						src,
 						dst,
-						result,
-						len);
+						(const unsigned char*)obj->value,
+						obj->len);
 				ind_frame.SetAPCI(GROUP_RESPONSE | ind_frame.GetAPCI());
 				send_ind = true;
 			}
@@ -448,14 +467,22 @@ void CEmulatorHandler::CEmulatorInputHandler::HandleTunnelRequest(unsigned char*
 
 		} // release state_monitor before Broadcast to avoid deadlock
 
-		// Broadcast outside state_monitor lock
+		// Broadcast outside state_monitor lock. delayed answers are sent by the output handler
 		if(send_con){
 			LOG_DEBUG("[Send] [Frame Confirmation]");
-			_emulator->Broadcast(con_frame);
+			if(delay > 0){
+				_emulator->SendDelayed(con_frame, delay);
+			}else{
+				_emulator->Broadcast(con_frame);
+			}
 		}
 		if(send_ind){
 			LOG_DEBUG("[Send] [GROUP_RESPONE Indication] Value");
-			_emulator->Broadcast(ind_frame);
+			if(delay > 0){
+				_emulator->SendDelayed(ind_frame, delay);
+			}else{
+				_emulator->Broadcast(ind_frame);
+			}
 		}
 
 	END_TRY_START_CATCH(e)
@@ -538,8 +565,7 @@ void CEmulatorHandler::CEmulatorInputHandler::HandleConnectionStateRequest(unsig
 		}
 
 		//reset the timeout
-		s->_timeout.SetNow();
-		s->_timeout += HEARTBEAT_REQUEST_TIME_OUT;
+		s->_timeout = time(NULL) + HEARTBEAT_REQUEST_TIME_OUT;
 
 		CConnectionStateResponse resp(s->channelid, E_NO_ERROR);
 		resp.FillBuffer(buffer, max_len);
@@ -669,7 +695,7 @@ bool CEmulatorHandler::CEmulatorInputHandler::SendTunnelToClient(const CCemi_L_D
 			unsigned char buffer[256];
 			CTunnelingRequest req(s->channelid, s->send_sequence, frame);
 			req.FillBuffer(buffer, sizeof(buffer));
-			_sock.SendTo(buffer, req.GetTotalSize(), s->_remote_data_addr, s->_remote_data_port);
+			_emulator->GetImpairment().SendTunnelRequest(buffer, req.GetTotalSize(), s->_remote_data_addr, s->_remote_data_port);
 		}else{
 			LOG_ERROR("[Received] [EIB] Raw frame. no client connected: ignoring.");
 		}
@@ -742,6 +768,14 @@ void CEmulatorHandler::CEmulatorInputHandler::Close()
 	_stop = true;
 }
 
+bool CEmulatorHandler::CEmulatorInputHandler::Lost(int percent)
+{
+	if(percent <= 0){
+		return false;
+	}
+	return (int)(_prng() % 100) < percent;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 CEmulatorHandler::CEmulatorOutputHandler::CEmulatorOutputHandler() :
@@ -759,9 +793,10 @@ void CEmulatorHandler::CEmulatorOutputHandler::Close()
 {
 	JTCSynchronized sync(_mon);
 	_stop = true;
-	// Drain the queue so run() doesn't try to Broadcast stale items
+	// Drain the queues so run() doesn't try to Broadcast stale items
 	// after the server has disconnected.
 	while(!_q.empty()) _q.pop();
+	_delayed.clear();
 	_mon.notify();
 }
 
@@ -772,27 +807,53 @@ void CEmulatorHandler::CEmulatorOutputHandler::EnqueueFrame(const CGroupEntry& g
 	_mon.notify();
 }
 
+void CEmulatorHandler::CEmulatorOutputHandler::EnqueueDelayed(const CCemi_L_Data_Frame& frame, int delay_ms)
+{
+	JTCSynchronized sync(_mon);
+	//frames with the same due time keep their order (confirmation before response)
+	_delayed.insert(pair<std::chrono::steady_clock::time_point, CCemi_L_Data_Frame>(
+		std::chrono::steady_clock::now() + std::chrono::milliseconds(delay_ms), frame));
+	_mon.notify();
+}
+
 void CEmulatorHandler::CEmulatorOutputHandler::run()
 {
 	while(!_stop)
 	{
 		CGroupEntry ge;
 		bool have_item = false;
+		vector<CCemi_L_Data_Frame> due;
 
-		// Hold _mon only long enough to wait and dequeue one item.
+		// Hold _mon only long enough to wait and dequeue.
 		{
 			JTCSynchronized sync(_mon);
 			if(_q.empty()){
-				_mon.wait(200);
+				long wait = 200;
+				if(!_delayed.empty()){
+					long long left = std::chrono::duration_cast<std::chrono::milliseconds>(
+						_delayed.begin()->first - std::chrono::steady_clock::now()).count();
+					wait = left < 0 ? 0 : (left < wait ? (long)left : wait);
+				}
+				if(wait > 0){
+					_mon.wait(wait);
+				}
 			}
 			if(!_q.empty()){
 				ge = _q.front();
 				_q.pop();
 				have_item = true;
 			}
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			while(!_delayed.empty() && _delayed.begin()->first <= now){
+				due.push_back(_delayed.begin()->second);
+				_delayed.erase(_delayed.begin());
+			}
 		}
 
 		// Broadcast without holding _mon so Close() can set _stop.
+		for(unsigned int i = 0; i < due.size() && !_stop; i++){
+			_emulator->Broadcast(due[i]);
+		}
 		if(have_item){
 			CCemi_L_Data_Frame ind(L_DATA_IND,
 									ge.GetPhyAddress(),
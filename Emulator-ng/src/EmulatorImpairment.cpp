@@ -0,0 +1,230 @@
+#include "EmulatorImpairment.h"
+#include "Emulator-ng.h"
+
+using namespace std::chrono;
+
+CEmulatorImpairment::CEmulatorImpairment() :
+JTCThread("CEmulatorImpairment"),
+_stop(false),
+_enabled(false),
+_sock(NULL)
+{
+	ResetProfile(_profile);
+	memset(&_stats, 0, sizeof(_stats));
+}
+
+CEmulatorImpairment::~CEmulatorImpairment()
+{
+}
+
+void CEmulatorImpairment::ResetProfile(CImpairmentProfile& profile)
+{
+	profile.drop = 0;
+	profile.duplicate = 0;
+	profile.reorder = 0;
+	profile.reorder_window = 0;
+	profile.ack_suppress = 0;
+	profile.delay = "none";
+	profile.delay_mean = 0;
+	profile.delay_jitter = 0;
+	profile.seed = 0;
+}
+
+void CEmulatorImpairment::Init(UDPSocket* sock)
+{
+	_sock = sock;
+}
+
+void CEmulatorImpairment::SetProfile(const CImpairmentProfile& profile)
+{
+	JTCSynchronized sync(*this);
+	_profile = profile;
+	_profile.delay.ToLower();
+	if(_profile.delay != "none" && _profile.delay != "constant" && _profile.delay != "uniform" &&
+	   _profile.delay != "normal" && _profile.delay != "exponential"){
+		LOG_ERROR("Unknown delay distribution \"%s\". Delays are disabled.", _profile.delay.GetBuffer());
+		_profile.delay = "none";
+	}
+	_enabled = _profile.drop > 0 || _profile.duplicate > 0 || (_profile.reorder > 0 && _profile.reorder_window > 0) ||
+			   _profile.ack_suppress > 0 || (_profile.delay != "none" && (_profile.delay_mean > 0 || _profile.delay_jitter > 0));
+	_prng.seed(_profile.seed != 0 ? _profile.seed : (unsigned int)time(NULL));
+	memset(&_stats, 0, sizeof(_stats));
+	if(!_enabled){
+		//nothing may stay behind once the stage is bypassed
+		ReleaseHeld(true, steady_clock::now());
+	}
+	notify();
+}
+
+bool CEmulatorImpairment::IsEnabled()
+{
+	JTCSynchronized sync(*this);
+	return _enabled;
+}
+
+CImpairmentStats CEmulatorImpairment::GetStats()
+{
+	JTCSynchronized sync(*this);
+	return _stats;
+}
+
+void CEmulatorImpairment::SendTunnelRequest(const unsigned char* buffer, int len, const CString& addr, int port)
+{
+	Send(buffer, len, addr, port, false);
+}
+
+void CEmulatorImpairment::SendAck(const unsigned char* buffer, int len, const CString& addr, int port)
+{
+	Send(buffer, len, addr, port, true);
+}
+
+bool CEmulatorImpairment::Roll(int percent)
+{
+	if(percent <= 0){
+		return false;
+	}
+	return (int)(_prng() % 100) < percent;
+}
+
+int CEmulatorImpairment::SampleDelay()
+{
+	double mean = _profile.delay_mean, jitter = _profile.delay_jitter, delay = 0;
+	if(_profile.delay == "constant"){
+		delay = mean;
+	}else if(_profile.delay == "uniform"){
+		std::uniform_real_distribution<double> d(mean - jitter, mean + jitter);
+		delay = d(_prng);
+	}else if(_profile.delay == "normal"){
+		std::normal_distribution<double> d(mean, jitter);
+		delay = d(_prng);
+	}else if(_profile.delay == "exponential" && mean > 0){
+		std::exponential_distribution<double> d(1.0 / mean);
+		delay = d(_prng);
+	}
+	return delay < 0 ? 0 : (int)delay;
+}
+
+void CEmulatorImpairment::Send(const unsigned char* buffer, int len, const CString& addr, int port, bool is_ack)
+{
+	{
+		JTCSynchronized sync(*this);
+		if(_enabled){
+			if(Roll(is_ack ? _profile.ack_suppress : _profile.drop)){
+				if(is_ack){
+					_stats.acks_suppressed++;
+				}else{
+					_stats.dropped++;
+				}
+				return;
+			}
+
+			Datagram d;
+			d.data.assign(buffer, buffer + len);
+			d.addr = addr;
+			d.port = port;
+
+			steady_clock::time_point now = steady_clock::now();
+			int delay = SampleDelay();
+			if(delay > 0){
+				_stats.delayed++;
+			}
+			steady_clock::time_point due = now + milliseconds(delay);
+
+			if(!is_ack && _profile.reorder_window > 0 && Roll(_profile.reorder)){
+				HeldDatagram h;
+				h.datagram = d;
+				h.remaining = _profile.reorder_window;
+				h.since = now;
+				_held.push_back(h);
+				_stats.reordered++;
+			}else{
+				Schedule(d, due);
+				if(!is_ack && Roll(_profile.duplicate)){
+					Schedule(d, due);
+					_stats.duplicated++;
+				}
+				//held datagrams go out after the ones that overtook them
+				ReleaseHeld(false, due);
+			}
+			notify();
+			return;
+		}
+	}
+
+	_sock->SendTo(buffer, len, addr, port);
+}
+
+void CEmulatorImpairment::Schedule(const Datagram& d, const steady_clock::time_point& due)
+{
+	//datagrams with the same due time keep their order
+	_scheduled.insert(std::pair<steady_clock::time_point, Datagram>(due, d));
+}
+
+void CEmulatorImpairment::ReleaseHeld(bool all, const steady_clock::time_point& due)
+{
+	std::deque<HeldDatagram>::iterator it = _held.begin();
+	while(it != _held.end())
+	{
+		if(all || --it->remaining <= 0){
+			Schedule(it->datagram, due);
+			it = _held.erase(it);
+		}else{
+			++it;
+		}
+	}
+}
+
+void CEmulatorImpairment::run()
+{
+	std::vector<Datagram> due;
+	while(!_stop)
+	{
+		due.clear();
+		{
+			JTCSynchronized sync(*this);
+			steady_clock::time_point now = steady_clock::now();
+			long wait = 200;
+			if(!_scheduled.empty()){
+				long long left = duration_cast<milliseconds>(_scheduled.begin()->first - now).count();
+				wait = left < wait ? (long)left : wait;
+			}
+			if(!_held.empty()){
+				long long left = duration_cast<milliseconds>(_held.front().since + milliseconds(IMPAIRMENT_MAX_HOLD) - now).count();
+				wait = left < wait ? (long)left : wait;
+			}
+			if(wait > 0){
+				this->wait(wait);
+				now = steady_clock::now();
+			}
+			//a held datagram is released when no later traffic came for too long
+			while(!_held.empty() && _held.front().since + milliseconds(IMPAIRMENT_MAX_HOLD) <= now){
+				Schedule(_held.front().datagram, now);
+				_held.pop_front();
+			}
+			while(!_scheduled.empty() && _scheduled.begin()->first <= now){
+				due.push_back(_scheduled.begin()->second);
+				_scheduled.erase(_scheduled.begin());
+			}
+			_stats.sent += (int)due.size();
+		}
+
+		//send outside the lock so handlers are never blocked by the socket
+		for(unsigned int i = 0; i < due.size() && !_stop; i++)
+		{
+			START_TRY
+				_sock->SendTo(&due[i].data[0], (int)due[i].data.size(), due[i].addr, due[i].port);
+			END_TRY_START_CATCH_SOCKET(e)
+				LOG_ERROR("Socket Error in impairment stage: %s", e.what());
+			END_CATCH
+		}
+	}
+}
+
+void CEmulatorImpairment::Close()
+{
+	JTCSynchronized sync(*this);
+	_stop = true;
+	_scheduled.clear();
+	_held.clear();
+	notify();
+}
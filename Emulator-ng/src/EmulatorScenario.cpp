@@ -0,0 +1,449 @@
+#include "EmulatorScenario.h"
+#include "Emulator-ng.h"
+#include <cmath>
+#include <thread>
+
+using namespace std::chrono;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+CScenarioStep::CScenarioStep()
+{
+	Reset();
+}
+
+CScenarioStep::~CScenarioStep()
+{
+}
+
+void CScenarioStep::Reset()
+{
+	_name.Clear();
+	_type = UNKNOWN;
+	_start = 0;
+	_duration = 0;
+	_period = 0;
+	_spread = 0;
+	_count = 1;
+	_rate = 0;
+	_min_rate = 0;
+	_address.Set((unsigned int)0, true);
+	_phy.Set((unsigned int)0, false);
+	_has_phy = false;
+	_value_len = 1;
+	_fixed_len = 0;
+	memset(_value, 0, sizeof(_value));
+}
+
+CScenarioStep::StepType CScenarioStep::ParseType(const CString& type)
+{
+	CString tmp(type);
+	tmp.ToUpper();
+	if(tmp == "SCENE") return SCENE;
+	if(tmp == "READ_STORM") return READ_STORM;
+	if(tmp == "STREAM") return STREAM;
+	if(tmp == "DIURNAL") return DIURNAL;
+	return UNKNOWN;
+}
+
+const char* CScenarioStep::GetTypeName(StepType type)
+{
+	switch(type)
+	{
+	case SCENE: return "SCENE";
+	case READ_STORM: return "READ_STORM";
+	case STREAM: return "STREAM";
+	case DIURNAL: return "DIURNAL";
+	default: return "UNKNOWN";
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CScenarioFile::CScenarioFile() :
+_seed(1),
+_phy((unsigned int)0xFFFF, false)
+{
+}
+
+CScenarioFile::~CScenarioFile()
+{
+}
+
+void CScenarioFile::Load(const CString& file_name)
+{
+	ifstream f(file_name.GetBuffer());
+	if(f.fail()){
+		throw CEIBException(FileError, "Scenario file \"%s\" not found", file_name.GetBuffer());
+	}
+	f.close();
+
+	Clear();
+	Init(file_name);
+	CGenericDB<CString,CScenarioStep>::Load();
+	if(_data.empty()){
+		throw CEIBException(ConfigFileError, "Scenario file \"%s\" has no steps", file_name.GetBuffer());
+	}
+}
+
+void CScenarioFile::OnReadRecordNameComplete(CScenarioStep& current_record, const CString& record_name)
+{
+	current_record._name = record_name;
+}
+
+void CScenarioFile::OnReadParamComplete(CScenarioStep& current_record, const CString& param,const CString& value)
+{
+	CString tmp(param);
+	tmp.ToUpper();
+
+	if(current_record._name == SCENARIO_SETTINGS){
+		if(tmp == "SEED"){
+			_seed = (unsigned int)value.ToLong();
+		}else if(tmp == "PHY"){
+			_phy = CEibAddress(value);
+		}else{
+			throw CEIBException(ConfigFileError,"Scenario file error. Unknown setting: %s", param.GetBuffer());
+		}
+		return;
+	}
+
+	if(tmp == "TYPE"){
+		current_record._type = CScenarioStep::ParseType(value);
+	}else if(tmp == "START"){
+		current_record._start = value.ToInt();
+	}else if(tmp == "DURATION"){
+		current_record._duration = value.ToInt();
+	}else if(tmp == "PERIOD"){
+		current_record._period = value.ToInt();
+	}else if(tmp == "SPREAD"){
+		current_record._spread = value.ToInt();
+	}else if(tmp == "COUNT"){
+		current_record._count = value.ToInt();
+	}else if(tmp == "RATE" || tmp == "MAX_RATE"){
+		current_record._rate = value.ToDouble();
+	}else if(tmp == "MIN_RATE"){
+		current_record._min_rate = value.ToDouble();
+	}else if(tmp == "ADDRESS"){
+		current_record._address = CEibAddress(value);
+	}else if(tmp == "PHY"){
+		current_record._phy = CEibAddress(value);
+		current_record._has_phy = true;
+	}else if(tmp == "VALUE"){
+		current_record._fixed_len = (short)value.ToByteArray(current_record._value, sizeof(current_record._value));
+	}else if(tmp == "VALUE_LEN"){
+		current_record._value_len = value.ToInt();
+	}else{
+		throw CEIBException(ConfigFileError,"Scenario file error. Unknown parameter: %s", param.GetBuffer());
+	}
+}
+
+void CScenarioFile::OnReadRecordComplete(CScenarioStep& current_record)
+{
+	CScenarioStep& s = current_record;
+	const char* name = s._name.GetBuffer();
+
+	if(s._name == SCENARIO_SETTINGS){
+		s.Reset();
+		return;
+	}
+	if(s._type == CScenarioStep::UNKNOWN){
+		throw CEIBException(ConfigFileError,"Scenario step %s: missing or unknown TYPE", name);
+	}
+	if(!s._address.IsGroupAddress()){
+		throw CEIBException(ConfigFileError,"Scenario step %s: ADDRESS must be a group address", name);
+	}
+	if(s._count < 1 || s._address.ToByteArray() + s._count - 1 > 0xFFFF){
+		throw CEIBException(ConfigFileError,"Scenario step %s: COUNT is out of range", name);
+	}
+	if(s._start < 0 || s._duration < 0 || s._period < 0 || s._spread < 0){
+		throw CEIBException(ConfigFileError,"Scenario step %s: negative time", name);
+	}
+	if(s._value_len < 1 || s._value_len > MAX_EIB_VAL){
+		throw CEIBException(ConfigFileError,"Scenario step %s: VALUE_LEN must be 1 - %d", name, MAX_EIB_VAL);
+	}
+	if(s._rate > SCENARIO_MAX_RATE || s._min_rate > SCENARIO_MAX_RATE){
+		throw CEIBException(ConfigFileError,"Scenario step %s: rate is too high", name);
+	}
+
+	switch(s._type)
+	{
+	case CScenarioStep::SCENE:
+	case CScenarioStep::READ_STORM:
+		if(s._duration > 0 && s._period == 0){
+			throw CEIBException(ConfigFileError,"Scenario step %s: repeated bursts need a PERIOD", name);
+		}
+		break;
+	case CScenarioStep::STREAM:
+		if(s._rate <= 0 || s._duration == 0){
+			throw CEIBException(ConfigFileError,"Scenario step %s: STREAM needs RATE and DURATION", name);
+		}
+		break;
+	case CScenarioStep::DIURNAL:
+		if(s._rate <= 0 || s._min_rate < 0 || s._min_rate > s._rate || s._period == 0 || s._duration == 0){
+			throw CEIBException(ConfigFileError,"Scenario step %s: DIURNAL needs PERIOD, DURATION and 0 <= MIN_RATE <= MAX_RATE", name);
+		}
+		break;
+	default:
+		break;
+	}
+
+	if(!AddRecord(s._name, s)){
+		throw CEIBException(ConfigFileError,"Scenario file error. Duplicate step: %s", name);
+	}
+	s.Reset();
+}
+
+void CScenarioFile::OnSaveRecordStarted(const CScenarioStep& record,CString& record_name, list<pair<CString, CString> >& /*param_values*/)
+{
+	//scenario files are only read
+	record_name = record._name;
+}
+
+void CScenarioFile::GetSteps(std::vector<CScenarioStep>& steps) const
+{
+	map<CString,CScenarioStep>::const_iterator it;
+	for(it = _data.begin(); it != _data.end(); ++it)
+	{
+		steps.push_back(it->second);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CEmulatorScenario::CEmulatorScenario() :
+JTCThread("CEmulatorScenario"),
+_stop(false),
+_running(false),
+_sent(0),
+_max_late(0),
+_total_late(0)
+{
+}
+
+CEmulatorScenario::~CEmulatorScenario()
+{
+}
+
+void CEmulatorScenario::Init(const CString& file_name, const CString& record_file)
+{
+	CScenarioFile file;
+	file.Load(file_name);
+
+	std::vector<CScenarioStep> steps;
+	file.GetSteps(steps);
+	_runners.clear();
+	for(unsigned int i = 0; i < steps.size(); i++)
+	{
+		StepRunner r;
+		r.step = steps[i];
+		r.index = 0;
+		r.next = 0;
+		Schedule(r);
+		_runners.push_back(r);
+	}
+	_prng.seed(file.GetSeed());
+	_phy = file.GetPhyAddress();
+
+	_record_file = record_file;
+	_record.open(_record_file.GetBuffer(), ios::out | ios::trunc);
+	if(_record.fail()){
+		throw CEIBException(FileError, "Cannot create scenario record file \"%s\"", _record_file.GetBuffer());
+	}
+	_record << "seq,scheduled_us,actual_us,step,type,address,value" << endl;
+	_running = true;
+
+	LOG_INFO("[Scenario] Loaded %d steps from %s (seed %u)", (int)_runners.size(), file_name.GetBuffer(), file.GetSeed());
+}
+
+void CEmulatorScenario::Close()
+{
+	JTCSynchronized sync(*this);
+	_stop = true;
+	this->notify();
+}
+
+bool CEmulatorScenario::IsRunning()
+{
+	JTCSynchronized sync(*this);
+	return _running;
+}
+
+int CEmulatorScenario::GetSentCount()
+{
+	JTCSynchronized sync(*this);
+	return _sent;
+}
+
+unsigned int CEmulatorScenario::Random(unsigned int range)
+{
+	//raw engine output: std distributions are not the same on every standard library
+	return (unsigned int)(_prng() % range);
+}
+
+double CEmulatorScenario::DiurnalRate(const CScenarioStep& step, long long offset) const
+{
+	//the day starts at the trough (midnight) and peaks after half a period
+	double day = (double)(offset % ((long long)step._period * 1000)) / ((double)step._period * 1000);
+	return step._min_rate + (step._rate - step._min_rate) * (1 - cos(2 * M_PI * day)) / 2;
+}
+
+void CEmulatorScenario::Schedule(StepRunner& r)
+{
+	const CScenarioStep& s = r.step;
+	long long start = (long long)s._start * 1000;
+	long long end = start + (long long)s._duration * 1000;
+
+	switch(s._type)
+	{
+	case CScenarioStep::SCENE:
+	case CScenarioStep::READ_STORM:
+		{
+			long long burst = r.index / s._count;
+			long long j = r.index % s._count;
+			long long t = start + burst * s._period * 1000LL + j * s._spread * 1000LL / s._count;
+			bool done = (s._duration == 0) ? (burst > 0) : (burst * s._period * 1000LL >= (long long)s._duration * 1000);
+			r.next = done ? -1 : t;
+		}
+		break;
+	case CScenarioStep::STREAM:
+		{
+			double interval = 1000000.0 / (s._rate * s._count);
+			long long t = start + (long long)(r.index * interval);
+			r.next = (t >= end) ? -1 : t;
+		}
+		break;
+	case CScenarioStep::DIURNAL:
+		{
+			long long t = start;
+			if(r.index > 0){
+				//a trough of 0 telegrams per second is stretched to one telegram per period
+				double rate = DiurnalRate(s, r.next - start);
+				double min_rate = 1000.0 / s._period;
+				t = r.next + (long long)(1000000.0 / (rate > min_rate ? rate : min_rate));
+			}
+			r.next = (t >= end) ? -1 : t;
+		}
+		break;
+	default:
+		r.next = -1;
+		break;
+	}
+}
+
+void CEmulatorScenario::Fire(StepRunner& r, long long scheduled, long long actual)
+{
+	const CScenarioStep& s = r.step;
+	unsigned int base = s._address.ToByteArray();
+	unsigned int offset;
+	if(s._type == CScenarioStep::DIURNAL){
+		offset = Random(s._count);
+	}else{
+		offset = (unsigned int)(r.index % s._count);
+	}
+
+	CGroupEntry ge;
+	ge.SetAddress(CEibAddress(base + offset, true));
+	ge.SetPhyAddress(s._has_phy ? s._phy : _phy);
+
+	char value[MAX_EIB_VAL];
+	int len;
+	if(s._type == CScenarioStep::READ_STORM){
+		value[0] = GROUP_READ;
+		len = 1;
+	}else{
+		if(s._fixed_len > 0){
+			len = s._fixed_len;
+			memcpy(value, s._value, len);
+		}else{
+			len = s._value_len;
+			for(int i = 0; i < len; i++){
+				value[i] = (char)Random(256);
+			}
+			if(len > 1){
+				value[0] = 0;
+			}
+		}
+		//short values are in the low 6 bits of the APCI byte
+		value[0] = (char)(GROUP_WRITE | (value[0] & 0x3F));
+	}
+	ge.SetValue(value, len);
+	ge.SetValueLen(len);
+
+	CEIBEmulator::GetInstance().GetHandler().SendIndication(ge);
+
+	_record << _sent + 1 << ',' << scheduled << ',' << actual << ',' << s._name.GetBuffer() << ','
+			<< CScenarioStep::GetTypeName(s._type) << ',' << ge.GetAddress().ToString().GetBuffer() << ','
+			<< CString::ToHexFormat(value, len, true).GetBuffer() << '\n';
+
+	long long late = actual - scheduled;
+	if(late > _max_late){
+		_max_late = late;
+	}
+	_total_late += late;
+
+	JTCSynchronized sync(*this);
+	_sent++;
+}
+
+void CEmulatorScenario::WaitUntil(const steady_clock::time_point& deadline)
+{
+	while(!_stop)
+	{
+		steady_clock::time_point now = steady_clock::now();
+		if(now >= deadline){
+			return;
+		}
+		microseconds left = duration_cast<microseconds>(deadline - now);
+		if(left.count() > SCENARIO_SPIN_US){
+			//sleep on the monitor so Close() wakes us up
+			long ms = (long)((left.count() - SCENARIO_SPIN_US) / 1000);
+			JTCSynchronized sync(*this);
+			if(ms > 0 && !_stop){
+				this->wait(ms);
+			}
+			continue;
+		}
+		std::this_thread::yield();
+	}
+}
+
+void CEmulatorScenario::run()
+{
+	steady_clock::time_point begin = steady_clock::now();
+	while(!_stop)
+	{
+		//next telegram of all steps (ties go to the first step, so runs are repeatable)
+		int next = -1;
+		for(unsigned int i = 0; i < _runners.size(); i++)
+		{
+			if(_runners[i].next >= 0 && (next < 0 || _runners[i].next < _runners[next].next)){
+				next = i;
+			}
+		}
+		if(next < 0){
+			break;
+		}
+
+		StepRunner& r = _runners[next];
+		long long scheduled = r.next;
+		WaitUntil(begin + microseconds(scheduled));
+		if(_stop){
+			break;
+		}
+		long long actual = duration_cast<microseconds>(steady_clock::now() - begin).count();
+		Fire(r, scheduled, actual);
+		r.index++;
+		Schedule(r);
+	}
+
+	_record.flush();
+	_record.close();
+
+	JTCSynchronized sync(*this);
+	LOG_INFO("[Scenario] %s after %d telegrams. Max lateness: %lld us, average: %lld us. Record: %s",
+			 _stop ? "Stopped" : "Completed", _sent, _max_late, _sent > 0 ? _total_late / _sent : 0LL,
+			 _record_file.GetBuffer());
+	_running = false;
+}
@@ -8,11 +8,12 @@ void usage()
 	cout << "Usage: Emulator-ng [OPTION]" << endl;
 	cout << "Available options:" << endl;
 	cout << '\t' << "-i Interactive mode for creating the configuration file" << endl;
+	cout << '\t' << "-s <file> Run a load scenario file once the emulator is started" << endl;
 	cout << '\t' << "-h prints this message and exit" << endl << endl;
 	cout << "Report Emulator-ng bugs to yosig81@gmail.com" << endl << endl;
 }
 
-void emulator_main(bool interactive_conf)
+void emulator_main(bool interactive_conf, const CString& scenario)
 {
 	if(interactive_conf){
 		CEIBEmulator::GetInstance().InteractiveConf();
@@ -22,6 +23,9 @@ void emulator_main(bool interactive_conf)
 	bool initialized = CEIBEmulator::GetInstance().Init();
 	if(initialized){
 		CEIBEmulator::GetInstance().Run(NULL);
+		if(!scenario.IsEmpty()){
+			CEIBEmulator::GetInstance().RunScenario(scenario);
+		}
 	}
 	else{
 		cerr << "Error initializating EIB Emulator." << endl;
@@ -35,16 +39,19 @@ void emulator_main(bool interactive_conf)
 int main(int argc, char **argv)
 {
 	bool interactive_conf = false;
+	CString scenario;
 
 	int c;
 	opterr = 0;
 
-	while ((c = getopt (argc, argv, "ih :")) != -1)
+	while ((c = getopt (argc, argv, "ihs: ")) != -1)
 	{
 		switch(c)
 		{
 		case 'i': interactive_conf = true;
 			break;
+		case 's': scenario = optarg;
+			break;
 		case 'h':
 			usage();
 			exit(0);
@@ -56,6 +63,6 @@ int main(int argc, char **argv)
 		}
 	}
 
-	emulator_main(interactive_conf);
+	emulator_main(interactive_conf, scenario);
 	return 0;
 }
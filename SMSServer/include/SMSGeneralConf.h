@@ -7,6 +7,10 @@ CONF_ENTRY(CString,NetworkName,"SMS_NETWORK_NAME","SMS")
 CONF_ENTRY(CString,Password,"SMS_SERVER_PASSWORD","SMS")
 CONF_ENTRY(int,DeviceBaudRate,"SMS_DEVICE_BAUD_RATE",19200)
 CONF_ENTRY(int,LogLevel,"LOG_LEVEL",3)
+CONF_ENTRY(int,RateLimit,"SMS_RATE_LIMIT",10)
+CONF_ENTRY(int,DedupWindow,"SMS_DEDUP_WINDOW",60)
+CONF_ENTRY(int,SendQueueSize,"SMS_SEND_QUEUE_SIZE",100)
+CONF_ENTRY(int,BatchLength,"SMS_BATCH_LENGTH",160)
 #ifdef WIN32
 CONF_ENTRY(int,ListenInterface,"LISTEN_INTERFACE",1)
 CONF_ENTRY(CString,Device,"SMS_DEVICE","COM1")
@@ -0,0 +1,81 @@
+#ifndef __SMS_SENDER_HEADER__
+#define __SMS_SENDER_HEADER__
+
+#include "JTC.h"
+#include "CString.h"
+#include <deque>
+#include <map>
+#include <string>
+#include <chrono>
+
+using namespace std;
+
+#define SMS_SENDER_MAX_WAIT_MS	1000	//longest sleep when the queue is empty (new messages wake the thread)
+#define SMS_BATCH_SEPARATOR		"\n"
+
+/*! \class CSMSSender
+	\brief Send queue in front of the cellular modem
+
+	Callers only queue messages and return immediately; this thread is the only one that
+	submits SMS messages to the modem. Alarm messages are sent before normal ones, the same text
+	to the same number is sent only once within the deduplication window, and pending messages
+	to the same number are joined into one SMS as long as it does not exceed the batch length.
+	Submissions are spaced according to the configured rate (messages per minute).
+*/
+class CSMSSender : public JTCThread, public JTCMonitor
+{
+public:
+	CSMSSender();
+	virtual ~CSMSSender();
+
+	/*!
+	\brief Applies the queue settings. may be called while the thread runs
+	\fn void Init(int rate_per_minute, int dedup_window_sec, int max_queue, int batch_len)
+	\param rate_per_minute 0 disables the rate limit
+	\param dedup_window_sec 0 disables deduplication
+	\param batch_len 0 disables batching
+	*/
+	void Init(int rate_per_minute, int dedup_window_sec, int max_queue, int batch_len);
+
+	virtual void run();
+	void Close();
+
+	/*!
+	\brief Queues a message without blocking
+	\fn bool Enqueue(const CString& phone_number, const CString& text, bool alarm)
+	\return false if the message was a duplicate or the queue was full
+	*/
+	bool Enqueue(const CString& phone_number, const CString& text, bool alarm);
+
+	int GetPending();
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	typedef struct
+	{
+		CString phone_number;
+		CString text;
+		bool alarm;
+	}OutgoingSMS;
+
+	static std::string DedupKey(const CString& phone_number, const CString& text);
+	//a message counts for deduplication only once it was queued
+	bool IsDuplicate(const std::string& key, const Clock::time_point& now);
+	bool TakeNext(OutgoingSMS& sms);
+
+private:
+	bool _stop;
+	int _interval_ms;
+	int _dedup_window_ms;
+	int _max_queue;
+	int _batch_len;
+	Clock::time_point _next_send;
+	deque<OutgoingSMS> _alarms;
+	deque<OutgoingSMS> _normal;
+	map<std::string, Clock::time_point> _recent; //phone number + text -> time it was queued
+};
+
+typedef JTCHandleT<CSMSSender> CSMSSenderHandle;
+
+#endif
@@ -11,6 +11,7 @@
 #include "gsm_util.h"
 #include "EIBAgent.h"
 #include "SMSListener.h"
+#include "SMSSender.h"
 #include "SMSServerConfig.h"
 #include "LogFile.h"
 #include "MsgTable.h"
@@ -81,7 +82,17 @@ public:
 	CSMSListenerHandle& GetSMSListener() { return _listener; }
 
 	void InteractiveConf();
-	bool SendSMS(const CString& phone_number, const CString& text);
+	/*!
+		\fn bool SendSMS(const CString& phone_number, const CString& text, bool alarm = false)
+		\brief Queues an SMS on the send queue. never blocks on the modem
+		\return false if the message was not queued (duplicate or queue full)
+	*/
+	bool SendSMS(const CString& phone_number, const CString& text, bool alarm = false);
+	/*!
+		\fn bool SubmitSMS(const CString& phone_number, const CString& text)
+		\brief Submits an SMS to the modem and waits for it. used by the send queue thread only
+	*/
+	bool SubmitSMS(const CString& phone_number, const CString& text);
 
 private:
 	void DeleteAllMessages();
@@ -95,6 +106,7 @@ private:
 	CLogFile _log;
 	CMsgTable _msg_table;
 	CSMSListenerHandle _listener;
+	CSMSSenderHandle _sender;
 };
 
 #endif
@@ -3,6 +3,10 @@
 
 #include "CString.h"
 #include "GenericDB.h"
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <unordered_map>
 
 #define SMS_DB_FILE "Sms.db"
 #define PHONE_NUMBER_BLOCK_PREFIX_STR "PHONE_NUMBER-"
@@ -10,6 +14,7 @@
 #define SMS_COMMAND_STR "SMS_TO_EIB"
 #define ALERT_PARAM_SEPERATOR_STR ":"
 #define CMD_PARAM_SEPERATO_STR ":"
+#define ALERT_ALARM_FLAG_STR "alarm"
 
 struct _AddressValueKey
 {
@@ -54,18 +59,20 @@ typedef struct _AddressValueKey AddressValueKey;
 class CUserAlertRecord
 {
 public:
-	CUserAlertRecord() {};
+	CUserAlertRecord() : _alarm(false) {};
 	virtual ~CUserAlertRecord() {};
 
 	unsigned char GetValue() const{ return _value;}
 	unsigned short GetDestAddress() const { return _d_address;}
 	const CString& GetPoneNumber() const{ return _phone_number; }
 	const CString& GetTextMessage() const{ return _text_msg;}
+	bool IsAlarm() const { return _alarm; }
 
 	void SetDestAddress(unsigned short address) { _d_address = address;}
 	void SetValue(unsigned char value) { _value = value;}
 	void SetPhoneNumber(const CString& phone_number) { _phone_number = phone_number; }
 	void SetTextMessage(const CString& text_message) { _text_msg = text_message;}
+	void SetAlarm(bool alarm) { _alarm = alarm; }
 
 	bool operator==(const CUserAlertRecord& other)
 	{
@@ -75,6 +82,7 @@ public:
 private:
 	unsigned short _d_address;
 	unsigned char _value;
+	bool _alarm; //sent before the other queued messages
 	CString _text_msg;
 	CString _phone_number;
 };
@@ -120,19 +128,65 @@ private:
 	map<CString,CUserAlertRecord> _sms_to_eib_db;
 };
 
+typedef std::vector<CUserAlertRecord> CAlertList;
+
+/*! \class CSmsIndex
+	\brief Inverted index of all users: telegram (address + value) to alerts, SMS text to commands
+
+	The index is immutable once built. Readers get it as a snapshot, so a reload never changes
+	the lists they are iterating.
+*/
+class CSmsIndex
+{
+public:
+	CSmsIndex() {};
+	virtual ~CSmsIndex() {};
+
+	void Build(const map<CString,CUserEntry>& users);
+
+	/*!
+	\brief Alerts of all users for a telegram, or NULL. valid as long as the snapshot is held
+	\fn const CAlertList* FindAlerts(unsigned short d_address, unsigned char value) const
+	*/
+	const CAlertList* FindAlerts(unsigned short d_address, unsigned char value) const;
+	/*!
+	\brief Commands of all users for an SMS text, or NULL. valid as long as the snapshot is held
+	\fn const CAlertList* FindCommands(const CString& sms_msg) const
+	*/
+	const CAlertList* FindCommands(const CString& sms_msg) const;
+
+private:
+	static unsigned int AlertKey(unsigned short d_address, unsigned char value) { return ((unsigned int)d_address << 8) | value; }
+
+	std::unordered_map<unsigned int, CAlertList> _alerts;
+	std::unordered_map<CString, CAlertList, CStringHash> _commands;
+};
+
+typedef std::shared_ptr<const CSmsIndex> CSmsIndexSnapshot;
+
 class CSMSServerDB : public CGenericDB<CString,CUserEntry>
 {
 public:
 	CSMSServerDB();
 	virtual ~CSMSServerDB();
 
+	/*!
+	\brief Parses the database file and rebuilds the index
+	\fn bool Load()
+	*/
+	bool Load();
+	/*!
+	\brief Parses the database file again. the live records and index are replaced only if the file is valid
+	\fn bool Reload()
+	*/
+	bool Reload();
+	CSmsIndexSnapshot GetIndex() const { return std::atomic_load(&_index); }
+
 	virtual void OnReadParamComplete(CUserEntry& current_record, const CString& param,const CString& value);
 	virtual void OnReadRecordComplete(CUserEntry& current_record);
 	virtual void OnReadRecordNameComplete(CUserEntry& current_record, const CString& record_name);
 	virtual void OnSaveRecordStarted(const CUserEntry& record,CString& record_name, list<pair<CString, CString> >& param_values);
 	
-	bool FindSmsMesaages(unsigned short d_address, unsigned short value, list<CUserAlertRecord>& result) ;
-	bool FindEibMessages(const CString& sms_msg, list<CUserAlertRecord>& result) ;
 
 	void InteractiveConf();
 
@@ -145,6 +199,10 @@ private:
 	bool AddUserEntry(CUserEntry& entry);
 	bool EditUserEntry(const CString& file_name);
 	bool DeleteUserEntry(const CString& file_name);
+	void RebuildIndex();
+
+private:
+	CSmsIndexSnapshot _index; //accessed through std::atomic_load/atomic_store only
 };
 
 #endif
@@ -69,14 +69,16 @@ void CEIBAgent::run()
 		{
 			LOG_DEBUG("[Received] CEMI frame from EIB Server. EIBAddress: %s (%d bytes).", func.ToString().GetBuffer(), length);
 
-			list<CUserAlertRecord> result;
-			if(db.FindSmsMesaages(func.ToByteArray(),val[0],result)){
-				list<CUserAlertRecord>::iterator it;
-				for(it = result.begin(); it != result.end(); ++it)
+			//the snapshot keeps the alert list alive even if the database is reloaded meanwhile
+			CSmsIndexSnapshot index = db.GetIndex();
+			const CAlertList* result = index->FindAlerts(func.ToByteArray(),val[0]);
+			if(result != NULL){
+				CAlertList::const_iterator it;
+				for(it = result->begin(); it != result->end(); ++it)
 				{
 					//JTCSynchronized(*(singleton.GetSMSListener()));
 					LOG_DEBUG("Trying to send SMS: %s", it->GetPoneNumber().GetBuffer());
-					CSMSServer::GetInstance().SendSMS(it->GetPoneNumber(),it->GetTextMessage());
+					CSMSServer::GetInstance().SendSMS(it->GetPoneNumber(),it->GetTextMessage(),it->IsAlarm());
 				}
 			}
 		}
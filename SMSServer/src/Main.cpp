@@ -21,7 +21,18 @@ void smsserver_main(bool interactive_conf, bool interactive_smsdb)
 		cerr << "Error during initialization of SMS Server." << endl;
 	}
 
-	CUtils::WaitForCharInput('q', "Press q to stop SMS Server: ");
+	CString input;
+	while(true)
+	{
+		CUtils::WaitForInput(input, "Press q to stop SMS Server, r to reload the SMS database: ");
+		input.Trim();
+		if(input == "q" || !cin.good()){
+			break;
+		}
+		if(input == "r" && initialized){
+			CSMSServer::GetInstance().GetDB().Reload();
+		}
+	}
 	CSMSServer::GetInstance().Close();
 }
 
@@ -103,10 +103,11 @@ void CSMSListener::CheckForNewMessages(EventHandler& event_handler,MeTa* me)
     }
 
 	//look for the sms that received in the db
-	list<CUserAlertRecord> res;
-	if(CSMSServer::GetInstance().GetDB().FindEibMessages(text,res)){
-		list<CUserAlertRecord>::iterator it;
-		for(it = res.begin(); it != res.end(); ++it)
+	CSmsIndexSnapshot snapshot = CSMSServer::GetInstance().GetDB().GetIndex();
+	const CAlertList* res = snapshot->FindCommands(text);
+	if(res != NULL){
+		CAlertList::const_iterator it;
+		for(it = res->begin(); it != res->end(); ++it)
 		{
 			if(origin_number != it->GetPoneNumber()){
 				continue;
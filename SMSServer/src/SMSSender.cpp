@@ -0,0 +1,175 @@
+#include "SMSSender.h"
+#include "SMSServer.h"
+
+using namespace std::chrono;
+
+CSMSSender::CSMSSender() :
+JTCThread("CSMSSender"),
+_stop(false),
+_interval_ms(0),
+_dedup_window_ms(0),
+_max_queue(0),
+_batch_len(0),
+_next_send(Clock::now())
+{
+}
+
+CSMSSender::~CSMSSender()
+{
+}
+
+void CSMSSender::Init(int rate_per_minute, int dedup_window_sec, int max_queue, int batch_len)
+{
+	JTCSynchronized sync(*this);
+	_interval_ms = rate_per_minute > 0 ? 60000 / rate_per_minute : 0;
+	_dedup_window_ms = dedup_window_sec > 0 ? dedup_window_sec * 1000 : 0;
+	_max_queue = max_queue > 0 ? max_queue : 1;
+	_batch_len = batch_len > 0 ? batch_len : 0;
+}
+
+std::string CSMSSender::DedupKey(const CString& phone_number, const CString& text)
+{
+	std::string key(phone_number.GetBuffer());
+	key += '\n';
+	key += text.GetBuffer();
+	return key;
+}
+
+bool CSMSSender::IsDuplicate(const std::string& key, const Clock::time_point& now)
+{
+	if(_dedup_window_ms == 0){
+		return false;
+	}
+
+	//forget the messages whose window is over
+	map<std::string, Clock::time_point>::iterator it = _recent.begin();
+	while(it != _recent.end())
+	{
+		if(now - it->second >= milliseconds(_dedup_window_ms)){
+			_recent.erase(it++);
+		}else{
+			++it;
+		}
+	}
+
+	return _recent.find(key) != _recent.end();
+}
+
+bool CSMSSender::Enqueue(const CString& phone_number, const CString& text, bool alarm)
+{
+	JTCSynchronized sync(*this);
+	if(_stop){
+		return false;
+	}
+	Clock::time_point now = Clock::now();
+	std::string key = DedupKey(phone_number, text);
+	if(IsDuplicate(key, now)){
+		LOG_DEBUG("SMS to %s suppressed: same text was queued within the deduplication window", phone_number.GetBuffer());
+		return false;
+	}
+
+	if((int)(_alarms.size() + _normal.size()) >= _max_queue){
+		//an alarm makes room by dropping the oldest normal message
+		if(!alarm || _normal.empty()){
+			LOG_ERROR("SMS send queue is full. Message to %s dropped.", phone_number.GetBuffer());
+			return false;
+		}
+		//the dropped message was never sent, a retry must not be suppressed
+		LOG_ERROR("SMS send queue is full. Message to %s dropped.", _normal.front().phone_number.GetBuffer());
+		_recent.erase(DedupKey(_normal.front().phone_number, _normal.front().text));
+		_normal.pop_front();
+	}
+
+	OutgoingSMS sms;
+	sms.phone_number = phone_number;
+	sms.text = text;
+	sms.alarm = alarm;
+	if(alarm){
+		_alarms.push_back(sms);
+	}else{
+		_normal.push_back(sms);
+	}
+	if(_dedup_window_ms > 0){
+		_recent[key] = now;
+	}
+	notify();
+	return true;
+}
+
+int CSMSSender::GetPending()
+{
+	JTCSynchronized sync(*this);
+	return (int)(_alarms.size() + _normal.size());
+}
+
+bool CSMSSender::TakeNext(OutgoingSMS& sms)
+{
+	deque<OutgoingSMS>& queue = !_alarms.empty() ? _alarms : _normal;
+	if(queue.empty()){
+		return false;
+	}
+	sms = queue.front();
+	queue.pop_front();
+
+	if(_batch_len == 0){
+		return true;
+	}
+
+	//join the other pending messages of the same priority to the same number
+	deque<OutgoingSMS>::iterator it = queue.begin();
+	while(it != queue.end())
+	{
+		if(it->phone_number == sms.phone_number &&
+		   sms.text.GetLength() + (int)strlen(SMS_BATCH_SEPARATOR) + it->text.GetLength() <= _batch_len)
+		{
+			sms.text += SMS_BATCH_SEPARATOR;
+			sms.text += it->text;
+			it = queue.erase(it);
+		}else{
+			++it;
+		}
+	}
+	return true;
+}
+
+void CSMSSender::run()
+{
+	while(!_stop)
+	{
+		OutgoingSMS sms;
+		{
+			JTCSynchronized sync(*this);
+			long wait = SMS_SENDER_MAX_WAIT_MS;
+			if(!_alarms.empty() || !_normal.empty()){
+				long long left = duration_cast<milliseconds>(_next_send - Clock::now()).count();
+				wait = left < wait ? (long)left : wait;
+			}
+			if(wait > 0){
+				this->wait(wait);
+			}
+			if(_stop || Clock::now() < _next_send || !TakeNext(sms)){
+				sms.phone_number.Clear();
+			}else{
+				_next_send = Clock::now() + milliseconds(_interval_ms);
+			}
+		}
+
+		//the modem is slow, it is never accessed while holding the lock
+		if(!sms.phone_number.IsEmpty()){
+			LOG_DEBUG("Sending %s SMS to %s", sms.alarm ? "alarm" : "normal", sms.phone_number.GetBuffer());
+			CSMSServer::GetInstance().SubmitSMS(sms.phone_number, sms.text);
+		}
+	}
+}
+
+void CSMSSender::Close()
+{
+	JTCSynchronized sync(*this);
+	_stop = true;
+	if(!_alarms.empty() || !_normal.empty()){
+		LOG_INFO("SMS send queue closed. %d messages were not sent.", (int)(_alarms.size() + _normal.size()));
+	}
+	_alarms.clear();
+	_normal.clear();
+	notify();
+}
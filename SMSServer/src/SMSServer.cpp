@@ -9,6 +9,7 @@ CSingletonProcess(SMS_SERVER_PROCESS_NAME)
 {
 	_listener = new CSMSListener();
 	_agent = new CEIBAgent();
+	_sender = new CSMSSender();
 }
 
 CSMSServer::~CSMSServer()
@@ -60,6 +61,9 @@ bool CSMSServer::Init()
 		//DeleteAllMessages();
 		_listener->start();
 		LOG_INFO("Starting SMS Listener... Successful.");
+		_sender->Init(_conf.GetRateLimit(), _conf.GetDedupWindow(), _conf.GetSendQueueSize(), _conf.GetBatchLength());
+		_sender->start();
+		LOG_INFO("Starting SMS send queue... Successful.");
 	END_TRY_START_CATCH_GSM(e)
 		LOG_ERROR("Cellular Modem connection Failed: %s",e.what());
 		res = false;
@@ -86,6 +90,12 @@ void CSMSServer::Close()
 	_agent->Close();
 	_agent->join();
 
+	LOG_INFO("Closing the SMS send queue...");
+	_sender->Close();
+	if(_sender->isAlive()){
+		_sender->join();
+	}
+
 	LOG_INFO("Closing the cellular port...");
 	_listener->Close();
 	_listener->join();
@@ -119,7 +129,12 @@ void CSMSServer::DeleteAllMessages()
 	}
 }
 
-bool CSMSServer::SendSMS(const CString& phone_number,const CString& text)
+bool CSMSServer::SendSMS(const CString& phone_number,const CString& text, bool alarm)
+{
+	return _sender->Enqueue(phone_number, text, alarm);
+}
+
+bool CSMSServer::SubmitSMS(const CString& phone_number,const CString& text)
 {
 	START_TRY
 		if(_meta == NULL){
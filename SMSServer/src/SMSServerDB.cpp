@@ -3,7 +3,8 @@
 #include "cli.h"
 #include "SMSServer.h"
 
-CSMSServerDB::CSMSServerDB()
+CSMSServerDB::CSMSServerDB() :
+_index(std::make_shared<CSmsIndex>())
 {
 }
 
@@ -44,7 +45,8 @@ void CSMSServerDB::OnSaveRecordStarted(const CUserEntry& record,CString& record_
 	char val[512];
 	for(; it1 != m1.end(); it1++)
 	{
-		sprintf(val, "%s:0x%x:%s", CEibAddress(it1->second.GetDestAddress(), true).ToString().GetBuffer(), it1->second.GetValue(), it1->second.GetTextMessage().GetBuffer());
+		sprintf(val, "%s:0x%x:%s%s%s", CEibAddress(it1->second.GetDestAddress(), true).ToString().GetBuffer(), it1->second.GetValue(), it1->second.GetTextMessage().GetBuffer(),
+			it1->second.IsAlarm() ? ALERT_PARAM_SEPERATOR_STR : "", it1->second.IsAlarm() ? ALERT_ALARM_FLAG_STR : "");
 		param_values.insert(param_values.end(), pair<CString,CString>(ALERT_PARAM_STR,val));
 	}
 
@@ -64,7 +66,8 @@ void CSMSServerDB::ParseAlertRecord(const CString& alert_record,CUserEntry& reco
 {
 	StringTokenizer tok(alert_record,ALERT_PARAM_SEPERATOR_STR);
 
-	if (tok.CountTokens() != 3){
+	int tokens = tok.CountTokens();
+	if (tokens != 3 && tokens != 4){
 		throw CEIBException(ConfigFileError,"error in db file. \"%s\" entry is incorrect",alert_record.GetBuffer());
 	}
 
@@ -86,6 +89,15 @@ void CSMSServerDB::ParseAlertRecord(const CString& alert_record,CUserEntry& reco
 	alert.SetTextMessage(tok.NextToken());
 	alert.SetPhoneNumber(record.GetPhoneNumber());
 
+	if(tokens == 4){
+		CString flag = tok.NextToken();
+		flag.Trim();
+		if(flag != ALERT_ALARM_FLAG_STR){
+			throw CEIBException(ConfigFileError,"error in SMS db file. \"%s\" entry is incorrect",alert_record.GetBuffer());
+		}
+		alert.SetAlarm(true);
+	}
+
 	record.AddAlertRecord(alert);
 }
 
@@ -120,44 +132,36 @@ void CSMSServerDB::ParseCommandRecord(const CString& command_record,CUserEntry&
 	record.AddSmsCommand(cmd);
 }
 
-bool CSMSServerDB::FindSmsMesaages(unsigned short d_address, unsigned short value, list<CUserAlertRecord>& result)
+bool CSMSServerDB::Load()
 {
-	//first clear the list
-	result.clear();
+	bool res = CGenericDB<CString,CUserEntry>::Load();
+	RebuildIndex();
+	return res;
+}
 
-	//now find
-	map<CString,CUserEntry>::iterator it;
-	for(it = _data.begin();it != _data.end();++it)
-	{
-		CUserEntry& tmp = it->second;
-		map<AddressValueKey,CUserAlertRecord>::iterator sec_it;
-		AddressValueKey avk(d_address,value);
-		sec_it = tmp.GetEibToSmsDB().find(avk);
-		if (sec_it != tmp.GetEibToSmsDB().end()){
-			result.push_back(sec_it->second);
-		}
-	}
+bool CSMSServerDB::Reload()
+{
+	//parse into a separate database so a broken file leaves the live one untouched
+	CSMSServerDB db;
+	START_TRY
+		db.Init(_file_name);
+		db.Load();
+	END_TRY_START_CATCH(e)
+		LOG_ERROR("Cannot reload %s: %s. Keeping the current database.", _file_name.GetBuffer(), e.what());
+		return false;
+	END_CATCH
 
-	return (result.size() > 0);
+	_data = db._data;
+	std::atomic_store(&_index, db.GetIndex());
+	LOG_INFO("Database reloaded: %d users.", (int)_data.size());
+	return true;
 }
 
-bool CSMSServerDB::FindEibMessages(const CString& sms_msg, list<CUserAlertRecord>& result)
+void CSMSServerDB::RebuildIndex()
 {
-	//first clear the list
-	result.clear();
-	//now find
-	map<CString,CUserEntry>::iterator it;
-	for(it = _data.begin();it != _data.end();++it)
-	{
-		CUserEntry& tmp = it->second;
-		map<CString,CUserAlertRecord>::iterator sec_it;
-		sec_it = tmp.GetSmsToEibDB().find(sms_msg);
-		if (sec_it != tmp.GetSmsToEibDB().end()){
-			result.push_back(sec_it->second);
-		}
-	}
-
-	return (result.size() > 0);
+	std::shared_ptr<CSmsIndex> index = std::make_shared<CSmsIndex>();
+	index->Build(_data);
+	std::atomic_store(&_index, CSmsIndexSnapshot(index));
 }
 
 void CSMSServerDB::InteractiveConf()
@@ -297,6 +301,42 @@ void CSMSServerDB::Print()
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void CSmsIndex::Build(const map<CString,CUserEntry>& users)
+{
+	_alerts.clear();
+	_commands.clear();
+
+	map<CString,CUserEntry>::const_iterator it;
+	for(it = users.begin(); it != users.end(); ++it)
+	{
+		const map<AddressValueKey,CUserAlertRecord>& alerts = it->second.GetEibToSmsDBConst();
+		map<AddressValueKey,CUserAlertRecord>::const_iterator ait;
+		for(ait = alerts.begin(); ait != alerts.end(); ++ait){
+			_alerts[AlertKey(ait->second.GetDestAddress(), ait->second.GetValue())].push_back(ait->second);
+		}
+
+		const map<CString,CUserAlertRecord>& commands = it->second.GetSmsToEibDBConst();
+		map<CString,CUserAlertRecord>::const_iterator cit;
+		for(cit = commands.begin(); cit != commands.end(); ++cit){
+			_commands[cit->first].push_back(cit->second);
+		}
+	}
+}
+
+const CAlertList* CSmsIndex::FindAlerts(unsigned short d_address, unsigned char value) const
+{
+	std::unordered_map<unsigned int, CAlertList>::const_iterator it = _alerts.find(AlertKey(d_address, value));
+	return it == _alerts.end() ? NULL : &it->second;
+}
+
+const CAlertList* CSmsIndex::FindCommands(const CString& sms_msg) const
+{
+	std::unordered_map<CString, CAlertList, CStringHash>::const_iterator it = _commands.find(sms_msg);
+	return it == _commands.end() ? NULL : &it->second;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool CUserEntry::AddAlertRecord(CUserAlertRecord& alert)
 {
 	unsigned short d_address = alert.GetDestAddress();
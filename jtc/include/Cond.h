@@ -96,6 +96,11 @@ private:
     calc_timeout(long timeout);
 #endif
 
+#if defined(HAVE_JTC_FUTEX)
+    void
+    wake_recursive(int n);
+#endif
+
     //
     // Hide copy constructor and assignment operator.
     //
@@ -108,6 +113,18 @@ private:
     pthread_cond_t m_cond; // Pthread condition variable.
 #endif
 
+#if defined(HAVE_JTC_FUTEX)
+    //
+    // Waiters with a recursive mutex sleep on m_seq, which changes
+    // on every signal. Signaled waiters are requeued onto the futex
+    // of their mutex, so they are woken by its release instead of
+    // waking up only to block on the still locked mutex.
+    //
+    int m_seq;
+    int m_waiters; // Recursive mutex waiters, protected by the mutex.
+    int* m_mutex_state; // Futex word of the waiters' mutex.
+#endif
+
 #if defined(HAVE_WIN32_THREADS)
     CondImpl* m_impl;
 #endif
@@ -0,0 +1,184 @@
+// **********************************************************************
+//
+// Copyright (c) 2002
+// IONA Technologies, Inc.
+// Waltham, MA, USA
+//
+// All Rights Reserved
+//
+// **********************************************************************
+
+#ifndef JTC_EXECUTOR_H
+#define JTC_EXECUTOR_H
+
+#include <Monitor.h>
+#include <Handle.h>
+
+class JTCExecutorWorker;
+class JTCExecutorTimer;
+class JTCExecutorQueue;
+
+//
+// A fixed pool of worker threads that run JTCRunnable tasks.
+//
+// Every worker owns a work-stealing deque. A task submitted from a
+// worker goes to that worker's deque and is taken back LIFO by its
+// owner, idle workers steal FIFO from the other deques. Tasks
+// submitted from any other thread go through a shared injection
+// queue. Delayed tasks are kept by a single timer thread and handed to
+// the pool once they are due.
+//
+// The workers and the timer run in a ThreadGroup of their own that
+// carries the executor name. A task that throws does not end its
+// worker, the exception is reported through uncaughtException() of
+// that ThreadGroup.
+//
+// Tasks should be short. A task that blocks holds a worker for as
+// long as it blocks.
+//
+class JTC_IMPORT_EXPORT JTCExecutor : public JTCMonitor, public virtual JTCRefCount
+{
+public:
+
+    //
+    // Create an executor with nthreads workers. If nthreads is not
+    // positive one worker per online processor is used. The
+    // ThreadGroup is a child of the group of the calling thread, or of
+    // parent.
+    //
+    JTCExecutor(const char* name, int nthreads = 0);
+
+    JTCExecutor(JTCThreadGroupHandle& parent, const char* name,
+                int nthreads = 0);
+
+    //
+    // Calls shutdown() if that did not happen yet and joins the workers,
+    // also when shutdown() was called from a task. Must not be called
+    // from a task.
+    //
+    virtual
+    ~JTCExecutor();
+
+    //
+    // Start the workers and the timer. Tasks submitted before start()
+    // wait in the injection queue.
+    //
+    void
+    start();
+
+    //
+    // Submit a task. Returns false if the executor is shut down. Tasks
+    // running on the executor may still submit tasks while it drains.
+    //
+    bool
+    execute(const JTCRunnableHandle& task);
+
+    //
+    // Submit a task that runs after millis milliseconds. Returns false
+    // if the executor is shut down, throws
+    // JTCIllegalThreadStateException if it is not started.
+    //
+    bool
+    schedule(const JTCRunnableHandle& task, long millis);
+
+    //
+    // Stop accepting tasks, run the tasks that are queued and wait for
+    // the workers to terminate. Delayed tasks that are not due yet are
+    // discarded. If called from a task the workers are not joined, the
+    // destructor joins them.
+    //
+    void
+    shutdown();
+
+    //
+    // Has shutdown() been called?
+    //
+    bool
+    isShutdown() const;
+
+    //
+    // Number of worker threads.
+    //
+    int
+    size() const;
+
+    //
+    // Get the name of this executor.
+    //
+    const char*
+    getName() const;
+
+    //
+    // Get the ThreadGroup of the worker threads.
+    //
+    JTCThreadGroupHandle
+    getThreadGroup() const;
+
+    //
+    // Daemon status of the ThreadGroup. A daemon group is destroyed
+    // when the last worker terminates.
+    //
+    bool
+    isDaemon() const;
+
+    void
+    setDaemon(bool daemon);
+
+private:
+
+    //
+    // Hide copy constructor and assignment operator.
+    //
+    JTCExecutor(const JTCExecutor&);
+    void operator=(const JTCExecutor&);
+
+    void
+    init(const JTCThreadGroupHandle& parent, const char* name, int nthreads);
+
+    //
+    // The worker that runs the calling thread, or 0.
+    //
+    JTCExecutorWorker*
+    current_worker() const;
+
+    //
+    // Wait for the timer and the workers to terminate. Not from a task.
+    //
+    void
+    join_workers();
+
+    //
+    // Next task for worker, or 0 once the executor is shut down and
+    // there is no work left.
+    //
+    JTCRunnableHandle*
+    next(JTCExecutorWorker* worker);
+
+    JTCRunnableHandle*
+    steal(JTCExecutorWorker* worker);
+
+    //
+    // Is there any queued task? The monitor must be locked.
+    //
+    bool
+    has_work() const;
+
+    JTCThreadGroupHandle m_group; // ThreadGroup of the workers
+    int m_nthreads; // Number of workers
+    JTCExecutorWorker** m_workers; // The workers
+    JTCThreadHandle* m_threads; // Handles keeping the workers alive
+    JTCThreadHandle m_timer_thread; // Handle keeping the timer alive
+    JTCExecutorTimer* m_timer; // The timer thread
+    JTCExecutorQueue* m_queue; // Injection queue
+    int m_idle; // Number of parked workers
+    bool m_started; // Has start() been called?
+    bool m_shutdown; // Has shutdown() been called?
+    bool m_joined; // Have the workers been joined?
+
+    friend class JTCExecutorWorker;
+    friend class JTCExecutorTimer;
+};
+
+typedef JTCHandleT<JTCExecutor> JTCExecutorHandle;
+
+#endif
@@ -0,0 +1,65 @@
+// **********************************************************************
+//
+// Copyright (c) 2002
+// IONA Technologies, Inc.
+// Waltham, MA, USA
+//
+// All Rights Reserved
+//
+// **********************************************************************
+
+#ifndef JTC_FUTEX_H
+#define JTC_FUTEX_H
+
+#include <Types.h>
+
+#if defined(HAVE_JTC_FUTEX)
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+
+//
+// Thin wrappers around the futex system call, used by the recursive
+// mutex and the condition variable. All of them operate on an int
+// that is otherwise accessed with the __atomic builtins.
+//
+
+//
+// Block while *addr == val, or until timeout (relative, 0 means
+// forever) expires. Returns 0 or the errno value (EAGAIN if *addr
+// already changed, ETIMEDOUT, EINTR).
+//
+inline int
+jtc_futex_wait(int* addr, int val, const struct timespec* timeout)
+{
+    if (syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, timeout, 0, 0) == 0)
+	return 0;
+    return errno;
+}
+
+//
+// Wake up to n threads blocked on addr.
+//
+inline void
+jtc_futex_wake(int* addr, int n)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, 0, 0, 0);
+}
+
+//
+// Move up to n threads blocked on addr to addr2 without waking them,
+// provided *addr still equals val. Returns false if *addr changed.
+//
+inline bool
+jtc_futex_requeue(int* addr, int n, int* addr2, int val)
+{
+    return syscall(SYS_futex, addr, FUTEX_CMP_REQUEUE_PRIVATE, 0,
+		   (void*)(long)n, addr2, val) != -1;
+}
+
+#endif
+
+#endif
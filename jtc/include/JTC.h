@@ -18,6 +18,7 @@
 #include <Runnable.h>
 #include <TSS.h>
 #include <RWMutex.h>
+#include <Executor.h>
 
 #include <HandleI.h>
 #include <MonitorI.h>
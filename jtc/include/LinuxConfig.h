@@ -61,9 +61,19 @@
 /* Define if OS supports posix threads. */
 #define HAVE_POSIX_THREADS 1
 
+/* Define if the recursive mutex and monitors use futexes (Linux only). */
+#if defined(__linux__)
+#define HAVE_JTC_FUTEX 1
+#endif
+
 /* Define if OS supports pthread_attr_setstacksize. */
 #define HAVE_PTHREAD_ATTR_SETSTACKSIZE 1
 
+/* Define if OS supports pthread_setaffinity_np. */
+#if defined(__linux__)
+#define HAVE_PTHREAD_SETAFFINITY_NP 1
+#endif
+
 /* Define if OS supports pthread_delay_np. */
 /* #undef HAVE_PTHREAD_DELAY_NP */
 
@@ -241,6 +241,31 @@ private:
     unsigned int
     reset_for_condvar();
 
+#if defined(HAVE_JTC_FUTEX)
+    //
+    // Re-acquire the mutex count times after a condition variable
+    // wait. The waiter may have been requeued onto m_state, so the
+    // mutex is always taken as contended.
+    //
+    void
+    lock_for_condvar(unsigned int count);
+
+    //
+    // Acquire m_state: 0 unlocked, 1 locked, 2 locked with (possibly)
+    // blocked threads. An uncontended lock is a single compare and
+    // swap, threads that find the mutex locked sleep on the futex.
+    //
+    void
+    acquire(bool contended);
+
+    void
+    release();
+
+    int m_state; // Futex word.
+    pthread_t m_owner; // Current owner, 0 when unlocked.
+    unsigned int m_count; // Number of times the mutex has been aquired.
+#else
+
 #if defined(HAVE_POSIX_THREADS)
     pthread_mutex_t m_lock; // Pthreads mutex.
 #endif
@@ -253,6 +278,7 @@ private:
  
     unsigned int m_count; // Number of times the mutex has been aquired.
     JTCThreadId m_owner; // Current owner of the mutex.
+#endif
 
     friend class JTCCondHelper;
     friend class JTCCond;
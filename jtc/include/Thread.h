@@ -124,6 +124,53 @@ public:
     int
     getPriority() const;
 
+    //
+    // Set the stack size of this thread in bytes. Must be called
+    // before start(). 0 uses the default stack size.
+    //
+    void
+    setStackSize(size_t bytes);
+
+    //
+    // Get the stack size requested for this thread, or 0.
+    //
+    size_t
+    getStackSize() const;
+
+    //
+    // Set the default stack size in bytes for threads started after
+    // this call that do not set their own. 0 uses the system
+    // default. Same as the -JTCss option, which takes kilobytes.
+    //
+    static void
+    setDefaultStackSize(size_t bytes);
+
+    //
+    // Restrict this thread to the ncpus processors listed in cpus. A
+    // ncpus of 0 allows all processors again. The thread must be
+    // started.
+    //
+    void
+    setAffinity(const int* cpus, int ncpus);
+
+    //
+    // Scheduling policies for setSchedPolicy().
+    //
+    enum SchedPolicy
+    {
+	JTC_SCHED_OTHER = 0,
+	JTC_SCHED_FIFO  = 1,
+	JTC_SCHED_RR    = 2
+    };
+
+    //
+    // Set the scheduling policy and the native priority of this
+    // thread. The realtime policies usually need privileges. The
+    // thread must be started.
+    //
+    void
+    setSchedPolicy(SchedPolicy policy, int priority);
+
     //
     // Enumerate all threads in this threads group.
     //
@@ -266,6 +313,11 @@ private:
     HANDLE m_handle;
 #endif
 
+    //
+    // Requested stack size, 0 for the default. Protected by m_mutex.
+    //
+    size_t m_stack_size;
+
     //
     // Group of this thread (immutable)
     //
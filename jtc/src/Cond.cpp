@@ -13,6 +13,8 @@
 #include <SyncT.h>
 #include <JTCSemaphore.h>
 
+#include <Futex.h>
+
 #include <errno.h>
 #include <assert.h>
 
@@ -28,7 +30,7 @@ using namespace std;
 #endif // !HAVE_JTC_NO_IOSTREAM
 
 
-#if defined(HAVE_POSIX_THREADS)
+#if defined(HAVE_POSIX_THREADS) && !defined(HAVE_JTC_FUTEX)
 
 //
 // This helper class is used to re-acquire the the recursive mutex.
@@ -236,6 +238,11 @@ private:
 // ----------------------------------------------------------------------
 
 JTCCond::JTCCond()
+#if defined(HAVE_JTC_FUTEX)
+    : m_seq(0),
+      m_waiters(0),
+      m_mutex_state(0)
+#endif
 {
 #if defined(HAVE_POSIX_THREADS)
     JTC_SYSCALL_2(pthread_cond_init, &m_cond, 0, != 0)
@@ -312,6 +319,10 @@ JTCCond::wait(JTCMutex& mutex, long timeout)
 void
 JTCCond::signal()
 {
+#if defined(HAVE_JTC_FUTEX)
+    wake_recursive(1);
+#endif
+
 #if defined(HAVE_POSIX_THREADS)
     JTC_SYSCALL_1(pthread_cond_signal, &m_cond, != 0)
 #endif
@@ -327,6 +338,10 @@ JTCCond::signal()
 void
 JTCCond::broadcast()
 {
+#if defined(HAVE_JTC_FUTEX)
+    wake_recursive(INT_MAX);
+#endif
+
 #if defined(HAVE_POSIX_THREADS)
     JTC_SYSCALL_1(pthread_cond_broadcast,&m_cond, != 0)
 #endif
@@ -348,7 +363,36 @@ JTCCond::broadcast()
 bool
 JTCCond::wait_internal(JTCRecursiveMutex& mutex, long timeout)
 {
-#if defined(HAVE_POSIX_THREADS)
+#if defined(HAVE_JTC_FUTEX)
+    //
+    // m_seq is read while the mutex is held, so a signal sent after
+    // the mutex is released makes the futex wait return at once.
+    //
+    int seq = __atomic_load_n(&m_seq, __ATOMIC_RELAXED);
+    m_mutex_state = &mutex.m_state;
+    ++m_waiters;
+    unsigned int count = mutex.reset_for_condvar();
+
+    struct timespec reltime;
+    struct timespec* preltime = 0;
+    if (timeout >= 0)
+    {
+	reltime.tv_sec = timeout / 1000;
+	reltime.tv_nsec = (timeout % 1000) * 1000000;
+	preltime = &reltime;
+    }
+    int rc = jtc_futex_wait(&m_seq, seq, preltime);
+
+    mutex.lock_for_condvar(count);
+    --m_waiters;
+
+    //
+    // A requeued waiter may time out on the mutex, it was signaled
+    // nevertheless.
+    //
+    return rc != ETIMEDOUT || __atomic_load_n(&m_seq, __ATOMIC_RELAXED) != seq;
+
+#elif defined(HAVE_POSIX_THREADS)
     try
     {
 	unsigned int count = mutex.reset_for_condvar();
@@ -481,6 +525,39 @@ JTCCond::wait_internal(JTCMutex& mutex, long timeout)
 #endif
 }
 
+#if defined(HAVE_JTC_FUTEX)
+//
+// Wake up to n threads waiting with a recursive mutex. The caller
+// holds that mutex (monitor notifications are sent before it is
+// released), so the woken threads are moved to the mutex futex and
+// run once the caller releases it.
+//
+void
+JTCCond::wake_recursive(int n)
+{
+    if (m_waiters == 0)
+	return;
+
+    int seq = __atomic_add_fetch(&m_seq, 1, __ATOMIC_RELAXED);
+
+    //
+    // The requeued threads are only woken by a release that sees the
+    // mutex contended.
+    //
+    int c = 1;
+    __atomic_compare_exchange_n(m_mutex_state, &c, 2, false,
+				__ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    if (c == 0 || !jtc_futex_requeue(&m_seq, n, m_mutex_state, seq))
+    {
+	//
+	// Mutex not held by the caller or a concurrent signal: plain
+	// wake up.
+	//
+	jtc_futex_wake(&m_seq, n);
+    }
+}
+#endif
+
 #if defined(HAVE_POSIX_THREADS)
 struct timespec
 JTCCond::calc_timeout(long timeout)
@@ -0,0 +1,780 @@
+// **********************************************************************
+//
+// Copyright (c) 2002
+// IONA Technologies, Inc.
+// Waltham, MA, USA
+//
+// All Rights Reserved
+//
+// **********************************************************************
+
+#include <Executor.h>
+#include <Thread.h>
+#include <ThreadGroup.h>
+#include <Runnable.h>
+#include <SyncT.h>
+#include <Exception.h>
+#include <HandleI.h>
+
+#include <deque>
+#include <map>
+#include <vector>
+#include <chrono>
+#include <stdio.h>
+#include <assert.h>
+
+#if defined(HAVE_POSIX_THREADS)
+#   include <unistd.h>
+#endif
+
+#ifndef HAVE_NO_EXPLICIT_TEMPLATES
+template class JTCHandleT<JTCExecutor>;
+#else
+#  ifdef HAVE_PRAGMA_DEFINE
+#    pragma define(JTCHandleT<JTCExecutor>)
+#  endif
+#endif
+
+//
+// Implementation notes:
+//
+// The worker deques are Chase-Lev deques ("Dynamic Circular
+// Work-Stealing Deque", with the memory orderings of Le et al,
+// "Correct and Efficient Work-Stealing for Weak Memory Models"). The
+// owner pushes and takes at the bottom without locking, thieves take
+// from the top with a single CAS. A full deque doubles its array, the
+// old arrays are kept until the deque is destroyed since a thief may
+// still be reading one of them. Without the GCC atomic builtins the
+// deque falls back to a mutex.
+//
+// Workers park on the executor monitor. A worker increments m_idle and
+// checks for work again before waiting, a submitter publishes its task
+// and then reads m_idle. Both sides use sequentially consistent
+// operations so at least one of them sees the other and no task is
+// left behind with every worker parked.
+//
+
+// ----------------------------------------------------------------------
+// JTCWorkDeque
+// ----------------------------------------------------------------------
+
+#if defined(__GNUC__)
+
+class JTCWorkDeque
+{
+public:
+
+    JTCWorkDeque()
+        : m_top(0), m_bottom(0), m_array(new Array(64))
+    {
+    }
+
+    ~JTCWorkDeque()
+    {
+	delete m_array;
+	for (size_t i = 0; i < m_retired.size(); ++i)
+	    delete m_retired[i];
+    }
+
+    //
+    // Push a task. Called by the owner only.
+    //
+    void
+    push(JTCRunnableHandle* task)
+    {
+	long b = __atomic_load_n(&m_bottom, __ATOMIC_RELAXED);
+	long t = __atomic_load_n(&m_top, __ATOMIC_ACQUIRE);
+	Array* a = __atomic_load_n(&m_array, __ATOMIC_RELAXED);
+	if (b - t > a -> m_size - 1)
+	    a = grow(a, t, b);
+	a -> put(b, task);
+	__atomic_store_n(&m_bottom, b + 1, __ATOMIC_RELEASE);
+    }
+
+    //
+    // Take the most recently pushed task. Called by the owner only.
+    //
+    JTCRunnableHandle*
+    take()
+    {
+	long b = __atomic_load_n(&m_bottom, __ATOMIC_RELAXED) - 1;
+	Array* a = __atomic_load_n(&m_array, __ATOMIC_RELAXED);
+	__atomic_store_n(&m_bottom, b, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	long t = __atomic_load_n(&m_top, __ATOMIC_RELAXED);
+
+	JTCRunnableHandle* task = 0;
+	if (t <= b)
+	{
+	    task = a -> get(b);
+	    if (t == b)
+	    {
+		//
+		// Last task, race the thieves for it.
+		//
+		if (!__atomic_compare_exchange_n(&m_top, &t, t + 1, false,
+						 __ATOMIC_SEQ_CST,
+						 __ATOMIC_RELAXED))
+		    task = 0;
+		__atomic_store_n(&m_bottom, b + 1, __ATOMIC_RELAXED);
+	    }
+	}
+	else
+	{
+	    __atomic_store_n(&m_bottom, b + 1, __ATOMIC_RELAXED);
+	}
+	return task;
+    }
+
+    //
+    // Take the oldest task. Called by any thread. lost is set if
+    // another thread won the race for the task.
+    //
+    JTCRunnableHandle*
+    steal(bool& lost)
+    {
+	long t = __atomic_load_n(&m_top, __ATOMIC_ACQUIRE);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	long b = __atomic_load_n(&m_bottom, __ATOMIC_ACQUIRE);
+
+	lost = false;
+	if (t >= b)
+	    return 0;
+
+	Array* a = __atomic_load_n(&m_array, __ATOMIC_ACQUIRE);
+	JTCRunnableHandle* task = a -> get(t);
+	if (!__atomic_compare_exchange_n(&m_top, &t, t + 1, false,
+					 __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+	{
+	    lost = true;
+	    return 0;
+	}
+	return task;
+    }
+
+    bool
+    empty() const
+    {
+	long b = __atomic_load_n(&m_bottom, __ATOMIC_SEQ_CST);
+	long t = __atomic_load_n(&m_top, __ATOMIC_SEQ_CST);
+	return t >= b;
+    }
+
+private:
+
+    struct Array
+    {
+	long m_size; // Always a power of two
+	JTCRunnableHandle** m_slots;
+
+	Array(long size)
+	    : m_size(size), m_slots(new JTCRunnableHandle*[size])
+	{
+	}
+
+	~Array()
+	{
+	    delete[] m_slots;
+	}
+
+	JTCRunnableHandle*
+	get(long i) const
+	{
+	    return __atomic_load_n(&m_slots[i & (m_size - 1)],
+				   __ATOMIC_RELAXED);
+	}
+
+	void
+	put(long i, JTCRunnableHandle* task)
+	{
+	    __atomic_store_n(&m_slots[i & (m_size - 1)], task,
+			     __ATOMIC_RELAXED);
+	}
+    };
+
+    Array*
+    grow(Array* a, long t, long b)
+    {
+	Array* bigger = new Array(a -> m_size * 2);
+	for (long i = t; i < b; ++i)
+	    bigger -> put(i, a -> get(i));
+	m_retired.push_back(a);
+	__atomic_store_n(&m_array, bigger, __ATOMIC_RELEASE);
+	return bigger;
+    }
+
+    //
+    // top and bottom are written by different threads, keep them on
+    // separate cache lines.
+    //
+    long m_top;
+    char m_pad[64 - sizeof(long)];
+    long m_bottom;
+    Array* m_array;
+    std::vector<Array*> m_retired;
+};
+
+#else
+
+class JTCWorkDeque
+{
+public:
+
+    void
+    push(JTCRunnableHandle* task)
+    {
+	JTCSyncT<JTCMutex> guard(m_mutex);
+	m_tasks.push_back(task);
+    }
+
+    JTCRunnableHandle*
+    take()
+    {
+	JTCSyncT<JTCMutex> guard(m_mutex);
+	if (m_tasks.empty())
+	    return 0;
+	JTCRunnableHandle* task = m_tasks.back();
+	m_tasks.pop_back();
+	return task;
+    }
+
+    JTCRunnableHandle*
+    steal(bool& lost)
+    {
+	lost = false;
+	JTCSyncT<JTCMutex> guard(m_mutex);
+	if (m_tasks.empty())
+	    return 0;
+	JTCRunnableHandle* task = m_tasks.front();
+	m_tasks.pop_front();
+	return task;
+    }
+
+    bool
+    empty() const
+    {
+	JTCSyncT<JTCMutex> guard(m_mutex);
+	return m_tasks.empty();
+    }
+
+private:
+
+    JTCMutex m_mutex;
+    std::deque<JTCRunnableHandle*> m_tasks;
+};
+
+#endif
+
+//
+// Counters shared between submitters and parked workers.
+//
+#if defined(__GNUC__)
+#   define JTC_EXECUTOR_LOAD(v) __atomic_load_n(&(v), __ATOMIC_SEQ_CST)
+#   define JTC_EXECUTOR_INC(v) __atomic_add_fetch(&(v), 1, __ATOMIC_SEQ_CST)
+#   define JTC_EXECUTOR_DEC(v) __atomic_sub_fetch(&(v), 1, __ATOMIC_SEQ_CST)
+#   define JTC_EXECUTOR_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#   define JTC_EXECUTOR_LOAD(v) InterlockedCompareExchange((long*)&(v), 0, 0)
+#   define JTC_EXECUTOR_INC(v) InterlockedIncrement((long*)&(v))
+#   define JTC_EXECUTOR_DEC(v) InterlockedDecrement((long*)&(v))
+#   define JTC_EXECUTOR_FENCE() MemoryBarrier()
+#endif
+
+// ----------------------------------------------------------------------
+// JTCExecutorQueue
+// ----------------------------------------------------------------------
+
+//
+// The injection queue. Guarded by the executor monitor.
+//
+class JTCExecutorQueue : public std::deque<JTCRunnableHandle*>
+{
+};
+
+// ----------------------------------------------------------------------
+// JTCExecutorWorker
+// ----------------------------------------------------------------------
+
+class JTCExecutorWorker : public JTCThread
+{
+public:
+
+    JTCExecutorWorker(JTCExecutor* executor, JTCThreadGroupHandle& group,
+		      const char* name, int index)
+	: JTCThread(group, name), m_executor(executor),
+	  m_seed(2654435761u * (unsigned)(index + 1))
+    {
+    }
+
+    virtual void
+    run()
+    {
+	JTCRunnableHandle* task;
+	while ((task = m_executor -> next(this)) != 0)
+	{
+	    try
+	    {
+		(*task) -> run();
+	    }
+	    catch(const JTCException& e)
+	    {
+		getThreadGroup() -> uncaughtException(this, e);
+	    }
+	    catch(...)
+	    {
+		getThreadGroup() -> uncaughtException(this);
+	    }
+	    delete task;
+	}
+    }
+
+    //
+    // xorshift, picks the first victim to steal from.
+    //
+    unsigned
+    random()
+    {
+	m_seed ^= m_seed << 13;
+	m_seed ^= m_seed >> 17;
+	m_seed ^= m_seed << 5;
+	return m_seed;
+    }
+
+    JTCExecutor* m_executor;
+    JTCWorkDeque m_deque;
+    unsigned m_seed;
+};
+
+// ----------------------------------------------------------------------
+// JTCExecutorTimer
+// ----------------------------------------------------------------------
+
+class JTCExecutorTimer : public JTCThread, public JTCMonitor
+{
+public:
+
+    typedef std::chrono::steady_clock Clock;
+
+    JTCExecutorTimer(JTCExecutor* executor, JTCThreadGroupHandle& group,
+		     const char* name)
+	: JTCThread(group, name), m_executor(executor), m_done(false)
+    {
+    }
+
+    ~JTCExecutorTimer()
+    {
+	clear();
+    }
+
+    bool
+    add(const JTCRunnableHandle& task, long millis)
+    {
+	JTCSyncT<JTCMonitor> sync(*this);
+	if (m_done)
+	    return false;
+	Clock::time_point due = Clock::now() +
+	    std::chrono::milliseconds(millis < 0 ? 0 : millis);
+	bool first = m_tasks.empty() || due < m_tasks.begin() -> first;
+	m_tasks.insert(std::make_pair(due, new JTCRunnableHandle(task)));
+	if (first)
+	    notify();
+	return true;
+    }
+
+    void
+    close()
+    {
+	JTCSyncT<JTCMonitor> sync(*this);
+	m_done = true;
+	clear();
+	notify();
+    }
+
+    virtual void
+    run()
+    {
+	std::vector<JTCRunnableHandle*> due;
+	for (;;)
+	{
+	    {
+		JTCSyncT<JTCMonitor> sync(*this);
+		while (!m_done)
+		{
+		    if (m_tasks.empty())
+		    {
+			wait();
+			continue;
+		    }
+		    Clock::time_point now = Clock::now();
+		    if (m_tasks.begin() -> first <= now)
+			break;
+		    long millis = (long)std::chrono::duration_cast<
+			std::chrono::milliseconds>(m_tasks.begin() -> first -
+						   now).count();
+		    wait(millis > 0 ? millis : 1);
+		}
+		if (m_done)
+		    return;
+
+		Clock::time_point now = Clock::now();
+		while (!m_tasks.empty() && m_tasks.begin() -> first <= now)
+		{
+		    due.push_back(m_tasks.begin() -> second);
+		    m_tasks.erase(m_tasks.begin());
+		}
+	    }
+
+	    //
+	    // Hand the due tasks over outside of the timer lock.
+	    //
+	    for (size_t i = 0; i < due.size(); ++i)
+	    {
+		m_executor -> execute(*due[i]);
+		delete due[i];
+	    }
+	    due.clear();
+	}
+    }
+
+private:
+
+    void
+    clear()
+    {
+	std::multimap<Clock::time_point, JTCRunnableHandle*>::iterator p;
+	for (p = m_tasks.begin(); p != m_tasks.end(); ++p)
+	    delete p -> second;
+	m_tasks.clear();
+    }
+
+    JTCExecutor* m_executor;
+    bool m_done;
+    std::multimap<Clock::time_point, JTCRunnableHandle*> m_tasks;
+};
+
+// ----------------------------------------------------------------------
+// JTCExecutor constructor and destructor
+// ----------------------------------------------------------------------
+
+JTCExecutor::JTCExecutor(const char* name, int nthreads)
+{
+    init(JTCThread::currentThread() -> getThreadGroup(), name, nthreads);
+}
+
+JTCExecutor::JTCExecutor(JTCThreadGroupHandle& parent, const char* name,
+			 int nthreads)
+{
+    init(parent, name, nthreads);
+}
+
+JTCExecutor::~JTCExecutor()
+{
+    if (!m_shutdown)
+	shutdown();
+
+    //
+    // shutdown() does not join when it is called from a task. The
+    // workers use m_workers until they terminate.
+    //
+    if (m_started)
+    {
+	assert(current_worker() == 0);
+	join_workers();
+    }
+
+    for (JTCExecutorQueue::iterator p = m_queue -> begin();
+	 p != m_queue -> end(); ++p)
+	delete *p;
+    delete m_queue;
+    delete[] m_workers;
+    delete[] m_threads;
+}
+
+// ----------------------------------------------------------------------
+// JTCExecutor private member implementation
+// ----------------------------------------------------------------------
+
+void
+JTCExecutor::init(const JTCThreadGroupHandle& parent, const char* name,
+		  int nthreads)
+{
+    if (nthreads <= 0)
+    {
+#if defined(HAVE_POSIX_THREADS)
+	nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#elif defined(HAVE_WIN32_THREADS)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	nthreads = (int)info.dwNumberOfProcessors;
+#endif
+	if (nthreads <= 0)
+	    nthreads = 1;
+    }
+
+    m_group = new JTCThreadGroup(parent, name);
+    m_nthreads = nthreads;
+    m_workers = new JTCExecutorWorker*[nthreads];
+    m_threads = new JTCThreadHandle[nthreads];
+    m_timer = 0;
+    m_queue = new JTCExecutorQueue;
+    m_idle = 0;
+    m_started = false;
+    m_shutdown = false;
+    m_joined = false;
+}
+
+JTCExecutorWorker*
+JTCExecutor::current_worker() const
+{
+    JTCExecutorWorker* worker =
+	dynamic_cast<JTCExecutorWorker*>(JTCThread::currentThread());
+    if (worker != 0 && worker -> m_executor == this)
+	return worker;
+    return 0;
+}
+
+JTCRunnableHandle*
+JTCExecutor::next(JTCExecutorWorker* worker)
+{
+    for (;;)
+    {
+	JTCRunnableHandle* task = worker -> m_deque.take();
+	if (task != 0)
+	    return task;
+
+	task = steal(worker);
+	if (task != 0)
+	    return task;
+
+	JTCSyncT<JTCMonitor> sync(*this);
+
+	if (!m_queue -> empty())
+	{
+	    task = m_queue -> front();
+	    m_queue -> pop_front();
+
+	    //
+	    // Move a share of the injection queue to this worker so the
+	    // others can steal it without taking the monitor.
+	    //
+	    size_t share = m_queue -> size() / m_nthreads;
+	    if (share > 0)
+	    {
+		for (size_t i = 0; i < share; ++i)
+		{
+		    worker -> m_deque.push(m_queue -> front());
+		    m_queue -> pop_front();
+		}
+		if (JTC_EXECUTOR_LOAD(m_idle) > 0)
+		    notify();
+	    }
+	    return task;
+	}
+
+	JTC_EXECUTOR_INC(m_idle);
+	if (!has_work())
+	{
+	    if (m_shutdown)
+	    {
+		JTC_EXECUTOR_DEC(m_idle);
+		return 0;
+	    }
+	    wait();
+	}
+	JTC_EXECUTOR_DEC(m_idle);
+    }
+}
+
+JTCRunnableHandle*
+JTCExecutor::steal(JTCExecutorWorker* worker)
+{
+    if (m_nthreads == 1)
+	return 0;
+
+    bool retry;
+    do
+    {
+	retry = false;
+	int start = (int)(worker -> random() % (unsigned)m_nthreads);
+	for (int i = 0; i < m_nthreads; ++i)
+	{
+	    JTCExecutorWorker* victim = m_workers[(start + i) % m_nthreads];
+	    if (victim == worker)
+		continue;
+
+	    bool lost;
+	    JTCRunnableHandle* task = victim -> m_deque.steal(lost);
+	    if (task != 0)
+		return task;
+	    if (lost)
+		retry = true;
+	}
+    }
+    while (retry);
+
+    return 0;
+}
+
+bool
+JTCExecutor::has_work() const
+{
+    if (!m_queue -> empty())
+	return true;
+    if (!m_started)
+	return false;
+    for (int i = 0; i < m_nthreads; ++i)
+    {
+	if (!m_workers[i] -> m_deque.empty())
+	    return true;
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------
+// JTCExecutor public member implementation
+// ----------------------------------------------------------------------
+
+void
+JTCExecutor::start()
+{
+    JTCSyncT<JTCMonitor> sync(*this);
+    if (m_started || m_shutdown)
+	throw JTCIllegalThreadStateException("executor already started");
+
+    //
+    // All workers exist before the first one runs, thieves walk the
+    // whole array.
+    //
+    char name[256];
+    for (int i = 0; i < m_nthreads; ++i)
+    {
+	snprintf(name, sizeof(name), "%s-%d", m_group -> getName(), i);
+	m_workers[i] = new JTCExecutorWorker(this, m_group, name, i);
+	m_threads[i] = m_workers[i];
+    }
+    snprintf(name, sizeof(name), "%s-timer", m_group -> getName());
+    m_timer = new JTCExecutorTimer(this, m_group, name);
+    m_timer_thread = m_timer;
+
+    m_started = true;
+    for (int i = 0; i < m_nthreads; ++i)
+	m_threads[i] -> start();
+    m_timer_thread -> start();
+}
+
+bool
+JTCExecutor::execute(const JTCRunnableHandle& task)
+{
+    JTCExecutorWorker* worker = current_worker();
+    if (worker != 0)
+    {
+	//
+	// Fast path: tasks submitted by a task stay on this worker.
+	//
+	worker -> m_deque.push(new JTCRunnableHandle(task));
+	JTC_EXECUTOR_FENCE();
+	if (JTC_EXECUTOR_LOAD(m_idle) > 0)
+	{
+	    JTCSyncT<JTCMonitor> sync(*this);
+	    notify();
+	}
+	return true;
+    }
+
+    JTCSyncT<JTCMonitor> sync(*this);
+    if (m_shutdown)
+	return false;
+    m_queue -> push_back(new JTCRunnableHandle(task));
+    if (JTC_EXECUTOR_LOAD(m_idle) > 0)
+	notify();
+    return true;
+}
+
+bool
+JTCExecutor::schedule(const JTCRunnableHandle& task, long millis)
+{
+    JTCExecutorTimer* timer;
+    {
+	JTCSyncT<JTCMonitor> sync(*this);
+	if (m_shutdown)
+	    return false;
+	if (!m_started)
+	    throw JTCIllegalThreadStateException("executor not started");
+	timer = m_timer;
+    }
+    return timer -> add(task, millis);
+}
+
+void
+JTCExecutor::shutdown()
+{
+    {
+	JTCSyncT<JTCMonitor> sync(*this);
+	if (m_shutdown)
+	    return;
+	m_shutdown = true;
+	notifyAll();
+    }
+
+    if (!m_started)
+	return;
+
+    m_timer -> close();
+
+    //
+    // A task cannot wait for its own worker.
+    //
+    if (current_worker() != 0)
+	return;
+
+    join_workers();
+}
+
+void
+JTCExecutor::join_workers()
+{
+    if (m_joined)
+	return;
+    m_joined = true;
+
+    m_timer_thread -> join();
+    for (int i = 0; i < m_nthreads; ++i)
+	m_threads[i] -> join();
+}
+
+bool
+JTCExecutor::isShutdown() const
+{
+    JTCSyncT<JTCMonitor> sync(*this);
+    return m_shutdown;
+}
+
+int
+JTCExecutor::size() const
+{
+    return m_nthreads;
+}
+
+const char*
+JTCExecutor::getName() const
+{
+    return m_group -> getName();
+}
+
+JTCThreadGroupHandle
+JTCExecutor::getThreadGroup() const
+{
+    return m_group;
+}
+
+bool
+JTCExecutor::isDaemon() const
+{
+    return m_group -> isDaemon();
+}
+
+void
+JTCExecutor::setDaemon(bool daemon)
+{
+    m_group -> setDaemon(daemon);
+}
@@ -118,6 +118,10 @@ JTCMonitorBase::validate_owner(const JTCThreadId& id, const char* caller) const
 // upon initial acquisition of the monitor lock (either through a call
 // to lock(), or a return from wait().
 //
+// With futexes (HAVE_JTC_FUTEX) the notified threads are requeued onto
+// the monitor mutex rather than woken, so they run once the monitor is
+// released instead of waking up only to block on it again.
+//
 
 // ----------------------------------------------------------------------
 // JTCMonitorT constructor and destructor
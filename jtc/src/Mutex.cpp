@@ -9,6 +9,7 @@
 // **********************************************************************
 
 #include <Mutex.h>
+#include <Futex.h>
 
 #include <stdlib.h>
 #include <assert.h>
@@ -20,6 +21,25 @@ using namespace std;
 #   endif
 #endif // !HAVE_JTC_NO_IOSTREAM
 
+#if defined(HAVE_JTC_FUTEX)
+
+// ----------------------------------------------------------------------
+// JTCRecursiveMutex constructor and destructor
+// ----------------------------------------------------------------------
+
+JTCRecursiveMutex::JTCRecursiveMutex()
+    : m_state(0),
+      m_owner(0),
+      m_count(0)
+{
+}
+
+JTCRecursiveMutex::~JTCRecursiveMutex()
+{
+}
+
+#else
+
 // ----------------------------------------------------------------------
 // JTCRecursiveMutex constructor and destructor
 // ----------------------------------------------------------------------
@@ -48,6 +68,8 @@ JTCRecursiveMutex::~JTCRecursiveMutex()
 #endif
 }
 
+#endif
+
 // ----------------------------------------------------------------------
 // JTCRecursiveMutex public member implementation
 // ----------------------------------------------------------------------
@@ -88,6 +110,149 @@ JTCRecursiveMutex::trylock() const
     return ((JTCRecursiveMutex*)this) -> trylock_internal();
 }
 
+#if defined(HAVE_JTC_FUTEX)
+
+//
+// Implementation notes:
+//
+// m_state is the futex word (see "Futexes Are Tricky", U. Drepper):
+// 0 unlocked, 1 locked, 2 locked and threads may be blocked. Only the
+// owner writes m_count. m_owner is written by the owner and read by
+// other threads only to find out that they are not the owner, so
+// relaxed atomic accesses are sufficient.
+//
+
+//
+// Return the ID of the owning thread. If the mutex isn't locked then
+// return nullThreadId.
+//
+JTCThreadId
+JTCRecursiveMutex::get_owner() const
+{
+    pthread_t owner = __atomic_load_n(&m_owner, __ATOMIC_RELAXED);
+    if (owner == 0)
+	return JTCThreadId();
+    return JTCThreadId(owner);
+}
+
+// ----------------------------------------------------------------------
+// JTCRecursiveMutex private member implementation
+// ----------------------------------------------------------------------
+
+void
+JTCRecursiveMutex::acquire(bool contended)
+{
+    int c = 0;
+    if (!contended &&
+	__atomic_compare_exchange_n(&m_state, &c, 1, false,
+				    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+	return;
+    }
+
+    //
+    // Mark the mutex contended so that release() wakes us, and sleep
+    // until it is released.
+    //
+    if (contended || c != 2)
+	c = __atomic_exchange_n(&m_state, 2, __ATOMIC_ACQUIRE);
+    while (c != 0)
+    {
+	jtc_futex_wait(&m_state, 2, 0);
+	c = __atomic_exchange_n(&m_state, 2, __ATOMIC_ACQUIRE);
+    }
+}
+
+void
+JTCRecursiveMutex::release()
+{
+    if (__atomic_fetch_sub(&m_state, 1, __ATOMIC_RELEASE) != 1)
+    {
+	__atomic_store_n(&m_state, 0, __ATOMIC_RELEASE);
+	jtc_futex_wake(&m_state, 1);
+    }
+}
+
+bool
+JTCRecursiveMutex::lock_internal(int count)
+{
+    pthread_t self = pthread_self();
+    if (__atomic_load_n(&m_owner, __ATOMIC_RELAXED) == self)
+    {
+	m_count += count;
+	return false;
+    }
+
+    acquire(false);
+    __atomic_store_n(&m_owner, self, __ATOMIC_RELAXED);
+    m_count = count;
+    return true;
+}
+
+bool
+JTCRecursiveMutex::trylock_internal()
+{
+    pthread_t self = pthread_self();
+    if (__atomic_load_n(&m_owner, __ATOMIC_RELAXED) == self)
+    {
+	++m_count;
+	return true;
+    }
+
+    int c = 0;
+    if (!__atomic_compare_exchange_n(&m_state, &c, 1, false,
+				     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+	return false;
+    }
+    __atomic_store_n(&m_owner, self, __ATOMIC_RELAXED);
+    m_count = 1;
+    return true;
+}
+
+bool
+JTCRecursiveMutex::unlock_internal()
+{
+    if (--m_count != 0)
+	return false;
+
+    __atomic_store_n(&m_owner, (pthread_t)0, __ATOMIC_RELAXED);
+    release();
+    return true;
+}
+
+//
+// Lock the mutex count times.
+//
+void
+JTCRecursiveMutex::lock(unsigned int count) const
+{
+    //
+    // Work around lack of mutable.
+    //
+    ((JTCRecursiveMutex*)this) -> lock_internal(count);
+}
+
+unsigned int
+JTCRecursiveMutex::reset_for_condvar()
+{
+    unsigned int count = m_count;
+    m_count = 0;
+    __atomic_store_n(&m_owner, (pthread_t)0, __ATOMIC_RELAXED);
+    release();
+    return count;
+}
+
+void
+JTCRecursiveMutex::lock_for_condvar(unsigned int count)
+{
+    acquire(true);
+    __atomic_store_n(&m_owner, pthread_self(), __ATOMIC_RELAXED);
+    m_count = count;
+}
+
+#else
+
 //
 // Return the ID of the owning thread. If the mutex isn't locked then
 // return nullThreadId.
@@ -356,3 +521,5 @@ JTCRecursiveMutex::reset_for_condvar()
 
     return count;
 }
+
+#endif
@@ -41,6 +41,7 @@
 
 #if defined(HAVE_POSIX_THREADS)
 #   include <unistd.h>
+#   include <limits.h>
 #   include <sys/types.h>
 #endif
 
@@ -260,6 +261,7 @@ JTCThread::init(const JTCThreadGroupHandle& group, JTCRunnableHandle target,
 #ifndef WIN32
     m_detached = false;
 #endif
+    m_stack_size = 0;
     m_thread_number = get_next_thread_number();
     ++m_refcount; // We're referencing outself.  Boost the reference count.
     m_is_adopted = false; // The thread was not adopted
@@ -320,6 +322,7 @@ JTCThread::JTCThread(JTCThreadId id, bool main)
 #ifndef WIN32
     m_detached = true;
 #endif
+    m_stack_size = 0;
     m_thread_number = get_next_thread_number();
     m_state = JTCThread::runnable;
 #ifdef WIN32
@@ -616,6 +619,147 @@ JTCThread::getPriority() const
 #endif
 }
 
+//
+// Set the stack size of the thread.
+//
+void
+JTCThread::setStackSize(size_t bytes)
+{
+    JTCSyncT<JTCMutex> guard(m_mutex);
+
+    if (m_state != JTCThread::new_thread)
+    {
+	throw JTCIllegalThreadStateException("state is not new_thread");
+    }
+    m_stack_size = bytes;
+}
+
+//
+// Get the requested stack size of the thread.
+//
+size_t
+JTCThread::getStackSize() const
+{
+    JTCSyncT<JTCMutex> guard(m_mutex);
+    return m_stack_size;
+}
+
+//
+// Set the stack size of threads that don't set their own.
+//
+void
+JTCThread::setDefaultStackSize(size_t bytes)
+{
+    lsd_initial_stack_size = bytes;
+}
+
+//
+// Restrict the thread to a set of processors.
+//
+void
+JTCThread::setAffinity(const int* cpus, int ncpus)
+{
+    JTCSyncT<JTCMutex> guard(m_mutex);
+
+    if (m_state == JTCThread::new_thread || m_state == JTCThread::dead)
+    {
+	throw JTCIllegalThreadStateException("thread is not running");
+    }
+    if (ncpus < 0 || (ncpus > 0 && cpus == 0))
+    {
+	throw JTCIllegalArgumentException("bad cpu list");
+    }
+
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (ncpus == 0)
+    {
+	long n = sysconf(_SC_NPROCESSORS_CONF);
+	for (long i = 0; i < n && i < CPU_SETSIZE; ++i)
+	    CPU_SET(i, &set);
+    }
+    for (int i = 0; i < ncpus; ++i)
+    {
+	if (cpus[i] < 0 || cpus[i] >= CPU_SETSIZE)
+	{
+	    throw JTCIllegalArgumentException("cpu out of range");
+	}
+	CPU_SET(cpus[i], &set);
+    }
+    JTC_SYSCALL_3(pthread_setaffinity_np, m_thread_id, sizeof(set), &set,
+		  != 0)
+#elif defined(HAVE_WIN32_THREADS)
+    DWORD_PTR mask = 0;
+    if (ncpus == 0)
+    {
+	DWORD_PTR system_mask;
+	JTC_SYSCALL_3(GetProcessAffinityMask, GetCurrentProcess(), &mask,
+		      &system_mask, == 0)
+    }
+    for (int i = 0; i < ncpus; ++i)
+    {
+	if (cpus[i] < 0 || cpus[i] >= (int)(sizeof(mask) * 8))
+	{
+	    throw JTCIllegalArgumentException("cpu out of range");
+	}
+	mask |= (DWORD_PTR)1 << cpus[i];
+    }
+    JTC_SYSCALL_2(SetThreadAffinityMask, m_handle, mask, == 0)
+#else
+    throw JTCIllegalArgumentException("cpu affinity not supported");
+#endif
+}
+
+//
+// Set the scheduling policy of the thread.
+//
+void
+JTCThread::setSchedPolicy(SchedPolicy policy, int priority)
+{
+    JTCSyncT<JTCMutex> guard(m_mutex);
+
+    if (m_state == JTCThread::new_thread || m_state == JTCThread::dead)
+    {
+	throw JTCIllegalThreadStateException("thread is not running");
+    }
+
+#if defined(HAVE_POSIX_THREADS)
+    int native;
+    switch(policy)
+    {
+    case JTC_SCHED_OTHER:
+	native = SCHED_OTHER;
+	break;
+    case JTC_SCHED_FIFO:
+	native = SCHED_FIFO;
+	break;
+    case JTC_SCHED_RR:
+	native = SCHED_RR;
+	break;
+    default:
+	throw JTCIllegalArgumentException("unknown scheduling policy");
+    }
+    if (priority < sched_get_priority_min(native) ||
+	priority > sched_get_priority_max(native))
+    {
+	throw JTCIllegalArgumentException("priority out of range");
+    }
+    sched_param param;
+    param.sched_priority = priority;
+    JTC_SYSCALL_3(pthread_setschedparam, m_thread_id, native, &param, != 0)
+#endif
+#if defined(HAVE_WIN32_THREADS)
+    //
+    // There are no realtime policies per thread, the realtime ones map
+    // to the highest priority.
+    //
+    int native = policy == JTC_SCHED_OTHER ? THREAD_PRIORITY_NORMAL :
+	THREAD_PRIORITY_TIME_CRITICAL;
+    JTC_SYSCALL_2(SetThreadPriority, m_handle, native, == 0)
+#endif
+}
+
 //
 // Start execution of the thread.
 //
@@ -658,9 +802,24 @@ JTCThread::start()
 #   endif
 
 #   ifdef HAVE_PTHREAD_ATTR_SETSTACKSIZE
-    if (lsd_initial_stack_size != 0)
+    size_t stack_size = m_stack_size != 0 ? m_stack_size :
+	lsd_initial_stack_size;
+    if (stack_size != 0)
     {
-        pthread_attr_setstacksize(&attr, lsd_initial_stack_size);
+	//
+	// The size is rounded up to whole pages, too small sizes are
+	// raised to the minimum.
+	//
+	if (stack_size < (size_t)PTHREAD_STACK_MIN)
+	{
+	    stack_size = PTHREAD_STACK_MIN;
+	}
+	long page = sysconf(_SC_PAGESIZE);
+	if (page > 0)
+	{
+	    stack_size = (stack_size + page - 1) / page * page;
+	}
+        pthread_attr_setstacksize(&attr, stack_size);
     }
 #   endif
 
@@ -697,7 +856,7 @@ JTCThread::start()
     {
 	JTC_SYSCALL_6(
 	    m_handle = (HANDLE)::_beginthreadex,
-	    NULL, lsd_initial_stack_size,
+	    NULL, m_stack_size != 0 ? m_stack_size : lsd_initial_stack_size,
             (unsigned (__stdcall*)(void*))lsf_thread_adapter, (LPVOID)this,
 	    0, (unsigned int*)&id, == NULL)
     }
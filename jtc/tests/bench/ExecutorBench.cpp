@@ -0,0 +1,211 @@
+// ExecutorBench.cpp -- JTCExecutor throughput and latency.
+//
+// Compares JTCExecutor with what the servers do today: one dedicated
+// JTCThread that drains a JTCMonitor guarded queue. Not part of ctest;
+// run jtc_executor_bench by hand.
+//
+//   throughput (external) : empty tasks submitted from a non-pool thread
+//   throughput (fan-out)  : a binary tree of tasks submitted by tasks
+//   wake latency          : submit-to-run delay with an idle pool
+//   timer lateness        : how late delayed tasks start
+
+#include <JTC.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+class FnTask : public JTCRunnable
+{
+public:
+    explicit FnTask(std::function<void()> fn) : m_fn(std::move(fn)) {}
+    void run() override { m_fn(); }
+private:
+    std::function<void()> m_fn;
+};
+
+// One thread draining a monitor guarded queue
+class DedicatedThread : public JTCThread, public JTCMonitor
+{
+public:
+    DedicatedThread() : JTCThread("bench-dedicated"), m_stop(false) {}
+
+    void post(std::function<void()> fn)
+    {
+        JTCSynchronized sync(*this);
+        m_tasks.push_back(std::move(fn));
+        notify();
+    }
+
+    void stop()
+    {
+        JTCSynchronized sync(*this);
+        m_stop = true;
+        notify();
+    }
+
+    void run() override
+    {
+        for (;;) {
+            std::function<void()> fn;
+            {
+                JTCSynchronized sync(*this);
+                while (m_tasks.empty() && !m_stop)
+                    wait();
+                if (m_tasks.empty())
+                    return;
+                fn = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            fn();
+        }
+    }
+
+private:
+    std::deque<std::function<void()>> m_tasks;
+    bool m_stop;
+};
+
+double Ns(const Clock::time_point& a, const Clock::time_point& b)
+{
+    return std::chrono::duration<double, std::nano>(b - a).count();
+}
+
+void WaitFor(std::atomic<long>& count, long n)
+{
+    while (count.load() < n)
+        std::this_thread::yield();
+}
+
+double ExternalExecutor(JTCExecutor* ex, long n)
+{
+    std::atomic<long> count{0};
+    Clock::time_point start = Clock::now();
+    for (long i = 0; i < n; ++i)
+        ex->execute(new FnTask([&]() { ++count; }));
+    WaitFor(count, n);
+    return Ns(start, Clock::now()) / n;
+}
+
+double ExternalDedicated(DedicatedThread* t, long n)
+{
+    std::atomic<long> count{0};
+    Clock::time_point start = Clock::now();
+    for (long i = 0; i < n; ++i)
+        t->post([&]() { ++count; });
+    WaitFor(count, n);
+    return Ns(start, Clock::now()) / n;
+}
+
+void Tree(JTCExecutor* ex, int depth, std::atomic<long>* count)
+{
+    ++*count;
+    if (depth == 0)
+        return;
+    ex->execute(new FnTask([=]() { Tree(ex, depth - 1, count); }));
+    ex->execute(new FnTask([=]() { Tree(ex, depth - 1, count); }));
+}
+
+double FanOut(JTCExecutor* ex, int depth)
+{
+    std::atomic<long> count{0};
+    long n = (1L << (depth + 1)) - 1;
+    Clock::time_point start = Clock::now();
+    ex->execute(new FnTask([=, &count]() { Tree(ex, depth, &count); }));
+    WaitFor(count, n);
+    return Ns(start, Clock::now()) / n;
+}
+
+void Percentiles(std::vector<double>& v, double& p50, double& p99)
+{
+    std::sort(v.begin(), v.end());
+    p50 = v[v.size() / 2];
+    p99 = v[v.size() * 99 / 100];
+}
+
+template <class Submit>
+void WakeLatency(Submit submit, int rounds, double& p50, double& p99)
+{
+    std::vector<double> samples;
+    for (int i = 0; i < rounds; ++i) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        std::atomic<bool> ran{false};
+        Clock::time_point at;
+        Clock::time_point start = Clock::now();
+        submit([&]() { at = Clock::now(); ran = true; });
+        while (!ran.load())
+            std::this_thread::yield();
+        samples.push_back(Ns(start, at) / 1000.0);
+    }
+    Percentiles(samples, p50, p99);
+}
+
+void TimerLateness(JTCExecutor* ex, int n, double& p50, double& p99)
+{
+    std::vector<double> late(n);
+    std::atomic<int> done{0};
+    for (int i = 0; i < n; ++i) {
+        long delay = 1 + i % 20;
+        Clock::time_point due = Clock::now() + std::chrono::milliseconds(delay);
+        ex->schedule(new FnTask([&, i, due]() {
+            late[i] = Ns(due, Clock::now()) / 1000.0;
+            ++done;
+        }), delay);
+    }
+    while (done.load() < n)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    Percentiles(late, p50, p99);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    long scale = argc > 1 ? atol(argv[1]) : 1;
+    if (scale <= 0)
+        scale = 1;
+
+    JTCInitialize init;
+
+    JTCExecutorHandle ex = new JTCExecutor("bench");
+    ex->start();
+    JTCHandleT<DedicatedThread> dedicated = new DedicatedThread;
+    dedicated->start();
+
+    printf("%d workers\n\n", ex->size());
+    printf("%-28s %12s %12s\n", "throughput ns/task", "executor", "dedicated");
+    printf("%-28s %12.1f %12.1f\n", "external submit",
+           ExternalExecutor(ex.get(), 200000 * scale),
+           ExternalDedicated(dedicated.get(), 200000 * scale));
+    printf("%-28s %12.1f %12s\n", "fan-out (2^17 tasks)",
+           FanOut(ex.get(), 16), "-");
+
+    double p50, p99, d50, d99;
+    JTCExecutor* raw = ex.get();
+    DedicatedThread* draw = dedicated.get();
+    WakeLatency([raw](std::function<void()> fn) { raw->execute(new FnTask(fn)); },
+                2000, p50, p99);
+    WakeLatency([draw](std::function<void()> fn) { draw->post(fn); },
+                2000, d50, d99);
+    printf("\n%-28s %12s %12s\n", "latency us", "executor", "dedicated");
+    printf("%-28s %12.1f %12.1f\n", "wake p50", p50, d50);
+    printf("%-28s %12.1f %12.1f\n", "wake p99", p99, d99);
+
+    TimerLateness(ex.get(), 500, p50, p99);
+    printf("%-28s %12.1f %12s\n", "timer lateness p50", p50, "-");
+    printf("%-28s %12.1f %12s\n", "timer lateness p99", p99, "-");
+
+    dedicated->stop();
+    dedicated->join();
+    ex->shutdown();
+    return 0;
+}
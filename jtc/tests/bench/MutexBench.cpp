@@ -0,0 +1,192 @@
+// MutexBench.cpp -- JTCRecursiveMutex microbenchmarks.
+//
+// Compares JTCRecursiveMutex with the previous implementation (an internal
+// pthread mutex guarding owner/count in front of the real lock) and with
+// std::recursive_mutex. Not part of ctest; run jtc_bench by hand.
+//
+//   uncontended : one thread, lock/unlock (and a nested lock) in a loop
+//   ping-pong   : 2 threads hand a JTCMonitor-style turn back and forth
+//   contended   : 8 threads increment a shared counter
+
+#include <JTC.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// The recursive mutex jtc used before the futex fast path
+class LegacyRecursiveMutex
+{
+public:
+    LegacyRecursiveMutex() : m_count(0)
+    {
+        pthread_mutex_init(&m_internal, 0);
+        pthread_mutex_init(&m_lock, 0);
+    }
+
+    ~LegacyRecursiveMutex()
+    {
+        pthread_mutex_destroy(&m_internal);
+        pthread_mutex_destroy(&m_lock);
+    }
+
+    void lock()
+    {
+        pthread_t self = pthread_self();
+        for (;;) {
+            pthread_mutex_lock(&m_internal);
+            if (m_count == 0) {
+                m_count = 1;
+                m_owner = self;
+                pthread_mutex_lock(&m_lock);
+                pthread_mutex_unlock(&m_internal);
+                return;
+            }
+            if (pthread_equal(m_owner, self)) {
+                ++m_count;
+                pthread_mutex_unlock(&m_internal);
+                return;
+            }
+            pthread_mutex_unlock(&m_internal);
+            // wait for the owner to release, then retry
+            pthread_mutex_lock(&m_lock);
+            pthread_mutex_unlock(&m_lock);
+        }
+    }
+
+    void unlock()
+    {
+        pthread_mutex_lock(&m_internal);
+        if (--m_count == 0)
+            pthread_mutex_unlock(&m_lock);
+        pthread_mutex_unlock(&m_internal);
+    }
+
+private:
+    pthread_mutex_t m_internal;
+    pthread_mutex_t m_lock;
+    pthread_t m_owner;
+    unsigned m_count;
+};
+
+template <class M>
+double Uncontended(long iters)
+{
+    M m;
+    Clock::time_point start = Clock::now();
+    for (long i = 0; i < iters; ++i) {
+        m.lock();
+        m.lock();
+        m.unlock();
+        m.unlock();
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iters;
+}
+
+template <class M>
+double Contended(int threads, long iters)
+{
+    M m;
+    long counter = 0;
+    std::atomic<bool> go{false};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            JTCAdoptCurrentThread adopt;
+            while (!go.load())
+                std::this_thread::yield();
+            for (long i = 0; i < iters; ++i) {
+                m.lock();
+                ++counter;
+                m.unlock();
+            }
+        });
+    }
+    Clock::time_point start = Clock::now();
+    go = true;
+    for (auto& w : workers)
+        w.join();
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    if (counter != threads * iters)
+        fprintf(stderr, "counter mismatch: %ld\n", counter);
+    return ns / (threads * iters);
+}
+
+// Two threads take turns; each turn is a wait/notify round trip
+double PingPongMonitor(long rounds)
+{
+    JTCMonitor mon;
+    int turn = 0;
+    auto player = [&](int me) {
+        JTCAdoptCurrentThread adopt;
+        for (long i = 0; i < rounds; ++i) {
+            JTCSynchronized sync(mon);
+            while (turn != me)
+                mon.wait();
+            turn = 1 - me;
+            mon.notify();
+        }
+    };
+    Clock::time_point start = Clock::now();
+    std::thread a(player, 0), b(player, 1);
+    a.join();
+    b.join();
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (2 * rounds);
+}
+
+double PingPongStd(long rounds)
+{
+    std::mutex m;
+    std::condition_variable cv;
+    int turn = 0;
+    auto player = [&](int me) {
+        for (long i = 0; i < rounds; ++i) {
+            std::unique_lock<std::mutex> l(m);
+            cv.wait(l, [&]() { return turn == me; });
+            turn = 1 - me;
+            cv.notify_one();
+        }
+    };
+    Clock::time_point start = Clock::now();
+    std::thread a(player, 0), b(player, 1);
+    a.join();
+    b.join();
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (2 * rounds);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    long scale = argc > 1 ? atol(argv[1]) : 1;
+    if (scale <= 0)
+        scale = 1;
+
+    JTCInitialize init;
+
+    printf("%-28s %12s %12s %12s\n", "ns/op", "jtc", "legacy", "std");
+    printf("%-28s %12.1f %12.1f %12.1f\n", "uncontended (nested)",
+           Uncontended<JTCRecursiveMutex>(2000000 * scale),
+           Uncontended<LegacyRecursiveMutex>(2000000 * scale),
+           Uncontended<std::recursive_mutex>(2000000 * scale));
+    printf("%-28s %12.1f %12.1f %12.1f\n", "2 threads",
+           Contended<JTCRecursiveMutex>(2, 200000 * scale),
+           Contended<LegacyRecursiveMutex>(2, 200000 * scale),
+           Contended<std::recursive_mutex>(2, 200000 * scale));
+    printf("%-28s %12.1f %12.1f %12.1f\n", "8 threads",
+           Contended<JTCRecursiveMutex>(8, 50000 * scale),
+           Contended<LegacyRecursiveMutex>(8, 50000 * scale),
+           Contended<std::recursive_mutex>(8, 50000 * scale));
+    printf("%-28s %12.1f %12s %12.1f\n", "monitor ping-pong",
+           PingPongMonitor(20000 * scale), "-", PingPongStd(20000 * scale));
+    return 0;
+}
@@ -183,3 +183,83 @@ TEST_F(CondTest, RecursiveMutexTimedWaitTimeout)
     rm.unlock();
     rm.unlock();
 }
+
+// ---------------------------------------------------------------------------
+// With recursive mutex: signal while the signaler keeps the mutex past the
+// waiter's timeout. The waiter must still report that it was signaled.
+// ---------------------------------------------------------------------------
+
+TEST_F(CondTest, RecursiveMutexSignalWhileMutexHeld)
+{
+    JTCRecursiveMutex rm;
+    JTCCond cv;
+    std::atomic<bool> ready{false};
+    std::atomic<bool> released{false};
+    bool result = false;
+
+    std::thread waiter([&]() {
+        JTCAdoptCurrentThread adopt;
+        rm.lock();
+        ready = true;
+        result = cv.wait(rm, 200);
+        // The mutex is reacquired only after the signaler released it
+        EXPECT_TRUE(released.load());
+        EXPECT_EQ(rm.count(), 1u);
+        rm.unlock();
+    });
+
+    while (!ready.load()) { std::this_thread::yield(); }
+    rm.lock();
+    cv.signal();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    released = true;
+    rm.unlock();
+
+    waiter.join();
+    EXPECT_TRUE(result);
+}
+
+// ---------------------------------------------------------------------------
+// With recursive mutex: broadcast wakes every waiter exactly once
+// ---------------------------------------------------------------------------
+
+TEST_F(CondTest, RecursiveMutexBroadcastWakesAll)
+{
+    JTCRecursiveMutex rm;
+    JTCCond cv;
+    const int N = 6;
+    int waiting = 0;
+    int woken = 0;
+    bool go = false;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < N; ++i) {
+        threads.emplace_back([&]() {
+            JTCAdoptCurrentThread adopt;
+            rm.lock();
+            ++waiting;
+            while (!go)
+                cv.wait(rm);
+            ++woken;
+            rm.unlock();
+        });
+    }
+
+    for (;;) {
+        rm.lock();
+        int w = waiting;
+        rm.unlock();
+        if (w == N)
+            break;
+        std::this_thread::yield();
+    }
+
+    rm.lock();
+    go = true;
+    cv.broadcast();
+    rm.unlock();
+
+    for (auto& t : threads)
+        t.join();
+    EXPECT_EQ(woken, N);
+}
@@ -0,0 +1,273 @@
+#include <JTC.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// JTCInitialize is provided by TestMain.cpp for the entire test run.
+
+class ExecutorTest : public ::testing::Test {};
+
+namespace {
+
+class FnTask : public JTCRunnable
+{
+public:
+    explicit FnTask(std::function<void()> fn) : m_fn(std::move(fn)) {}
+    void run() override { m_fn(); }
+private:
+    std::function<void()> m_fn;
+};
+
+JTCRunnableHandle Task(std::function<void()> fn)
+{
+    return new FnTask(std::move(fn));
+}
+
+class CountingGroup : public JTCThreadGroup
+{
+public:
+    explicit CountingGroup(const char* name) : JTCThreadGroup(name) {}
+    void uncaughtException(JTCThreadHandle, const JTCException&) override { ++caught; }
+    void uncaughtException(JTCThreadHandle) override { ++caught; }
+    std::atomic<int> caught{0};
+};
+
+// Spawns two children until depth reaches 0
+void FanOut(JTCExecutor* ex, int depth, std::atomic<int>* count)
+{
+    ++*count;
+    if (depth == 0)
+        return;
+    ex->execute(Task([=]() { FanOut(ex, depth - 1, count); }));
+    ex->execute(Task([=]() { FanOut(ex, depth - 1, count); }));
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Every submitted task runs once
+// ---------------------------------------------------------------------------
+
+TEST_F(ExecutorTest, RunsSubmittedTasks)
+{
+    JTCExecutorHandle ex = new JTCExecutor("Pool", 4);
+    EXPECT_EQ(ex->size(), 4);
+    ex->start();
+
+    std::atomic<int> count{0};
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_TRUE(ex->execute(Task([&]() { ++count; })));
+
+    ex->shutdown();
+    EXPECT_EQ(count.load(), 1000);
+}
+
+// ---------------------------------------------------------------------------
+// Tasks submitted before start() wait for the workers
+// ---------------------------------------------------------------------------
+
+TEST_F(ExecutorTest, TasksSubmittedBeforeStart)
+{
+    JTCExecutorHandle ex = new JTCExecutor("Early", 2);
+    std::atomic<int> count{0};
+    for (int i = 0; i < 10; ++i)
+        ex->execute(Task([&]() { ++count; }));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(count.load(), 0);
+
+    ex->start();
+    ex->shutdown();
+    EXPECT_EQ(count.load(), 10);
+}
+
+// ---------------------------------------------------------------------------
+// Tasks submitted by tasks go through the worker deques
+// ---------------------------------------------------------------------------
+
+TEST_F(ExecutorTest, FanOutFromTasks)
+{
+    JTCExecutorHandle ex = new JTCExecutor("FanOut", 4);
+    ex->start();
+
+    std::atomic<int> count{0};
+    JTCExecutor* raw = ex.get();
+    ex->execute(Task([&count, raw]() { FanOut(raw, 12, &count); }));
+
+    // 2^13 - 1 tasks
+    for (int i = 0; i < 500 && count.load() < 8191; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ex->shutdown();
+    EXPECT_EQ(count.load(), 8191);
+}
+
+// ---------------------------------------------------------------------------
+// Shutdown runs what is queued and rejects new tasks
+// ---------------------------------------------------------------------------
+
+TEST_F(ExecutorTest, ShutdownDrainsAndRejects)
+{
+    JTCExecutorHandle ex = new JTCExecutor("Drain", 1);
+    ex->start();
+
+    std::atomic<int> count{0};
+    for (int i = 0; i < 50; ++i) {
+        ex->execute(Task([&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            ++count;
+        }));
+    }
+    ex->shutdown();
+    EXPECT_EQ(count.load(), 50);
+    EXPECT_TRUE(ex->isShutdown());
+
+    EXPECT_FALSE(ex->execute(Task([&]() { ++count; })));
+    EXPECT_FALSE(ex->schedule(Task([&]() { ++count; }), 1));
+    EXPECT_EQ(count.load(), 50);
+}
+
+// A task may shut its executor down; the workers are then joined on destruction
+TEST_F(ExecutorTest, ShutdownFromTaskJoinsOnDestruction)
+{
+    std::atomic<int> count{0};
+    {
+        JTCExecutorHandle ex = new JTCExecutor("SelfShutdown", 2);
+        ex->start();
+        JTCExecutor* raw = ex.get();
+        ex->execute(Task([raw, &count]() {
+            raw->shutdown();
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            ++count;
+        }));
+        while (!ex->isShutdown())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // the destructor waited for the task that called shutdown()
+    EXPECT_EQ(count.load(), 1);
+}
+
+// ---------------------------------------------------------------------------
+// Delayed tasks
+// ---------------------------------------------------------------------------
+
+TEST_F(ExecutorTest, ScheduleRunsAfterDelay)
+{
+    JTCExecutorHandle ex = new JTCExecutor("Delay", 2);
+    ex->start();
+
+    std::atomic<bool> ran{false};
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<long long> elapsed{0};
+    EXPECT_TRUE(ex->schedule(Task([&]() {
+        elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        ran = true;
+    }), 50));
+
+    for (int i = 0; i < 100 && !ran.load(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_TRUE(ran.load());
+    EXPECT_GE(elapsed.load(), 45);
+    ex->shutdown();
+}
+
+TEST_F(ExecutorTest, ScheduleOrder)
+{
+    JTCExecutorHandle ex = new JTCExecutor("Order", 1);
+    ex->start();
+
+    std::mutex m;
+    std::vector<int> order;
+    auto record = [&](int v) {
+        return Task([&, v]() {
+            std::lock_guard<std::mutex> l(m);
+            order.push_back(v);
+        });
+    };
+    ex->schedule(record(3), 90);
+    ex->schedule(record(1), 10);
+    ex->schedule(record(2), 50);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    ex->shutdown();
+    ASSERT_EQ(order.size(), 3u);
+    EXPECT_EQ(order[0], 1);
+    EXPECT_EQ(order[1], 2);
+    EXPECT_EQ(order[2], 3);
+}
+
+TEST_F(ExecutorTest, PendingDelayedTasksDiscardedOnShutdown)
+{
+    JTCExecutorHandle ex = new JTCExecutor("Discard", 1);
+    ex->start();
+
+    std::atomic<bool> ran{false};
+    ex->schedule(Task([&]() { ran = true; }), 5000);
+    ex->shutdown();
+    EXPECT_FALSE(ran.load());
+}
+
+TEST_F(ExecutorTest, ScheduleBeforeStartThrows)
+{
+    JTCExecutorHandle ex = new JTCExecutor("NotStarted", 1);
+    EXPECT_THROW(ex->schedule(Task([]() {}), 1), JTCIllegalThreadStateException);
+    ex->shutdown();
+}
+
+// ---------------------------------------------------------------------------
+// ThreadGroup integration
+// ---------------------------------------------------------------------------
+
+TEST_F(ExecutorTest, WorkersRunInExecutorGroup)
+{
+    JTCExecutorHandle ex = new JTCExecutor("Named", 2);
+    EXPECT_STREQ(ex->getName(), "Named");
+    ex->start();
+
+    std::string name;
+    JTCThreadGroup* group = 0;
+    std::atomic<bool> ran{false};
+    ex->execute(Task([&]() {
+        name = JTCThread::currentThread()->getName();
+        group = JTCThread::currentThread()->getThreadGroup().get();
+        ran = true;
+    }));
+    ex->shutdown();
+
+    ASSERT_TRUE(ran.load());
+    EXPECT_EQ(name.compare(0, 6, "Named-"), 0) << name;
+    EXPECT_EQ(group, ex->getThreadGroup().get());
+}
+
+TEST_F(ExecutorTest, DaemonFollowsGroup)
+{
+    JTCExecutorHandle ex = new JTCExecutor("Daemon", 1);
+    EXPECT_FALSE(ex->isDaemon());
+    ex->setDaemon(true);
+    EXPECT_TRUE(ex->isDaemon());
+    EXPECT_TRUE(ex->getThreadGroup()->isDaemon());
+    ex->start();
+    ex->shutdown();
+}
+
+TEST_F(ExecutorTest, UncaughtExceptionReportedToGroup)
+{
+    CountingGroup* counting = new CountingGroup("Parent");
+    JTCThreadGroupHandle parent = counting;
+    JTCExecutorHandle ex = new JTCExecutor(parent, "Throwing", 1);
+    ex->start();
+
+    std::atomic<bool> after{false};
+    ex->execute(Task([]() { throw JTCException("task failed"); }));
+    ex->execute(Task([]() { throw 42; }));
+    ex->execute(Task([&]() { after = true; }));
+    ex->shutdown();
+
+    EXPECT_EQ(counting->caught.load(), 2);
+    EXPECT_TRUE(after.load()) << "worker did not survive the exception";
+}
@@ -190,3 +190,30 @@ TEST_F(RecursiveMutexTest, DeepRecursion)
         m.unlock();
     EXPECT_EQ(m.count(), 0u);
 }
+
+TEST_F(RecursiveMutexTest, ContendedTryLockAndLock)
+{
+    JTCRecursiveMutex m;
+    int counter = 0;
+    const int N = 8;
+    const int ITERS = 5000;
+
+    auto worker = [&]() {
+        JTCAdoptCurrentThread adopt;
+        for (int i = 0; i < ITERS; ++i) {
+            if (!m.trylock())
+                m.lock();
+            ++counter;
+            EXPECT_EQ(m.count(), 1u);
+            m.unlock();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < N; ++i)
+        threads.emplace_back(worker);
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_EQ(counter, N * ITERS);
+}
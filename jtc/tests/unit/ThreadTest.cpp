@@ -365,3 +365,93 @@ TEST_F(ThreadTest, StartHook)
     // Restore old hook
     JTCThread::setStartHook(g_old_start_hook);
 }
+
+// ---------------------------------------------------------------------------
+// Per-thread stack size
+// ---------------------------------------------------------------------------
+
+class StackThread : public JTCThread
+{
+public:
+    std::atomic<size_t> stack{0};
+    StackThread() : JTCThread("StackThread") {}
+    void run() override {
+        pthread_attr_t attr;
+        size_t size = 0;
+        if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+            pthread_attr_getstacksize(&attr, &size);
+            pthread_attr_destroy(&attr);
+        }
+        stack = size;
+    }
+};
+
+TEST_F(ThreadTest, StackSize)
+{
+    JTCHandleT<StackThread> t = new StackThread();
+    EXPECT_EQ(t->getStackSize(), 0u);
+    t->setStackSize(192 * 1024);
+    EXPECT_EQ(t->getStackSize(), 192u * 1024);
+    t->start();
+    t->join();
+    EXPECT_EQ(t->stack.load(), 192u * 1024);
+}
+
+TEST_F(ThreadTest, StackSizeAfterStartThrows)
+{
+    JTCThreadHandle t = new SleepThread(50);
+    t->start();
+    EXPECT_THROW(t->setStackSize(65536), JTCIllegalThreadStateException);
+    t->join();
+}
+
+// ---------------------------------------------------------------------------
+// CPU affinity and scheduling policy
+// ---------------------------------------------------------------------------
+
+class CpuThread : public JTCThread
+{
+public:
+    std::atomic<bool> go{false};
+    std::atomic<int> cpu{-1};
+    CpuThread() : JTCThread("CpuThread") {}
+    void run() override {
+        while (!go.load())
+            JTCThread::yield();
+        cpu = sched_getcpu();
+    }
+};
+
+TEST_F(ThreadTest, AffinityPinsThread)
+{
+    JTCHandleT<CpuThread> t = new CpuThread();
+    t->start();
+    int cpus[] = { 0 };
+    t->setAffinity(cpus, 1);
+    t->go = true;
+    t->join();
+    EXPECT_EQ(t->cpu.load(), 0);
+}
+
+TEST_F(ThreadTest, AffinityBeforeStartThrows)
+{
+    JTCThreadHandle t = new FlagThread("AffinityThread");
+    int cpus[] = { 0 };
+    EXPECT_THROW(t->setAffinity(cpus, 1), JTCIllegalThreadStateException);
+    t->destroy();
+}
+
+TEST_F(ThreadTest, SchedPolicy)
+{
+    JTCThreadHandle t = new SleepThread(50);
+    t->start();
+    EXPECT_NO_THROW(t->setSchedPolicy(JTCThread::JTC_SCHED_OTHER, 0));
+    EXPECT_THROW(t->setSchedPolicy(JTCThread::JTC_SCHED_OTHER, 5),
+                 JTCIllegalArgumentException);
+    // SCHED_FIFO needs privileges, either outcome is fine
+    try {
+        t->setSchedPolicy(JTCThread::JTC_SCHED_FIFO, 1);
+    } catch (const JTCSystemCallException&) {
+    }
+    t->join();
+}